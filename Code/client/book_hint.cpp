@@ -0,0 +1,40 @@
+#include "book_hint.h"
+#include <QCoreApplication>
+
+//最多标出的着法数
+#define book_hint_count 5
+
+QString book_path()
+{
+    return QCoreApplication::applicationDirPath() + "/opening.book";
+}
+
+void draw_book_hints(QPainter &painter, const opening_book &book, const game_board &game, int square)
+{
+    if(!book.is_open() || game.over())
+        return;
+    book_continuation hints[book_hint_count];
+    int n = book.lookup(game, hints, book_hint_count);
+
+    painter.save();
+    QFont font = painter.font();
+    font.setPointSize(8);
+    painter.setFont(font);
+    for(int i = 0; i < n; i++)
+    {
+        int x = (hints[i].move / board_size + 1) * square;
+        int y = (hints[i].move % board_size + 1) * square;
+        int r = square * 2 / 5;
+        //最常见的着法颜色最深
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QColor(0, 150, 0, 160 - i * 20));
+        painter.drawEllipse(QPoint(x, y), r, r);
+
+        //对局数和胜率(和棋算半局)
+        double rate = (hints[i].wins + hints[i].draws * 0.5) / hints[i].games;
+        painter.setPen(Qt::white);
+        painter.drawText(QRect(x - r, y - r, 2 * r, 2 * r), Qt::AlignCenter,
+                         QString("%1\n%2%").arg(hints[i].games).arg(qRound(rate * 100)));
+    }
+    painter.restore();
+}
@@ -0,0 +1,21 @@
+/*
+ * 开局提示
+ * 在棋盘上标出当前局面在开局库(core/opening_book.h)中的常见后续着法，本地对战和网络对战共用
+*/
+
+#ifndef BOOK_HINT_H
+#define BOOK_HINT_H
+
+#include <QPainter>
+#include <QString>
+#include "game_board.h"
+#include "opening_book.h"
+
+//开局库文件：程序所在目录下的opening.book(由core/book工具生成)
+QString book_path();
+
+//在棋盘上画出最常见的几个后续着法：半透明圆圈，标上对局数和落子方的胜率
+//square为格子边长，第i行第j列交叉点的中心在((i+1)*square, (j+1)*square)
+void draw_book_hints(QPainter &painter, const opening_book &book, const game_board &game, int square);
+
+#endif // BOOK_HINT_H
@@ -6,6 +6,8 @@
  * - TCP连接的建立与断开
  * - 消息的发送与接收
  * - 消息队列的管理与消息协议的解析
+ * - 协议版本协商：服务器支持时改用长度前缀的二进制帧（编解码与服务器共用core/protocol.h），
+ *   收到的二进制帧解码成与文本协议相同的队列消息，界面代码不需要区分协议版本
  *
  * 使用Windows Socket API (WinSock2) 实现网络通信
  * 采用多线程方式异步接收服务器消息
@@ -44,6 +46,8 @@ client_net::client_net()
     connected = false;              // 当前未连接服务器
     connect_thread_running = false; // 连接线程未运行
     received = false;               // 未准备好接收数据
+    version = 1;                    // 协商之前使用文本协议
+    lobby_new = false;              // 没有未通知的大厅推送
 }
 
 /**
@@ -90,7 +94,8 @@ bool client_net::isConnected()
  * 1. 检查是否已连接，避免重复连接
  * 2. 重新创建套接字（解决重连问题）
  * 3. 循环尝试连接（最多10次）
- * 4. 连接成功后启动接收线程
+ * 4. 连接成功后协商协议版本（见handshake）
+ * 5. 启动接收线程
  *
  * 注意：使用::connect()调用全局connect函数，避免与成员函数名冲突
  */
@@ -125,7 +130,10 @@ bool client_net::connect()
             connected = true;               // 标记为已连接状态
             received = true;                // 标记为可接收数据状态
             connect_thread_running = false; // 连接过程结束
-            qDebug() << "连接服务器成功" <<Qt::endl;
+
+            // 协商协议版本，必须在接收线程启动之前完成（握手应答由本线程读取）
+            version = handshake() ? proto_version : 1;
+            qDebug() << "连接服务器成功 协议版本:" << version <<Qt::endl;
 
             // 启动数据接收线程
             // _beginthreadex: Windows多线程函数，创建新线程执行recv_msg函数
@@ -142,6 +150,48 @@ bool client_net::connect()
     return false;
 }
 
+/**
+ * @brief 版本协商
+ * @return bool 服务器支持二进制协议返回true
+ *
+ * 发送文本帧"V2\n"，等待服务器原样回复"V2\n"：
+ * - 新服务器回复后，双方之后都使用二进制帧
+ * - 旧服务器不认识"V2"（按未知消息忽略），不会回复，等待1秒超时后继续使用文本协议
+ *
+ * 用select等待而不是SO_RCVTIMEO：WinSock中recv超时后套接字状态不确定，不能继续使用
+ */
+bool client_net::handshake()
+{
+    if(send(client_fd, "V2\n", 3, 0) != 3)
+        return false;
+
+    char reply[3];
+    int got = 0;
+    while(got < 3)
+    {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(client_fd, &fds);
+        timeval timeout = {1, 0};
+        if(select(0, &fds, NULL, NULL, &timeout) <= 0)     //超时:旧服务器
+            return false;
+        int ret = recv(client_fd, reply + got, 3 - got, 0);
+        if(ret <= 0)
+            return false;
+        got += ret;
+    }
+    return memcmp(reply, "V2\n", 3) == 0;
+}
+
+/**
+ * @brief 获取与服务器协商得到的协议版本
+ * @return int 1为文本协议，2为二进制协议
+ */
+int client_net::protocol_version()
+{
+    return version;
+}
+
 /**
  * @brief 断开与服务器的连接
  *
@@ -208,26 +258,71 @@ void client_net::set_port(QString str)
  *
  * 发送流程：
  * 1. 检查连接状态
- * 2. 将QString转换为UTF-8编码的字节数组
+ * 2. 将QString转换为UTF-8编码的字节数组，末尾追加'\n'
  * 3. 调用send()函数发送数据
  *
- * 注意：必须使用strlen获取实际字符串长度，不能使用sizeof
+ * 注意：每条消息末尾自动追加'\n'作为帧分隔符
+ * 协商为二进制协议时，消息按proto_from_text编码为对应类型的二进制帧
  */
 int client_net::send_msg(QString msg)
 {
+    if(connected && version >= 2)
+    {
+        QByteArray text = msg.toUtf8();
+        std::string frame;
+        if(!proto_from_text(text.constData(), text.size(), frame))
+            return SOCKET_ERROR;    // 超过帧的最大长度
+        return send_frame(frame);
+    }
     if(connected)
     {
-        // 将QString转换为UTF-8字节数组并发送
-        // send()参数：套接字、数据缓冲区、数据长度、标志位
-        //[BUG] strlen(msg.toUtf8().data())不能写成sizeof()
+        // 将QString转换为UTF-8字节数组并追加帧分隔符'\n'
+        // 服务器按'\n'切分消息，连续发送的多条消息即使被TCP合并也能正确拆开
+        //[BUG] 长度必须取字节数组的实际长度，不能使用sizeof
         // sizeof返回指针大小(8字节)，而非字符串实际长度
-        return send(client_fd, msg.toUtf8().data(), strlen(msg.toUtf8().data()), 0);
+        QByteArray frame = msg.toUtf8();
+        frame.append('\n');
+        return send(client_fd, frame.constData(), frame.size(), 0);
     }
     else
         return SOCKET_ERROR;    // 未连接时返回错误
 
 }
 
+/**
+ * @brief 向服务器发送落子
+ * @param x 横坐标（0-14）
+ * @param y 纵坐标（0-14）
+ * @return int 发送成功返回发送的字节数，失败返回SOCKET_ERROR
+ *
+ * 二进制协议下为4字节的落子帧（操作码 + 格子下标），文本协议下为"OMxy"
+ */
+int client_net::send_move(int x, int y)
+{
+    if(version >= 2)
+    {
+        std::string frame;
+        proto_move(frame, x, y);
+        return send_frame(frame);
+    }
+    QString msg = "OM";
+    msg += QChar(proto_coord_char(x));
+    msg += QChar(proto_coord_char(y));
+    return send_msg(msg);
+}
+
+/**
+ * @brief 发送已编码的二进制帧
+ * @param frame 一个或多个完整的帧
+ * @return int 发送成功返回发送的字节数，失败返回SOCKET_ERROR
+ */
+int client_net::send_frame(const std::string &frame)
+{
+    if(!connected)
+        return SOCKET_ERROR;
+    return send(client_fd, frame.data(), (int)frame.size(), 0);
+}
+
 /**
  * @brief 从消息队列中获取一条消息
  * @return QString 返回队列头部的消息，队列为空或未连接时返回空字符串
@@ -272,6 +367,8 @@ void client_net::push_msg(QString msg)
  *   - Z: 其他信息
  * - 格式示例：/N房间数据/S状态数据/
  *
+ * - 以'L'开头的帧是大厅推送事件，存入单独的大厅事件列表（见push_lobby_event）
+ *
  * 处理逻辑：
  * 1. 遍历消息字符串，查找'/'分隔符
  * 2. 根据消息类型标识符截取对应消息内容
@@ -279,6 +376,13 @@ void client_net::push_msg(QString msg)
  */
 void client_net::msg_handle(QString msg)
 {
+    // 大厅推送事件单独存放，不进入对局消息队列
+    if(msg.startsWith('L'))
+    {
+        push_lobby_event(msg);
+        return;
+    }
+
     for(int i = 0; i < msg.size(); i++)
     {
         //如果遇到/则开始截取后面直到下一个/前的消息字符串
@@ -335,26 +439,77 @@ int client_net::msg_end(int index, QString str)
     if(index == str.size())
         return index;
 
-    QString ret;    // 用于存储截取的消息内容
+    // 查找下一个'/'，一次截取整段（不逐字符拼接）
+    int end = str.indexOf('/', index);
+    if(end == -1)
+        end = str.size();       // 字符串结束但未遇到'/'，截取剩余内容
+
+    push_msg(str.mid(index, end - index));     // 将截取的消息存入队列
+    return end;     // 返回'/'的位置或字符串末尾位置
+}
 
-    for(; index < str.size(); index++)
+/**
+ * @brief 处理服务器发来的一个二进制帧（v2协议）
+ * @param frame 完整的帧（含长度字段）
+ * @param size 帧的总字节数
+ *
+ * 解码后存入与文本协议相同的队列，界面代码无需区分协议版本：
+ * - 开始、先后手、加入结果、对手信息：直接存入对应的队列消息，不再经过msg_handle逐段截取
+ * - 大厅推送：存入大厅事件列表
+ * - 对战消息：还原为"OMxy"等原消息后存入队列
+ * - 心跳：在接收线程中立即原样应答，不进入队列（服务器据此判断连接是否仍然在线）
+ * - op_text：服务器未做类型化的文本消息（如R的房间列表），按文本协议处理
+ */
+void client_net::frame_handle(const char *frame, int size)
+{
+    std::string text;
+    if(!proto_to_text(frame, size, text))
+        return;         // 未知操作码或非法帧，忽略
+    const unsigned char *payload = (const unsigned char*)frame + proto_header + 1;
+    QString msg = QString::fromUtf8(text.data(), (int)text.size());
+
+    switch((unsigned char)frame[proto_header])
     {
-        //遇到/截取完毕 放入消息队列中
-        // 遇到'/'表示当前消息结束
-        if(str[index] == '/')
+    case op_heartbeat:
+        send_frame(std::string(frame, size));
+        break;
+    case op_start:
+    case op_join_result:
+        push_msg(msg.mid(2));       // 去掉"/Z"，与文本协议截取后的结果相同
+        break;
+    case op_opponent:               // 对手信息拆成4条消息：有无对手、准备状态、IP、FD
+        if(payload[0])
         {
-            push_msg(ret);      // 将截取的消息存入队列
-            return index;       // 返回'/'的位置
+            char ip[16];
+            proto_format_ip(proto_get32(payload + 2), ip);
+            push_msg("1");
+            push_msg(QString::number(payload[1]));
+            push_msg(ip);
+            push_msg(QString::number(proto_get32(payload + 6)));
         }
         else
         {
-            ret += str[index];  // 拼接字符到结果字符串
+            push_msg("0");
+            push_msg(" ");
+            push_msg(" ");
+            push_msg(" ");
         }
+        break;
+    case op_lobby_reset:
+    case op_room:
+    case op_room_full:
+    case op_room_closed:
+    case op_counts:
+    case op_page:
+        push_lobby_event(msg);
+        break;
+    case op_text:
+        msg_handle(msg);
+        break;
+    default:
+        push_msg(msg);
+        break;
     }
-
-    // 字符串结束但未遇到'/'，将剩余内容存入队列
-    push_msg(ret);
-    return index;   // 返回字符串末尾位置
 }
 
 /**
@@ -385,6 +540,62 @@ int client_net::queue_size()
     return msg_queue.size();
 }
 
+/**
+ * @brief 加入一条大厅推送事件
+ * @param msg 以'L'开头的完整帧
+ *
+ * 在接收线程中调用，加锁后存入大厅事件列表
+ */
+void client_net::push_lobby_event(QString msg)
+{
+    QMutexLocker locker(&lobby_mutex);
+    lobby_events.append(msg);
+    lobby_new = true;
+}
+
+/**
+ * @brief 取出所有未处理的大厅推送事件
+ * @return QStringList 按到达顺序排列的事件
+ *
+ * 在界面线程中调用
+ */
+QStringList client_net::take_lobby_events()
+{
+    QMutexLocker locker(&lobby_mutex);
+    QStringList events;
+    events.swap(lobby_events);
+    return events;
+}
+
+/**
+ * @brief 设置收到大厅推送时的回调
+ * @param listener 回调函数（在接收线程中调用，需要自行切换到界面线程）
+ */
+void client_net::set_lobby_listener(std::function<void()> listener)
+{
+    QMutexLocker locker(&lobby_mutex);
+    lobby_listener = listener;
+}
+
+/**
+ * @brief 本次接收到了新的大厅推送时调用回调
+ *
+ * 每次recv()之后调用一次，同一批到达的多条事件只通知一次
+ */
+void client_net::notify_lobby()
+{
+    std::function<void()> listener;
+    {
+        QMutexLocker locker(&lobby_mutex);
+        if(!lobby_new)
+            return;
+        lobby_new = false;
+        listener = lobby_listener;
+    }
+    if(listener)
+        listener();
+}
+
 /**
  * @brief 数据接收线程函数（独立线程运行）
  * @param arg 线程参数，传入client_net对象指针
@@ -392,7 +603,8 @@ int client_net::queue_size()
  *
  * 线程工作流程：
  * 1. 无限循环等待接收服务器数据
- * 2. 接收到数据后调用msg_handle()解析并存入队列
+ * 2. 接收到数据后按'\n'切分成完整的消息帧，逐帧调用msg_handle()解析并存入队列
+ *    （二进制协议下按长度字段切分，逐帧调用frame_handle()）
  * 3. 连接断开或服务器关闭时退出线程
  *
  * 线程退出条件：
@@ -408,13 +620,11 @@ unsigned WINAPI recv_msg(void *arg)
     client_net *net = (client_net*)arg;
     SOCKET fd = net->get_socket_fd();   // 获取套接字描述符
     char msg[1024];                     // 接收缓冲区，最大接收1024字节
+    QByteArray pending;                 // 尚未组成完整帧的数据（TCP可能拆分或合并消息）
 
     // 无限循环接收数据
     while(1)
     {
-        // 每次接收前清空缓冲区，防止脏数据残留
-        memset(msg, 0, sizeof(msg));     //[BUG]*在循环体内必须初始化，否则套接字字符后有脏数据
-
         // 阻塞等待接收服务器数据
         // recv()参数：套接字、缓冲区、缓冲区大小、标志位
         // 返回值：接收到的字节数，0表示连接关闭，负值表示错误
@@ -437,12 +647,42 @@ unsigned WINAPI recv_msg(void *arg)
             return NULL;            // 退出线程
         }
 
-        // 成功接收到数据，打印调试信息
-        qDebug() << "recv msg:" << msg << Qt::endl;
+        // 成功接收到数据，按实际长度追加（不依赖'\0'结尾）
+        pending.append(msg, ret);
+        qDebug() << "recv msg:" << QByteArray(msg, ret) << Qt::endl;
 
-        // 调用消息处理函数，解析消息并存入队列
+        // 按'\n'切分出每一条完整的消息，逐条解析并存入队列
         // 上层应用通过get_msg()从队列中读取消息
-        net->msg_handle(msg);           //处理数据(存入消息队列中)
+        int start = 0, pos;
+        if(net->protocol_version() >= 2)
+        {
+            // 二进制协议：长度字段给出整帧大小，不需要查找分隔符
+            long size;
+            while((size = proto_frame_size(pending.constData() + start, pending.size() - start)) > 0)
+            {
+                net->frame_handle(pending.constData() + start, (int)size);
+                start += (int)size;
+            }
+            if(size < 0)
+            {
+                qDebug() << "非法的协议帧" << Qt::endl;
+                net->disconnect();
+                return NULL;
+            }
+        }
+        else
+        {
+            while((pos = pending.indexOf('\n', start)) != -1)
+            {
+                if(pos > start)
+                    net->msg_handle(QString::fromUtf8(pending.constData() + start, pos - start));   //处理数据(存入消息队列中)
+                start = pos + 1;
+            }
+        }
+        pending.remove(0, start);       // 保留不完整的半帧，等待后续数据
+
+        // 通知界面处理本批收到的大厅推送
+        net->notify_lobby();
     }
     return NULL;
 }
@@ -13,6 +13,11 @@
 #include <QString>
 #include <process.h>
 #include <QDebug>
+#include <QMutex>
+#include <QStringList>
+#include <functional>
+#include <string>
+#include "protocol.h"
 
 using namespace std;
 
@@ -28,13 +33,20 @@ public:
     bool connect();                 //连接服务器
     void disconnect();              //断开连接
     int send_msg(QString);         //向服务器发送数据
+    int send_move(int x, int y);    //向服务器发送落子(v2为二进制帧,否则为文本OMxy)
+    int protocol_version();         //与服务器协商得到的协议版本
     void push_msg(QString msg);                //向消息队列中加入数据
     QString get_msg();              //向消息队列中取数据
     void msg_handle(QString msg);   //处理服务器发来的数据
     int msg_end(int index, QString str);           //截取消息字符串
+    void frame_handle(const char *frame, int size);    //处理服务器发来的一个二进制帧(v2)
     void clear();                   //清理消息队列
     bool queue_empty();
     int queue_size();
+    void push_lobby_event(QString msg);        //加入一条大厅推送事件
+    QStringList take_lobby_events();           //取出所有未处理的大厅推送事件
+    void set_lobby_listener(std::function<void()> listener);    //设置收到大厅推送时的回调(在接收线程中调用)
+    void notify_lobby();                       //有新的大厅推送时调用回调
     bool connect_thread_running;    //是否正字连接
 
 private:
@@ -43,8 +55,17 @@ private:
     SOCKET client_fd;               //客户端套接字
     bool connected;                 //是否已经连接(只读)
     bool received;                  //是否可接收数据(只读)
+    int version;                    //协议版本(1文本 2二进制),连接时协商
+
+    bool handshake();               //版本协商:请求使用二进制协议
+    int send_frame(const std::string &frame);      //发送已编码的二进制帧
 
     QQueue<QString> msg_queue;      //消息队列
+
+    QStringList lobby_events;       //大厅推送事件(以L开头的帧),与对局消息队列分开
+    QMutex lobby_mutex;             //保护lobby_events(接收线程写入,界面线程取出)
+    bool lobby_new;                 //本次接收到了新的大厅推送
+    std::function<void()> lobby_listener;   //收到大厅推送时的回调
 };
 
 //进行C++thread多线程编程时线程调用的程序必须加WINAPI宏形式声明
@@ -1,10 +1,36 @@
 #include "gamewin.h"
 #include "ui_gamewin.h"
+#include "book_hint.h"
+#include "renju_hint.h"
+#include <windows.h>
+#include <QThread>
 
 
 //棋盘横竖各15条线
 #define chessboard_size 15
 
+//交给思考线程的参数：当前棋局的副本，线程结束前释放
+struct ai_task
+{
+    GameWin *win;
+    engine *ai;
+    game_board game;
+    int time_ms;
+    int serial;
+};
+
+//思考线程：在副本上搜索，结果通过队列连接交回界面线程(ai_done)
+unsigned WINAPI ai_think(void *arg)
+{
+    ai_task *task = (ai_task*)arg;
+    search_result r = task->ai->think(task->game, task->time_ms);
+    qDebug() << "电脑落子:" << r.move / chessboard_size << r.move % chessboard_size << "方式" << r.kind
+             << "深度" << r.depth << "评分" << r.score << "节点" << r.nodes << "用时" << r.time_ms << "ms";
+    QMetaObject::invokeMethod(task->win, "ai_done", Qt::QueuedConnection, Q_ARG(int, task->serial), Q_ARG(int, r.move));
+    delete task;
+    return 0;
+}
+
 GameWin::GameWin(QWidget *parent) :
     QWidget(parent),
     ui(new Ui::GameWin)
@@ -16,16 +42,22 @@ GameWin::GameWin(QWidget *parent) :
     white_chess.load(":/new/prefix1/img/shiro.png");
     black_chess.load(":/new/prefix1/img/kuro.png");
     board_bg.load(":/new/prefix1/img/btnbg.jpg");
+    ui->ai_threads->setValue(QThread::idealThreadCount());      //默认用满所有核
+    //没有开局库文件时电脑直接搜索，开局提示按钮不可用
+    if(book.open(book_path().toLocal8Bit().constData()))
+        ai.set_book(&book);
+    else
+        ui->book_btn->setDisabled(true);
 
     square = 800 / (chessboard_size + 1);           //格子边长赋值
     //保存每个点的信息  [BUG]下标必须从0开始
     for(int i = 0; i < chessboard_size; i++)
     {
-        chess_info.push_back(QVector<QPair<QRect, int>>());
+        chess_info.push_back(QVector<QRect>());
         for(int j = 0; j < chessboard_size; j++)
         {
             //设置每个点的点击范围
-            chess_info[i].push_back(QPair<QRect, int>(QRect((i+1)*square - square*1.25/3, (j+1)*square - square*1.25/3, square/3*2.5, square/3*2.5), -1));
+            chess_info[i].push_back(QRect((i+1)*square - square*1.25/3, (j+1)*square - square*1.25/3, square/3*2.5, square/3*2.5));
         }
     }
 
@@ -34,12 +66,14 @@ GameWin::GameWin(QWidget *parent) :
 
 GameWin::~GameWin()
 {
+    ai_stop();
     delete ui;
 }
 
 void GameWin::closeEvent(QCloseEvent *)
 {
     qDebug() << "关闭事件触发";
+    ai_stop();
     emit GameWin::gameOver();       //发出游戏结束信号
 }
 
@@ -73,7 +107,7 @@ void GameWin::paintEvent(QPaintEvent *)
     painter.drawPoint(800 / 2, 800 / 2);
 
     //黑子回合显示黑子图片
-    if(black)
+    if(game.to_move() == stone_black)
     {
         ui->chess_label->setStyleSheet("border-image:url(:new/prefix1/img/kuro.png);");
     }
@@ -83,31 +117,38 @@ void GameWin::paintEvent(QPaintEvent *)
     }
 
     //画棋子
-    for(auto &x : chess_info)
+    for(int i = 0; i < chess_info.size(); i++)
     {
-        for(auto &y : x)
+        for(int j = 0; j < chess_info[i].size(); j++)
         {
-            switch (y.second)
+            switch (game.at(i, j))
             {
-                case 1:
-                    painter.drawPixmap(y.first, black_chess);
-                    break;
-                case 0:
-                    painter.drawPixmap(y.first, white_chess);
+                case stone_black:
+                    painter.drawPixmap(chess_info[i][j], black_chess);
                     break;
-                case -1:
+                case stone_white:
+                    painter.drawPixmap(chess_info[i][j], white_chess);
                     break;
                 default:break;
             }
         }
     }
-    if(!back.empty())
+    //最后一步画红点
+    int last = game.last();
+    if(last != -1)
     {
         pen.setWidth(8);
         pen.setColor(QColor(Qt::red));
         painter.setPen(pen);
-        painter.drawPoint((back.top().first + 1) * 50, (back.top().second + 1) * 50);
+        painter.drawPoint((last / chessboard_size + 1) * 50, (last % chessboard_size + 1) * 50);
     }
+
+    //开局提示
+    if(show_book)
+        draw_book_hints(painter, book, game, square);
+
+    //连珠规则下轮到黑方时标出禁手点
+    draw_forbidden_marks(painter, game, square);
 }
 
 void GameWin::mousePressEvent(QMouseEvent *event)
@@ -118,26 +159,20 @@ void GameWin::mousePressEvent(QMouseEvent *event)
 
 void GameWin::initialization()
 {
-    black = true;
+    ai_stop();
     running = true;
-    back.resize(0);
+    game.reset();
     ui->back_btn->setDisabled(false);
     ui->chessboard->setText("");
     ui->chessboard->setStyleSheet("color:red");
-    for(auto &x : chess_info)
-    {
-        for(auto &y : x)
-        {
-            y.second = -1;
-        }
-    }
     update();       //更新窗口
+    ai_move();      //电脑执黑时先走
 }
 
 
 void GameWin::press_event(int x, int y)
 {
-    if(!running)
+    if(!running || (ai_mode && game.to_move() == ai_color))     //电脑思考时不能落子
         return;
     qDebug() << "点击位置:" << x << " " << y;
     QRect r(x, y, 5, 5);        //点击的触摸区域
@@ -146,77 +181,32 @@ void GameWin::press_event(int x, int y)
         for(int j = 0; j < chess_info[i].size(); j++)
         {
             //如果点击位置相交且该点没有落子
-            if(chess_info[i][j].first.intersects(r) && chess_info[i][j].second == -1)
+            if(chess_info[i][j].intersects(r) && game.at(i, j) == stone_none)
             {
-                chess_info[i][j].second = black;        //记录该点落子颜色
-                black = !black;
-                back.push(QPair<int, int>(i, j));
+                int result = game.play(i, j);       //落子 轮次交换与五连判定见core/game_board.h
                 qDebug() << i << " " << j;
-                win(i, j);
+                win(result);
             }
         }
     }
     update();
+    ai_move();
 }
 
-void GameWin::win(int x, int y)
+//根据落子结果(play_result)显示胜负：五连为刚落子的一方获胜，下满为和棋
+//禁手点和非法落子(结果为负)不改变棋盘，什么也不做
+void GameWin::win(int result)
 {
-    int dir1[4][2] = {
-                        {0, 1},     //上下
-                        {1, 1},     //左上右下
-                        {1, 0},     //左右
-                        {1, -1}     //右下左上
-                     };
-    int dir2[4][2] = {
-                        {0, -1},    //上下
-                        {-1, -1},   //左上右下
-                        {-1, 0},    //左右
-                        {-1, 1}     //右下左上
-                     };
-
-    //枚举4对方向
-    for(int i = 0; i < 4; i++)
+    if(result == play_five || result == play_full)
     {
-        int sum = 0;
-        int a = x, b = y;
-        //验证该方向上前4个点
-        for(int j = 0; j <= 4; j++)
-        {
-            a += dir1[i][0];
-            b += dir1[i][1];
-            if(a >= 0 && b >= 0 && a < chess_info.size() && b < chess_info.size() && chess_info[a][b].second == (!black))
-            {
-                sum++;
-            }
-            else
-                break;
-        }
-
-        //[BUG] 还原a,b点
-        a = x, b = y;
-
-        //验证该方向上后4个点
-        for(int j = 0; j <= 4; j++)
-        {
-            a += dir2[i][0];
-            b += dir2[i][1];
-            if(a >= 0 && b >= 0 && a < chess_info.size() && b < chess_info.size() && chess_info[a][b].second == (!black))
-            {
-                sum++;
-            }
-            else
-                break;
-        }
-
-        if(sum >= 4)
-        {
-            if(black)
-                ui->chessboard->setText("白方胜利");
-            else
-                ui->chessboard->setText("黑方胜利");
-            running = false;
-            ui->back_btn->setDisabled(true);
-        }
+        if(result == play_full)
+            ui->chessboard->setText("和棋");
+        else if(game.winner() == stone_white)
+            ui->chessboard->setText("白方胜利");
+        else
+            ui->chessboard->setText("黑方胜利");
+        running = false;
+        ui->back_btn->setDisabled(true);
     }
 }
 
@@ -231,14 +221,72 @@ void GameWin::on_new_btn_clicked()
     initialization();
 }
 
-//悔棋按钮事件
+//悔棋按钮事件 人机对战时退回到玩家的回合
 void GameWin::on_back_btn_clicked()
 {
-    if(back.empty())
+    ai_stop();
+    if(game.undo() && ai_mode && game.to_move() == ai_color)
+        game.undo();
+    update();
+    ai_move();
+}
+
+//人机对战按钮事件 打开时玩家执当前该走的一方，电脑执另一方
+void GameWin::on_ai_btn_clicked(bool checked)
+{
+    ai_stop();
+    ai_mode = checked;
+    ai_color = game.to_move() == stone_black ? stone_white : stone_black;
+    ai_move();
+}
+
+//开局提示按钮事件
+void GameWin::on_book_btn_clicked(bool checked)
+{
+    show_book = checked;
+    update();
+}
+
+//禁手规则选项事件 切换规则后重新开局(开局库只用于无禁手规则，电脑在连珠规则下不按库走)
+void GameWin::on_renju_check_toggled(bool checked)
+{
+    ai_stop();
+    game.reset();
+    game.set_rule(checked ? rule_renju : rule_freestyle);
+    initialization();
+}
+
+void GameWin::ai_move()
+{
+    if(!ai_mode || !running || game.over() || game.to_move() != ai_color || ai_thread)
+        return;
+    ai.set_threads(ui->ai_threads->value());       //思考线程未启动，可以修改
+    ai_task *task = new ai_task{this, &ai, game, (int)(ui->ai_time->value() * 1000), ai_serial};
+    ai_thread = _beginthreadex(NULL, 0, ai_think, task, 0, NULL);
+}
+
+void GameWin::ai_stop()
+{
+    ai_serial++;
+    if(!ai_thread)
+        return;
+    //线程可能还没进入think()(think()开始时清除停止标志)，所以等待时反复发出停止
+    while(WaitForSingleObject((HANDLE)ai_thread, 10) == WAIT_TIMEOUT)
+        ai.stop();
+    CloseHandle((HANDLE)ai_thread);
+    ai_thread = 0;
+}
+
+void GameWin::ai_done(int serial, int move)
+{
+    if(serial != ai_serial)         //新游戏、悔棋之前发出的思考，ai_stop()已回收线程
+        return;
+    //线程发出结果后马上结束
+    WaitForSingleObject((HANDLE)ai_thread, INFINITE);
+    CloseHandle((HANDLE)ai_thread);
+    ai_thread = 0;
+    if(!running)
         return;
-    QPair<int, int> p = back.top();
-    chess_info[p.first][p.second].second = -1;
-    back.pop();
-    black = !black;
+    win(game.play(move));
     update();
 }
@@ -2,13 +2,16 @@
 #define GAMEWIN_H
 
 #include <QWidget>
-#include <QStack>
 #include <QLabel>
 #include <QCloseEvent>
 #include <QPainter>
 #include <QPaintEvent>
 #include "QMouseEvent"
 #include <QDebug>
+#include <process.h>
+#include "game_board.h"
+#include "engine.h"
+#include "opening_book.h"
 
 namespace Ui {
 class GameWin;
@@ -25,7 +28,9 @@ public:
 public:
     void initialization();          //重新游戏 初始化棋盘
     void press_event(int, int);              //鼠标点击事件处理
-    void win(int, int);             //判断是否胜利
+    void win(int);                  //根据落子结果显示胜负
+    void ai_move();                 //人机对战轮到电脑时，开一个线程思考
+    void ai_stop();                 //停止正在进行的思考并等待线程结束
 
 public:
     void closeEvent(QCloseEvent *event);
@@ -40,10 +45,18 @@ private:
     QPixmap black_chess;       //黑棋图片
     QPixmap board_bg;          //棋盘背景
 
-    bool black = true;          //是否黑子回合 否则白子回合
     bool running;               //游戏是否运行
-    QVector<QVector<QPair<QRect, int>>> chess_info;         //棋盘信息 记录每个点的落子颜色与落子范围等
-    QStack<QPair<int, int>> back;                          //所有落子信息 悔棋用
+    QVector<QVector<QRect>> chess_info;                    //每个点的落子范围
+    game_board game;                                       //棋局：棋盘、落子顺序、悔棋、轮次与胜负(与服务器共用gobang_core库)
+
+    engine ai;                  //电脑对手(core/engine.h)，在单独的线程中思考，界面线程不阻塞
+    bool ai_mode = false;       //是否人机对战
+    int ai_color = stone_white; //电脑执子颜色
+    uintptr_t ai_thread = 0;    //正在思考的线程句柄(_beginthreadex返回值)，没有时为0
+    int ai_serial = 0;          //思考编号，新游戏、悔棋、切换模式时加一，之前的思考结果作废
+
+    opening_book book;          //开局库(core/opening_book.h)，电脑开局时按库走，也用于开局提示
+    bool show_book = false;     //是否在棋盘上标出开局库中的后续着法
 
 signals:
     void gameOver();        //游戏结束信号（关闭事件触发时发出）
@@ -53,6 +66,10 @@ private slots:
     void on_exit_btn_clicked();
     void on_new_btn_clicked();
     void on_back_btn_clicked();
+    void on_ai_btn_clicked(bool checked);
+    void on_book_btn_clicked(bool checked);
+    void on_renju_check_toggled(bool checked);
+    void ai_done(int serial, int move);     //思考线程结束后在界面线程中调用，落下电脑的棋子
 };
 
 #endif // GAMEWIN_H
@@ -4,7 +4,11 @@ RC_ICONS = gobang.ico
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
-CONFIG += c++11
+CONFIG += c++14
+
+# 与服务器共用的协议编解码和gobang_core库（棋盘、落子顺序、悔棋、轮次与胜负、电脑对手，不依赖Qt）
+# 客户端在Windows上编译，直接把库的源文件编进来；Linux下的静态库见core/makefile
+INCLUDEPATH += ../core
 
 # The following define makes your compiler emit warnings if you use
 # any Qt feature that has been marked deprecated (the exact warnings
@@ -18,17 +22,33 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    ../core/engine.cpp \
+    ../core/game_board.cpp \
+    ../core/opening_book.cpp \
+    ../core/renju.cpp \
+    book_hint.cpp \
     client_net.cpp \
     gamewin.cpp \
     internet_game.cpp \
     main.cpp \
-    menu.cpp
+    menu.cpp \
+    renju_hint.cpp
 
 HEADERS += \
+    ../core/bitboard.h \
+    ../core/engine.h \
+    ../core/game_board.h \
+    ../core/opening_book.h \
+    ../core/protocol.h \
+    ../core/renju.h \
+    ../core/transposition.h \
+    ../core/zobrist.h \
+    book_hint.h \
     client_net.h \
     gamewin.h \
     internet_game.h \
-    menu.h
+    menu.h \
+    renju_hint.h
 
 FORMS += \
     gamewin.ui \
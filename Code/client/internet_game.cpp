@@ -5,7 +5,7 @@
  * 本文件实现了五子棋网络对战的核心功能，包括：
  * - 游戏界面的初始化与绘制
  * - 网络通信与消息处理
- * - 落子逻辑与胜负判断
+ * - 落子逻辑（棋盘、轮次与胜负判断由gobang_core库的game_board完成）
  * - 准备、认输、悔棋等游戏功能
  * - 实时聊天功能
  *
@@ -15,6 +15,8 @@
 
 #include "internet_game.h"
 #include "ui_internet_game.h"
+#include "book_hint.h"
+#include "renju_hint.h"
 
 /**
  * @brief 棋盘大小常量定义
@@ -91,15 +93,15 @@ internet_game::internet_game(int x,int y,client_net *client_,QString room_name,Q
     prepare=false;      // 己方是否已准备
     color=-1;           // 己方棋子颜色（-1:未确定, 0:白棋, 1:黑棋）
     running=false;      // 游戏是否正在进行
-    turn=false;         // 是否轮到己方落子
+
+    // 映射开局库文件（程序目录下的opening.book），没有时开局提示不可用
+    if(!book.open(book_path().toLocal8Bit().constData()))
+        ui->check_book->setDisabled(true);
 
     // 启动定时器，每500毫秒触发一次timerEvent
     // 用于轮询服务器消息，实现实时同步
     timerId1=startTimer(500);
 
-    // 初始化棋盘数据结构
-    back.resize(0);             //记录棋盘信息初始化 清空落子历史栈
-
     // 计算每个格子的边长
     // 棋盘区域800像素，分成16份（15条线+两边各留半格）
     square = 800 / (chessboard_size + 1);           //格子边长赋值
@@ -109,15 +111,13 @@ internet_game::internet_game(int x,int y,client_net *client_,QString room_name,Q
     for(int i = 0; i < chessboard_size; i++)
     {
         // 为每一列创建一个向量
-        chess_info.push_back(QVector<QPair<QRect, int>>());
+        chess_info.push_back(QVector<QRect>());
         for(int j = 0; j < chessboard_size; j++)
         {
-            // 为每个交叉点设置点击检测区域和初始状态
-            // QRect: 定义该点的可点击矩形区域
-            // int: 该点的落子状态（-1:空, 0:白棋, 1:黑棋）
+            // 为每个交叉点设置点击检测区域（落子状态保存在game中）
             //设置每个点的点击范围
             // 点击范围略大于格子，提升用户体验
-            chess_info[i].push_back(QPair<QRect, int>(QRect((i+1)*square - square * 1.25 / 3, (j+1)*square - square * 1.25 / 3, square/3*2.5, square/3*2.5), -1));
+            chess_info[i].push_back(QRect((i+1)*square - square * 1.25 / 3, (j+1)*square - square * 1.25 / 3, square/3*2.5, square/3*2.5));
         }
     }
 }
@@ -149,18 +149,16 @@ internet_game::internet_game(QWidget *parent)
     prepare = false;
     color = -1;
     running = false;
-    turn = false;
     timerId1 = startTimer(500); // 启动定时器
 
-    back.resize(0); // 记录棋盘信息初始化
     square = 800 / (chessboard_size + 1); // 格子边长赋值
     // 保存每个点的信息
     for (int i = 0; i < chessboard_size; i++) {
-        chess_info.push_back(QVector<QPair<QRect, int>>());
+        chess_info.push_back(QVector<QRect>());
         for (int j = 0; j < chessboard_size; j++) {
             // 设置每个点的点击范围
-            chess_info[i].push_back(QPair<QRect, int>(
-                QRect((i + 1) * square - square * 1.25 / 3, (j + 1) * square - square * 1.25 / 3, square / 3 * 2.5, square / 3 * 2.5), -1));
+            chess_info[i].push_back(
+                QRect((i + 1) * square - square * 1.25 / 3, (j + 1) * square - square * 1.25 / 3, square / 3 * 2.5, square / 3 * 2.5));
         }
     }
 }
@@ -183,22 +181,14 @@ internet_game::~internet_game()
  *
  * 用于新游戏开始时重置所有棋盘数据：
  * 1. 清空聊天记录
- * 2. 清空落子历史栈
- * 3. 重置所有交叉点为空状态
- * 4. 刷新界面显示
+ * 2. 清空棋盘和落子记录
+ * 3. 刷新界面显示
  */
 void internet_game::initialization()
 {
     //prepare=false;
     ui->LE_recv->clear();           //清空聊天信息框
-    back.resize(0);                 //清空栈（落子历史记录）
-
-    // 遍历棋盘所有交叉点，重置为空状态
-    for(auto &x:chess_info)
-    {
-        for(auto &y:x)
-            y.second=-1;            //清空落子信息容器 -1表示该位置为空
-    }
+    game.reset();                   //清空棋盘和落子记录
     update();                       //更新棋盘界面 触发paintEvent重绘
 }
 
@@ -211,8 +201,7 @@ void internet_game::initialization()
  * 1. 检查游戏状态和回合
  * 2. 判断点击位置是否在有效交叉点附近
  * 3. 检查该位置是否已有棋子
- * 4. 记录落子信息并发送给服务器
- * 5. 进行胜负判断
+ * 4. 在game上落子（同时完成五连判断和回合交换）并发送给服务器，连珠规则下黑方的禁手点不能落子
  *
  * 坐标编码规则：
  * - 0-9: 直接用字符'0'-'9'表示
@@ -226,7 +215,7 @@ void internet_game::take_chess(int x, int y)
         return;
 
     // 不是己方回合不能落子
-    if(!turn)           //不是己方回合不能落子
+    if(!my_turn())      //不是己方回合不能落子
         return;
 
     qDebug() << "落子位置:" << x << " " << y << Qt::endl;
@@ -242,46 +231,18 @@ void internet_game::take_chess(int x, int y)
         {
             // 判断条件：点击区域与交叉点区域相交 且 该点为空
             //如果点击位置相交且该点没有落子
-            if(chess_info[i][j].first.intersects(r) && chess_info[i][j].second == -1)
+            if(chess_info[i][j].intersects(r) && game.at(i, j) == stone_none)
             {
-                // 记录落子：将该点状态设为己方颜色
-                chess_info[i][j].second = color;        //记录该点落子颜色
-
-                // ��落子位置压入历史栈（用于悔棋功能）
-                back.push(QPair<int, int>(i, j));
+                // 记录落子：落子、记入落子顺序（用于悔棋）、五连判断并交换回合
+                // 五连或下满后game不再接受落子，等待服务器下发的对局结果（W消息）
+                // 连珠规则下黑方的禁手点不接受落子（服务器同样会拒绝）
+                if(game.play(i, j) < 0)
+                    continue;
                 qDebug() << i << " " << j;
 
-                // 构造发送给服务器的落子消息
-                // 格式: "OMxy" 其中x,y为坐标
-                QString msg="OM00";
-
-                // 编码x坐标（列）
-                switch(i)                           //存储x坐标的值
-                {
-                case 10: msg[2] = 'a'; break;       //如果是10则转换成字符a,以此类推
-                case 11: msg[2] = 'b'; break;
-                case 12: msg[2] = 'c'; break;
-                case 13: msg[2] = 'd'; break;
-                case 14: msg[2] = 'e'; break;
-                default: msg[2] = QChar('0' + i); // 使用 QChar 构造函数 0-9直接转字符
-                }
-
-                // 编码y坐标（行）
-                switch(j)                           //存储y坐标的值
-                {
-                case 10: msg[3] = 'a'; break;
-                case 11: msg[3] = 'b'; break;
-                case 12: msg[3] = 'c'; break;
-                case 13: msg[3] = 'd'; break;
-                case 14: msg[3] = 'e'; break;
-                default: msg[3] = QChar('0' + j); // 使用 QChar 构造函数
-                }
-
                 // 发送落子消息给服务器（服务器会转发给对手）
-                client->send_msg(msg);
-
-                // 进行胜负判断，如果未分胜负则交换回合
-                win(i, j);                      //己方落子胜利判断与回合转换
+                // 二进制协议下为落子帧（格子下标x*15+y），文本协议下为"OMxy"
+                client->send_move(i, j);
             }
         }
     }
@@ -291,105 +252,17 @@ void internet_game::take_chess(int x, int y)
 }
 
 /**
- * @brief 胜负判断函数
- * @param x 最后落子的x坐标（棋盘坐标，非像素）
- * @param y 最后落子的y坐标（棋盘坐标，非像素）
+ * @brief 是否轮到己方落子
  *
- * 五子棋胜利条件：在横、竖、斜四个方向上有连续5个同色棋子
+ * 轮次由棋局中已落子数的奇偶决定（黑方先手，悔棋后自然恢复），游戏进行中、
+ * 已选定颜色、且未分胜负时才可能是己方回合
  *
- * 算法思路：
- * 1. 从落子点出发，检查4个方向（横、竖、左斜、右斜）
- * 2. 每个方向分正反两个向量，统计连续同色棋子数
- * 3. 如果任一方向连续同色棋子>=5，则该方获胜
- * 4. 未分胜负则交换回合
+ * 胜负以服务器为准：服务器保存权威棋盘，校验每步落子并判定五连，
+ * 本地五连或下满只用于在结果到达之前停止落子（game.over()）
  */
-void internet_game::win(int x, int y)
+bool internet_game::my_turn() const
 {
-    // 定义4个方向的正向向量
-    int dir1[4][2] = {
-        {0, 1},     //上下（向下）
-        {1, 1},     //左上右下（向右下）
-        {1, 0},     //左右（向右）
-        {1, -1}     //右下左上（向右上）
-    };
-
-    // 定义4个方向的反向向量
-    int dir2[4][2] = {
-        {0, -1},    //上下（向上）
-        {-1, -1},   //左上右下（向左上）
-        {-1, 0},    //左右（向左）
-        {-1, 1}     //右下左上（向左下）
-    };
-
-    // 判断当前落子方的颜色
-    // turn为true表示己方刚落子，颜色为color
-    // turn为false表示对方刚落子，���色为!color
-    bool black = (turn ? color : !color);           //判断当前落子方棋子颜色
-
-    //枚举4对方向
-    for(int i = 0; i < 4; i++)
-    {
-        int sum = 0;        // 该方向连续同色棋子计数（不包含当前落子点）
-        int a = x, b = y;   // 从落子点开始检测
-
-        // 向正方向检测，最多检测4个点
-        //验证该方向上前4个点
-        for(int j = 0; j <= 4; j++)
-        {
-            a += dir1[i][0];
-            b += dir1[i][1];
-            // 边界检查 + 颜色匹配检查
-            //[BUG] chess_info[a][b].second == black 表示该点上的棋子颜色与当前落子方的颜色一致
-            if(a >= 0 && b >= 0 && a < chess_info.size() && b < chess_info.size() && chess_info[a][b].second == black)
-                sum++;
-            else
-                break;      // 遇到边界或不同颜色棋子，停止检测
-        }
-
-        // 重置坐标，准备检测反方向
-        //[BUG] 还原a,b点
-        a = x, b = y;
-
-        // 向反方向检测，最多检测4个点
-        //验证该方向上后4个点
-        for(int j = 0; j <= 4; j++)
-        {
-            a += dir2[i][0];
-            b += dir2[i][1];
-            //[BUG] chess_info[a][b].second == black 表示该点上的棋子颜色与当前落子方的颜色一致
-            if(a >= 0 && b >= 0 && a < chess_info.size() && b < chess_info.size() && chess_info[a][b].second == black)
-                sum++;
-            else
-                break;
-        }
-
-        // 加上落子点本身，如果>=5则获胜
-        // sum统计的是除落子点外的连续同色棋子，所以>=4即表示总共>=5
-        if(sum >= 4)                //五子相连 游戏结束
-        {
-            // 显示胜利信息
-            if(black)
-                ui->label_victory->setText("黑方胜利");
-            else
-                ui->label_victory->setText("白方胜利");
-
-            // 游戏结束处理：取消准备状态，显示结果
-            on_Button_prepare_clicked();    //(游戏结束)调用准备按钮函数 相当于取消准备
-            ui->label_prepare->show();
-            ui->label_victory->show();
-
-            // 切换回准备界面
-            ui->stackedWidget->setCurrentIndex(0);
-
-            // 重置游戏状态
-            color=-1;
-            running=false;
-            return ;
-        }
-    }
-
-    // 未分胜负，交换回合
-    turn = !turn;               //*交换回合
+    return running && color != -1 && !game.over() && game.to_move() == color;
 }
 
 
@@ -397,30 +270,16 @@ void internet_game::win(int x, int y)
  * @brief 悔棋操作 - 撤销最后一步落子
  *
  * 悔棋流程：
- * 1. 从历史栈中取出最后落子位置
- * 2. 将该位置重置为空状态
- * 3. 交换回合（因为撤销了一步）
- * 4. 刷新界面
+ * 1. 撤销棋局的最后一步（棋盘上的棋子和落子记录）
+ * 2. 回合随已落子数自然还原
+ * 3. 刷新界面
  */
 void internet_game::go_back()
 {
-    // 栈为空时无法悔棋
-    if(back.empty())
+    // 没有落子时无法悔棋
+    if(!game.undo())
         return;
 
-    // 获取栈顶元素（最后一步落子位置）
-    int x = back.top().first;           //[BUG]top访问栈顶 不能写成pop
-    int y = back.top().second;
-
-    // 清除该位置的落子记录
-    chess_info[x][y].second = -1;       //将该点落子记录清除
-
-    // 弹出栈顶元素
-    back.pop();                         //栈顶元素出栈
-
-    // 悔棋后回合也要还原
-    turn = !turn;                       //交换回合
-
     // 刷新棋盘显示
     update();                           //重画棋盘
 }
@@ -458,7 +317,8 @@ void internet_game::wait_over()
  * 3. 棋盘中心点（天元）
  * 4. 所有已落子的棋子
  * 5. 最后落子位置的红点标记
- * 6. 当前回合提示
+ * 6. 连珠规则下轮到黑方时的禁手点
+ * 7. 当前回合提示
  */
 void internet_game::paintEvent(QPaintEvent *)
 {
@@ -498,36 +358,43 @@ void internet_game::paintEvent(QPaintEvent *)
 
     // 绘制所有已落子的棋子
     //以上是绘制棋盘，接下来就是绘制棋子
-    for(auto x:chess_info)
+    for(int i = 0; i < chess_info.size(); i++)
     {
-        for(auto y:x)
+        for(int j = 0; j < chess_info[i].size(); j++)
         {
-            //painter.drawRect(y.first);    // 调试用：绘制点击区域
+            //painter.drawRect(chess_info[i][j]);    // 调试用：绘制点击区域
 
             // 根据落子状态绘制对应颜色的棋子
-            switch(y.second)
-            {
-            case 1:painter.drawPixmap(y.first,black_chess);break;   // 黑棋
-            case 0:painter.drawPixmap(y.first,white_chess);break;   // 白棋
-            case -1:break;                                          // 空位
-            default:break;
-            }
-
-            // 在最后落子位置绘制红点标记
-            if(!back.empty())
+            switch(game.at(i, j))
             {
-                pen.setWidth(8);
-                pen.setColor(QColor(Qt::red));      // 红色标记
-                painter.setPen(pen);
-                // 计算最后落子的像素位置并绘制红点
-                painter.drawPoint((back.top().first + 1) * 50, (back.top().second + 1) * 50);
+            case stone_black:painter.drawPixmap(chess_info[i][j],black_chess);break;   // 黑棋
+            case stone_white:painter.drawPixmap(chess_info[i][j],white_chess);break;   // 白棋
+            default:break;                                                          // 空位
             }
         }
     }
 
+    // 在最后落子位置绘制红点标记
+    int last = game.last();
+    if(last != -1)
+    {
+        pen.setWidth(8);
+        pen.setColor(QColor(Qt::red));      // 红色标记
+        painter.setPen(pen);
+        // 计算最后落子的像素位置并绘制红点
+        painter.drawPoint((last / chessboard_size + 1) * 50, (last % chessboard_size + 1) * 50);
+    }
+
+    // 开局提示：标出开局库中当前局面的常见后续着法
+    if(show_book)
+        draw_book_hints(painter, book, game, square);
+
+    // 连珠规则的房间：标出黑方的禁手点
+    draw_forbidden_marks(painter, game, square);
+
     // 显示当前回合提示
     if(running)
-        if(turn)            //如果是你的回合
+        if(my_turn())       //如果是你的回合
         {
             ui->label_msg->setText("你的回合");
             ui->label_msg->setStyleSheet("QLabel{""color:green;""}");   // 绿色表示可以落子
@@ -596,6 +463,7 @@ void internet_game::get_prepare_information()
  *
  * 消息协议说明：
  * - "start": 双方准备就绪，游戏开始
+ * - "K0"/"K1": 房间的规则（无禁手/连珠），在先后手确认之前到达
  * - "c1": 己方为黑棋（先手）
  * - "c0": 己方为白棋（后手）
  * - "OMxy": 落子消息（x,y为坐标）
@@ -604,6 +472,7 @@ void internet_game::get_prepare_information()
  * - "ONxxx": 聊天消息
  * - "OB": 悔棋请求
  * - "OB1"/"OB0": 悔棋响应（同意/拒绝）
+ * - "W1"/"W0"/"W2": 服务器判定的对局结果（黑胜/白胜/和棋）
  */
 void internet_game::timerEvent(QTimerEvent *event)
 {
@@ -661,7 +530,7 @@ void internet_game::timerEvent(QTimerEvent *event)
                 if(str[0] == 'O' && str[1] == 'R')
                 {
                     // 对手退出处理
-                    on_Button_prepare_clicked();    //(游戏结束)调用准备按钮函数，相当于取消准备
+                    reset_prepare();    //(游戏结束)回到未准备状态
                     ui->label_prepare->show();
                     ui->label_victory->setText("对手退出了游戏");
                     ui->label_victory->show();
@@ -683,11 +552,17 @@ void internet_game::timerEvent(QTimerEvent *event)
                     running = false;
                 }
 
+                // 房间的规则（game_rule），决定本地棋盘是否判定禁手
+                if(str.size() == 2 && str[0] == 'K' && str[1] >= '0' && str[1] - '0' < rule_count)
+                {
+                    game.set_rule(str[1] - '0');
+                    update();
+                }
+
                 // 处理先后手确认消息
                 if(msg == "c1")         //如果是先手即黑方
                 {
-                    color = 1;          // 黑棋
-                    turn = true;        //*轮到己方回合
+                    color = 1;          // 黑棋（先手，轮到己方回合）
                     ui->button_black->hide();
                     ui->button_white->hide();
                     ui->Label_your_color->show();
@@ -695,8 +570,7 @@ void internet_game::timerEvent(QTimerEvent *event)
                 }
                 else if(msg == "c0")         //如果是先手即黑方
                 {
-                    color = 0;          // 白棋
-                    turn = false;       //*不是己方回合
+                    color = 0;          // 白棋（后手，对方回合）
                     ui->button_black->hide();
                     ui->button_white->hide();
                     ui->Label_your_color->show();
@@ -713,6 +587,31 @@ void internet_game::timerEvent(QTimerEvent *event)
                 QString recv = client->get_msg();
                 string msg = recv.toStdString();
 
+                // ----- 服务器判定的对局结果 -----
+                if(msg.size() == 2 && msg[0] == 'W')
+                {
+                    // 显示结果信息
+                    if(msg[1] == '1')
+                        ui->label_victory->setText("黑方胜利");
+                    else if(msg[1] == '0')
+                        ui->label_victory->setText("白方胜利");
+                    else
+                        ui->label_victory->setText("和棋");
+
+                    // 游戏结束处理：回到未准备状态，显示结果
+                    reset_prepare();    //(游戏结束)回到未准备状态
+                    ui->label_prepare->show();
+                    ui->label_victory->show();
+
+                    // 切换回准备界面
+                    ui->stackedWidget->setCurrentIndex(0);
+
+                    // 重置游戏状态
+                    color=-1;
+                    running=false;
+                    return;
+                }
+
                 // 所有对战消息以'O'开头
                 if(msg[0] == 'O')
                     switch(msg[1])
@@ -723,29 +622,23 @@ void internet_game::timerEvent(QTimerEvent *event)
                         // 解码坐标
                         //处理获得落子x,y的坐标
                         int x, y;
-                        // 解码x坐标（a-e表示10-14）
-                        if(msg[2] >= 'a' && msg[2] <= 'e')
-                            x = msg[2] - 'a' + 10;
-                        else
-                            x = msg[2] - '0';
-                        // 解码y坐标
-                        if(msg[3] >= 'a' && msg[3] <= 'e')
-                            y = msg[3] - 'a' + 10;
-                        else
-                            y = msg[3] - '0';
-
-                        // 记录对手落子
-                        chess_info[x][y].second = !color;           //存储对手的落子信息
-                        back.push(QPair<int, int>(x, y));
+                        // 解码坐标（0-9直接为数字，a-e表示10-14）
+                        x = proto_coord_value(msg[2]);
+                        y = proto_coord_value(msg[3]);
+                        if(msg.size() != 4 || x < 0 || y < 0)
+                            break;              // 非法坐标，忽略
+
+                        // 记录对手落子（同时完成回合交换与五连判断）
+                        if(game.play(x, y) < 0)
+                            break;          // 与本地棋盘冲突，忽略
                         update();           //更新棋盘
-                        win(x, y);          //进行回合交换与胜利判断
                     }
                     break;
 
                     // ----- 对手退出房间 -----
                     case 'R':           //对手退出房间处理
                     {
-                        on_Button_prepare_clicked();    //(游戏结束)调用准备按钮函数，相当于取消准备
+                        reset_prepare();    //(游戏结束)回到未准备状态
                         ui->label_prepare->show();
                         ui->label_victory->setText("对手退出了游戏");
                         ui->label_victory->show();
@@ -767,7 +660,7 @@ void internet_game::timerEvent(QTimerEvent *event)
                     // ----- 对手认输 -----
                     case 'S':           //对手认输处理
                     {
-                        on_Button_prepare_clicked();    //(游戏结束)调用准备按钮函数，相当于取消准备
+                        reset_prepare();    //(游戏结束)回到未准备状态
                         ui->label_prepare->show();
                         ui->label_victory->setText("对手已认输");
                         ui->label_victory->show();
@@ -825,7 +718,7 @@ void internet_game::timerEvent(QTimerEvent *event)
                     {
                         ui->label_anwser->setText("对手同意悔棋");
                         // 根据当前回合决定悔棋步数
-                        if(turn)
+                        if(my_turn())
                         {
                             go_back();go_back();     //己方回合后退2步（撤销对方和己方各一步）
                         }
@@ -970,6 +863,26 @@ void internet_game::on_Button_prepare_clicked()
     }
 }
 
+/**
+ * @brief 对局结束后回到未准备状态
+ *
+ * v2连接：服务器开局时已清除准备状态，这里只更新本地状态和界面，不发送"prepare"
+ * （发送会被服务器当作重新准备）；文本协议（旧服务器）仍按原来的方式发送"prepare"取消准备
+ */
+void internet_game::reset_prepare()
+{
+    if(client->protocol_version() < 2)
+    {
+        if(prepare)
+            on_Button_prepare_clicked();
+        return;
+    }
+    prepare=false;
+    ui->label_prepare->setText("请准备...");
+    ui->label_prepare->setStyleSheet("QLabel{color:rgba(255,0,0,0.6);}");   // 红色提示
+    ui->Button_prepare->setText("准备");
+}
+
 /**
  * @brief 选择黑棋（先手）按钮点击处理
  *
@@ -1017,8 +930,8 @@ void internet_game::on_btn_surrender_clicked()
 
     client->send_msg("OS");             //向服务器发送认输消息,通知对手已认输
 
-    // 本地处理：取消准备状态，显示结果
-    on_Button_prepare_clicked();
+    // 本地处理：回到未准备状态，显示结果
+    reset_prepare();
     ui->label_prepare->show();
     ui->label_victory->setText("你已认输");
     ui->label_victory->show();
@@ -1069,7 +982,7 @@ void internet_game::on_Button_send_clicked()
 void internet_game::on_btn_back_clicked()
 {
     // 游戏未开始、未选择颜色或没有落子记录时不能悔棋
-    if(!running || color == -1 || back.empty())
+    if(!running || color == -1 || game.moves() == 0)
         return;
 
     client->send_msg("OB");         //向服务器发送悔棋请求
@@ -1099,7 +1012,7 @@ void internet_game::on_button_agree_clicked()
     client->send_msg("OB1");         //向服务器发送悔棋同意信息
 
     // 根据当前回合决定悔棋步数
-    if(!turn)               //如果不是己方回合 则向前退回两步
+    if(!my_turn())          //如果不是己方回合 则向前退回两步
     {
         go_back();
         go_back();
@@ -1126,3 +1039,13 @@ void internet_game::on_button_refuse_clicked()
     client->send_msg("OB0");        //向服务器发送悔棋拒绝信息
     wait_over();
 }
+
+/**
+ * @brief 开局提示复选框 - 切换是否在棋盘上标出开局库中的后续着法
+ * @param checked 是否勾选
+ */
+void internet_game::on_check_book_toggled(bool checked)
+{
+    show_book = checked;
+    update();
+}
@@ -2,7 +2,6 @@
 #define INTERNET_GAME_H
 
 #include <QWidget>
-#include <QStack>
 #include <QLabel>
 #include <QCloseEvent>
 #include <QPainter>
@@ -15,6 +14,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <QMessageBox>
+#include "game_board.h"
+#include "opening_book.h"
 
 namespace Ui {
 class internet_game;
@@ -39,23 +40,26 @@ private:
     QPixmap black_chess;       //黑棋图片
     QPixmap board_bg;          //棋盘背景
 
-    QVector<QVector<QPair<QRect, int>>> chess_info;         //棋盘信息 记录每个点的落子颜色与落子范围等
-    QStack<QPair<int, int>> back;                          //所有落子信息 悔棋用
+    QVector<QVector<QRect>> chess_info;                    //每个点的落子范围
+    game_board game;                                       //棋局：棋盘、落子顺序、悔棋、轮次与胜负(与服务器共用gobang_core库)
 
     bool wait;//用于游戏运行中，一方发出悔棋、新游戏的请求后发出方持续的状态，这个状态下发出方将只等待处理对方的回应信息
-    bool turn;//用于游戏运行中，你的回合，为你的回合时才能下棋，但此时，依然可以点击悔棋、新游戏等按钮
     int timerId1;
     int color;//颜色，先后手，0为白棋，1为黑棋，其他值为游戏尚未开始
     bool running;//游戏运行与否，为false则代表游戏处于等待状态，需要两个玩家，并且都准备
     bool prepare;//存放准备按钮的值，0为未准备，1为准备。
     bool ban_mouse;     //是否禁用鼠标
 
+    opening_book book;          //开局库(core/opening_book.h)，用于开局提示
+    bool show_book = false;     //是否在棋盘上标出开局库中的后续着法
+
 public:
     void initialization();          //初始化棋盘
     void take_chess(int ,int );     //落子函数
-    void win(int x,int y);//判断胜利条件
+    bool my_turn() const;           //是否己方回合，为你的回合时才能下棋，但此时，依然可以点击悔棋、新游戏等按钮
     void go_back();                 //悔棋操作
     void get_prepare_information();
+    void reset_prepare();   //对局结束后回到未准备状态（v2连接不通知服务器）
     void wait_over();       //等待状态结束
 
 protected:
@@ -79,6 +83,7 @@ private slots:
     void on_btn_back_clicked();
     void on_button_agree_clicked();
     void on_button_refuse_clicked();
+    void on_check_book_toggled(bool checked);
 };
 
 #endif // INTERNET_GAME_H
@@ -81,6 +81,15 @@ Menu::Menu(QWidget *parent)
     //ui->tableView->setColumnWidth(2,50);  // 套接字列（已注释）
     ui->tableView->setColumnWidth(2,150);   // 进入房间按钮列
 
+    // 大厅推送在接收线程中到达，切换到界面线程后再更新房间列表
+    subscribed = false;
+    page_offset = 0;
+    page_total = 0;
+    page_rows_pending = 0;
+    page_refresh_pending = false;
+    client->set_lobby_listener([this](){
+        QMetaObject::invokeMethod(this, [this](){ apply_lobby_events(); }, Qt::QueuedConnection);
+    });
 }
 
 /**
@@ -94,6 +103,7 @@ Menu::Menu(QWidget *parent)
 Menu::~Menu()
 {
     qDebug() << "主页面析构~" <<Qt::endl;
+    client->set_lobby_listener(nullptr);
     delete client;          //释放网络信息传输对象内存
     delete tableModel;      // 释放表格模型内存
     delete ui;              // 释放UI内存
@@ -131,6 +141,10 @@ void Menu::timerEvent(QTimerEvent *event)
         // 显示绿色提示文字
         ui->connect_stat_label->setStyleSheet("QLabel{color:green}");
         ui->connect_stat_label->setText("已连接服务器-<创建或加入对局>");
+
+        // 连接成功后（且在大厅页面时）订阅大厅推送
+        if(!subscribed && this->isVisible())
+            subscribe_lobby();
         return;
     }
     // 状态3: 未连接
@@ -143,6 +157,7 @@ void Menu::timerEvent(QTimerEvent *event)
         // 显示红色提示文字
         ui->connect_stat_label->setStyleSheet("QLabel{color:red}");
         ui->connect_stat_label->setText("<请连接服务器>");
+        subscribed = false;         // 重新连接后需要重新订阅
         return;
     }
 }
@@ -257,6 +272,7 @@ void Menu::on_exit_net_btn_clicked()
     // 如果已连接，断开与服务器的连接
     if(client->isConnected())
         client->disconnect();
+    subscribed = false;
 
     // 切换回主菜单页面（索引0）
     ui->stackedWidget->setCurrentIndex(0);              //切回主页面
@@ -323,7 +339,7 @@ unsigned WINAPI connect_thread(void *arg)
  * 6. 连接游戏结束信号
  *
  * 消息协议：
- * - 格式: "C:房间名"
+ * - 格式: "C:房间名"（无禁手），勾选禁手规则时为 "C1:房间名"（连珠规则）
  * - C表示Create（创建）
  */
 //创建房间按钮功能实现
@@ -334,11 +350,13 @@ void Menu::on_create_btn_clicked()
         return;
 
     // 构造创建房间的消息
-    // 格式: "C:" + 房间名（从输入框获取）
-    QString create_str = "C:" + ui->LineEdit->text();       //房间名
+    // 格式: "C:" + 房间名（从输入框获取），连珠规则的房间在C后面带上规则号
+    QString create_str = (ui->check_renju->isChecked() ? QString("C%1:").arg(rule_renju) : QString("C:"))
+                         + ui->LineEdit->text();       //房间名
 
     // 发送创建房间请求
     int ret = client->send_msg(create_str);
+    subscribed = false;         // 服务器创建房间时退订大厅推送
 
     // 检查发送是否成功
     if(ret == SOCKET_ERROR)
@@ -366,97 +384,246 @@ void Menu::on_create_btn_clicked()
         qDebug() << "网络游戏结束" << Qt::endl;
         delete inter_game;      // 释放游戏窗口
         this->show();           //显示菜单
+        on_refresh_btn_clicked();   // 重新订阅大厅推送
     });
 }
 
 /**
  * @brief 刷新房间列表按钮点击事件处理
  *
- * 刷新流程：
- * 1. 清空消息队列
- * 2. 向服务器发送刷新请求"R"
- * 3. 等待服务器响应
- * 4. 解析响应数据（在线人数、房间列表）
- * 5. 清空并重建表格显示
- * 6. 为每个房间创建"开战"按钮并绑定事件
- *
- * 服务器响应数据格式：
- * 1. 在线人数（字符串）
- * 2. 空闲房间数量（字符串）
- * 3. 对于每个房间：房间名、IP地址、套接字FD
+ * 重新订阅大厅推送并查询当前页：
+ * 之后房间的新建、占满、关闭和在线人数变化都会主动推送，不再需要轮询和等待
  */
 //刷新战局按钮
 void Menu::on_refresh_btn_clicked()
 {
-    // 清空消息队列，避免旧消息干扰
-    client->clear();
-
-    // 未连接时不能刷新
+    // 未连接时无法刷新
     if(!client->isConnected())
         return ;
 
-    // 发送刷新请求
-    client->send_msg("R");                          //给服务器发送刷新请求
+    subscribe_lobby();
+}
 
-    // 等待服务器响应（阻塞300ms）
-    Sleep(300);
+/**
+ * @brief 订阅大厅推送并查询当前页
+ *
+ * 消息协议：
+ * - 发送: "S1"（只订阅增量，不需要全量房间列表）
+ * - 发送: "Q{偏移}/{条数}/{前缀}"（查询当前页）
+ * - 接收: 大厅推送事件和查询结果，由apply_lobby_events处理
+ */
+void Menu::subscribe_lobby()
+{
+    if(client->send_msg("S1") == SOCKET_ERROR)
+        return;
+    subscribed = true;
+    query_page();
+}
 
-    // 获取并显示在线人数
-    int people=client->get_msg().toInt();           //在消息队列中获取已连接的客户端数
-    ui->people_label->setText(QString("在线人数:%1").arg(people));
+/**
+ * @brief 查询当前页
+ *
+ * 房间按房间名排序，只返回房间名以筛选框内容开头的空闲房间
+ */
+void Menu::query_page()
+{
+    client->send_msg(QString("Q%1/%2/%3").arg(page_offset).arg(page_size).arg(ui->filter_edit->text()));
+}
 
-    // 获取空闲房间数量
-    string str=client->get_msg().toStdString();        //获取没有人加入的空闲房间
-    int sum=0;
-    // 将字符串转换为数字
-    for(int i=0;i<str.size();i++)
-        sum=sum*10+str[i]-'0';                              //字符串转数字
+/**
+ * @brief 大厅变化后稍后重新查询当前页
+ *
+ * 增量事件能立即移除已满或关闭的房间，但补位和总数需要重新查询；
+ * 100ms内的多次变化只查询一次
+ */
+void Menu::schedule_page_refresh()
+{
+    if(page_refresh_pending)
+        return;
+    page_refresh_pending = true;
+    QTimer::singleShot(100, this, [this](){
+        page_refresh_pending = false;
+        if(subscribed && client->isConnected())
+            query_page();
+    });
+}
 
-    // 清空现有的房间列表
-    tableModel->removeRows(0,tableModel->rowCount());       //先清空列表(初始化)
+/**
+ * @brief 更新页码显示和翻页按钮状态
+ */
+void Menu::update_page_label()
+{
+    int pages = (page_total + page_size - 1) / page_size;
+    if(pages == 0)
+        pages = 1;
+    ui->page_label->setText(QString("%1/%2页 共%3间").arg(page_offset / page_size + 1).arg(pages).arg(page_total));
+    ui->prev_page_btn->setDisabled(page_offset == 0);
+    ui->next_page_btn->setDisabled(page_offset + page_size >= page_total);
+}
 
-    // 遍历并显示每个空闲房间的信息
-    for(int i=0;i<sum;i++)                          //遍历列表显示每个空闲房间信息
-    {
-        QString get;
+/**
+ * @brief 上一页按钮点击事件处理
+ */
+void Menu::on_prev_page_btn_clicked()
+{
+    if(page_offset == 0 || !client->isConnected())
+        return;
+    page_offset = qMax(0, page_offset - page_size);
+    query_page();
+}
 
-        // 为每个房间创建"开战"按钮
-        QPushButton *button = new QPushButton("开战");
+/**
+ * @brief 下一页按钮点击事件处理
+ */
+void Menu::on_next_page_btn_clicked()
+{
+    if(page_offset + page_size >= page_total || !client->isConnected())
+        return;
+    page_offset += page_size;
+    query_page();
+}
 
-        // 获取并显示房间名
-        get=client->get_msg();
-        tableModel->setItem(i, 0, new QStandardItem(get));  //显示房间名
-        // 将房间名存储到按钮的自定义属性中，供join_game使用
-        button->setProperty("Name",get);        //设置属性
+/**
+ * @brief 筛选框内容变化时回到第一页重新查询
+ * @param text 房间名前缀
+ */
+void Menu::on_filter_edit_textChanged(const QString &text)
+{
+    Q_UNUSED(text);
+    page_offset = 0;
+    if(subscribed && client->isConnected())
+        query_page();
+}
 
-        // 获取并显示房间创建者的IP地址
-        get=client->get_msg();
-        tableModel->setItem(i, 1, new QStandardItem(get));  //显示IP地址
-        button->setProperty("Ip",get);
+/**
+ * @brief 按房间ID查找房间列表中的行
+ * @param id 房间ID
+ * @return int 行号，不存在返回-1
+ */
+int Menu::find_room_row(QString id)
+{
+    for(int i = 0; i < tableModel->rowCount(); i++)
+    {
+        QStandardItem *item = tableModel->item(i, 0);
+        if(item && item->data(Qt::UserRole).toString() == id)
+            return i;
+    }
+    return -1;
+}
 
-        // 获取房间创建者的套接字FD（不显示，但存储供加入时使用）
-        get=client->get_msg();
-        //tableModel->setItem(i, 2, new QStandardItem(get));  //显示套接字
-        button->setProperty("Fd",get);
+/**
+ * @brief 房间列表末尾添加一行
+ * @param id 房间ID（不显示，存储供加入时使用；64位整数，按字符串原样保存）
+ * @param ip 房主IP
+ * @param name 房间名
+ */
+void Menu::add_room_row(QString id, QString ip, QString name)
+{
+    int row = tableModel->rowCount();
+
+    // 显示房间名和IP地址，房间ID存在条目数据中供查找
+    QStandardItem *name_item = new QStandardItem(name);
+    name_item->setData(id, Qt::UserRole);
+    tableModel->setItem(row, 0, name_item);
+    tableModel->setItem(row, 1, new QStandardItem(ip));
+
+    // 为每个房间创建"开战"按钮，房间信息存储到按钮的自定义属性中，供join_game使用
+    QPushButton *button = new QPushButton("开战");
+    button->setProperty("Name", name);
+    button->setProperty("Ip", ip);
+    button->setProperty("Room", id);
+
+    // 将按钮放置到表格的第3列，绑定按钮点击事件到join_game函数
+    ui->tableView->setIndexWidget(tableModel->index(row, 2), button);
+    connect(button, &QPushButton::pressed, this, &Menu::join_game);
+}
 
-        // 将按钮放置到表格的第3列
-        ui->tableView->setIndexWidget(tableModel->index(i, 2), button);
+/**
+ * @brief 把收到的大厅推送和查询结果应用到房间列表
+ *
+ * 由接收线程通知，在界面线程中执行；同一批到达的事件一次处理完
+ *
+ * 事件格式：
+ * - LQ{匹配总数}/{偏移}/{本页条数}  查询结果，随后是本页的L+行
+ * - L+{房间ID}/{房主IP}/{房间名}    查询结果中的一行，或房间变为空闲（增量）
+ * - Lf{房间ID}                      房间已满，从列表移除
+ * - L-{房间ID}                      房间关闭，从列表移除
+ * - L#{在线人数}/{空闲房间数}
+ * - L*                              清空列表（全量同步时使用）
+ */
+void Menu::apply_lobby_events()
+{
+    QStringList events = client->take_lobby_events();
+    if(events.isEmpty())
+        return;
 
-        // 绑定按钮点击事件到join_game函数
-        connect(button,&QPushButton::pressed,this,&Menu::join_game);    //绑定join点击事件
+    for(int i = 0; i < events.size(); i++)
+    {
+        const QString &ev = events[i];
+        if(ev.size() < 2)
+            continue;
+        QString body = ev.mid(2);
+
+        switch(ev[1].unicode())
+        {
+            case '*':
+                tableModel->removeRows(0, tableModel->rowCount());
+                break;
+            case 'Q':
+                // 新的一页：清空列表，接下来的若干条L+是本页内容
+                tableModel->removeRows(0, tableModel->rowCount());
+                page_total = body.section('/', 0, 0).toInt();
+                page_offset = body.section('/', 1, 1).toInt();
+                page_rows_pending = body.section('/', 2, 2).toInt();
+                update_page_label();
+                break;
+            case '+':
+            {
+                // 房间名可能含有'/'，放在最后
+                QString id = body.section('/', 0, 0);
+                QString ip = body.section('/', 1, 1);
+                QString name = body.section('/', 2);
+                if(page_rows_pending > 0)
+                {
+                    page_rows_pending--;
+                    add_room_row(id, ip, name);
+                    break;
+                }
+                // 增量：已在本页的房间原地更新，符合筛选条件的新房间重新查询后补入
+                int row = find_room_row(id);
+                if(row >= 0)
+                {
+                    tableModel->removeRows(row, 1);
+                    add_room_row(id, ip, name);
+                }
+                else if(name.startsWith(ui->filter_edit->text()))
+                    schedule_page_refresh();
+                break;
+            }
+            case 'f':
+            case '-':
+            {
+                int row = find_room_row(body);
+                if(row >= 0)
+                {
+                    tableModel->removeRows(row, 1);
+                    schedule_page_refresh();
+                }
+                break;
+            }
+            case '#':
+                ui->people_label->setText(QString("在线人数:%1").arg(body.section('/', 0, 0).toInt()));
+                break;
+        }
     }
 
     // 根据是否有房间调整列宽
-    if(sum==0)
+    if(tableModel->rowCount() == 0)
         ui->tableView->setColumnWidth(0,265);
     else
         ui->tableView->setColumnWidth(0,250);
     ui->tableView->setColumnWidth(1,130);
     ui->tableView->setColumnWidth(2,150);
-    //ui->tableView->setColumnWidth(3,130);
-
-    // 清空消息队列
-    client->clear();                            //清空消息队列
 }
 
 /**
@@ -473,7 +640,7 @@ void Menu::on_refresh_btn_clicked()
  * 6. 成功则创建游戏窗口，失败则提示并刷新列表
  *
  * 消息协议：
- * - 发送: "J" + 房间FD（加入请求）
+ * - 发送: "J" + 房间ID（加入请求）
  * - 接收: "success" 或 失败消息
  */
 //加入房间按钮
@@ -487,13 +654,16 @@ void Menu::join_game()
     QPushButton *button = (QPushButton *)sender();      //获取信号发送者对象(join按钮)
 
     // 构造加入房间的消息
-    // 格式: "J" + 目标房间的套接字FD
-    QString msg="J"+button->property("Fd").toString();
+    // 格式: "J" + 目标房间ID
+    QString msg="J"+button->property("Room").toString();
 
     // 未连接时不能加入房间
     if(!client->isConnected())
         return;
 
+    // 服务器收到加入请求后退订大厅推送，失败时由on_refresh_btn_clicked重新订阅
+    subscribed = false;
+
     // 发送加入请求
     int ret=client->send_msg(msg);
     qDebug() << "send msg:" << msg << Qt::endl;
@@ -518,7 +688,7 @@ void Menu::join_game()
 
     // 加入成功，清空消息队列
     client->clear();
-    qDebug()<<"已加入房间,套接字:"<<button->property("Fd").toString()<<Qt::endl;
+    qDebug()<<"已加入房间,房间ID:"<<button->property("Room").toString()<<Qt::endl;
 
     // 清空房间列表
     tableModel->removeRows(0,tableModel->rowCount());
@@ -31,6 +31,21 @@ public:
 
     void join_game();
 
+    bool subscribed;            //是否已订阅大厅推送
+    void subscribe_lobby();     //订阅大厅推送(只推送增量)并查询当前页
+    void apply_lobby_events();  //把收到的大厅推送应用到房间列表
+    int find_room_row(QString id);      //按房间ID查找房间列表中的行(不存在返回-1)
+    void add_room_row(QString id, QString ip, QString name);    //房间列表中添加一行
+
+    static const int page_size = 20;    //每页房间数
+    int page_offset;            //当前页第一个房间的名次
+    int page_total;             //符合筛选条件的空闲房间总数
+    int page_rows_pending;      //查询结果中尚未收到的房间行数
+    bool page_refresh_pending;  //是否已安排重新查询当前页
+    void query_page();          //查询当前页(Q请求)
+    void schedule_page_refresh();       //大厅变化后稍后重新查询当前页(合并短时间内的多次变化)
+    void update_page_label();   //更新页码显示和翻页按钮状态
+
 private slots:
     void on_local_game_btn_clicked();
 
@@ -48,6 +63,12 @@ private slots:
 
     void on_refresh_btn_clicked();
 
+    void on_prev_page_btn_clicked();
+
+    void on_next_page_btn_clicked();
+
+    void on_filter_edit_textChanged(const QString &text);
+
 private:
     Ui::Menu *ui;
 };
@@ -0,0 +1,24 @@
+#include "renju_hint.h"
+
+void draw_forbidden_marks(QPainter &painter, const game_board &game, int square)
+{
+    if(game.rule() != rule_renju || game.over() || game.to_move() != stone_black)
+        return;
+
+    painter.save();
+    QPen pen(QColor(220, 0, 0));
+    pen.setWidth(3);
+    painter.setPen(pen);
+    int r = square / 5;
+    for(int cell = 0; cell < board_cells; cell++)
+    {
+        //game_board::forbidden先按附近的黑子数筛选(已有棋子的点直接返回forbid_none)，并缓存上次的结果(落子后只重新判定经过它的4条线)，整盘逐点判定的开销很小
+        if(game.forbidden(cell) == forbid_none)
+            continue;
+        int x = (cell / board_size + 1) * square;
+        int y = (cell % board_size + 1) * square;
+        painter.drawLine(x - r, y - r, x + r, y + r);
+        painter.drawLine(x - r, y + r, x + r, y - r);
+    }
+    painter.restore();
+}
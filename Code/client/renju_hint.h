@@ -0,0 +1,16 @@
+/*
+ * 禁手提示
+ * 连珠规则下轮到黑方时，在棋盘上标出黑方的禁手点(core/renju.h)，本地对战和网络对战共用
+*/
+
+#ifndef RENJU_HINT_H
+#define RENJU_HINT_H
+
+#include <QPainter>
+#include "game_board.h"
+
+//连珠规则、对局未结束且轮到黑方时，在每个禁手点上画一个红叉
+//square为格子边长，第i行第j列交叉点的中心在((i+1)*square, (j+1)*square)
+void draw_forbidden_marks(QPainter &painter, const game_board &game, int square);
+
+#endif // RENJU_HINT_H
@@ -0,0 +1,669 @@
+/**
+ * @file bench.cpp
+ * @brief gobang_core库基准测试（不依赖Qt和网络，Linux下直接用g++编译）
+ *
+ * - 五连判定：客户端原来的逐格扫描 vs 位棋盘，在同样的随机对局上比较每步的用时
+ * - 整局规则：game_board落子到分出胜负、再全部悔棋，比较每步落子和悔棋的用时
+ * - 电脑对手：限时搜索对只搜2层的搜索，交换先后手各下若干局，统计胜负、每秒节点数和超时
+ * - 置换表：在固定的一组局面上搜到固定深度，比较不用和使用置换表的节点数、用时和命中率
+ * - 多线程：同一组局面用1/2/4/.../最大线程数搜到同一深度，比较到达该深度的用时和每秒节点数
+ * - 开局库：随机对局生成数百万个局面的开局库，测量生成、打开（映射）和查询的用时
+ * - 连珠禁手：随机的连珠对局中每个空位，比较game_board::forbidden()与按定义逐格递归的判定的用时；
+ *   再让电脑在连珠规则下对局，统计胜负和每秒节点数
+ *
+ * 只计时，不检查结果；规则、禁手、开局库和搜索的正确性由test.cpp（make test）检查
+ *
+ * 用法: ./bench [对局数] [电脑对局数] [每步毫秒] [置换表/多线程测试深度] [最大线程数]
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<time.h>
+#include<vector>
+#include<algorithm>
+
+#include "bitboard.h"
+#include "game_board.h"
+#include "engine.h"
+#include "opening_book.h"
+#include "zobrist.h"
+
+using namespace std;
+
+/* ==================== 计时工具 ==================== */
+
+static double now_sec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+/**
+ * @brief 生成n局随机落子顺序（每局是0~cells-1的一个排列）
+ */
+static void shuffle_games(vector<uint16_t> &order,int n,int cells)
+{
+    for(int g=0;g<n;g++)
+    {
+        uint16_t* p=&order[g*cells];
+        for(int k=0;k<cells;k++)
+            p[k]=(uint16_t)k;
+        for(int k=cells-1;k>0;k--)
+            swap(p[k],p[rand()%(k+1)]);
+    }
+}
+
+/* ==================== 五连判定 ==================== */
+
+/**
+ * @brief 客户端原来的棋盘格：点击区域（QRect）+ 落子颜色
+ */
+struct old_cell
+{
+    int rect[4];
+    int color;      // -1空 0白 1黑
+};
+
+/**
+ * @brief 客户端原来的胜负判断：从落子点向4对方向逐格扫描（与GameWin/internet_game的win相同）
+ */
+static bool old_five(const vector<vector<old_cell> > &chess_info,int x,int y,int color)
+{
+    int dir1[4][2]={{0,1},{1,1},{1,0},{1,-1}};
+    int dir2[4][2]={{0,-1},{-1,-1},{-1,0},{-1,1}};
+    int size=(int)chess_info.size();
+    for(int i=0;i<4;i++)
+    {
+        int sum=0;
+        int a=x,b=y;
+        for(int j=0;j<=4;j++)
+        {
+            a+=dir1[i][0];
+            b+=dir1[i][1];
+            if(a>=0&&b>=0&&a<size&&b<size&&chess_info[a][b].color==color)
+                sum++;
+            else
+                break;
+        }
+        a=x,b=y;
+        for(int j=0;j<=4;j++)
+        {
+            a+=dir2[i][0];
+            b+=dir2[i][1];
+            if(a>=0&&b>=0&&a<size&&b<size&&chess_info[a][b].color==color)
+                sum++;
+            else
+                break;
+        }
+        if(sum>=4)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 五连判定：随机对局（随机落点，双方交替，出现五连或下满为止），两种实现各走一遍
+ *
+ * 每批先生成对局的落子顺序，再分别用两种实现走完这一批，计时只包含落子和判定
+ */
+template<int N>
+static void bench_win(int games)
+{
+    const int cells=N*N;
+    const int batch=1000;
+    vector<uint16_t>order(batch*cells);
+    vector<vector<old_cell> >chess_info(N,vector<old_cell>(N));
+    bitboard<N> board;
+    double t_old=0,t_new=0;
+    long long checks=0;
+    srand(1357);
+
+    for(int done=0;done<games;done+=batch)
+    {
+        int n=min(batch,games-done);
+        shuffle_games(order,n,cells);
+
+        // 落子直到某一方五连或下满
+        double t0=now_sec();
+        for(int g=0;g<n;g++)
+        {
+            const uint16_t* p=&order[g*cells];
+            for(int x=0;x<N;x++)
+                for(int y=0;y<N;y++)
+                    chess_info[x][y].color=-1;
+            int k;
+            for(k=0;k<cells;k++)
+            {
+                int x=p[k]/N,y=p[k]%N,color=k%2?0:1;
+                chess_info[x][y].color=color;
+                if(old_five(chess_info,x,y,color))
+                    break;
+            }
+        }
+        double t1=now_sec();
+        for(int g=0;g<n;g++)
+        {
+            const uint16_t* p=&order[g*cells];
+            board.clear();
+            int k;
+            for(k=0;k<cells;k++)
+            {
+                int x=p[k]/N,y=p[k]%N,color=k%2?0:1;
+                board.place(color,x,y);
+                if(board.five(color,x,y))
+                    break;
+            }
+            checks+=k<cells?k+1:k;
+        }
+        double t2=now_sec();
+        t_old+=t1-t0;
+        t_new+=t2-t1;
+    }
+
+    printf("win %2dx%-2d %7d games %9lld moves: scan %7.1f ns/move   bitboard %7.1f ns/move   (%.2fx)\n",
+        N,N,games,checks,t_old*1e9/checks,t_new*1e9/checks,t_old/t_new);
+}
+
+/* ==================== 整局规则 ==================== */
+
+/**
+ * @brief 整局规则：随机对局用game_board下到结束，再悔棋到空棋盘
+ */
+static void bench_rules(int games)
+{
+    const int batch=1000;
+    vector<uint16_t>order(batch*board_cells);
+    vector<game_board>boards(batch);
+    double t_play=0,t_undo=0;
+    long long played=0;
+    srand(8642);
+
+    for(int done=0;done<games;done+=batch)
+    {
+        int n=min(batch,games-done);
+        shuffle_games(order,n,board_cells);
+
+        double t0=now_sec();
+        for(int g=0;g<n;g++)
+        {
+            const uint16_t* p=&order[g*board_cells];
+            game_board &b=boards[g];
+            b.reset();
+            for(int k=0;b.play(p[k])==play_ok;k++)
+                ;
+        }
+        double t1=now_sec();
+        for(int g=0;g<n;g++)
+        {
+            played+=boards[g].moves();
+            while(boards[g].undo())
+                ;
+        }
+        double t2=now_sec();
+        t_play+=t1-t0;
+        t_undo+=t2-t1;
+
+    }
+
+    printf("rules %7d games %9lld moves: play %7.1f ns/move   undo %7.1f ns/move\n",
+        games,played,t_play*1e9/played,t_undo*1e9/played);
+}
+
+/* ==================== 连珠禁手 ==================== */
+
+/**
+ * @brief 按定义逐格判定的黑方禁手（带越界检查，不限制读取范围），作为用时的参照
+ */
+struct renju_reference
+{
+    int b[board_size][board_size];
+
+    explicit renju_reference(const game_board &game)
+    {
+        for(int x=0;x<board_size;x++)
+            for(int y=0;y<board_size;y++)
+                b[x][y]=game.at(x,y);
+    }
+
+    bool black(int x,int y) const
+    {
+        return x>=0&&y>=0&&x<board_size&&y<board_size&&b[x][y]==stone_black;
+    }
+
+    bool empty(int x,int y) const
+    {
+        return x>=0&&y>=0&&x<board_size&&y<board_size&&b[x][y]==stone_none;
+    }
+
+    // (x,y)所在的连续黑子：返回长度，first为靠负方向一端的偏移
+    int run(int x,int y,int dx,int dy,int* first=0) const
+    {
+        int lo=0,hi=0;
+        while(black(x+(lo-1)*dx,y+(lo-1)*dy))
+            lo--;
+        while(black(x+(hi+1)*dx,y+(hi+1)*dy))
+            hi++;
+        if(first)
+            *first=lo;
+        return hi-lo+1;
+    }
+
+    // 这条线上再下一子能使(x,y)所在的连子恰好为5的空位数，两个空位是同一个活四的两端时算一个
+    int fours(int x,int y,int dx,int dy)
+    {
+        int points[9],n=0;
+        for(int k=-4;k<=4;k++)
+        {
+            int ex=x+k*dx,ey=y+k*dy;
+            if(!empty(ex,ey))
+                continue;
+            b[ex][ey]=stone_black;
+            if(run(x,y,dx,dy)==5)
+                points[n++]=k;
+            b[ex][ey]=stone_none;
+        }
+        if(n==2&&points[1]-points[0]==5&&run(x,y,dx,dy)==4)
+            n=1;
+        return n;
+    }
+
+    // (x,y)所在的连续4子两端都是空位且都能恰好连五
+    bool straight_four(int x,int y,int dx,int dy) const
+    {
+        int lo;
+        if(run(x,y,dx,dy,&lo)!=4)
+            return false;
+        int hi=lo+3;
+        return empty(x+(lo-1)*dx,y+(lo-1)*dy)&&empty(x+(hi+1)*dx,y+(hi+1)*dy)
+            &&!black(x+(lo-2)*dx,y+(lo-2)*dy)&&!black(x+(hi+2)*dx,y+(hi+2)*dy);
+    }
+
+    // 这条线上再下一个不是禁手的子能形成活四
+    bool three(int x,int y,int dx,int dy)
+    {
+        for(int k=-4;k<=4;k++)
+        {
+            int ex=x+k*dx,ey=y+k*dy;
+            if(!empty(ex,ey))
+                continue;
+            b[ex][ey]=stone_black;
+            bool ok=straight_four(x,y,dx,dy);
+            b[ex][ey]=stone_none;
+            if(ok&&forbidden(ex,ey)==forbid_none)
+                return true;
+        }
+        return false;
+    }
+
+    int forbidden(int x,int y)
+    {
+        static const int dx[4]={0,1,1,1},dy[4]={1,0,1,-1};
+        b[x][y]=stone_black;
+        bool five=false,overline=false;
+        int four=0,threes=0,f[4];
+        for(int d=0;d<4;d++)
+        {
+            int len=run(x,y,dx[d],dy[d]);
+            five|=len==5;
+            overline|=len>5;
+            four+=f[d]=fours(x,y,dx[d],dy[d]);
+        }
+        int result=forbid_none;
+        if(!five&&overline)
+            result=forbid_overline;
+        else if(!five&&four>=2)
+            result=forbid_double_four;
+        else if(!five)
+        {
+            for(int d=0;d<4;d++)
+                threes+=!f[d]&&three(x,y,dx[d],dy[d]);
+            if(threes>=2)
+                result=forbid_double_three;
+        }
+        b[x][y]=stone_none;
+        return result;
+    }
+};
+
+/**
+ * @brief 随机连珠对局上的禁手判定，以及连珠规则下的电脑对局
+ */
+static void bench_renju(int positions,int engine_games,int time_ms)
+{
+    // 随机对局：中心9x9内随机落子（黑方的禁手点被拒绝后重选），逐个空位比对
+    vector<game_board> boards;
+    srand(1357);
+    for(int g=0;(int)boards.size()<positions;g++)
+    {
+        game_board game(rule_renju);
+        int plies=20+g%40;
+        for(int k=0;k<plies&&!game.over();k++)
+        {
+            int tries=0;
+            while(game.play((7+rand()%9-4)*board_size+7+rand()%9-4)<0&&++tries<1000)
+                ;
+        }
+        if(!game.over())
+            boards.push_back(game);
+    }
+    // 第一遍从空的缓存开始判定；第二遍读缓存；最后悔一步棋再判定（只有经过悔掉的棋子的4条线要重新判定）
+    for(size_t g=0;g<boards.size();g++)
+        boards[g].set_rule(rule_renju);
+    int kinds[4]={0,0,0,0};
+    long long checks=0,undo_checks=0;
+    double t0=now_sec();
+    for(size_t g=0;g<boards.size();g++)
+        for(int cell=0;cell<board_cells;cell++)
+        {
+            checks+=boards[g].at(cell)==stone_none;
+            kinds[boards[g].forbidden(cell)]++;
+        }
+    double t1=now_sec();
+    for(size_t g=0;g<boards.size();g++)
+    {
+        renju_reference ref(boards[g]);
+        for(int cell=0;cell<board_cells;cell++)
+            if(boards[g].at(cell)==stone_none)
+                ref.forbidden(cell/board_size,cell%board_size);
+    }
+    double t2=now_sec();
+    int cached=0;
+    for(size_t g=0;g<boards.size();g++)
+        for(int cell=0;cell<board_cells;cell++)
+            cached+=boards[g].forbidden(cell);
+    double t3=now_sec();
+    for(size_t g=0;g<boards.size();g++)
+    {
+        boards[g].undo();
+        for(int cell=0;cell<board_cells;cell++)
+        {
+            undo_checks+=boards[g].at(cell)==stone_none;
+            cached+=boards[g].forbidden(cell);
+        }
+    }
+    double t4=now_sec();
+
+    // 连珠规则下的电脑对局
+    engine timed,shallow;
+    int results[3]={0,0,0};
+    long long nodes=0,ms=0;
+    for(int g=0;g<engine_games;g++)
+    {
+        game_board game(rule_renju);
+        int timed_color=g%2?stone_white:stone_black;
+        srand(9753+g/2);
+        game.play(board_cells/2);
+        while(game.play((7+rand()%5-2)*board_size+7+rand()%5-2)<0)
+            ;
+        while(!game.over())
+        {
+            search_result r;
+            if(game.to_move()==timed_color)
+            {
+                r=timed.think(game,time_ms);
+                nodes+=r.nodes;
+                ms+=r.time_ms;
+            }
+            else
+                r=shallow.think(game,time_ms,2);
+            if(game.play(r.move)<0)
+                break;
+        }
+        results[game.winner()==stone_none?2:game.winner()]++;
+    }
+
+    printf("renju %6d positions %9lld cells: forbidden %6.1f ns/cell   reference %8.1f ns/cell   "
+        "double three %d   double four %d   overline %d\n",
+        (int)boards.size(),checks,(t1-t0)*1e9/checks,(t2-t1)*1e9/checks,
+        kinds[forbid_double_three],kinds[forbid_double_four],kinds[forbid_overline]);
+    printf("renju cache: cached %6.1f ns/cell   after undo %6.1f ns/cell   (%d)\n",
+        (t3-t2)*1e9/checks,(t4-t3)*1e9/undo_checks,cached);
+    printf("renju engine %4d games %5d ms/move: black +%d white +%d =%d   %.0f knodes/s\n",
+        engine_games,time_ms,results[stone_black],results[stone_white],results[2],ms?(double)nodes/ms:0.0);
+}
+
+/* ==================== 电脑对手 ==================== */
+
+/**
+ * @brief 限时搜索（time_ms）对只搜2层的搜索（两边都有算杀），双方交替执黑
+ *
+ * 统计限时一方的胜负、α-β搜索完成的平均深度、每秒节点数和单步最长用时
+ */
+static void bench_engine(int games,int time_ms)
+{
+    engine timed,shallow;
+    int wins=0,losses=0,draws=0,max_ms=0;
+    long long nodes=0,ms=0,depth_sum=0,searches=0,probes=0,hits=0;
+
+    for(int g=0;g<games;g++)
+    {
+        game_board game;
+        int timed_color=g%2?stone_white:stone_black;
+        // 第一步天元，第二步随机放在周围两格内；每个开局交换先后手各下一局
+        srand(4321+g/2);
+        game.play(board_cells/2);
+        while(game.play((7+rand()%5-2)*board_size+7+rand()%5-2)==play_illegal)
+            ;
+        while(!game.over())
+        {
+            search_result r;
+            if(game.to_move()==timed_color)
+            {
+                r=timed.think(game,time_ms);
+                nodes+=r.nodes;
+                ms+=r.time_ms;
+                probes+=r.tt_probes;
+                hits+=r.tt_hits;
+                max_ms=max(max_ms,r.time_ms);
+                if(r.kind==search_alphabeta)
+                {
+                    depth_sum+=r.depth;
+                    searches++;
+                }
+            }
+            else
+                r=shallow.think(game,time_ms,2);
+            game.play(r.move);
+        }
+        if(game.winner()==timed_color)
+            wins++;
+        else if(game.winner()==stone_none)
+            draws++;
+        else
+            losses++;
+    }
+
+    printf("engine %4d games %5d ms/move: +%d -%d =%d vs depth 2   avg depth %.1f   %.0f knodes/s   tt hits %.1f%%   max %d ms/move\n",
+        games,time_ms,wins,losses,draws,searches?(double)depth_sum/searches:0.0,ms?(double)nodes/ms:0.0,
+        probes?100.0*hits/probes:0.0,max_ms);
+}
+
+/**
+ * @brief 固定的一组局面：与bench_engine相同的开局，再由只搜2层的搜索双方各走若干步，
+ *        只保留需要α-β搜索的局面（算杀直接找到结果的局面与置换表无关）
+ */
+static vector<game_board> hash_positions(int count)
+{
+    vector<game_board> positions;
+    engine shallow(0);
+    for(int g=0;(int)positions.size()<count&&g<count*4;g++)
+    {
+        game_board game;
+        srand(4321+g);
+        game.play(board_cells/2);
+        while(game.play((7+rand()%5-2)*board_size+7+rand()%5-2)==play_illegal)
+            ;
+        for(int k=0;k<4+g%8&&!game.over();k++)
+            game.play(shallow.think(game,1000000,2).move);
+        if(!game.over()&&shallow.think(game,1000000,1).kind==search_alphabeta)
+            positions.push_back(game);
+    }
+    return positions;
+}
+
+/**
+ * @brief 不用和使用置换表各搜到depth层（不限时间），比较节点数、用时和命中率
+ *
+ * 每个局面前清空置换表，用时即到达该深度的时间（包括两者相同的算杀阶段）；选出不同落子的局面数只作参考
+ * （置换表改变了搜索顺序和截断，同分的着法可能不同）
+ */
+static void bench_hash(int count,int depth)
+{
+    vector<game_board> positions=hash_positions(count);
+    engine plain(0),hashed;
+    long long nodes[2]={0,0},ab_nodes[2]={0,0},probes=0,hits=0;
+    double sec[2]={0,0};
+    int differ=0;
+    for(size_t i=0;i<positions.size();i++)
+    {
+        search_result r[2];
+        for(int k=0;k<2;k++)
+        {
+            engine &e=k?hashed:plain;
+            e.clear_hash();
+            double t0=now_sec();
+            r[k]=e.think(positions[i],100000000,depth);
+            sec[k]+=now_sec()-t0;
+            nodes[k]+=r[k].nodes;
+            ab_nodes[k]+=r[k].ab_nodes;
+        }
+        probes+=r[1].tt_probes;
+        hits+=r[1].tt_hits;
+        differ+=r[0].move!=r[1].move;
+    }
+    for(int k=0;k<2;k++)
+        printf("hash %s %3d positions depth %d: %10lld nodes (alpha-beta %10lld) %8.1f ms/position %6.0f knodes/s\n",
+            k?"on ":"off",(int)positions.size(),depth,nodes[k],ab_nodes[k],
+            positions.empty()?0.0:sec[k]*1e3/positions.size(),sec[k]?nodes[k]/sec[k]/1e3:0.0);
+    printf("hash on: %.1f%% hits   %.2fx fewer alpha-beta nodes   %.2fx faster to depth   %d/%d different moves\n",
+        probes?100.0*hits/probes:0.0,ab_nodes[1]?(double)ab_nodes[0]/ab_nodes[1]:0.0,sec[1]?sec[0]/sec[1]:0.0,
+        differ,(int)positions.size());
+}
+
+/**
+ * @brief 1、2、4……max_threads个线程各搜到depth层（不限时间，每个局面前清空置换表）
+ *
+ * 到达深度的总用时包括单线程的算杀阶段，加速比按多线程的α-β搜索阶段计算；
+ * 机器的核数少于线程数时多出的线程只会分走时间，加速比会下降
+ */
+static void bench_smp(int count,int depth,int max_threads)
+{
+    vector<game_board> positions=hash_positions(count);
+    engine e;
+    double base=0;
+    for(int threads=1;threads<=max_threads;threads*=2)
+    {
+        e.set_threads(threads);
+        long long nodes=0,ab_nodes=0,ab_ms=0,depth_sum=0;
+        double sec=0;
+        for(size_t i=0;i<positions.size();i++)
+        {
+            e.clear_hash();
+            double t0=now_sec();
+            search_result r=e.think(positions[i],100000000,depth);
+            sec+=now_sec()-t0;
+            nodes+=r.nodes;
+            ab_nodes+=r.ab_nodes;
+            ab_ms+=r.ab_time_ms;
+            depth_sum+=r.depth;
+        }
+        if(threads==1)
+            base=(double)ab_ms;
+        int n=max((int)positions.size(),1);
+        printf("smp %2d threads %3d positions depth %d: %8.1f ms/position to depth (alpha-beta %8.1f ms, %5.2fx)   %7.0f knodes/s   avg depth %.1f\n",
+            threads,(int)positions.size(),depth,sec*1e3/n,(double)ab_ms/n,ab_ms?base/ab_ms:0.0,
+            ab_ms?(double)ab_nodes/ab_ms:0.0,(double)depth_sum/n);
+    }
+}
+
+/* ==================== 开局库 ==================== */
+
+/**
+ * @brief 整局棋按对称变换t变换后的前moves步
+ */
+static game_board transform_game(const game_board &game,int t,int moves)
+{
+    game_board out;
+    for(int i=0;i<moves;i++)
+        out.play(book_transform(t,game.move(i)));
+    return out;
+}
+
+/**
+ * @brief games局天元附近的随机对局，每局记入前plies步，生成开局库后映射并查询
+ */
+static void bench_book(int games,int plies)
+{
+    const char* path="bench.book";
+    vector<game_board> sample;
+    book_builder builder;
+    srand(2468);
+    double t0=now_sec();
+    for(int g=0;g<games;g++)
+    {
+        game_board game;
+        for(int k=0;k<plies&&!game.over();k++)
+            while(game.play((7+rand()%9-4)*board_size+7+rand()%9-4)==play_illegal)
+                ;
+        builder.add_game(game,plies);
+        if(g%997==0&&game.moves()==plies)
+            sample.push_back(game);
+    }
+    double t1=now_sec();
+    if(!builder.write(path))
+    {
+        perror(path);
+        exit(1);
+    }
+    double t2=now_sec();
+
+    const int opens=100;
+    opening_book book;
+    for(int i=0;i<opens;i++)
+        if(!book.open(path))
+        {
+            printf("book: cannot open %s\n",path);
+            exit(1);
+        }
+    double t3=now_sec();
+
+    // 随机局面查询的用时（多数不在库中）
+    book_continuation c[board_cells];
+    long long found=0;
+    const int probes=200000;
+    for(int i=0;i<probes;i++)
+    {
+        const game_board &s=sample[i%sample.size()];
+        found+=book.lookup(transform_game(s,i%8,1+i%(plies-1)),c,board_cells)>0;
+    }
+    double t5=now_sec();
+    for(int i=0;i<probes;i++)
+        transform_game(sample[i%sample.size()],i%8,1+i%(plies-1));
+    double t6=now_sec();
+    book.close();
+    remove(path);
+
+    printf("book %8zu positions %8zu moves: build %6.0f ms   write %6.0f ms   open %7.3f ms   lookup %6.0f ns   found %lld/%d\n",
+        builder.positions(),builder.moves(),(t1-t0)*1e3,(t2-t1)*1e3,(t3-t2)*1e3/opens,
+        ((t5-t3)-(t6-t5))*1e9/probes,found,probes);
+}
+
+int main(int argc,char* argv[])
+{
+    int games=argc>1?atoi(argv[1]):1000000;
+    int engine_games=argc>2?atoi(argv[2]):10;
+    int time_ms=argc>3?atoi(argv[3]):100;
+    int hash_depth=argc>4?atoi(argv[4]):8;
+    int max_threads=argc>5?atoi(argv[5]):32;
+
+    bench_win<15>(games);
+    bench_win<19>(games);
+    bench_rules(games);
+    bench_book(games/10,20);
+    bench_renju(games/100,engine_games,time_ms);
+    bench_engine(engine_games,time_ms);
+    bench_hash(12,hash_depth);
+    bench_smp(12,hash_depth,max_threads);
+    return 0;
+}
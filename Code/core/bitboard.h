@@ -0,0 +1,160 @@
+/**
+ * @file bitboard.h
+ * @brief 按位存储的棋盘与五连判定（本地对战、网络对战和服务器共用）
+ *
+ * 每种颜色每行一个位掩码，rows[颜色][x]的第y位表示(x,y)上有该颜色的棋子。
+ * 15路棋盘每行用16位，两种颜色共60字节；19路棋盘每行用32位。
+ *
+ * 五连判定全部是移位与按位与，不逐格检查边界：
+ * - 横线：m&(m>>1)&(m>>2)&(m>>3)&(m>>4) 的第j位为1，表示第j~j+4位都是1
+ * - 竖线：连续5行直接相与，第y位为1表示这5行的第y列都有子
+ * - 斜线：第k行右移k位后相与（左上到右下），或左移k位后相与（右上到左下）
+ * 判断某一点是否构成五连时，只看包含该点的窗口和该点所在的那一位
+ *
+ * 本文件只依赖C++标准库，不依赖Qt
+ */
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include<stdint.h>
+#include<string.h>
+
+/**
+ * @brief 棋子颜色（与客户端界面一致：1黑 0白 -1空）
+ */
+enum stone
+{
+    stone_none=-1,
+    stone_white=0,
+    stone_black=1
+};
+
+/**
+ * @brief 行掩码的类型：不超过16路用16位，否则用32位
+ */
+template<int N> struct bitboard_row { typedef uint32_t type; };
+template<> struct bitboard_row<15> { typedef uint16_t type; };
+
+template<int N>
+class bitboard
+{
+public:
+    typedef typename bitboard_row<N>::type row_type;
+    static const int size=N;        // 棋盘边长
+    static const int cells=N*N;     // 格子数
+
+    bitboard() { clear(); }
+
+    /**
+     * @brief 清空棋盘
+     */
+    void clear() { memset(rows,0,sizeof(rows)); }
+
+    /**
+     * @brief (x,y)上的棋子（stone）
+     */
+    int at(int x,int y) const
+    {
+        if(rows[stone_black][x]>>y&1)
+            return stone_black;
+        if(rows[stone_white][x]>>y&1)
+            return stone_white;
+        return stone_none;
+    }
+
+    /**
+     * @brief (x,y)是否为空位
+     */
+    bool empty(int x,int y) const { return !((rows[0][x]|rows[1][x])>>y&1); }
+
+    /**
+     * @brief 在(x,y)放一个color的棋子（调用者保证该点为空）
+     */
+    void place(int color,int x,int y) { rows[color][x]|=(row_type)(1u<<y); }
+
+    /**
+     * @brief 移除(x,y)上的棋子
+     */
+    void remove(int x,int y)
+    {
+        row_type mask=(row_type)~(1u<<y);
+        rows[0][x]&=mask;
+        rows[1][x]&=mask;
+    }
+
+    /**
+     * @brief color在(x,y)上的子是否处在某条五连（或更长的连珠）中
+     */
+    bool five(int color,int x,int y) const
+    {
+        const row_type* r=rows[color];
+
+        // 横线：第y-4~y位中任意一位开始的5位全为1
+        uint32_t low=(uint32_t)(y>=4?y-4:0);
+        if(run(r[x])>>low&((1u<<(y-low+1))-1))
+            return true;
+
+        // 竖线和斜线：包含第x行的每个5行窗口
+        int first=x>=4?x-4:0;
+        int last=x<=N-5?x:N-5;
+        for(int s=first;s<=last;s++)
+        {
+            int k=x-s;      // (x,y)是窗口中的第k行
+            uint32_t v=r[s],d=r[s],a=r[s];
+            for(int i=1;i<5;i++)
+            {
+                uint32_t row=r[s+i];
+                v&=row;
+                d&=row>>i;
+                a&=row<<i;
+            }
+            // v的第y位：第y列；d的第y-k位：从(s,y-k)开始向右下；a的第y+k位：从(s,y+k)开始向左下
+            if(v>>y&1)
+                return true;
+            if(y-k>=0&&d>>(y-k)&1)
+                return true;
+            if(a>>(y+k)&1)
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief 整个棋盘上color是否有五连（不知道最后一步时使用，如载入棋局）
+     */
+    bool any_five(int color) const
+    {
+        const row_type* r=rows[color];
+        for(int x=0;x<N;x++)
+            if(run(r[x]))
+                return true;
+        for(int s=0;s+5<=N;s++)
+        {
+            uint32_t v=r[s],d=r[s],a=r[s];
+            for(int i=1;i<5;i++)
+            {
+                uint32_t row=r[s+i];
+                v&=row;
+                d&=row>>i;
+                a&=row<<i;
+            }
+            if(v|d|a)
+                return true;
+        }
+        return false;
+    }
+
+private:
+    /**
+     * @brief 第j位为1表示m的第j~j+4位都是1
+     */
+    static uint32_t run(uint32_t m)
+    {
+        return m&(m>>1)&(m>>2)&(m>>3)&(m>>4);
+    }
+
+    row_type rows[2][N];    // rows[颜色][x]
+};
+
+#endif // BITBOARD_H
@@ -0,0 +1,110 @@
+/**
+ * @file book.cpp
+ * @brief 开局库工具：用电脑自我对局生成开局库，查询局面的后续着法（不依赖Qt，Linux下直接用g++编译）
+ *
+ * 用法:
+ *   ./book build 文件 [对局数=200] [记入步数=12] [每步毫秒=100] [线程数=1]
+ *       开局第一步天元、第二步随机放在周围两格内，之后双方都由电脑走；
+ *       每局的前若干步记入对局统计，电脑在这些局面上的评分一起记入
+ *   ./book show 文件 [x,y ...]
+ *       按给出的落子顺序摆出局面，列出库中的后续着法
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+
+#include "game_board.h"
+#include "engine.h"
+#include "opening_book.h"
+
+static double now_sec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+static int build(const char* path,int games,int plies,int time_ms,int threads)
+{
+    book_builder builder;
+    engine ai;
+    ai.set_threads(threads);
+    int results[3]={0,0,0};     // 白胜、黑胜、和棋
+    double start=now_sec();
+    for(int g=0;g<games;g++)
+    {
+        game_board game;
+        srand(1234+g);
+        game.play(board_cells/2);
+        while(game.play((7+rand()%5-2)*board_size+7+rand()%5-2)==play_illegal)
+            ;
+        while(!game.over())
+        {
+            search_result r=ai.think(game,time_ms);
+            if(game.moves()<plies)
+                builder.add_score(game,r.move,r.score);
+            game.play(r.move);
+        }
+        builder.add_game(game,plies);
+        results[game.winner()==stone_none?2:game.winner()]++;
+        printf("\rgame %d/%d: black %d white %d draw %d",g+1,games,results[stone_black],results[stone_white],results[2]);
+        fflush(stdout);
+    }
+    printf("\n");
+    if(!builder.write(path))
+    {
+        perror(path);
+        return 1;
+    }
+    printf("%s: %zu positions, %zu moves, %.1f s\n",path,builder.positions(),builder.moves(),now_sec()-start);
+    return 0;
+}
+
+static int show(const char* path,int argc,char* argv[])
+{
+    opening_book book;
+    double t0=now_sec();
+    if(!book.open(path))
+    {
+        fprintf(stderr,"%s: cannot open opening book\n",path);
+        return 1;
+    }
+    double t1=now_sec();
+    game_board game;
+    for(int i=0;i<argc;i++)
+    {
+        int x,y;
+        if(sscanf(argv[i],"%d,%d",&x,&y)!=2||game.play(x,y)==play_illegal)
+        {
+            fprintf(stderr,"bad move %s\n",argv[i]);
+            return 1;
+        }
+    }
+    book_continuation c[32];
+    int n=book.lookup(game,c,32);
+    printf("%s: %zu positions, opened in %.3f ms; %d continuations after %d moves\n",
+        path,book.size(),(t1-t0)*1e3,n,game.moves());
+    for(int i=0;i<n;i++)
+    {
+        printf("  %2d,%-2d  games %6d  wins %5.1f%%  draws %5.1f%%",c[i].move/board_size,c[i].move%board_size,
+            c[i].games,c[i].games?100.0*c[i].wins/c[i].games:0.0,c[i].games?100.0*c[i].draws/c[i].games:0.0);
+        if(c[i].score!=book_score_none)
+            printf("  score %d",c[i].score);
+        printf("\n");
+    }
+    return 0;
+}
+
+int main(int argc,char* argv[])
+{
+    if(argc>=3&&strcmp(argv[1],"build")==0)
+        return build(argv[2],argc>3?atoi(argv[3]):200,argc>4?atoi(argv[4]):12,
+            argc>5?atoi(argv[5]):100,argc>6?atoi(argv[6]):1);
+    if(argc>=3&&strcmp(argv[1],"show")==0)
+        return show(argv[2],argc-3,argv+3);
+    fprintf(stderr,"usage: %s build FILE [games] [plies] [time_ms] [threads]\n"
+        "       %s show FILE [x,y ...]\n",argv[0],argv[0]);
+    return 1;
+}
@@ -0,0 +1,994 @@
+/**
+ * @file engine.cpp
+ * @brief 电脑对手的实现（gobang_core库）
+ *
+ * 搜索用自己的棋盘：四周各留4格边界的一维数组（23x23），沿一个方向走就是下标加上固定的步长，
+ * 读取一条线上的9个格子不需要判断越界。另外记录每个空位周围两格内的棋子数，用来生成候选点。
+ *
+ * 棋型：落子点两侧各4格，己方棋子和空位各一个8位掩码（对方棋子和边界都算阻挡），
+ * 查表得到这一方向上的棋型（连五、活四、冲四、活三、眠三、活二、眠二）。
+ * 表在第一次使用时按定义递归生成：能连五的空位有两个以上为活四、一个为冲四，
+ * 再下一子能成活四为活三、能成冲四为眠三，依此类推。
+ * 每个格子每个方向、每种颜色的掩码（棋型码）随棋盘增量维护：落子或悔棋只改动经过该点的
+ * 4条线上两侧各4格的掩码，各异或一个位，取棋型只需查一次表。
+ *
+ * 静态评分：所有5格窗口按内容（3进制编码）查编译期生成的评分表再求和。每个窗口的编码和总分同样增量维护，
+ * 落子或悔棋只更新经过该点的4x5个窗口，评分本身不再扫描棋盘。
+ *
+ * 置换表：搜索棋盘在落子和悔棋时增量维护局面的Zobrist键（与game_board::key()相同），
+ * 表中保存的着法是搜索棋盘上的下标。
+ *
+ * 连珠规则（renju.h）：黑方的候选点、挡点和威胁都排除禁手点，黑方只有恰好五连才算连五点。
+ * 禁手判定先看落子点四个方向的棋型码（至少两个方向活三以上，或有活四、连五的方向）再调用renju_forbidden，
+ * 绝大多数候选点只需要4次查表。
+ *
+ * 多线程（Lazy SMP）：每个线程有自己的searcher（棋盘、节点数、超时状态），只共用置换表和停止标志。
+ * 线程用std::thread（服务器同样使用；客户端的MinGW需为posix线程模型，Qt自带的即是）。
+ */
+
+#include "engine.h"
+#include "zobrist.h"
+
+#include<string.h>
+#include<limits.h>
+#include<algorithm>
+#include<chrono>
+#include<memory>
+#include<thread>
+#include<vector>
+
+using namespace std;
+
+namespace
+{
+
+/* ==================== 棋型表 ==================== */
+
+enum line_pattern
+{
+    pat_none,
+    pat_two,            // 眠二
+    pat_open_two,       // 活二
+    pat_three,          // 眠三
+    pat_open_three,     // 活三
+    pat_four,           // 冲四
+    pat_open_four,      // 活四（或同一条线上的两个冲四）
+    pat_five            // 连五
+};
+
+/**
+ * @brief 两侧8个格子的掩码（第0~3位为左侧由远到近，第4~7位为右侧由近到远）到棋型的表
+ */
+class pattern_table
+{
+public:
+    pattern_table()
+    {
+        memset(table,0xFF,sizeof(table));
+        for(int own=0;own<256;own++)
+            for(int empty=0;empty<256;empty++)
+                if(!(own&empty))
+                    classify(expand(own)|1<<4,expand(empty));
+    }
+
+    int lookup(int own,int empty) const { return table[own|empty<<8]; }
+    int lookup(int code) const { return table[code]; }
+
+private:
+    // 8位掩码插入中心位（第4位）后的9位掩码
+    static int expand(int m) { return (m&0xF)|(m&0xF0)<<1; }
+    static int compress(int m) { return (m&0xF)|(m>>1&0xF0); }
+
+    // 9位中包含中心的某个5位窗口全是己方棋子
+    static bool five(int own)
+    {
+        for(int s=0;s<=4;s++)
+            if((own>>s&0x1F)==0x1F)
+                return true;
+        return false;
+    }
+
+    int classify(int own,int empty)
+    {
+        uint8_t &t=table[compress(own)|compress(empty)<<8];
+        if(t!=0xFF)
+            return t;
+        if(five(own))
+            return t=pat_five;
+        int wins=0;
+        for(int e=0;e<9;e++)
+            if(empty>>e&1&&five(own|1<<e))
+                wins++;
+        if(wins>=2)
+            return t=pat_open_four;
+        if(wins==1)
+            return t=pat_four;
+        // 再下一子能形成的最好棋型降一级
+        int best=pat_none;
+        for(int e=0;e<9;e++)
+        {
+            if(!(empty>>e&1))
+                continue;
+            int next=classify(own|1<<e,empty&~(1<<e));
+            int now=next==pat_open_four?pat_open_three:next==pat_four?pat_three
+                :next==pat_open_three?pat_open_two:next==pat_three?pat_two:pat_none;
+            best=max(best,now);
+        }
+        return t=(uint8_t)best;
+    }
+
+    uint8_t table[65536];
+};
+
+const pattern_table& patterns()
+{
+    static const pattern_table table;
+    return table;
+}
+
+/* ==================== 搜索用的棋盘 ==================== */
+
+const int pad=4;                                // 四周留出的边界
+const int width=board_size+2*pad;               // 一行的步长
+const int squares=width*width;
+const int8_t sq_empty=2,sq_border=3;            // 黑白两色与stone相同（1黑0白）
+const int dirs[4]={1,width,width+1,width-1};    // 横、竖、两条斜线
+
+const int max_ply=128;                          // 搜索的最大层数
+const int ab_width=12;                          // α-β每层最多搜索的候选点数
+const int leaf_vcf_depth=4;                     // 叶子节点VCF的进攻步数
+const int root_vcf_depth=12;                    // 根节点VCF的进攻步数
+const int root_vct_depth=6;                     // 根节点VCT的进攻步数
+const int book_min_games=3;                     // 开局库中没有评分的着法至少要有的对局数
+
+// 辅助线程跳过的深度：编号i（从1开始）的线程在 (depth+skip_phase)/skip_size 为奇数时跳过这一层，
+// 同一时刻各线程多在搜不同的深度
+const int skip_size[20]={1,1,2,2,2,2,3,3,3,3,3,3,4,4,4,4,4,4,4,4};
+const int skip_phase[20]={0,1,0,1,2,3,0,1,2,3,4,5,0,1,2,3,4,5,6,7};
+
+inline int to_sq(int cell) { return (cell/board_size+pad)*width+cell%board_size+pad; }
+inline int to_cell(int s) { return (s/width-pad)*board_size+s%width-pad; }
+
+/**
+ * @brief 按搜索棋盘下标排列的Zobrist随机数（边界上为0）
+ */
+struct square_keys
+{
+    uint64_t keys[2][squares];
+
+    square_keys()
+    {
+        memset(keys,0,sizeof(keys));
+        for(int cell=0;cell<board_cells;cell++)
+            for(int color=0;color<2;color++)
+                keys[color][to_sq(cell)]=zobrist()(color,cell);
+    }
+};
+
+const square_keys& sq_keys()
+{
+    static const square_keys table;
+    return table;
+}
+
+// 各棋型用于排序的分数
+const int pattern_score[8]={0,2,10,10,100,120,5000,100000};
+// 5格窗口中只有一方的n个棋子时的评分
+constexpr int window_score[6]={0,1,8,60,600,10000};
+// 窗口编码中第j格的权
+constexpr int window_pow[5]={1,3,9,27,81};
+
+/**
+ * @brief 5格窗口的评分表（编译期生成）：第j格 空0/白1/黑2 乘以3^j 求和为编码，
+ *        只有一方的棋子时按棋子数评分（对黑方为正），两方都有时为0
+ */
+struct window_table
+{
+    int score[243];
+
+    constexpr window_table():score()
+    {
+        for(int code=0;code<243;code++)
+        {
+            int black=0,white=0;
+            for(int j=0,c=code;j<5;j++,c/=3)
+            {
+                black+=c%3==2;
+                white+=c%3==1;
+            }
+            score[code]=black&&white?0:black?window_score[black]:-window_score[white];
+        }
+    }
+};
+
+constexpr window_table window_values;
+static_assert(window_values.score[242]==window_score[5]&&window_values.score[121]==-window_score[5],
+    "window table must be built at compile time");
+
+/**
+ * @brief 以各格为起点、沿各方向的5格窗口是否整个在棋盘内（评估用）
+ */
+struct window_list
+{
+    bool valid[squares][4];
+
+    window_list()
+    {
+        const int dx[4]={0,1,1,1},dy[4]={1,0,1,-1};
+        memset(valid,0,sizeof(valid));
+        for(int x=0;x<board_size;x++)
+            for(int y=0;y<board_size;y++)
+                for(int d=0;d<4;d++)
+                {
+                    int ex=x+4*dx[d],ey=y+4*dy[d];
+                    valid[to_sq(x*board_size+y)][d]=ex>=0&&ey>=0&&ex<board_size&&ey<board_size;
+                }
+    }
+};
+
+const window_list& windows()
+{
+    static const window_list list;
+    return list;
+}
+
+// 客户端在Windows上编译，用标准库的单调时钟
+double now_ms()
+{
+    return chrono::duration<double,milli>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief 一次思考的全部状态
+ */
+class searcher
+{
+public:
+    searcher(const game_board &game,const atomic<bool> &stop_flag,const atomic<bool> &done_flag,transposition_table* tt)
+        :stopped(stop_flag),finished(done_flag),table(patterns()),keys(sq_keys()),windows_ok(windows()),tt(tt),
+        renju(game.rule()==rule_renju),key(0),
+        nodes(0),tt_probes(0),tt_hits(0),aborted(false),deadline(0),
+        completed(0),best_move(-1),best_score(-engine_win)
+    {
+        for(int s=0;s<squares;s++)
+        {
+            sq[s]=sq_border;
+            near[s]=0;
+        }
+        for(int cell=0;cell<board_cells;cell++)
+            sq[to_sq(cell)]=sq_empty;
+        // 空棋盘上的棋型码：两侧在棋盘内的格子都是空位
+        for(int s=0;s<squares;s++)
+            for(int d=0;d<4;d++)
+            {
+                int empty=0;
+                for(int k=1;k<=4;k++)
+                    if(sq[s]!=sq_border)
+                        empty|=(sq[s-k*dirs[d]]==sq_empty)<<(4-k)|(sq[s+k*dirs[d]]==sq_empty)<<(3+k);
+                lines[s][d][0]=lines[s][d][1]=(uint16_t)(empty<<8);
+            }
+        memset(window_code,0,sizeof(window_code));
+        total=0;
+        count=0;
+        side=stone_black;
+        for(int i=0;i<game.moves();i++)
+            place(to_sq(game.move(i)));
+    }
+
+    /* ---------- 落子与悔棋 ---------- */
+
+    void place(int s)
+    {
+        sq[s]=(int8_t)side;
+        history[count++]=s;
+        key^=keys.keys[side][s];
+        for(int dx=-2;dx<=2;dx++)
+            for(int dy=-2;dy<=2;dy++)
+                near[s+dx*width+dy]++;
+        update_lines(s,side,side+1);
+        side^=1;
+    }
+
+    void undo()
+    {
+        int s=history[--count];
+        sq[s]=sq_empty;
+        key^=keys.keys[side^1][s];
+        for(int dx=-2;dx<=2;dx++)
+            for(int dy=-2;dy<=2;dy++)
+                near[s+dx*width+dy]--;
+        update_lines(s,side^1,-(side^1)-1);
+        side^=1;
+    }
+
+    /**
+     * @brief color在s落子（digit为正）或移走（digit为负）后，更新经过s的4条线上的棋型码和窗口
+     * @param digit 窗口编码的变化（白1黑2，移走时取负）
+     */
+    void update_lines(int s,int color,int digit)
+    {
+        for(int d=0;d<4;d++)
+        {
+            int dir=dirs[d];
+            // s在左侧第k格的格子（右侧的位）和在右侧第k格的格子（左侧的位）：
+            // color的己方位和空位都翻转，另一方只有空位翻转；落子和移走是同一个操作
+            for(int k=1;k<=4;k++)
+            {
+                uint16_t* r=lines[s-k*dir][d];
+                uint16_t* l=lines[s+k*dir][d];
+                int rb=1<<(3+k),lb=1<<(4-k);
+                r[color]^=(uint16_t)(rb|rb<<8);
+                r[color^1]^=(uint16_t)(rb<<8);
+                l[color]^=(uint16_t)(lb|lb<<8);
+                l[color^1]^=(uint16_t)(lb<<8);
+            }
+            // s是第j格的窗口，起点为s-j*dir
+            for(int j=0;j<5;j++)
+            {
+                int w=s-j*dir;
+                uint8_t &code=window_code[w][d];
+                if(windows_ok.valid[w][d])
+                    total-=window_values.score[code];
+                code=(uint8_t)(code+digit*window_pow[j]);
+                if(windows_ok.valid[w][d])
+                    total+=window_values.score[code];
+            }
+        }
+    }
+
+    /* ---------- 棋型 ---------- */
+
+    /**
+     * @brief color在s（空位或己方棋子）沿第d个方向上的棋型
+     */
+    int pattern(int color,int s,int d) const { return table.lookup(lines[s][d][color]); }
+
+    /**
+     * @brief color在空位s落子是否为禁手（连珠规则下的黑方）
+     */
+    bool forbidden(int color,int s) const
+    {
+        if(!renju||color!=stone_black)
+            return false;
+        // 禁手至少要两个方向活三以上，或一个方向活四、连五（长连、同一条线上的双四）
+        int threes=0;
+        for(int d=0;d<4;d++)
+        {
+            int p=pattern(color,s,d);
+            if(p>=pat_open_four)
+                return renju_forbidden(sq,width,s,sq_empty)!=forbid_none;
+            threes+=p>=pat_open_three;
+        }
+        return threes>=2&&renju_forbidden(sq,width,s,sq_empty)!=forbid_none;
+    }
+
+    /**
+     * @brief color在空位s落子后四个方向合起来的威胁等级（棋型，双冲四或冲四活三算活四，禁手点为pat_none）
+     */
+    int threat(int color,int s) const
+    {
+        if(forbidden(color,s))
+            return pat_none;
+        int fours=0,threes=0,best=pat_none;
+        for(int d=0;d<4;d++)
+        {
+            int p=pattern(color,s,d);
+            if(p==pat_five)
+                return pat_five;
+            fours+=p==pat_four;
+            threes+=p==pat_open_three;
+            best=max(best,p);
+        }
+        if(fours>=2||(fours&&threes))
+            return pat_open_four;
+        return best;
+    }
+
+    /**
+     * @brief 落子s对side一方的排序分：己方进攻加上阻挡对方
+     */
+    int move_score(int s) const
+    {
+        int own=0,other=0;
+        for(int d=0;d<4;d++)
+        {
+            own+=pattern_score[pattern(side,s,d)];
+            other+=pattern_score[pattern(side^1,s,d)];
+        }
+        int t=threat(side,s),u=threat(side^1,s);
+        if(t>=pat_open_four)
+            own+=pattern_score[t];
+        if(u>=pat_open_four)
+            other+=pattern_score[u];
+        return own*5+other*4;
+    }
+
+    /**
+     * @brief color在s处的棋子沿某个方向连五需要的空位（最多max个，不重复；连珠规则下黑方只算恰好五连）
+     */
+    int five_points(int color,int s,int* out,int max_out) const
+    {
+        int n=0;
+        for(int d=0;d<4;d++)
+        {
+            int dir=dirs[d];
+            for(int k=-4;k<=4;k++)
+            {
+                int e=s+k*dir;
+                if(k==0||sq[e]!=sq_empty)
+                    continue;
+                int len=1;
+                for(int p=e+dir;sq[p]==color;p+=dir)
+                    len++;
+                for(int p=e-dir;sq[p]==color;p-=dir)
+                    len++;
+                if(len<5||(len>5&&renju&&color==stone_black))
+                    continue;
+                bool seen=false;
+                for(int i=0;i<n;i++)
+                    seen|=out[i]==e;
+                if(!seen)
+                {
+                    out[n++]=e;
+                    if(n==max_out)
+                        return n;
+                }
+            }
+        }
+        return n;
+    }
+
+    /**
+     * @brief 候选点：周围两格内有棋子的空位（不包括轮到的一方的禁手点）
+     */
+    int candidates(int* out) const
+    {
+        int n=0;
+        for(int x=0;x<board_size;x++)
+        {
+            const int8_t* row=sq+(x+pad)*width+pad;
+            const uint8_t* nr=near+(x+pad)*width+pad;
+            for(int y=0;y<board_size;y++)
+                if(row[y]==sq_empty&&nr[y]&&!forbidden(side,(x+pad)*width+pad+y))
+                    out[n++]=(x+pad)*width+pad+y;
+        }
+        return n;
+    }
+
+    /**
+     * @brief 静态评分（对轮到的一方）：增量维护的窗口总分
+     */
+    int evaluate() const { return side==stone_black?total:-total; }
+
+    /* ---------- 时间控制 ---------- */
+
+    bool timeout()
+    {
+        if(aborted)
+            return true;
+        if((++nodes&1023)==0&&(stopped||finished||now_ms()>deadline))
+            aborted=true;
+        return aborted;
+    }
+
+    /* ---------- 算杀 ---------- */
+
+    /**
+     * @brief 进攻方color走棋：能否在depth步进攻内取胜
+     * @param threes false为VCF（只用冲四），true为VCT（还可以用活三）
+     */
+    bool attack(int color,int depth,bool threes,int* first)
+    {
+        if(timeout())
+            return false;
+        int moves[board_cells],scores[board_cells];
+        int n=candidates(moves);
+        for(int i=0;i<n;i++)
+            if(threat(color,moves[i])==pat_five)
+            {
+                if(first)
+                    *first=moves[i];
+                return true;
+            }
+        // 防守方刚才的落子形成冲四时，只能先挡
+        int block[2];
+        int nb=count?five_points(color^1,history[count-1],block,2):0;
+        if(nb>=2)
+            return false;
+        if(nb==1)
+        {
+            if(depth<=0||forbidden(color,block[0]))
+                return false;
+            place(block[0]);
+            bool ok=defend(color,depth-1,threes,block[0]);
+            undo();
+            if(ok&&first)
+                *first=block[0];
+            return ok;
+        }
+        if(depth<=0)
+            return false;
+
+        // 冲四在前，活三在后，同类按排序分
+        int m=0;
+        for(int i=0;i<n;i++)
+        {
+            int t=threat(color,moves[i]);
+            if(t>=pat_four||(threes&&t==pat_open_three))
+            {
+                moves[m]=moves[i];
+                scores[m]=t*1000000+move_score(moves[i]);
+                m++;
+            }
+        }
+        sort_moves(moves,scores,m);
+        for(int i=0;i<m;i++)
+        {
+            place(moves[i]);
+            bool ok=defend(color,depth-1,threes,moves[i]);
+            undo();
+            if(aborted)
+                return false;
+            if(ok)
+            {
+                if(first)
+                    *first=moves[i];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 进攻方color刚在last落子，防守方走棋：是否所有应对都挡不住
+     */
+    bool defend(int color,int depth,bool threes,int last)
+    {
+        if(timeout())
+            return false;
+        int wins[2];
+        int nw=five_points(color,last,wins,2);
+        if(nw>=2)
+            return true;
+        if(nw==1)
+        {
+            if(forbidden(color^1,wins[0]))     // 只能挡在禁手点上
+                return true;
+            place(wins[0]);
+            bool ok=attack(color,depth,threes,0);
+            undo();
+            return ok;
+        }
+        if(!threes)
+            return false;
+
+        // 活三：防守点是这条线上两侧4格内的空位，另外防守方可以冲四反击
+        bool open_three=false;
+        int defenses[board_cells];
+        int n=0;
+        bool mark[squares]={false};
+        for(int d=0;d<4;d++)
+        {
+            if(pattern(color,last,d)!=pat_open_three)
+                continue;
+            open_three=true;
+            for(int k=-4;k<=4;k++)
+            {
+                int e=last+k*dirs[d];
+                if(sq[e]==sq_empty&&!mark[e]&&!forbidden(color^1,e))
+                {
+                    mark[e]=true;
+                    defenses[n++]=e;
+                }
+            }
+        }
+        if(!open_three)
+            return false;
+        int moves[board_cells];
+        int m=candidates(moves);
+        for(int i=0;i<m;i++)
+            if(!mark[moves[i]]&&threat(color^1,moves[i])>=pat_four)
+            {
+                mark[moves[i]]=true;
+                defenses[n++]=moves[i];
+            }
+        for(int i=0;i<n;i++)
+        {
+            place(defenses[i]);
+            bool ok=attack(color,depth,threes,0);
+            undo();
+            if(!ok||aborted)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 由浅到深做算杀，返回找到时的进攻步数（没找到或超时返回0）
+     */
+    int find_win(int color,int max_depth,bool threes,int* first)
+    {
+        for(int depth=1;depth<=max_depth&&!aborted;depth++)
+            if(attack(color,depth,threes,first))
+                return depth;
+        return 0;
+    }
+
+    /* ---------- α-β搜索 ---------- */
+
+    static void sort_moves(int* moves,int* scores,int n)
+    {
+        for(int i=1;i<n;i++)
+        {
+            int m=moves[i],s=scores[i],j=i;
+            for(;j>0&&scores[j-1]<s;j--)
+            {
+                moves[j]=moves[j-1];
+                scores[j]=scores[j-1];
+            }
+            moves[j]=m;
+            scores[j]=s;
+        }
+    }
+
+    /**
+     * @brief 生成并排序候选点，最多取limit个；first（置换表中的着法）是候选点时排在最前面
+     */
+    int ordered_moves(int* moves,int limit,int first=-1)
+    {
+        int scores[board_cells];
+        int n=candidates(moves);
+        for(int i=0;i<n;i++)
+            scores[i]=moves[i]==first?INT_MAX:move_score(moves[i]);
+        sort_moves(moves,scores,n);
+        return min(n,limit);
+    }
+
+    // 必胜/必败分数的范围（叶子节点的VCF还会再加几步）
+    static int tt_to(int v,int ply) { return transposition_table::to_tt(v,ply,engine_win,2*max_ply); }
+    static int tt_from(int v,int ply) { return transposition_table::from_tt(v,ply,engine_win,2*max_ply); }
+
+    int alphabeta(int depth,int alpha,int beta,int ply)
+    {
+        if(timeout())
+            return 0;
+        int me=side;
+        // 己方上一步形成的冲四没有被挡（对方必须挡，所以只可能是上一步）
+        int points[2];
+        if(count>=2&&five_points(me,history[count-2],points,1))
+            return engine_win-ply;
+        int nf=count?five_points(me^1,history[count-1],points,2):0;
+        if(nf>=2)
+            return -(engine_win-ply-1);
+        if(count==board_cells)
+            return 0;
+        if(ply>=max_ply)
+            return evaluate();
+
+        // 置换表：深度足够时按边界类型直接返回，否则只取最好着法用于排序
+        depth=max(depth,0);
+        int tt_move=-1;
+        if(tt)
+        {
+            tt_entry e;
+            tt_probes++;
+            if(tt->probe(key,e))
+            {
+                tt_hits++;
+                if(e.move>=0&&e.move<squares&&sq[e.move]==sq_empty)
+                    tt_move=e.move;
+                if(e.depth>=depth)
+                {
+                    int v=tt_from(e.value,ply);
+                    if(e.bound==bound_exact||(e.bound==bound_lower&&v>=beta)||(e.bound==bound_upper&&v<=alpha))
+                        return v;
+                }
+            }
+        }
+        if(depth==0&&nf==0)
+        {
+            int v=attack(me,leaf_vcf_depth,false,0)?engine_win-ply-2*leaf_vcf_depth:evaluate();
+            if(tt&&!aborted)
+                tt->store(key,-1,tt_to(v,ply),0,bound_exact);
+            return v;
+        }
+
+        int moves[board_cells];
+        int n,search_depth=depth;
+        if(nf==1)
+        {
+            // 挡冲四是唯一的应对，不减深度；挡点是己方的禁手时已经输了
+            if(forbidden(me,points[0]))
+                return -(engine_win-ply-1);
+            moves[0]=points[0];
+            n=1;
+            search_depth++;
+        }
+        else
+            n=ordered_moves(moves,ab_width,tt_move);
+
+        int alpha_orig=alpha,best=-engine_win,best_move=-1;
+        for(int i=0;i<n;i++)
+        {
+            place(moves[i]);
+            int v=-alphabeta(search_depth-1,-beta,-alpha,ply+1);
+            undo();
+            if(aborted)
+                return 0;
+            if(v>best)
+            {
+                best=v;
+                best_move=moves[i];
+                if(v>alpha)
+                    alpha=v;
+                if(alpha>=beta)
+                    break;
+            }
+        }
+        if(tt)
+        {
+            int bound=best<=alpha_orig?bound_upper:best>=beta?bound_lower:bound_exact;
+            tt->store(key,best_move,tt_to(best,ply),depth,bound);
+        }
+        return best;
+    }
+
+    /**
+     * @brief 根节点的迭代加深，结果记在completed/best_move/best_score
+     * @param id 线程编号，0为调用think()的线程，其余按编号错开跳过一部分深度
+     * @param done 正常结束（不是被打断）时设置，让其他线程停下
+     */
+    void iterate(int id,const int* root_moves,int rn,int max_depth,double start,int time_ms,atomic<bool> &done)
+    {
+        int root[board_cells];
+        copy(root_moves,root_moves+rn,root);
+        best_move=root[0];
+        best_score=-engine_win;
+        // 超时的那一层如果已经搜完上一层的最好点并找到更好的，也采用
+        for(int depth=1;depth<=max_depth;depth++)
+        {
+            if(id>0&&depth<max_depth&&(depth+skip_phase[(id-1)%20])/skip_size[(id-1)%20]%2)
+                continue;
+            int alpha=-engine_win-1,iter_move=-1,iter_score=-engine_win-1;
+            for(int i=0;i<rn;i++)
+            {
+                place(root[i]);
+                int v=-alphabeta(depth-1,-engine_win-1,-alpha,1);
+                undo();
+                if(aborted)
+                    break;
+                if(v>iter_score)
+                {
+                    iter_score=v;
+                    iter_move=i;
+                    if(v>alpha)
+                        alpha=v;
+                }
+            }
+            if(iter_move>=0&&(!aborted||iter_score>best_score))
+            {
+                best_move=root[iter_move];
+                best_score=iter_score;
+                // 最好点放到下一层的最前面
+                rotate(root,root+iter_move,root+iter_move+1);
+            }
+            if(aborted)
+                return;
+            completed=depth;
+            // 已分胜负，或剩下的时间不够再搜一层
+            if(best_score>=engine_win-max_ply||best_score<=-engine_win+max_ply)
+                break;
+            if(now_ms()-start>time_ms*0.5)
+                break;
+        }
+        done=true;
+    }
+
+    const atomic<bool> &stopped;
+    const atomic<bool> &finished;   // 多线程搜索中有线程已正常结束
+    const pattern_table &table;
+    const square_keys &keys;
+    const window_list &windows_ok;
+    transposition_table* tt;        // 置换表，不使用时为空
+    bool renju;                     // 连珠规则：黑方有禁手，只有恰好五连算胜
+
+    int8_t sq[squares];             // 格子：stone_black/stone_white/sq_empty/sq_border
+    uint8_t near[squares];          // 周围两格内的棋子数
+    uint16_t lines[squares][4][2];  // 棋型码：各格各方向两侧8格中 己方掩码|空位掩码<<8（按颜色）
+    uint8_t window_code[squares][4];    // 以各格为起点、沿各方向的5格窗口的编码
+    int total;                      // 所有窗口的评分之和（对黑方）
+    int history[board_cells];       // 落子顺序（搜索棋盘上的下标）
+    int count;                      // 已落子数
+    int side;                       // 轮到的一方
+    uint64_t key;                   // 局面的Zobrist键
+
+    long long nodes;                // 已搜索的节点数
+    long long tt_probes;            // 查询置换表的次数
+    long long tt_hits;              // 找到同一局面的次数
+    bool aborted;                   // 已超时或被停止
+    double deadline;                // 当前阶段的截止时间
+
+    int completed;                  // iterate()完整完成的深度
+    int best_move;                  // iterate()选出的着法
+    int best_score;                 // 及其评分
+};
+
+}
+
+search_result engine::think(const game_board &game,int time_ms,int max_depth)
+{
+    double start=now_ms();
+    stopped=false;
+    search_result result;
+    result.move=-1;
+    result.score=0;
+    result.depth=0;
+    result.kind=search_none;
+    result.nodes=0;
+    result.ab_nodes=0;
+    result.time_ms=0;
+    result.ab_time_ms=0;
+    result.tt_probes=0;
+    result.tt_hits=0;
+    if(game.over())
+        return result;
+
+    if(hashing)
+        table.new_search();
+    atomic<bool> done(false);
+    searcher s(game,stopped,done,hashing?&table:0);
+    int me=s.side;
+    int moves[board_cells];
+    int n=s.candidates(moves);
+    result.kind=search_forced;
+
+    if(game.moves()==0)
+        result.move=board_cells/2;
+    else
+    {
+        // 连五，其次挡对方的冲四（对方有多个连五点时已经输了，挡一个）
+        for(int i=0;i<n&&result.move<0;i++)
+            if(s.threat(me,moves[i])==pat_five)
+            {
+                result.move=to_cell(moves[i]);
+                result.score=engine_win-1;
+            }
+        for(int i=0;i<n&&result.move<0;i++)
+            if(s.threat(me^1,moves[i])==pat_five)
+                result.move=to_cell(moves[i]);
+    }
+
+    // 开局库：有评分时选评分最高的，否则选对局数足够、胜率最高的（库按无禁手规则生成，连珠规则下不用）
+    if(result.move<0&&book&&game.rule()==rule_freestyle)
+    {
+        book_continuation c[32];
+        int bn=book->lookup(game,c,32),pick=-1;
+        for(int i=0;i<bn;i++)
+            if(c[i].score!=book_score_none&&(pick<0||c[i].score>c[pick].score))
+                pick=i;
+        if(pick<0)
+            for(int i=0;i<bn;i++)
+                if(c[i].games>=book_min_games&&(pick<0||(2*c[i].wins+c[i].draws)*(long long)c[pick].games
+                    >(2*c[pick].wins+c[pick].draws)*(long long)c[i].games))
+                    pick=i;
+        if(pick>=0)
+        {
+            result.move=c[pick].move;
+            result.kind=search_book;
+            int v=c[pick].score==book_score_none?0:c[pick].score;
+            result.score=v>=book_score_win?engine_win-1:v<=-book_score_win?-(engine_win-1):v;
+        }
+    }
+
+    // 己方的VCF、VCT各占一部分时间
+    int first=-1;
+    if(result.move<0)
+    {
+        s.deadline=start+time_ms*0.1;
+        result.depth=s.find_win(me,root_vcf_depth,false,&first);
+        result.kind=search_vcf;
+        if(!result.depth)
+        {
+            s.aborted=false;
+            s.deadline=start+time_ms*0.3;
+            result.depth=s.find_win(me,root_vct_depth,true,&first);
+            result.kind=search_vct;
+        }
+        s.aborted=false;
+        if(result.depth)
+        {
+            result.move=to_cell(first);
+            result.score=engine_win-2*result.depth;
+        }
+    }
+
+    if(result.move<0)
+    {
+        result.kind=search_alphabeta;
+        result.depth=0;
+        int root[board_cells];
+        int rn=s.ordered_moves(root,board_cells);
+        // 空位都离棋子较远时（几乎不会出现）任选一个空位
+        for(int cell=0;rn==0&&cell<board_cells;cell++)
+            if(game.at(cell)==stone_none&&!s.forbidden(me,to_sq(cell)))
+                root[rn++]=to_sq(cell);
+        if(rn==0)
+        {
+            // 连珠规则下黑方剩下的空位全是禁手，没有可落子的位置
+            result.kind=search_none;
+            result.nodes=s.nodes;
+            result.time_ms=(int)(now_ms()-start);
+            return result;
+        }
+
+        // 对方的威胁：假设己方不落子时对方有VCF，则只保留落子后对方不再有VCF的点
+        // （不落子相当于让对方连走两步，几乎总有VCT，所以这里只看VCF）
+        s.deadline=start+time_ms*0.6;
+        s.side^=1;
+        bool threatened=s.find_win(me^1,root_vcf_depth,false,0)>0;
+        s.side^=1;
+        if(threatened)
+        {
+            int safe=0,i;
+            for(i=0;i<rn;i++)
+            {
+                s.place(root[i]);
+                bool lost=s.find_win(me^1,root_vcf_depth,false,0)>0;
+                s.undo();
+                if(s.aborted)
+                    break;
+                if(!lost)
+                    swap(root[safe++],root[i]);
+            }
+            // 超时时没检查完的点排在化解的点后面；都化解不了时全部保留
+            if(safe>0||i<rn)
+            {
+                copy(root+i,root+rn,root+safe);
+                rn=safe+rn-i;
+            }
+        }
+        s.aborted=false;
+        rn=min(rn,ab_width);
+
+        // 迭代加深：辅助线程在自己的棋盘上搜同一组根节点着法，调用者的线程结束后停下所有线程
+        s.deadline=start+time_ms;
+        long long ab_start=s.nodes;
+        double ab_clock=now_ms();
+        vector<unique_ptr<searcher>> helpers;
+        vector<thread> pool;
+        for(int id=1;id<thread_count;id++)
+        {
+            helpers.emplace_back(new searcher(game,stopped,done,hashing?&table:0));
+            searcher* h=helpers.back().get();
+            h->deadline=s.deadline;
+            pool.emplace_back([=,&done]{ h->iterate(id,root,rn,max_depth,start,time_ms,done); });
+        }
+        s.iterate(0,root,rn,max_depth,start,time_ms,done);
+        done=true;
+        for(size_t i=0;i<pool.size();i++)
+            pool[i].join();
+        result.ab_time_ms=(int)(now_ms()-ab_clock);
+
+        searcher* chosen=&s;
+        result.ab_nodes=s.nodes-ab_start;
+        for(size_t i=0;i<helpers.size();i++)
+        {
+            searcher &h=*helpers[i];
+            if(h.completed>chosen->completed)
+                chosen=&h;
+            result.nodes+=h.nodes;
+            result.ab_nodes+=h.nodes;
+            result.tt_probes+=h.tt_probes;
+            result.tt_hits+=h.tt_hits;
+        }
+        result.move=to_cell(chosen->best_move);
+        result.score=chosen->best_score;
+        result.depth=chosen->completed;
+    }
+
+    result.nodes+=s.nodes;
+    result.tt_probes+=s.tt_probes;
+    result.tt_hits+=s.tt_hits;
+    result.time_ms=(int)(now_ms()-start);
+    return result;
+}
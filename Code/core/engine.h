@@ -0,0 +1,117 @@
+/**
+ * @file engine.h
+ * @brief 电脑对手：α-β搜索 + 迭代加深 + VCF/VCT算杀（gobang_core库）
+ *
+ * 每次思考按以下顺序进行，任何一步得到结果就直接落子：
+ * 1. 己方能连五就连五，对方有冲四就挡；设置了开局库（set_book()）且当前局面在库中时走库中的着法
+ * 2. VCF：只用冲四连续进攻，对方每步只能挡，直到形成活四/双四或连五
+ * 3. VCT：冲四和活三连续进攻，对方可以在线上防守或反冲四
+ * 4. 迭代加深的α-β搜索：候选点只取已有棋子周围两格内的空位，按进攻+防守的棋型分排序后取前若干个；
+ *    对方冲四时只搜挡点且不减深度，叶子节点先做一次短的VCF再给出静态评分；
+ *    搜索结果按局面的Zobrist键存入置换表（transposition.h），不同落子顺序到达的同一局面直接复用，
+ *    表中的最好着法排在候选点的最前面。置换表在多次思考之间保留，新的一局开始时可以clear_hash()
+ *
+ * 连珠规则（game_board::rule()）下黑方不走禁手点，黑方只有恰好五连才算胜，对方只能挡在禁手点上的冲四算必胜；
+ * 开局库按无禁手规则生成，连珠规则下不使用
+ *
+ * 每个阶段都有时间上限，超时后使用最后一次完整完成的搜索结果；其他线程可以随时调用stop()让思考尽快返回。
+ *
+ * 前三步在调用者的线程中进行。第4步可以多线程（Lazy SMP，set_threads()）：调用者的线程之外再启动N-1个辅助线程，
+ * 各自从根节点独立地迭代加深，只通过共用的置换表互相利用结果；辅助线程按编号错开跳过一部分深度，
+ * 使各线程同一时刻多在搜不同的深度。任何一个线程正常结束（搜到最大深度、已分胜负或时间用过一半）后
+ * 其余线程都停下，采用完成深度最大的线程的结果（相同时优先调用者的线程）
+ *
+ * 本文件只依赖C++标准库，不依赖Qt
+ */
+
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include<atomic>
+
+#include "game_board.h"
+#include "opening_book.h"
+#include "transposition.h"
+
+/**
+ * @brief 选出落子的方式
+ */
+enum search_kind
+{
+    search_none,        // 对局已结束，没有可落子的位置
+    search_forced,      // 连五、挡四或开局第一步
+    search_book,        // 开局库
+    search_vcf,         // 找到VCF
+    search_vct,         // 找到VCT
+    search_alphabeta    // α-β搜索
+};
+
+/**
+ * @brief 一次思考的结果
+ */
+struct search_result
+{
+    int move;           // 落子的格子下标，没有可落子的位置时为-1
+    int score;          // 对落子方的评分（engine_win附近表示必胜/必败）
+    int depth;          // 完整完成的α-β搜索深度（算杀找到时为算杀的进攻步数）
+    int kind;           // 选出落子的方式（search_kind）
+    long long nodes;    // 搜索的节点数（包括算杀）
+    long long ab_nodes;     // 其中迭代加深的α-β搜索阶段的节点数（所有线程合计）
+    int time_ms;        // 用时（毫秒）
+    int ab_time_ms;     // 其中迭代加深的α-β搜索阶段的用时（毫秒）
+    long long tt_probes;    // α-β搜索查询置换表的次数
+    long long tt_hits;      // 其中找到同一局面的次数
+};
+
+const int engine_win=1000000;   // 必胜的评分，减去到达胜利的步数
+const int engine_max_threads=64;    // α-β搜索的最大线程数
+
+class engine
+{
+public:
+    /**
+     * @param tt_mb 置换表大小（MB），为0时不使用置换表
+     */
+    explicit engine(size_t tt_mb=16):stopped(false),hashing(tt_mb>0),thread_count(1),book(0),table(tt_mb) {}
+
+    /**
+     * @brief 为当前轮到的一方选择一步棋
+     * @param game 当前棋局（不会被修改）
+     * @param time_ms 思考时间上限（毫秒）
+     * @param max_depth α-β搜索的最大深度
+     * @return search_result 选出的落子及搜索统计
+     */
+    search_result think(const game_board &game,int time_ms,int max_depth=64);
+
+    /**
+     * @brief 让正在进行的think()尽快返回（可以在其他线程中调用）
+     */
+    void stop() { stopped=true; }
+
+    /**
+     * @brief 清空置换表（不能与think()同时调用）
+     */
+    void clear_hash() { table.clear(); }
+
+    /**
+     * @brief α-β搜索使用的线程数（包括调用think()的线程，限制在1~engine_max_threads，不能与think()同时调用）
+     */
+    void set_threads(int n) { thread_count=n<1?1:n>engine_max_threads?engine_max_threads:n; }
+    int threads() const { return thread_count; }
+
+    /**
+     * @brief 使用开局库（为空时不使用；开局库由调用者持有，不能与think()同时调用）
+     *
+     * 库中有引擎评分的着法时选评分最高的，否则在对局数足够的着法中选胜率（和棋算半局）最高的
+     */
+    void set_book(const opening_book* b) { book=b; }
+
+private:
+    std::atomic<bool> stopped;      // 由stop()设置，think()开始时清除
+    bool hashing;                   // 是否使用置换表
+    int thread_count;               // α-β搜索的线程数
+    const opening_book* book;       // 开局库，不使用时为空
+    transposition_table table;      // 置换表
+};
+
+#endif // ENGINE_H
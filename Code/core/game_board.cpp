@@ -0,0 +1,136 @@
+/**
+ * @file game_board.cpp
+ * @brief 一局五子棋的规则实现（gobang_core库）
+ */
+
+#include "game_board.h"
+#include "zobrist.h"
+
+#include<string.h>
+
+namespace
+{
+
+const int border_width=board_size+2;    // 加了边界的棋盘的边长
+const int8_t border=3;                  // 边界格的值（不是任何棋子）
+const int line_reach=5;                 // 禁手判定读取的范围：四个方向上两侧各5格
+const int dx[4]={0,1,1,1},dy[4]={1,0,1,-1};
+
+}
+
+void game_board::reset()
+{
+    stones.clear();
+    count=0;
+    win=stone_none;
+    hash=0;
+    memset(cells,border,sizeof(cells));
+    for(int x=0;x<board_size;x++)
+        memset(cells+(x+1)*border_width+1,stone_none,board_size);
+    memset(forbid_cache,-1,sizeof(forbid_cache));
+}
+
+int game_board::play(int cell)
+{
+    if(cell<0||cell>=board_cells||over())
+        return play_illegal;
+    int x=cell/board_size,y=cell%board_size;
+    if(!stones.empty(x,y))
+        return play_illegal;
+    int color=to_move();
+    if(color==stone_black&&rules==rule_renju&&forbidden(cell)!=forbid_none)
+        return play_forbidden;
+    stones.place(color,x,y);
+    history[count++]=(uint8_t)cell;
+    hash^=zobrist()(color,cell);
+    if(rules==rule_renju)
+        renju_update(cell,color);
+    if(stones.five(color,x,y))
+    {
+        win=(int8_t)color;
+        return play_five;
+    }
+    return count==board_cells?play_full:play_ok;
+}
+
+int game_board::play(int x,int y)
+{
+    if(x<0||y<0||x>=board_size||y>=board_size)
+        return play_illegal;
+    return play(x*board_size+y);
+}
+
+bool game_board::undo()
+{
+    if(count==0)
+        return false;
+    int cell=history[--count];
+    stones.remove(cell/board_size,cell%board_size);
+    hash^=zobrist()(count%2?stone_white:stone_black,cell);
+    if(rules==rule_renju)
+        renju_update(cell,stone_none);
+    // 五连之后不能再落子，所以获胜的一定是最后一步
+    win=stone_none;
+    return true;
+}
+
+int game_board::forbidden(int cell) const
+{
+    if(rules!=rule_renju||cell<0||cell>=board_cells)
+        return forbid_none;
+    int x=cell/board_size,y=cell%board_size;
+    if(!stones.empty(x,y))
+        return forbid_none;
+    if(forbid_cache[cell]>=0)
+        return forbid_cache[cell];
+
+    // 禁手至少要两条线上各有2个黑子（双三、双四），或一条线上有4个黑子（长连、同一条线上的双四），
+    // 只数两侧各5格，绝大多数空位到这里就能排除
+    int d,lines=0;
+    for(d=0;d<4;d++)
+    {
+        int n=0;
+        for(int side=-1;side<=1;side+=2)
+            for(int k=1;k<=line_reach;k++)
+            {
+                int nx=x+side*k*dx[d],ny=y+side*k*dy[d];
+                if(nx<0||ny<0||nx>=board_size||ny>=board_size)
+                    break;
+                n+=stones.at(nx,ny)==stone_black;
+            }
+        if(n>=4)
+            break;
+        lines+=n>=2;
+    }
+    bool local=true;
+    int result=forbid_none;
+    if(d<4||lines>=2)
+        result=renju_forbidden(cells,border_width,(x+1)*border_width+y+1,stone_none,&local);
+    if(local)
+        forbid_cache[cell]=(int8_t)result;
+    return result;
+}
+
+void game_board::set_rule(int r)
+{
+    // 改为连珠规则时按当前棋子重建加了边界的棋盘（无禁手规则下不维护），并丢弃已有的判定结果
+    if(r==rule_renju&&rules!=rule_renju)
+        for(int x=0;x<board_size;x++)
+            for(int y=0;y<board_size;y++)
+                cells[(x+1)*border_width+y+1]=(int8_t)stones.at(x,y);
+    rules=(int8_t)r;
+    memset(forbid_cache,-1,sizeof(forbid_cache));
+}
+
+void game_board::renju_update(int cell,int stone)
+{
+    int x=cell/board_size,y=cell%board_size;
+    cells[(x+1)*border_width+y+1]=(int8_t)stone;
+    for(int d=0;d<4;d++)
+        for(int k=-line_reach;k<=line_reach;k++)
+        {
+            int nx=x+k*dx[d],ny=y+k*dy[d];
+            if(nx>=0&&ny>=0&&nx<board_size&&ny<board_size)
+                forbid_cache[nx*board_size+ny]=-1;
+        }
+}
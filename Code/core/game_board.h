@@ -0,0 +1,142 @@
+/**
+ * @file game_board.h
+ * @brief 一局五子棋的规则：棋盘、落子顺序、悔棋、轮次与胜负（gobang_core库）
+ *
+ * 本地对战、网络对战和服务器共用这一份规则，界面只负责把点击换算成格子、把棋盘画出来：
+ * - 黑方先手，轮到哪一方由已落子数的奇偶决定（悔棋后自然恢复）
+ * - 只能落在棋盘内的空位上，分出胜负或下满之后不能再落子
+ * - 每步落子后判断是否五连
+ * - 规则可以是无禁手或连珠（renju.h）：连珠规则下黑方的禁手点不能落子，只有恰好五连才算胜
+ *
+ * 服务器上房间很多时棋盘大多不在缓存中，落子的开销主要是访问内存的次数，因此棋盘按位存储
+ * （bitboard.h）：两种颜色共60字节，加上落子数、胜负和规则正好一个缓存行。
+ * 落子、判空和五连判定只访问这一行；局面的Zobrist键（zobrist.h）和落子顺序（悔棋、标记最后一步用）
+ * 单独放在后面，每步只写键和一个字节。
+ *
+ * 连珠规则下还在最后增量维护加了一圈边界的棋盘（禁手判定直接读取，不再每次复制）和每个空位的禁手判定结果：
+ * 判定只读取四个方向上两侧各5格时，结果在这些格子不变时也不变，落子和悔棋只清除经过该点的4条线上的结果；
+ * 需要递归检查补三点的结果还与其他线有关，不缓存。无禁手规则的对局不访问这部分。
+ *
+ * 本文件只依赖C++标准库，不依赖Qt；实现在game_board.cpp，编译为libgobang_core.a（见core/makefile）
+ */
+
+#ifndef GAME_BOARD_H
+#define GAME_BOARD_H
+
+#include<stdint.h>
+
+#include "bitboard.h"
+#include "renju.h"
+
+const int board_size=15;                        // 棋盘边长
+const int board_cells=board_size*board_size;    // 格子数，格子下标为 x*board_size+y
+
+/**
+ * @brief 落子结果
+ */
+enum play_result
+{
+    play_forbidden=-2,  // 连珠规则下黑方的禁手，棋盘不变
+    play_illegal=-1,    // 越界、已有棋子或对局已结束，棋盘不变
+    play_ok=0,          // 已落子，对局继续
+    play_five=1,        // 已落子，落子方五连获胜
+    play_full=2         // 已落子，棋盘下满且无人获胜（和棋）
+};
+
+class game_board
+{
+public:
+    explicit game_board(int r=rule_freestyle):rules((int8_t)r) { reset(); }
+
+    /**
+     * @brief 清空棋盘（规则不变）
+     */
+    void reset();
+
+    /**
+     * @brief 对局规则（game_rule）；set_rule()只应在棋盘为空时调用
+     */
+    int rule() const { return rules; }
+    void set_rule(int r);
+
+    /**
+     * @brief 已落子数
+     */
+    int moves() const { return count; }
+
+    /**
+     * @brief 轮到落子的一方（黑方先手）
+     */
+    int to_move() const { return count%2?stone_white:stone_black; }
+
+    /**
+     * @brief 格子上的棋子（stone）
+     */
+    int at(int cell) const { return stones.at(cell/board_size,cell%board_size); }
+    int at(int x,int y) const { return stones.at(x,y); }
+
+    /**
+     * @brief 第i步（从0开始）落子的格子下标
+     */
+    int move(int i) const { return history[i]; }
+
+    /**
+     * @brief 最后一步的格子下标，棋盘为空时返回-1
+     */
+    int last() const { return count?history[count-1]:-1; }
+
+    /**
+     * @brief 局面的64位Zobrist键（zobrist.h），落子和悔棋时增量更新
+     */
+    uint64_t key() const { return hash; }
+
+    /**
+     * @brief 五连获胜的一方，未分胜负时为stone_none
+     */
+    int winner() const { return win; }
+
+    /**
+     * @brief 对局是否结束（有一方五连或棋盘下满）
+     */
+    bool over() const { return win!=stone_none||count==board_cells; }
+
+    /**
+     * @brief 黑方在空位cell落子是否为禁手（只在连珠规则下可能是，与轮到哪一方无关）
+     * @return int 禁手的种类（forbidden_kind），已有棋子或不是连珠规则时为forbid_none
+     *
+     * 会写入判定结果的缓存，不能在多个线程中同时对同一个棋盘调用
+     */
+    int forbidden(int cell) const;
+
+    /**
+     * @brief 当前一方在cell落子
+     * @param cell 格子下标（x*board_size+y）
+     * @return int 落子结果（play_result），连珠规则下黑方的禁手返回play_forbidden
+     */
+    int play(int cell);
+    int play(int x,int y);
+
+    /**
+     * @brief 撤销最后一步（撤销获胜的一步后对局继续）
+     * @return bool 棋盘为空时返回false
+     */
+    bool undo();
+
+private:
+    /**
+     * @brief 连珠规则下落子或悔棋后更新加了边界的棋盘，清除经过cell的4条线上的禁手判定结果
+     * @param stone 格子上新的棋子（悔棋时为stone_none）
+     */
+    void renju_update(int cell,int stone);
+
+    bitboard<board_size> stones;    // 两种颜色的棋子
+    uint8_t count;                  // 已落子数（不超过225）
+    int8_t win;                     // 五连获胜的一方（stone）
+    int8_t rules;                   // 对局规则（game_rule）
+    uint64_t hash;                  // 局面的Zobrist键（与落子顺序一起在第二个缓存行）
+    uint8_t history[board_cells];   // 落子顺序
+    int8_t cells[(board_size+2)*(board_size+2)];    // 加了一圈边界的棋盘（只在连珠规则下维护）
+    mutable int8_t forbid_cache[board_cells];       // 空位的禁手判定结果（forbidden_kind，-1表示需要重新判定）
+};
+
+#endif // GAME_BOARD_H
@@ -0,0 +1,284 @@
+/**
+ * @file opening_book.cpp
+ * @brief 开局库的映射、查询和生成（gobang_core库）
+ */
+
+#include "opening_book.h"
+#include "engine.h"
+
+#include<string.h>
+#include<stdio.h>
+#include<algorithm>
+
+#ifdef _WIN32
+#include<windows.h>
+#else
+#include<fcntl.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#endif
+
+using namespace std;
+
+static const char book_magic[8]={'G','O','B','O','O','K',0,0};
+
+static_assert(sizeof(book_header)==32&&sizeof(book_position)==16&&sizeof(book_move)==16,
+    "book structures are written to disk as-is");
+
+/* ==================== 对称 ==================== */
+
+int book_transform(int t,int cell)
+{
+    int x=cell/board_size,y=cell%board_size;
+    if(t&1)
+        x=board_size-1-x;
+    if(t&2)
+        y=board_size-1-y;
+    if(t&4)
+        swap(x,y);
+    return x*board_size+y;
+}
+
+int book_inverse_transform(int t,int cell)
+{
+    int x=cell/board_size,y=cell%board_size;
+    if(t&4)
+        swap(x,y);
+    if(t&2)
+        y=board_size-1-y;
+    if(t&1)
+        x=board_size-1-x;
+    return x*board_size+y;
+}
+
+uint64_t book_canonical_key(const game_board &game,int* symmetry)
+{
+    symmetric_keys k;
+    for(int i=0;i<game.moves();i++)
+        k.add(i%2?stone_white:stone_black,game.move(i));
+    return k.canonical(symmetry);
+}
+
+/* ==================== 映射与查询 ==================== */
+
+opening_book::opening_book()
+    :positions(0),moves(0),position_count(0),base(0),length(0)
+#ifdef _WIN32
+    ,file(INVALID_HANDLE_VALUE),mapping(0)
+#endif
+{
+}
+
+opening_book::~opening_book()
+{
+    close();
+}
+
+bool opening_book::open(const char* path)
+{
+    close();
+#ifdef _WIN32
+    file=CreateFileA(path,GENERIC_READ,FILE_SHARE_READ,NULL,OPEN_EXISTING,FILE_FLAG_RANDOM_ACCESS,NULL);
+    if(file==INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER file_size;
+    if(!GetFileSizeEx(file,&file_size)||file_size.QuadPart<(LONGLONG)sizeof(book_header))
+    {
+        close();
+        return false;
+    }
+    length=(size_t)file_size.QuadPart;
+    mapping=CreateFileMappingA(file,NULL,PAGE_READONLY,0,0,NULL);
+    base=mapping?MapViewOfFile(mapping,FILE_MAP_READ,0,0,0):0;
+    if(!base)
+    {
+        close();
+        return false;
+    }
+#else
+    int fd=::open(path,O_RDONLY);
+    if(fd<0)
+        return false;
+    struct stat st;
+    if(fstat(fd,&st)<0||st.st_size<(off_t)sizeof(book_header))
+    {
+        ::close(fd);
+        return false;
+    }
+    length=(size_t)st.st_size;
+    void* p=mmap(NULL,length,PROT_READ,MAP_SHARED,fd,0);
+    ::close(fd);            // 映射建立后不再需要描述符
+    if(p==MAP_FAILED)
+        return false;
+    madvise(p,length,MADV_RANDOM);
+    base=p;
+#endif
+    const book_header* h=(const book_header*)base;
+    size_t expect=sizeof(book_header)+(size_t)h->position_count*sizeof(book_position)
+        +(size_t)h->move_count*sizeof(book_move);
+    if(memcmp(h->magic,book_magic,8)!=0||h->version!=(uint32_t)book_version||expect!=length)
+    {
+        close();
+        return false;
+    }
+    position_count=h->position_count;
+    positions=(const book_position*)(h+1);
+    moves=(const book_move*)(positions+position_count);
+    return true;
+}
+
+void opening_book::close()
+{
+#ifdef _WIN32
+    if(base)
+        UnmapViewOfFile(base);
+    if(mapping)
+        CloseHandle(mapping);
+    if(file!=INVALID_HANDLE_VALUE)
+        CloseHandle(file);
+    mapping=0;
+    file=INVALID_HANDLE_VALUE;
+#else
+    if(base)
+        munmap((void*)base,length);
+#endif
+    base=0;
+    length=0;
+    positions=0;
+    moves=0;
+    position_count=0;
+}
+
+int opening_book::lookup(const game_board &game,book_continuation* out,int max_out) const
+{
+    if(!positions||max_out<=0)
+        return 0;
+    int symmetry;
+    uint64_t key=book_canonical_key(game,&symmetry);
+    const book_position* end=positions+position_count;
+    const book_position* p=lower_bound(positions,end,key,
+        [](const book_position &a,uint64_t k){ return a.key<k; });
+    if(p==end||p->key!=key)
+        return 0;
+
+    int n=0;
+    for(uint32_t i=0;i<p->count;i++)
+    {
+        const book_move &m=moves[p->first+i];
+        book_continuation c;
+        c.move=book_inverse_transform(symmetry,m.cell);
+        c.games=(int)m.games;
+        c.wins=(int)m.wins;
+        c.draws=(int)m.draws;
+        c.score=m.score;
+        if(game.at(c.move)!=stone_none)     // 键碰撞（几乎不可能）
+            continue;
+        // 按对局数插入排序，只保留前max_out个
+        int j;
+        if(n<max_out)
+            j=n++;
+        else if(out[max_out-1].games>=c.games)
+            continue;
+        else
+            j=max_out-1;
+        for(;j>0&&out[j-1].games<c.games;j--)
+            out[j]=out[j-1];
+        out[j]=c;
+    }
+    return n;
+}
+
+/* ==================== 生成 ==================== */
+
+void book_builder::add_game(const game_board &game,int max_plies)
+{
+    symmetric_keys k;
+    int winner=game.winner();
+    for(int i=0;i<game.moves()&&i<max_plies;i++)
+    {
+        int color=i%2?stone_white:stone_black;
+        int symmetry;
+        record r;
+        r.key=k.canonical(&symmetry);
+        r.cell=(uint16_t)book_transform(symmetry,game.move(i));
+        r.score=(int16_t)book_score_none;
+        r.games=1;
+        r.wins=winner==color;
+        r.draws=game.over()&&winner==stone_none;
+        r.order=(uint32_t)records.size();
+        records.push_back(r);
+        k.add(color,game.move(i));
+    }
+}
+
+void book_builder::add_score(const game_board &position,int cell,int score)
+{
+    int symmetry;
+    record r;
+    r.key=book_canonical_key(position,&symmetry);
+    r.cell=(uint16_t)book_transform(symmetry,cell);
+    // 评分压缩到16位：必胜/必败（engine_win附近）记为±book_score_win
+    if(score>=engine_win-1000)
+        score=book_score_win;
+    else if(score<=-engine_win+1000)
+        score=-book_score_win;
+    else
+        score=max(-book_score_win+1,min(book_score_win-1,score));
+    r.score=(int16_t)score;
+    r.games=r.wins=r.draws=0;
+    r.order=(uint32_t)records.size();
+    records.push_back(r);
+}
+
+bool book_builder::write(const char* path)
+{
+    sort(records.begin(),records.end(),[](const record &a,const record &b){
+        return a.key!=b.key?a.key<b.key:a.cell!=b.cell?a.cell<b.cell:a.order<b.order;
+    });
+    vector<book_position> pos;
+    vector<book_move> mv;
+    for(size_t i=0;i<records.size();)
+    {
+        const record &r=records[i];
+        if(pos.empty()||pos.back().key!=r.key)
+        {
+            book_position p;
+            p.key=r.key;
+            p.first=(uint32_t)mv.size();
+            p.count=0;
+            pos.push_back(p);
+        }
+        book_move m;
+        m.cell=r.cell;
+        m.score=(int16_t)book_score_none;
+        m.games=m.wins=m.draws=0;
+        for(;i<records.size()&&records[i].key==r.key&&records[i].cell==r.cell;i++)
+        {
+            m.games+=records[i].games;
+            m.wins+=records[i].wins;
+            m.draws+=records[i].draws;
+            if(records[i].score!=book_score_none)
+                m.score=records[i].score;
+        }
+        mv.push_back(m);
+        pos.back().count++;
+    }
+    position_count=pos.size();
+    move_count=mv.size();
+
+    book_header h;
+    memset(&h,0,sizeof(h));
+    memcpy(h.magic,book_magic,8);
+    h.version=book_version;
+    h.position_count=(uint32_t)pos.size();
+    h.move_count=mv.size();
+    FILE* f=fopen(path,"wb");
+    if(!f)
+        return false;
+    bool ok=fwrite(&h,sizeof(h),1,f)==1
+        &&(pos.empty()||fwrite(pos.data(),sizeof(book_position),pos.size(),f)==pos.size())
+        &&(mv.empty()||fwrite(mv.data(),sizeof(book_move),mv.size(),f)==mv.size());
+    ok=fclose(f)==0&&ok;
+    return ok;
+}
@@ -0,0 +1,204 @@
+/**
+ * @file opening_book.h
+ * @brief 开局库：按对称规范化的Zobrist键保存的落子统计（gobang_core库）
+ *
+ * 文件格式（小端，按下面三个结构体原样写入，打开时用mmap直接映射，不需要解析）：
+ * - book_header：魔数、版本、局面数、着法数
+ * - book_position数组：按键升序排列，每个局面指向着法数组中连续的一段
+ * - book_move数组：每个局面的后续着法及其对局数、胜局数、和局数和引擎评分
+ *
+ * 对称：棋盘有8种对称（旋转、翻转），同一局面的8个变换都归到键最小的那个（规范方向），
+ * 着法按规范方向保存，查询时再变换回当前棋盘的方向。查找是对局面数组的二分查找。
+ *
+ * 打开数百万个局面的开局库只做映射和检查文件头，耗时在毫秒级；页面在第一次访问时才读入，
+ * 多个窗口或进程打开同一个文件时共用同一份页面缓存
+ *
+ * 本文件只依赖C++标准库（映射文件在Linux上用mmap，在Windows上用MapViewOfFile），不依赖Qt
+ */
+
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+#include<stdint.h>
+#include<stddef.h>
+#include<vector>
+
+#include "game_board.h"
+#include "zobrist.h"
+
+const int book_version=1;
+const int book_score_none=-32768;       // 没有引擎评分
+const int book_score_win=30000;         // 引擎评分中的必胜（对落子方）
+
+/**
+ * @brief 文件头（32字节）
+ */
+struct book_header
+{
+    char magic[8];              // "GOBOOK\0\0"
+    uint32_t version;           // book_version
+    uint32_t position_count;    // 局面数
+    uint64_t move_count;        // 着法数
+    uint64_t reserved;
+};
+
+/**
+ * @brief 一个局面（16字节）
+ */
+struct book_position
+{
+    uint64_t key;               // 对称规范化的Zobrist键
+    uint32_t first;             // 第一个着法在着法数组中的下标
+    uint32_t count;             // 着法数
+};
+
+/**
+ * @brief 局面的一个后续着法（16字节）
+ */
+struct book_move
+{
+    uint16_t cell;              // 规范方向上的格子下标
+    int16_t score;              // 引擎评分（对落子方，±book_score_win为必胜/必败），没有时为book_score_none
+    uint32_t games;             // 走这步的对局数
+    uint32_t wins;              // 其中落子方获胜的对局数
+    uint32_t draws;             // 其中和棋的对局数
+};
+
+/**
+ * @brief 查询结果：当前棋盘方向上的一个后续着法
+ */
+struct book_continuation
+{
+    int move;                   // 格子下标
+    int games;
+    int wins;
+    int draws;
+    int score;                  // 引擎评分，没有时为book_score_none
+};
+
+/**
+ * @brief 对称变换t（0~7）下格子的位置：第0位左右翻转，第1位上下翻转，第2位再转置
+ */
+int book_transform(int t,int cell);
+int book_inverse_transform(int t,int cell);
+
+/**
+ * @brief 8个对称方向上的键，随落子增量更新（逐步求一局棋每个局面的规范键时不必每步重算）
+ */
+struct symmetric_keys
+{
+    uint64_t keys[8];
+
+    symmetric_keys() { for(int t=0;t<8;t++) keys[t]=0; }
+
+    void add(int color,int cell)
+    {
+        const zobrist_table &z=zobrist();
+        for(int t=0;t<8;t++)
+            keys[t]^=z(color,book_transform(t,cell));
+    }
+
+    // 最小的键及其变换（相同时取编号小的，生成和查询用同一规则）
+    uint64_t canonical(int* symmetry) const
+    {
+        int best=0;
+        for(int t=1;t<8;t++)
+            if(keys[t]<keys[best])
+                best=t;
+        *symmetry=best;
+        return keys[best];
+    }
+};
+
+/**
+ * @brief 局面的规范键
+ * @param symmetry 输出规范方向对应的变换（把当前棋盘变到规范方向）
+ */
+uint64_t book_canonical_key(const game_board &game,int* symmetry);
+
+/**
+ * @brief 只读的开局库（映射的文件）
+ */
+class opening_book
+{
+public:
+    opening_book();
+    ~opening_book();
+
+    /**
+     * @brief 映射开局库文件（之前打开的先关闭）
+     * @return bool 文件不存在或格式不对时返回false
+     */
+    bool open(const char* path);
+    void close();
+
+    bool is_open() const { return positions!=0; }
+    size_t size() const { return position_count; }
+
+    /**
+     * @brief 当前局面的后续着法，按对局数从多到少排列
+     * @return int 写入out的个数（最多max_out个），局面不在库中时为0
+     */
+    int lookup(const game_board &game,book_continuation* out,int max_out) const;
+
+private:
+    opening_book(const opening_book&);
+    opening_book& operator=(const opening_book&);
+
+    const book_position* positions;     // 映射的局面数组，没有打开时为空
+    const book_move* moves;             // 映射的着法数组
+    size_t position_count;
+    const void* base;                   // 映射的起始地址
+    size_t length;                      // 映射的长度
+#ifdef _WIN32
+    void* file;                         // 文件和映射对象的句柄
+    void* mapping;
+#endif
+};
+
+/**
+ * @brief 生成开局库：收集对局和引擎评分，排序合并后写成文件
+ */
+class book_builder
+{
+public:
+    /**
+     * @brief 记入一局棋的前max_plies步（按game的胜负统计）
+     */
+    void add_game(const game_board &game,int max_plies);
+
+    /**
+     * @brief 记入引擎对position局面下cell这步的评分（对落子方，engine_win附近为必胜/必败）
+     */
+    void add_score(const game_board &position,int cell,int score);
+
+    /**
+     * @brief 排序合并并写入文件
+     * @return bool 写入失败时返回false
+     */
+    bool write(const char* path);
+
+    /**
+     * @brief write()之后的局面数和着法数
+     */
+    size_t positions() const { return position_count; }
+    size_t moves() const { return move_count; }
+
+private:
+    struct record
+    {
+        uint64_t key;
+        uint16_t cell;
+        int16_t score;
+        uint32_t games;
+        uint32_t wins;
+        uint32_t draws;
+        uint32_t order;         // 记入的顺序（评分以最后一次为准）
+    };
+
+    std::vector<record> records;
+    size_t position_count=0;
+    size_t move_count=0;
+};
+
+#endif // OPENING_BOOK_H
@@ -0,0 +1,673 @@
+/**
+ * @file protocol.h
+ * @brief 二进制协议（v2）的编解码，服务器和客户端共用
+ *
+ * 帧格式（多字节整数一律为网络字节序）：
+ *
+ *     | 长度(2字节) | 操作码(1字节) | 负载(长度-1字节) |
+ *
+ * 长度字段包含操作码、不包含自身，接收方读出前2字节就知道整帧有多长，不需要逐字节查找分隔符。
+ * 落子只需要4个字节：长度、操作码、格子下标（x*15+y）。
+ *
+ * 版本协商：
+ * - 客户端连接后先发送文本帧"V2\n"，服务器回复"V2\n"，之后双方都改用二进制帧
+ * - 旧服务器不认识"V2"、不会回复，客户端等待超时后继续使用文本协议
+ * - 旧客户端从不发送"V2"，服务器对它一直使用文本协议
+ *
+ * 服务器的处理函数和客户端界面仍按原来的文本消息工作，二进制帧只在连接的两端与文本互相转换：
+ * - proto_from_text：文本消息 -> 二进制帧（无法识别的消息用op_text原样携带，不会丢失）
+ * - proto_to_text：二进制帧 -> 文本消息
+ * 两个函数互为逆运算。同一房间里一方是旧客户端时，由服务器在转发时完成转换。
+ *
+ * 本文件只依赖C++标准库，不依赖Qt和系统网络头文件
+ */
+
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include<stdint.h>
+#include<stddef.h>
+#include<stdio.h>
+#include<string.h>
+#include<string>
+
+const int proto_version=2;              // 二进制协议版本号
+const size_t proto_header=2;            // 长度字段的字节数
+const size_t proto_max_frame=1024;      // 长度字段的最大值（操作码+负载）
+const int proto_board=15;               // 棋盘边长，落子坐标编码为 x*proto_board+y
+
+/**
+ * @brief 操作码
+ *
+ * 注释中为对应的文本消息和负载格式（str表示负载剩余的全部字节）
+ */
+enum proto_op
+{
+    op_text=0,          // 无法识别的文本消息                     str 原文
+
+    // ===== 客户端 -> 服务器 =====
+    op_refresh=1,       // R
+    op_create=2,        // C:{房间名}                            str 房间名
+    op_exit=3,          // E
+    op_join=4,          // J{房间ID}                             u64 房间ID
+    op_update=5,        // U
+    op_subscribe=6,     // S / S1 / S0                           u8 模式（2全量 1增量 0退订）
+    op_query=7,         // Q{偏移}/{条数}/{前缀}                  u32 偏移, u16 条数, str 前缀
+    op_prepare=8,       // prepare
+    op_choose=9,        // color1 / color0                       u8 颜色（1黑 0白）
+    op_heartbeat=10,    // H（双向：服务器发送心跳，客户端收到后原样应答）
+    op_create_rule=11,  // C{规则}:{房间名}（指定对局规则）         u8 规则（game_rule）, str 房间名
+
+    // ===== 对战消息（双向，服务器转发给对手）=====
+    op_move=16,         // OM{x}{y}                              u8 格子下标
+    op_chat=17,         // ON{内容}                              str 内容
+    op_back=18,         // OB
+    op_back_reply=19,   // OB1 / OB0                             u8 是否同意
+    op_leave=20,        // OR
+    op_surrender=21,    // OS
+
+    // ===== 服务器 -> 客户端 =====
+    op_start=32,        // /Zstart
+    op_color=33,        // c1 / c0                               u8 颜色
+    op_join_result=34,  // /Zsuccess / /Zerror                   u8 是否成功
+    op_opponent=35,     // /Z{有对手}/Z{准备}/Z{IP}/Z{FD}         u8, u8, u32 IP, u32 FD
+    op_result=36,       // W{结果}（服务器判定的对局结果）         u8 结果（1黑胜 0白胜 2和棋）
+    op_rule=37,         // K{规则}（房间的对局规则，紧接在先后手之前） u8 规则（game_rule）
+    op_lobby_reset=40,  // L*
+    op_room=41,         // L+{房间ID}/{房主IP}/{房间名}           u64 房间ID, u32 IP, str 房间名
+    op_room_full=42,    // Lf{房间ID}                            u64 房间ID
+    op_room_closed=43,  // L-{房间ID}                            u64 房间ID
+    op_counts=44,       // L#{在线人数}/{空闲房间数}              u32, u32
+    op_page=45          // LQ{匹配总数}/{偏移}/{条数}             u32, u32, u32
+};
+
+/**
+ * @brief 是否为对战消息（服务器原样转发给对手）
+ */
+inline bool proto_is_relay(uint8_t op)
+{
+    return op>=op_move&&op<=op_surrender;
+}
+
+/* ==================== 落子坐标 ==================== */
+
+/**
+ * @brief 坐标值转文本协议中的字符（0-9直接用数字，10-14用a-e）
+ */
+inline char proto_coord_char(int v)
+{
+    return (char)(v<10?'0'+v:'a'+v-10);
+}
+
+/**
+ * @brief 文本协议中的坐标字符转坐标值
+ * @return int 非法字符返回-1
+ */
+inline int proto_coord_value(char ch)
+{
+    if(ch>='0'&&ch<='9')
+        return ch-'0';
+    if(ch>='a'&&ch<'a'+proto_board-10)
+        return ch-'a'+10;
+    return -1;
+}
+
+/* ==================== 字节序 ==================== */
+
+inline void proto_put8(std::string &out,uint32_t v) { out+=(char)(v&0xff); }
+inline void proto_put16(std::string &out,uint32_t v) { proto_put8(out,v>>8); proto_put8(out,v); }
+inline void proto_put32(std::string &out,uint32_t v) { proto_put16(out,v>>16); proto_put16(out,v); }
+inline void proto_put64(std::string &out,uint64_t v) { proto_put32(out,(uint32_t)(v>>32)); proto_put32(out,(uint32_t)v); }
+
+inline uint32_t proto_get16(const unsigned char* p) { return ((uint32_t)p[0]<<8)|p[1]; }
+inline uint32_t proto_get32(const unsigned char* p) { return (proto_get16(p)<<16)|proto_get16(p+2); }
+inline uint64_t proto_get64(const unsigned char* p) { return ((uint64_t)proto_get32(p)<<32)|proto_get32(p+4); }
+
+/* ==================== 分帧 ==================== */
+
+/**
+ * @brief 在输出缓冲区末尾开始一帧（先占位长度字段）
+ * @param out 输出缓冲区
+ * @param op 操作码
+ * @return size_t 帧在缓冲区中的起始位置，交给proto_end回填长度
+ */
+inline size_t proto_begin(std::string &out,uint8_t op)
+{
+    size_t at=out.size();
+    out.append(proto_header,'\0');
+    proto_put8(out,op);
+    return at;
+}
+
+/**
+ * @brief 结束一帧，回填长度字段
+ * @param out 输出缓冲区
+ * @param at proto_begin的返回值
+ */
+inline void proto_end(std::string &out,size_t at)
+{
+    size_t len=out.size()-at-proto_header;
+    out[at]=(char)(len>>8);
+    out[at+1]=(char)len;
+}
+
+/**
+ * @brief 检查缓冲区开头是否已经是一个完整的帧
+ * @param data 接收缓冲区
+ * @param size 缓冲区中的字节数
+ * @return long 完整帧的总字节数（含长度字段）；数据不足返回0；长度字段非法返回-1
+ */
+inline long proto_frame_size(const char* data,size_t size)
+{
+    if(size<proto_header)
+        return 0;
+    size_t len=proto_get16((const unsigned char*)data);
+    if(len==0||len>proto_max_frame)
+        return -1;
+    if(size<proto_header+len)
+        return 0;
+    return (long)(proto_header+len);
+}
+
+/**
+ * @brief 编码落子帧
+ * @param out 输出缓冲区
+ * @param x 横坐标
+ * @param y 纵坐标
+ */
+inline void proto_move(std::string &out,int x,int y)
+{
+    size_t at=proto_begin(out,op_move);
+    proto_put8(out,(uint32_t)(x*proto_board+y));
+    proto_end(out,at);
+}
+
+/* ==================== 文本解析辅助 ==================== */
+
+/**
+ * @brief 解析不带前导零的十进制整数（与snprintf("%llu")的输出一一对应）
+ * @param p 起始位置
+ * @param end 结束位置
+ * @param max 允许的最大值
+ * @param v 输出：解析结果
+ * @return const char* 数字之后的位置，不是合法数字或超过max时返回NULL
+ */
+inline const char* proto_parse_uint(const char* p,const char* end,uint64_t max,uint64_t &v)
+{
+    if(p>=end||*p<'0'||*p>'9')
+        return NULL;
+    if(*p=='0'&&p+1<end&&p[1]>='0'&&p[1]<='9')
+        return NULL;
+    v=0;
+    for(;p<end&&*p>='0'&&*p<='9';p++)
+    {
+        uint64_t d=(uint64_t)(*p-'0');
+        if(v>(max-d)/10)
+            return NULL;
+        v=v*10+d;
+    }
+    return p;
+}
+
+/**
+ * @brief 解析点分十进制IPv4地址
+ * @param ip 输出：按书写顺序排列的32位地址（第一段为最高字节）
+ * @return const char* 地址之后的位置，不合法时返回NULL
+ */
+inline const char* proto_parse_ip(const char* p,const char* end,uint32_t &ip)
+{
+    ip=0;
+    for(int i=0;i<4;i++)
+    {
+        uint64_t part;
+        if(i>0)
+        {
+            if(p>=end||*p!='.')
+                return NULL;
+            p++;
+        }
+        if(!(p=proto_parse_uint(p,end,255,part)))
+            return NULL;
+        ip=(ip<<8)|(uint32_t)part;
+    }
+    return p;
+}
+
+/**
+ * @brief IPv4地址转点分十进制
+ * @param ip 按书写顺序排列的32位地址
+ * @param buf 输出缓冲区（至少16字节）
+ */
+inline void proto_format_ip(uint32_t ip,char* buf)
+{
+    snprintf(buf,16,"%u.%u.%u.%u",ip>>24,(ip>>16)&0xff,(ip>>8)&0xff,ip&0xff);
+}
+
+inline bool proto_equal(const char* msg,size_t len,const char* s)
+{
+    return len==strlen(s)&&memcmp(msg,s,len)==0;
+}
+
+/* ==================== 文本 <-> 二进制 ==================== */
+
+/**
+ * @brief 文本消息编码为二进制帧
+ * @param msg 文本消息（不含分隔符'\n'）
+ * @param len 消息长度
+ * @param out 输出缓冲区（帧追加在末尾）
+ * @return bool 消息超过帧的最大长度时返回false，不输出任何内容
+ *
+ * 只有完全符合某种消息格式的文本才编码为对应的类型，其余一律用op_text携带原文，
+ * 因此对任何文本都有 proto_to_text(proto_from_text(msg)) == msg
+ */
+inline bool proto_from_text(const char* msg,size_t len,std::string &out)
+{
+    if(len+1>proto_max_frame)
+        return false;
+
+    const char* end=msg+len;
+    const char* p;
+    uint64_t a,b,c;
+    uint32_t ip;
+    size_t at;
+
+    switch(len?msg[0]:'\0')
+    {
+    case 'O':       // 对战消息
+        if(len==4&&msg[1]=='M')
+        {
+            int x=proto_coord_value(msg[2]),y=proto_coord_value(msg[3]);
+            if(x>=0&&y>=0)
+            {
+                proto_move(out,x,y);
+                return true;
+            }
+        }
+        if(len>=2&&msg[1]=='N')
+        {
+            at=proto_begin(out,op_chat);
+            out.append(msg+2,len-2);
+            proto_end(out,at);
+            return true;
+        }
+        if(proto_equal(msg,len,"OB"))
+        {
+            proto_end(out,proto_begin(out,op_back));
+            return true;
+        }
+        if(proto_equal(msg,len,"OB1")||proto_equal(msg,len,"OB0"))
+        {
+            at=proto_begin(out,op_back_reply);
+            proto_put8(out,msg[2]=='1');
+            proto_end(out,at);
+            return true;
+        }
+        if(proto_equal(msg,len,"OR"))
+        {
+            proto_end(out,proto_begin(out,op_leave));
+            return true;
+        }
+        if(proto_equal(msg,len,"OS"))
+        {
+            proto_end(out,proto_begin(out,op_surrender));
+            return true;
+        }
+        break;
+    case 'R':
+        if(len==1)
+        {
+            proto_end(out,proto_begin(out,op_refresh));
+            return true;
+        }
+        break;
+    case 'H':
+        if(len==1)
+        {
+            proto_end(out,proto_begin(out,op_heartbeat));
+            return true;
+        }
+        break;
+    case 'C':
+        if(len>=2&&msg[1]==':')
+        {
+            at=proto_begin(out,op_create);
+            out.append(msg+2,len-2);
+            proto_end(out,at);
+            return true;
+        }
+        if(len>=3&&msg[1]>='0'&&msg[1]<='9'&&msg[2]==':')
+        {
+            at=proto_begin(out,op_create_rule);
+            proto_put8(out,msg[1]-'0');
+            out.append(msg+3,len-3);
+            proto_end(out,at);
+            return true;
+        }
+        break;
+    case 'K':
+        if(len==2&&msg[1]>='0'&&msg[1]<='9')
+        {
+            at=proto_begin(out,op_rule);
+            proto_put8(out,msg[1]-'0');
+            proto_end(out,at);
+            return true;
+        }
+        break;
+    case 'E':
+        if(len==1)
+        {
+            proto_end(out,proto_begin(out,op_exit));
+            return true;
+        }
+        break;
+    case 'J':
+        if((p=proto_parse_uint(msg+1,end,UINT64_MAX,a))&&p==end)
+        {
+            at=proto_begin(out,op_join);
+            proto_put64(out,a);
+            proto_end(out,at);
+            return true;
+        }
+        break;
+    case 'U':
+        if(len==1)
+        {
+            proto_end(out,proto_begin(out,op_update));
+            return true;
+        }
+        break;
+    case 'S':
+        if(len==1||proto_equal(msg,len,"S1")||proto_equal(msg,len,"S0"))
+        {
+            at=proto_begin(out,op_subscribe);
+            proto_put8(out,len==1?2:msg[1]-'0');
+            proto_end(out,at);
+            return true;
+        }
+        break;
+    case 'Q':
+        if((p=proto_parse_uint(msg+1,end,UINT32_MAX,a))&&p<end&&*p=='/'
+            &&(p=proto_parse_uint(p+1,end,0xffff,b))&&p<end&&*p=='/')
+        {
+            at=proto_begin(out,op_query);
+            proto_put32(out,(uint32_t)a);
+            proto_put16(out,(uint32_t)b);
+            out.append(p+1,end-p-1);
+            proto_end(out,at);
+            return true;
+        }
+        break;
+    case 'p':
+        if(proto_equal(msg,len,"prepare"))
+        {
+            proto_end(out,proto_begin(out,op_prepare));
+            return true;
+        }
+        break;
+    case 'W':
+        if(len==2&&msg[1]>='0'&&msg[1]<='2')
+        {
+            at=proto_begin(out,op_result);
+            proto_put8(out,msg[1]-'0');
+            proto_end(out,at);
+            return true;
+        }
+        break;
+    case 'c':
+        if(proto_equal(msg,len,"color1")||proto_equal(msg,len,"color0"))
+        {
+            at=proto_begin(out,op_choose);
+            proto_put8(out,msg[5]=='1');
+            proto_end(out,at);
+            return true;
+        }
+        if(proto_equal(msg,len,"c1")||proto_equal(msg,len,"c0"))
+        {
+            at=proto_begin(out,op_color);
+            proto_put8(out,msg[1]=='1');
+            proto_end(out,at);
+            return true;
+        }
+        break;
+    case '/':       // 服务器应答
+        if(proto_equal(msg,len,"/Zstart"))
+        {
+            proto_end(out,proto_begin(out,op_start));
+            return true;
+        }
+        if(proto_equal(msg,len,"/Zsuccess")||proto_equal(msg,len,"/Zerror"))
+        {
+            at=proto_begin(out,op_join_result);
+            proto_put8(out,msg[2]=='s');
+            proto_end(out,at);
+            return true;
+        }
+        if(proto_equal(msg,len,"/Z0/Z /Z /Z "))
+        {
+            at=proto_begin(out,op_opponent);
+            proto_put16(out,0);
+            proto_put64(out,0);
+            proto_end(out,at);
+            return true;
+        }
+        // /Z1/Z{准备}/Z{IP}/Z{FD}
+        if(len>8&&memcmp(msg,"/Z1/Z",5)==0&&(msg[5]=='0'||msg[5]=='1')&&memcmp(msg+6,"/Z",2)==0
+            &&(p=proto_parse_ip(msg+8,end,ip))&&end-p>2&&memcmp(p,"/Z",2)==0
+            &&(p=proto_parse_uint(p+2,end,UINT32_MAX,a))&&p==end)
+        {
+            at=proto_begin(out,op_opponent);
+            proto_put8(out,1);
+            proto_put8(out,msg[5]-'0');
+            proto_put32(out,ip);
+            proto_put32(out,(uint32_t)a);
+            proto_end(out,at);
+            return true;
+        }
+        break;
+    case 'L':       // 大厅推送
+        if(proto_equal(msg,len,"L*"))
+        {
+            proto_end(out,proto_begin(out,op_lobby_reset));
+            return true;
+        }
+        if(len<2)
+            break;
+        if(msg[1]=='+'&&(p=proto_parse_uint(msg+2,end,UINT64_MAX,a))&&p<end&&*p=='/'
+            &&(p=proto_parse_ip(p+1,end,ip))&&p<end&&*p=='/')
+        {
+            at=proto_begin(out,op_room);
+            proto_put64(out,a);
+            proto_put32(out,ip);
+            out.append(p+1,end-p-1);
+            proto_end(out,at);
+            return true;
+        }
+        if((msg[1]=='f'||msg[1]=='-')&&(p=proto_parse_uint(msg+2,end,UINT64_MAX,a))&&p==end)
+        {
+            at=proto_begin(out,msg[1]=='f'?op_room_full:op_room_closed);
+            proto_put64(out,a);
+            proto_end(out,at);
+            return true;
+        }
+        if(msg[1]=='#'&&(p=proto_parse_uint(msg+2,end,UINT32_MAX,a))&&p<end&&*p=='/'
+            &&(p=proto_parse_uint(p+1,end,UINT32_MAX,b))&&p==end)
+        {
+            at=proto_begin(out,op_counts);
+            proto_put32(out,(uint32_t)a);
+            proto_put32(out,(uint32_t)b);
+            proto_end(out,at);
+            return true;
+        }
+        if(msg[1]=='Q'&&(p=proto_parse_uint(msg+2,end,UINT32_MAX,a))&&p<end&&*p=='/'
+            &&(p=proto_parse_uint(p+1,end,UINT32_MAX,b))&&p<end&&*p=='/'
+            &&(p=proto_parse_uint(p+1,end,UINT32_MAX,c))&&p==end)
+        {
+            at=proto_begin(out,op_page);
+            proto_put32(out,(uint32_t)a);
+            proto_put32(out,(uint32_t)b);
+            proto_put32(out,(uint32_t)c);
+            proto_end(out,at);
+            return true;
+        }
+        break;
+    }
+
+    at=proto_begin(out,op_text);
+    out.append(msg,len);
+    proto_end(out,at);
+    return true;
+}
+
+/**
+ * @brief 把多条以'\n'结尾的文本帧逐条编码为二进制帧
+ * @param data 文本帧
+ * @param len 数据长度
+ * @param out 输出缓冲区
+ */
+inline void proto_from_frames(const char* data,size_t len,std::string &out)
+{
+    const char* end=data+len;
+    while(data<end)
+    {
+        const char* nl=(const char*)memchr(data,'\n',end-data);
+        if(!nl)
+            nl=end;
+        proto_from_text(data,nl-data,out);
+        data=nl+1;
+    }
+}
+
+/**
+ * @brief 二进制帧解码为文本消息
+ * @param frame 一个完整的帧（含长度字段，由proto_frame_size确认）
+ * @param size 帧的总字节数
+ * @param text 输出：文本消息（不含分隔符'\n'）
+ * @return bool 未知操作码或负载长度与操作码不符时返回false
+ */
+inline bool proto_to_text(const char* frame,size_t size,std::string &text)
+{
+    const unsigned char* p=(const unsigned char*)frame+proto_header+1;
+    size_t n=size-proto_header-1;       // 负载长度
+    char buf[96];
+    char ip[16];
+
+    switch((unsigned char)frame[proto_header])
+    {
+    case op_text:       text.assign((const char*)p,n); return true;
+    case op_refresh:    text="R"; return n==0;
+    case op_create:     text.assign("C:").append((const char*)p,n); return true;
+    case op_create_rule:
+        if(n<1||p[0]>9)
+            return false;
+        snprintf(buf,sizeof(buf),"C%d:",p[0]);
+        text.assign(buf).append((const char*)p+1,n-1);
+        return true;
+    case op_exit:       text="E"; return n==0;
+    case op_join:
+        if(n!=8)
+            return false;
+        snprintf(buf,sizeof(buf),"J%llu",(unsigned long long)proto_get64(p));
+        break;
+    case op_update:     text="U"; return n==0;
+    case op_subscribe:
+        if(n!=1||p[0]>2)
+            return false;
+        text=p[0]==2?"S":p[0]==1?"S1":"S0";
+        return true;
+    case op_query:
+        if(n<6)
+            return false;
+        snprintf(buf,sizeof(buf),"Q%u/%u/",proto_get32(p),proto_get16(p+4));
+        text.assign(buf).append((const char*)p+6,n-6);
+        return true;
+    case op_prepare:    text="prepare"; return n==0;
+    case op_heartbeat:  text="H"; return n==0;
+    case op_choose:
+        if(n!=1)
+            return false;
+        text=p[0]?"color1":"color0";
+        return true;
+
+    case op_move:
+        if(n!=1||p[0]>=proto_board*proto_board)
+            return false;
+        text="OM";
+        text+=proto_coord_char(p[0]/proto_board);
+        text+=proto_coord_char(p[0]%proto_board);
+        return true;
+    case op_chat:       text.assign("ON").append((const char*)p,n); return true;
+    case op_back:       text="OB"; return n==0;
+    case op_back_reply:
+        if(n!=1)
+            return false;
+        text=p[0]?"OB1":"OB0";
+        return true;
+    case op_leave:      text="OR"; return n==0;
+    case op_surrender:  text="OS"; return n==0;
+
+    case op_start:      text="/Zstart"; return n==0;
+    case op_color:
+        if(n!=1)
+            return false;
+        text=p[0]?"c1":"c0";
+        return true;
+    case op_join_result:
+        if(n!=1)
+            return false;
+        text=p[0]?"/Zsuccess":"/Zerror";
+        return true;
+    case op_result:
+        if(n!=1||p[0]>2)
+            return false;
+        text="W";
+        text+=(char)('0'+p[0]);
+        return true;
+    case op_rule:
+        if(n!=1||p[0]>9)
+            return false;
+        text="K";
+        text+=(char)('0'+p[0]);
+        return true;
+    case op_opponent:
+        if(n!=10)
+            return false;
+        if(!p[0])
+        {
+            text="/Z0/Z /Z /Z ";
+            return true;
+        }
+        proto_format_ip(proto_get32(p+2),ip);
+        snprintf(buf,sizeof(buf),"/Z1/Z%d/Z%s/Z%u",p[1],ip,proto_get32(p+6));
+        break;
+    case op_lobby_reset: text="L*"; return n==0;
+    case op_room:
+        if(n<12)
+            return false;
+        proto_format_ip(proto_get32(p+8),ip);
+        snprintf(buf,sizeof(buf),"L+%llu/%s/",(unsigned long long)proto_get64(p),ip);
+        text.assign(buf).append((const char*)p+12,n-12);
+        return true;
+    case op_room_full:
+    case op_room_closed:
+        if(n!=8)
+            return false;
+        snprintf(buf,sizeof(buf),"L%c%llu",frame[proto_header]==op_room_full?'f':'-',(unsigned long long)proto_get64(p));
+        break;
+    case op_counts:
+        if(n!=8)
+            return false;
+        snprintf(buf,sizeof(buf),"L#%u/%u",proto_get32(p),proto_get32(p+4));
+        break;
+    case op_page:
+        if(n!=12)
+            return false;
+        snprintf(buf,sizeof(buf),"LQ%u/%u/%u",proto_get32(p),proto_get32(p+4),proto_get32(p+8));
+        break;
+    default:
+        return false;
+    }
+    text=buf;
+    return true;
+}
+
+#endif // PROTOCOL_H
@@ -0,0 +1,196 @@
+/**
+ * @file renju.cpp
+ * @brief 连珠规则的禁手判定（gobang_core库）
+ */
+
+#include "renju.h"
+#include "bitboard.h"
+
+#include<algorithm>
+
+using namespace std;
+
+namespace
+{
+
+const int reach=5;              // 一条线上读取落子点两侧的格数
+const int line_cells=2*reach+1;
+const int max_placed=16;        // 递归时假设落下的黑子数的上限（超过时当作不是禁手）
+
+/**
+ * @brief 中心所在的连续黑子数
+ */
+int run_length(const int* v)
+{
+    int len=1;
+    for(int k=reach+1;k<line_cells&&v[k]==1;k++)
+        len++;
+    for(int k=reach-1;k>=0&&v[k]==1;k--)
+        len++;
+    return len;
+}
+
+/**
+ * @brief 包含中心的四的个数：4黑1空、补上空位恰好五连的5格窗口，按4个黑子的位置去重
+ *        （活四的两个窗口是同一组黑子，只算一个）
+ */
+int four_count(const int* v)
+{
+    int masks[5],n=0;
+    for(int a=reach-4;a<=reach;a++)
+    {
+        int stones=0,empties=0,mask=0;
+        for(int k=a;k<a+5;k++)
+        {
+            stones+=v[k]==1;
+            empties+=v[k]==0;
+            mask|=(v[k]==1)<<k;
+        }
+        if(stones!=4||empties!=1||v[a-1]==1||v[a+5]==1)
+            continue;
+        bool seen=false;
+        for(int i=0;i<n;i++)
+            seen|=masks[i]==mask;
+        if(!seen)
+            masks[n++]=mask;
+    }
+    return n;
+}
+
+/**
+ * @brief 在空位e补一子后，是否有包含中心和e的活四（连续4子，两端都是空位且都能恰好连五）
+ */
+bool straight_four(const int* v,int e)
+{
+    for(int a=max(reach,e)-3;a<=min(reach,e);a++)
+    {
+        bool run=true;
+        for(int k=a;k<a+4;k++)
+            run&=k==e||v[k]==1;
+        if(run&&v[a-1]==0&&v[a+4]==0&&v[a-2]!=1&&v[a+5]!=1)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief 棋盘加上判定过程中假设落下的黑子（不修改调用者的数组）
+ */
+struct renju_view
+{
+    const int8_t* cells;
+    int dirs[4];
+    int8_t empty;
+    int placed[max_placed];
+    int n;
+    bool local;     // 没有递归检查过补三点
+
+    // 0空位 1黑子 2阻挡
+    int at(int p) const
+    {
+        for(int i=0;i<n;i++)
+            if(placed[i]==p)
+                return 1;
+        return cells[p]==stone_black?1:cells[p]==empty?0:2;
+    }
+
+    // s两侧各reach格，遇到阻挡后更远的格子都记为阻挡（因此不会越过边界读取）
+    void line(int s,int dir,int* v) const
+    {
+        v[reach]=at(s);
+        for(int side=-1;side<=1;side+=2)
+        {
+            bool blocked=false;
+            for(int k=1;k<=reach;k++)
+            {
+                int c=blocked?2:at(s+side*k*dir);
+                blocked=c==2;
+                v[reach+side*k]=c;
+            }
+        }
+    }
+
+    // 这条线上能形成活四的补三点（不检查补三点是否禁手），没有时返回-1
+    static int three_point(const int* v,int from)
+    {
+        for(int e=from;e<=reach+3;e++)
+            if(v[e]==0&&straight_four(v,e))
+                return e;
+        return -1;
+    }
+
+    int check(int s)
+    {
+        if(n==max_placed)
+            return forbid_none;
+        placed[n++]=s;
+        int v[4][line_cells];
+        bool five=false,overline=false;
+        for(int d=0;d<4;d++)
+        {
+            line(s,dirs[d],v[d]);
+            int len=run_length(v[d]);
+            five|=len==5;
+            overline|=len>5;
+        }
+        // 恰好五连优先于一切禁手
+        int result=forbid_none;
+        if(!five&&overline)
+            result=forbid_overline;
+        else if(!five)
+        {
+            int fours=0,shapes=0;
+            bool three[4];
+            for(int d=0;d<4;d++)
+            {
+                int f=four_count(v[d]);
+                fours+=f;
+                // 有四的方向不再算三
+                three[d]=!f&&three_point(v[d],reach-3)>=0;
+                shapes+=three[d];
+            }
+            if(fours>=2)
+                result=forbid_double_four;
+            else if(shapes>=2)
+            {
+                // 至少两个方向有活三的形状时，才逐个检查补三点是否禁手
+                local=false;
+                int threes=0;
+                for(int d=0;d<4&&threes<2;d++)
+                {
+                    if(!three[d])
+                        continue;
+                    for(int e=three_point(v[d],reach-3);e>=0;e=three_point(v[d],e+1))
+                        if(check(s+(e-reach)*dirs[d])==forbid_none)
+                        {
+                            threes++;
+                            break;
+                        }
+                }
+                if(threes>=2)
+                    result=forbid_double_three;
+            }
+        }
+        n--;
+        return result;
+    }
+};
+
+}
+
+int renju_forbidden(const int8_t* cells,int width,int s,int8_t empty,bool* local)
+{
+    renju_view view;
+    view.cells=cells;
+    view.dirs[0]=1;
+    view.dirs[1]=width;
+    view.dirs[2]=width+1;
+    view.dirs[3]=width-1;
+    view.empty=empty;
+    view.n=0;
+    view.local=true;
+    int result=view.check(s);
+    if(local)
+        *local=view.local;
+    return result;
+}
@@ -0,0 +1,60 @@
+/**
+ * @file renju.h
+ * @brief 连珠（Renju）规则：黑方禁手判定（gobang_core库）
+ *
+ * 连珠规则下黑方只有恰好五连才算胜，以下落子是禁手（白方没有禁手，五连或长连都算胜）：
+ * - 长连：形成六子或更长的连珠
+ * - 双四：一步同时形成两个四（包括同一条线上的 X.XXX.X 补中间）
+ * - 双三：一步同时形成两个活三
+ * 同时形成恰好五连时不算禁手。
+ *
+ * 四：再下一子就能恰好连五；两端都能连五的连续四子（活四）只算一个四。
+ * 活三：再下一子能形成活四，并且下这一子的点本身不是禁手。后一个条件要在落子之后的棋盘上
+ * 对那个点再做一次完整的禁手判定，所以双三的判定是递归的。
+ *
+ * 判定只读取落子点四个方向上两侧各5格（递归时是补三的点两侧各5格）。先按每个方向上的
+ * 连子数、冲四数和活三的形状（不递归）筛选，只有至少两个方向上有活三形状时才递归验证，
+ * 绝大多数空位不需要递归。
+ *
+ * 本文件只依赖C++标准库，不依赖Qt
+ */
+
+#ifndef RENJU_H
+#define RENJU_H
+
+#include<stdint.h>
+
+/**
+ * @brief 对局规则
+ */
+enum game_rule
+{
+    rule_freestyle=0,   // 无禁手：双方五连或长连都算胜
+    rule_renju=1        // 连珠：黑方有禁手，只有恰好五连算胜
+};
+
+const int rule_count=2;
+
+/**
+ * @brief 禁手的种类
+ */
+enum forbidden_kind
+{
+    forbid_none=0,          // 不是禁手
+    forbid_overline=1,      // 长连
+    forbid_double_four=2,   // 双四
+    forbid_double_three=3   // 双三
+};
+
+/**
+ * @brief 黑方在空位s落子是否为禁手
+ * @param cells 一维棋盘：黑子为stone_black，空位为empty，其他值（白子、边界）都算阻挡。
+ *              棋盘四周至少要有一圈边界，沿四个方向的步长为1、width、width+1、width-1
+ * @param s 落子点（空位）
+ * @param local 输出（可以为NULL）：结果只由s四个方向上两侧各5格决定时为true；
+ *              需要递归检查补三点时为false（这时结果还与补三点所在的其他线有关）
+ * @return int 禁手的种类（forbidden_kind），判定过程中假设的落子不写入cells
+ */
+int renju_forbidden(const int8_t* cells,int width,int s,int8_t empty,bool* local=0);
+
+#endif // RENJU_H
@@ -0,0 +1,659 @@
+/**
+ * @file test.cpp
+ * @brief gobang_core库单元测试（不依赖Qt和网络，Linux下直接用g++编译，几秒内跑完）
+ *
+ * - 轮次与落子：黑方先手、交替落子，越界、重复落子、结束后落子被拒绝且棋盘不变
+ * - 悔棋：逐步撤销恢复轮次、棋子和Zobrist键，撤销获胜的一步后对局继续
+ * - 五连：四个方向、贴边和角上的五连，断开的四子不算；下满为和棋
+ * - 位棋盘：固定种子的随机对局上，与逐格扫描的五连判定逐步比对（15路和19路）
+ * - 整局规则：随机对局用game_board下到结束，与位棋盘判定的结束步数、胜方比对，再悔棋到空棋盘
+ * - 连珠禁手：已知棋形的禁手种类，随机连珠局面的每个空位与按定义逐格递归的判定比对，
+ *   黑方长连、双四、双三被拒绝，白方长连获胜；只搜2层的电脑在连珠规则下对局的前60步不走禁手
+ * - 开局库：小规模随机对局生成开局库，每个局面都能查到实际的下一步，对称变换后的局面查到同样的统计
+ * - 电脑对手：1个和4个线程各搜几个局面，给出的都是空位
+ *
+ * 随机数都用固定种子，每次运行结果相同；任何一项不符时打印前几处并以非0退出
+ *
+ * 用法: ./core_test [对局数]   （make test用默认的2000局）
+ *
+ * 对局数为位棋盘与逐格扫描比对、整局规则检查的随机对局数（15路和19路各这么多局）；
+ * make verify用1000000局，在数百万个随机对局上比对位棋盘和原来的逐格扫描（约需一分钟）
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<vector>
+#include<algorithm>
+
+#include "bitboard.h"
+#include "game_board.h"
+#include "engine.h"
+#include "opening_book.h"
+#include "zobrist.h"
+
+using namespace std;
+
+static int failures=0;
+
+/**
+ * @brief 检查一项结果，不符时打印（每组最多打印前几处）并计数
+ */
+#define CHECK(cond,...) do{ if(!(cond)){ if(failures<20){ printf("  FAIL %s:%d: ",__FILE__,__LINE__); printf(__VA_ARGS__); printf("\n"); } failures++; } }while(0)
+
+#define C(x,y) ((x)*board_size+(y))
+
+/**
+ * @brief 按黑、白交替摆出黑子和白子（白子少一个时由最后一颗黑子结束）
+ */
+static bool setup(game_board &game,const int* black,int nb,const int* white,int nw)
+{
+    for(int i=0;i<nb;i++)
+    {
+        if(game.play(black[i])!=play_ok)
+            return false;
+        if(i<nw&&game.play(white[i])!=play_ok)
+            return false;
+    }
+    return true;
+}
+
+/* ==================== 轮次、落子与悔棋 ==================== */
+
+static void test_turns()
+{
+    game_board game;
+    CHECK(game.moves()==0&&game.to_move()==stone_black&&game.last()==-1&&!game.over()&&game.winner()==stone_none&&game.key()==0,"empty board");
+
+    CHECK(game.play(7,7)==play_ok,"first move");
+    CHECK(game.at(7,7)==stone_black&&game.at(C(7,7))==stone_black&&game.to_move()==stone_white&&game.last()==C(7,7)&&game.moves()==1,"black moved first");
+
+    // 重复落子、越界：棋盘不变
+    uint64_t key=game.key();
+    CHECK(game.play(7,7)==play_illegal,"occupied cell");
+    CHECK(game.play(-1,0)==play_illegal&&game.play(0,board_size)==play_illegal&&game.play(board_size,0)==play_illegal,"off the board");
+    CHECK(game.play(-1)==play_illegal&&game.play(board_cells)==play_illegal,"cell index out of range");
+    CHECK(game.moves()==1&&game.to_move()==stone_white&&game.key()==key,"board unchanged after illegal moves");
+
+    CHECK(game.play(7,8)==play_ok&&game.at(7,8)==stone_white&&game.to_move()==stone_black,"white second");
+    CHECK(game.play(0,0)==play_ok&&game.at(0,0)==stone_black&&game.move(0)==C(7,7)&&game.move(1)==C(7,8)&&game.move(2)==C(0,0),"alternating colours and history");
+
+    // 悔棋：逐步撤销，轮次、最后一步和键随之恢复
+    const zobrist_table &keys=zobrist();
+    CHECK(game.key()==keys.key(game),"incremental key");
+    CHECK(game.undo()&&game.at(0,0)==stone_none&&game.to_move()==stone_black&&game.last()==C(7,8)&&game.key()==keys.key(game),"undo third move");
+    CHECK(game.undo()&&game.at(7,8)==stone_none&&game.to_move()==stone_white&&game.last()==C(7,7)&&game.key()==key,"undo second move");
+    CHECK(game.undo()&&game.moves()==0&&game.key()==0&&game.last()==-1,"undo first move");
+    CHECK(!game.undo()&&game.moves()==0,"undo on an empty board");
+
+    // 悔棋后可以落在撤销的格子上
+    CHECK(game.play(7,7)==play_ok&&game.play(7,8)==play_ok,"replay undone cells");
+
+    // reset清空棋盘但保留规则
+    game.set_rule(rule_renju);
+    game.reset();
+    CHECK(game.moves()==0&&game.key()==0&&game.rule()==rule_renju&&game.at(7,7)==stone_none,"reset keeps the rule");
+}
+
+/* ==================== 五连 ==================== */
+
+static void test_five()
+{
+    // 四个方向，含贴边和角上的五连：黑方连五，白方随便落在远处
+    struct line
+    {
+        const char* name;
+        int black[5];
+        int white[4];
+    };
+    const line lines[]={
+        {"horizontal",{C(7,3),C(7,4),C(7,5),C(7,6),C(7,7)},{C(0,0),C(0,2),C(0,4),C(0,6)}},
+        {"vertical",{C(3,7),C(4,7),C(5,7),C(6,7),C(7,7)},{C(0,0),C(0,2),C(0,4),C(0,6)}},
+        {"diagonal",{C(3,3),C(4,4),C(5,5),C(6,6),C(7,7)},{C(0,14),C(0,12),C(0,10),C(0,8)}},
+        {"anti-diagonal",{C(3,11),C(4,10),C(5,9),C(6,8),C(7,7)},{C(0,0),C(0,2),C(0,4),C(0,6)}},
+        {"top edge",{C(0,10),C(0,11),C(0,12),C(0,13),C(0,14)},{C(7,0),C(7,2),C(7,4),C(7,6)}},
+        {"left edge",{C(10,0),C(11,0),C(12,0),C(13,0),C(14,0)},{C(7,7),C(7,9),C(7,11),C(7,13)}},
+        {"into a corner",{C(10,10),C(11,11),C(12,12),C(13,13),C(14,14)},{C(0,0),C(0,2),C(0,4),C(0,6)}},
+        {"from a corner",{C(14,0),C(13,1),C(12,2),C(11,3),C(10,4)},{C(0,0),C(0,2),C(0,4),C(0,6)}},
+    };
+    for(size_t i=0;i<sizeof(lines)/sizeof(lines[0]);i++)
+    {
+        const line &t=lines[i];
+        game_board game;
+        CHECK(setup(game,t.black,4,t.white,4),"%s: setup",t.name);
+        CHECK(game.winner()==stone_none&&!game.over(),"%s: four is not a win",t.name);
+        CHECK(game.play(t.black[4])==play_five,"%s: five",t.name);
+        CHECK(game.winner()==stone_black&&game.over(),"%s: black wins",t.name);
+        CHECK(game.play(C(1,1))==play_illegal&&game.moves()==9,"%s: no move after the end",t.name);
+
+        // 撤销获胜的一步后对局继续
+        CHECK(game.undo()&&game.winner()==stone_none&&!game.over()&&game.to_move()==stone_black,"%s: undo the winning move",t.name);
+        CHECK(game.play(C(1,1))==play_ok,"%s: play on after undo",t.name);
+    }
+
+    // 白方五连
+    {
+        game_board game;
+        const int black[]={C(0,0),C(0,2),C(0,4),C(0,6),C(0,8)};
+        const int white[]={C(9,1),C(9,2),C(9,3),C(9,4)};
+        CHECK(setup(game,black,5,white,4)&&game.play(C(9,5))==play_five&&game.winner()==stone_white,"white five");
+    }
+
+    // 中间断开的五子不算
+    {
+        game_board game;
+        const int black[]={C(7,2),C(7,3),C(7,5),C(7,6),C(7,7)};
+        const int white[]={C(0,0),C(0,2),C(0,4),C(0,6)};
+        CHECK(setup(game,black,5,white,4)&&game.winner()==stone_none,"broken line is not five");
+        CHECK(game.play(C(1,1))==play_ok&&game.play(C(7,4))==play_five,"filling the gap makes six, a win in freestyle");
+    }
+
+    // 下满为和棋：((x/2)+y)%2的花纹在任何方向上最多连两个
+    {
+        int parity_black=0;
+        for(int cell=0;cell<board_cells;cell++)
+            parity_black+=(cell/board_size/2+cell%board_size)%2;
+        int black_parity=parity_black==(board_cells+1)/2?1:0;
+        vector<int>black,white;
+        for(int cell=0;cell<board_cells;cell++)
+            ((cell/board_size/2+cell%board_size)%2==black_parity?black:white).push_back(cell);
+        game_board game;
+        bool ok=(int)black.size()==(board_cells+1)/2;
+        for(int i=0;i<board_cells&&ok;i++)
+        {
+            int r=game.play(i%2?white[i/2]:black[i/2]);
+            ok=r==(i<board_cells-1?play_ok:play_full);
+        }
+        CHECK(ok&&game.over()&&game.winner()==stone_none&&game.moves()==board_cells,"full board is a draw");
+        CHECK(game.undo()&&!game.over(),"undo the last move of a full board");
+    }
+}
+
+/* ==================== 位棋盘 ==================== */
+
+/**
+ * @brief 逐格扫描的五连判定（与客户端原来的win相同），用于比对
+ */
+template<int N>
+static bool scan_five(const int (&board)[N][N],int x,int y,int color)
+{
+    static const int dx[4]={0,1,1,1},dy[4]={1,0,1,-1};
+    for(int d=0;d<4;d++)
+    {
+        int sum=1;
+        for(int s=-1;s<=1;s+=2)
+            for(int k=1;k<=4;k++)
+            {
+                int a=x+s*k*dx[d],b=y+s*k*dy[d];
+                if(a<0||b<0||a>=N||b>=N||board[a][b]!=color)
+                    break;
+                sum++;
+            }
+        if(sum>=5)
+            return true;
+    }
+    return false;
+}
+
+template<int N>
+static void test_bitboard(int games)
+{
+    bitboard<N> board;
+    int scan[N][N];
+    vector<int>order(N*N);
+    int before=failures;
+    srand(1357+N);
+    for(int g=0;g<games;g++)
+    {
+        for(int k=0;k<N*N;k++)
+            order[k]=k;
+        for(int k=N*N-1;k>0;k--)
+            swap(order[k],order[rand()%(k+1)]);
+        board.clear();
+        for(int x=0;x<N;x++)
+            for(int y=0;y<N;y++)
+                scan[x][y]=stone_none;
+        int k;
+        for(k=0;k<N*N;k++)
+        {
+            int x=order[k]/N,y=order[k]%N,color=k%2?stone_white:stone_black;
+            CHECK(board.empty(x,y),"bitboard %dx%d game %d: cell %d,%d not empty",N,N,g,x,y);
+            board.place(color,x,y);
+            scan[x][y]=color;
+            CHECK(board.at(x,y)==color,"bitboard %dx%d game %d: stone at %d,%d",N,N,g,x,y);
+            bool five=board.five(color,x,y);
+            CHECK(five==scan_five<N>(scan,x,y,color),"bitboard %dx%d game %d move %d: five %d differs from scan",N,N,g,k,five);
+            if(five)
+                break;
+        }
+        if(k<N*N)
+        {
+            int color=k%2?stone_white:stone_black;
+            CHECK(board.any_five(color)&&!board.any_five(1-color),"bitboard %dx%d game %d: any_five after the end",N,N,g);
+            int x=order[k]/N,y=order[k]%N;
+            board.remove(x,y);
+            CHECK(board.empty(x,y)&&!board.five(color,x,y)&&!board.any_five(color),"bitboard %dx%d game %d: remove",N,N,g);
+        }
+        if(failures>before+5)
+            break;
+    }
+}
+
+/* ==================== 整局规则 ==================== */
+
+/**
+ * @brief 随机对局用game_board下到结束，与位棋盘判定比对，再悔棋到空棋盘
+ */
+static void test_rules(int games)
+{
+    vector<int>order(board_cells);
+    bitboard<board_size> kernel;
+    const zobrist_table &keys=zobrist();
+    int before=failures;
+    srand(8642);
+    for(int g=0;g<games&&failures<=before+5;g++)
+    {
+        for(int k=0;k<board_cells;k++)
+            order[k]=k;
+        for(int k=board_cells-1;k>0;k--)
+            swap(order[k],order[rand()%(k+1)]);
+
+        int end;
+        kernel.clear();
+        for(end=0;end<board_cells;end++)
+        {
+            int color=end%2?stone_white:stone_black;
+            kernel.place(color,order[end]/board_size,order[end]%board_size);
+            if(kernel.five(color,order[end]/board_size,order[end]%board_size))
+                break;
+        }
+        int last=end<board_cells?end:board_cells-1;
+        int winner=end<board_cells?(end%2?stone_white:stone_black):stone_none;
+
+        game_board b;
+        bool ok=true;
+        for(int k=0;k<=last&&ok;k++)
+            ok=b.to_move()==(k%2?stone_white:stone_black)
+                &&b.play(order[k])==(k<last?play_ok:(winner!=stone_none?play_five:play_full))
+                &&b.key()==keys.key(b);
+        CHECK(ok,"rules game %d: play until move %d",g,last);
+        CHECK(b.moves()==last+1&&b.over()&&b.winner()==winner&&b.last()==order[last],"rules game %d: result",g);
+        for(int k=0;k<board_cells&&ok;k++)
+            if(b.at(k)==stone_none)
+                ok=b.play(k)==play_illegal;
+        CHECK(ok,"rules game %d: moves after the end",g);
+        for(int k=last;k>=0&&ok;k--)
+            ok=b.move(k)==order[k]&&b.at(order[k])==(k%2?stone_white:stone_black)&&b.undo()
+                &&b.at(order[k])==stone_none&&b.winner()==stone_none&&!b.over()&&b.key()==keys.key(b);
+        CHECK(ok&&!b.undo()&&b.moves()==0,"rules game %d: undo back to an empty board",g);
+    }
+}
+
+/* ==================== 连珠禁手 ==================== */
+
+/**
+ * @brief 按定义逐格判定的黑方禁手（带越界检查，不限制读取范围），用于比对
+ */
+struct renju_reference
+{
+    int b[board_size][board_size];
+
+    explicit renju_reference(const game_board &game)
+    {
+        for(int x=0;x<board_size;x++)
+            for(int y=0;y<board_size;y++)
+                b[x][y]=game.at(x,y);
+    }
+
+    bool black(int x,int y) const
+    {
+        return x>=0&&y>=0&&x<board_size&&y<board_size&&b[x][y]==stone_black;
+    }
+
+    bool empty(int x,int y) const
+    {
+        return x>=0&&y>=0&&x<board_size&&y<board_size&&b[x][y]==stone_none;
+    }
+
+    // (x,y)所在的连续黑子：返回长度，first为靠负方向一端的偏移
+    int run(int x,int y,int dx,int dy,int* first=0) const
+    {
+        int lo=0,hi=0;
+        while(black(x+(lo-1)*dx,y+(lo-1)*dy))
+            lo--;
+        while(black(x+(hi+1)*dx,y+(hi+1)*dy))
+            hi++;
+        if(first)
+            *first=lo;
+        return hi-lo+1;
+    }
+
+    // 这条线上再下一子能使(x,y)所在的连子恰好为5的空位数，两个空位是同一个活四的两端时算一个
+    int fours(int x,int y,int dx,int dy)
+    {
+        int points[9],n=0;
+        for(int k=-4;k<=4;k++)
+        {
+            int ex=x+k*dx,ey=y+k*dy;
+            if(!empty(ex,ey))
+                continue;
+            b[ex][ey]=stone_black;
+            if(run(x,y,dx,dy)==5)
+                points[n++]=k;
+            b[ex][ey]=stone_none;
+        }
+        if(n==2&&points[1]-points[0]==5&&run(x,y,dx,dy)==4)
+            n=1;
+        return n;
+    }
+
+    // (x,y)所在的连续4子两端都是空位且都能恰好连五
+    bool straight_four(int x,int y,int dx,int dy) const
+    {
+        int lo;
+        if(run(x,y,dx,dy,&lo)!=4)
+            return false;
+        int hi=lo+3;
+        return empty(x+(lo-1)*dx,y+(lo-1)*dy)&&empty(x+(hi+1)*dx,y+(hi+1)*dy)
+            &&!black(x+(lo-2)*dx,y+(lo-2)*dy)&&!black(x+(hi+2)*dx,y+(hi+2)*dy);
+    }
+
+    // 这条线上再下一个不是禁手的子能形成活四
+    bool three(int x,int y,int dx,int dy)
+    {
+        for(int k=-4;k<=4;k++)
+        {
+            int ex=x+k*dx,ey=y+k*dy;
+            if(!empty(ex,ey))
+                continue;
+            b[ex][ey]=stone_black;
+            bool ok=straight_four(x,y,dx,dy);
+            b[ex][ey]=stone_none;
+            if(ok&&forbidden(ex,ey)==forbid_none)
+                return true;
+        }
+        return false;
+    }
+
+    int forbidden(int x,int y)
+    {
+        static const int dx[4]={0,1,1,1},dy[4]={1,0,1,-1};
+        b[x][y]=stone_black;
+        bool five=false,overline=false;
+        int four=0,threes=0,f[4];
+        for(int d=0;d<4;d++)
+        {
+            int len=run(x,y,dx[d],dy[d]);
+            five|=len==5;
+            overline|=len>5;
+            four+=f[d]=fours(x,y,dx[d],dy[d]);
+        }
+        int result=forbid_none;
+        if(!five&&overline)
+            result=forbid_overline;
+        else if(!five&&four>=2)
+            result=forbid_double_four;
+        else if(!five)
+        {
+            for(int d=0;d<4;d++)
+                threes+=!f[d]&&three(x,y,dx[d],dy[d]);
+            if(threes>=2)
+                result=forbid_double_three;
+        }
+        b[x][y]=stone_none;
+        return result;
+    }
+};
+
+/**
+ * @brief 连珠规则下摆出黑子和白子（白子不够时用角上的白子补齐轮次）
+ */
+static bool renju_setup(game_board &game,const int* black,int nb,const int* white,int nw)
+{
+    static const int fillers[8]={0,14,210,224,2,12,212,222};
+    game.set_rule(rule_renju);
+    game.reset();
+    for(int i=0;i<nb;i++)
+    {
+        if(game.play(black[i])!=play_ok)
+            return false;
+        if(game.play(i<nw?white[i]:fillers[i-nw])!=play_ok)
+            return false;
+    }
+    return true;
+}
+
+static void test_renju(int positions,int engine_games)
+{
+    struct shape
+    {
+        const char* name;
+        int black[8],nb;
+        int white[4],nw;
+        int cell,expect,result;
+    };
+    const shape shapes[]={
+        {"double three",{C(7,5),C(7,6),C(5,7),C(6,7)},4,{0},0,C(7,7),forbid_double_three,play_forbidden},
+        {"four-three",{C(7,4),C(7,5),C(7,6),C(5,7),C(6,7)},5,{0},0,C(7,7),forbid_none,play_ok},
+        {"double four",{C(7,4),C(7,5),C(7,6),C(4,7),C(5,7),C(6,7)},6,{C(7,3),C(3,7)},2,C(7,7),forbid_double_four,play_forbidden},
+        {"line double four",{C(7,3),C(7,5),C(7,6),C(7,9)},4,{0},0,C(7,7),forbid_double_four,play_forbidden},
+        {"overline",{C(7,1),C(7,2),C(7,3),C(7,5),C(7,6)},5,{0},0,C(7,4),forbid_overline,play_forbidden},
+        {"five",{C(7,3),C(7,4),C(7,5),C(7,6),C(5,7),C(6,7)},6,{0},0,C(7,7),forbid_none,play_five},
+        {"blocked three",{C(7,2),C(7,5),C(7,6),C(7,10),C(5,7),C(6,7)},6,{0},0,C(7,7),forbid_none,play_ok},
+    };
+    for(size_t i=0;i<sizeof(shapes)/sizeof(shapes[0]);i++)
+    {
+        const shape &t=shapes[i];
+        game_board game;
+        CHECK(renju_setup(game,t.black,t.nb,t.white,t.nw),"renju %s: setup",t.name);
+        renju_reference ref(game);
+        uint64_t key=game.key();
+        CHECK(game.forbidden(t.cell)==t.expect,"renju %s: forbidden() is %d",t.name,game.forbidden(t.cell));
+        CHECK(ref.forbidden(t.cell/board_size,t.cell%board_size)==t.expect,"renju %s: reference",t.name);
+        CHECK(game.play(t.cell)==t.result,"renju %s: play",t.name);
+        if(t.result==play_forbidden)
+            CHECK(game.key()==key&&game.to_move()==stone_black&&game.at(t.cell)==stone_none,"renju %s: board unchanged",t.name);
+
+        // 同一棋形在无禁手规则下不是禁手
+        if(t.result==play_forbidden)
+        {
+            game.set_rule(rule_freestyle);
+            CHECK(game.forbidden(t.cell)==forbid_none&&game.play(t.cell)>=play_ok,"renju %s: allowed in freestyle",t.name);
+        }
+    }
+
+    // 白方长连获胜
+    {
+        game_board game(rule_renju);
+        const int black[]={C(0,0),C(0,2),C(0,4),C(0,6),C(0,8),C(0,10)};
+        const int white[]={C(9,1),C(9,2),C(9,3),C(9,5),C(9,6)};
+        CHECK(setup(game,black,6,white,5)&&game.play(C(9,4))==play_five&&game.winner()==stone_white,"renju: white overline wins");
+    }
+
+    // 随机对局：中心9x9内随机落子（黑方的禁手点被拒绝后重选），逐个空位比对
+    vector<game_board> boards;
+    srand(1357);
+    for(int g=0;(int)boards.size()<positions;g++)
+    {
+        game_board game(rule_renju);
+        int plies=20+g%40;
+        for(int k=0;k<plies&&!game.over();k++)
+        {
+            int tries=0;
+            while(game.play((7+rand()%9-4)*board_size+7+rand()%9-4)<0&&++tries<1000)
+                ;
+        }
+        if(!game.over())
+            boards.push_back(game);
+    }
+    int kinds[4]={0,0,0,0};
+    for(size_t g=0;g<boards.size();g++)
+    {
+        renju_reference ref(boards[g]);
+        for(int cell=0;cell<board_cells;cell++)
+        {
+            if(boards[g].at(cell)!=stone_none)
+                continue;
+            int fast=boards[g].forbidden(cell),slow=ref.forbidden(cell/board_size,cell%board_size);
+            kinds[fast]++;
+            CHECK(fast==slow,"renju position %d cell %d,%d: %d vs reference %d",(int)g,cell/board_size,cell%board_size,fast,slow);
+        }
+    }
+
+    // 悔棋后再比对：缓存的判定结果要随悔掉的棋子一起失效
+    for(size_t g=0;g<boards.size();g+=8)
+    {
+        game_board game=boards[g];
+        for(int k=0;k<3&&game.undo();k++)
+        {
+            renju_reference ref(game);
+            for(int cell=0;cell<board_cells;cell++)
+                if(game.at(cell)==stone_none)
+                    CHECK(game.forbidden(cell)==ref.forbidden(cell/board_size,cell%board_size),"renju position %d undo %d cell %d,%d",(int)g,k+1,cell/board_size,cell%board_size);
+        }
+    }
+    CHECK(kinds[forbid_double_three]&&kinds[forbid_double_four]&&kinds[forbid_overline],"renju: random positions cover every kind (%d %d %d)",
+        kinds[forbid_double_three],kinds[forbid_double_four],kinds[forbid_overline]);
+
+    // 只搜2层的电脑在连珠规则下对局：黑方从不走禁手，落子都合法
+    engine shallow;
+    for(int g=0;g<engine_games;g++)
+    {
+        game_board game(rule_renju);
+        srand(9753+g);
+        game.play(board_cells/2);
+        while(game.play((7+rand()%5-2)*board_size+7+rand()%5-2)<0)
+            ;
+        while(!game.over()&&game.moves()<60)
+        {
+            search_result r=shallow.think(game,50,2);
+            int result=game.play(r.move);
+            if(result<0)
+            {
+                CHECK(false,"renju engine game %d move %d: illegal move %d (%d)",g,game.moves(),r.move,result);
+                break;
+            }
+        }
+    }
+}
+
+/* ==================== 开局库 ==================== */
+
+/**
+ * @brief 整局棋按对称变换t变换后的前moves步
+ */
+static game_board transform_game(const game_board &game,int t,int moves)
+{
+    game_board out;
+    for(int i=0;i<moves;i++)
+        out.play(book_transform(t,game.move(i)));
+    return out;
+}
+
+/**
+ * @brief 局面在某个非恒等的对称变换下不变（这时规范方向不唯一，变换后的着法可能落在等价的另一个点上）
+ */
+static bool self_symmetric(const game_board &game)
+{
+    for(int t=1;t<8;t++)
+        if(transform_game(game,t,game.moves()).key()==game.key())
+            return true;
+    return false;
+}
+
+static void test_book(int games,int plies)
+{
+    const char* path="core_test.book";
+    vector<game_board> sample;
+    book_builder builder;
+    srand(2468);
+    for(int g=0;g<games;g++)
+    {
+        game_board game;
+        for(int k=0;k<plies&&!game.over();k++)
+            while(game.play((7+rand()%9-4)*board_size+7+rand()%9-4)==play_illegal)
+                ;
+        builder.add_game(game,plies);
+        if(g%37==0&&game.moves()==plies)
+            sample.push_back(game);
+    }
+    for(int t=0;t<8;t++)
+        CHECK(book_inverse_transform(t,book_transform(t,C(3,5)))==C(3,5),"book: transform %d inverts",t);
+    opening_book book;
+    bool ok=builder.write(path)&&book.open(path);
+    CHECK(ok,"book: write and open %s",path);
+    if(!ok)
+        return;
+
+    book_continuation c[board_cells],d[board_cells];
+    for(size_t g=0;g<sample.size();g++)
+    {
+        int t=1+(int)g%7;
+        for(int k=0;k<plies;k++)
+        {
+            game_board prefix=transform_game(sample[g],0,k);
+            game_board mirrored=transform_game(sample[g],t,k);
+            int n=book.lookup(prefix,c,board_cells),m=book.lookup(mirrored,d,board_cells);
+            bool found=false;
+            for(int i=0;i<n;i++)
+                found|=c[i].move==sample[g].move(k)&&c[i].games>=1;
+            CHECK(found,"book: sample %d ply %d: actual move not found (%d continuations)",(int)g,k,n);
+            if(!found||self_symmetric(prefix))
+                continue;
+            bool same=n==m;
+            for(int i=0;i<n&&same;i++)
+            {
+                bool match=false;
+                for(int j=0;j<m;j++)
+                    match|=d[j].move==book_transform(t,c[i].move)&&d[j].games==c[i].games
+                        &&d[j].wins==c[i].wins&&d[j].draws==c[i].draws;
+                same=match;
+            }
+            CHECK(same,"book: sample %d ply %d: transform %d gives different continuations (%d / %d)",(int)g,k,t,n,m);
+        }
+    }
+    book.close();
+    remove(path);
+}
+
+/* ==================== 电脑对手 ==================== */
+
+static void test_engine(int positions,int depth)
+{
+    engine e;
+    for(int threads=1;threads<=4;threads*=4)
+    {
+        e.set_threads(threads);
+        for(int g=0;g<positions;g++)
+        {
+            game_board game;
+            srand(4321+g);
+            game.play(board_cells/2);
+            while(game.play((7+rand()%5-2)*board_size+7+rand()%5-2)==play_illegal)
+                ;
+            e.clear_hash();
+            search_result r=e.think(game,100000000,depth);
+            CHECK(r.move>=0&&r.move<board_cells&&game.at(r.move)==stone_none,"engine position %d, %d threads: illegal move %d",g,threads,r.move);
+        }
+    }
+}
+
+#undef C
+
+int main(int argc,char* argv[])
+{
+    int games=argc>1?atoi(argv[1]):2000;
+    int before;
+    #define RUN(title,call) do{ before=failures; call; printf("%-10s %s\n",title,failures==before?"ok":"FAILED"); }while(0)
+
+    RUN("turns",test_turns());
+    RUN("five",test_five());
+    RUN("bitboard",(test_bitboard<15>(games),test_bitboard<19>(games)));
+    RUN("rules",test_rules(games));
+    RUN("renju",test_renju(200,4));
+    RUN("book",test_book(2000,12));
+    RUN("engine",test_engine(4,4));
+    #undef RUN
+
+    printf("%s (%d failures)\n",failures?"FAILED":"all tests passed",failures);
+    return failures?1:0;
+}
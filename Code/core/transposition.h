@@ -0,0 +1,207 @@
+/**
+ * @file transposition.h
+ * @brief 置换表：多个搜索线程无锁共用的定长哈希表（gobang_core库）
+ *
+ * - 每个桶4项、每项16字节，桶按64字节对齐，一次探测只访问一个缓存行
+ * - 每项两个64位字：data（着法、分数、深度、边界类型、代数）和 key^data。
+ *   两个字分别原子地读写（relaxed），不加锁；另一个线程同时写同一项时读到的两个字可能不配套，
+ *   这时 key^data 还原不出原来的键，读出方当作未命中，不会用到拼错的数据
+ * - 替换策略优先保留深度大的项：同一局面直接覆盖；否则替换桶中 深度-代数差 最小的一项，
+ *   旧搜索留下的项即使深度大也会逐渐被替换
+ *
+ * 分数按“相对于当前层”存取：必胜/必败的分数与到达的步数有关，存入时换算为相对于该节点，
+ * 取出时再换算回相对于根节点（见 to_tt/from_tt）
+ *
+ * 本文件只依赖C++标准库，不依赖Qt
+ */
+
+#ifndef TRANSPOSITION_H
+#define TRANSPOSITION_H
+
+#include<stdint.h>
+#include<stddef.h>
+#include<atomic>
+#include<new>
+#include<vector>
+
+/**
+ * @brief 分数的边界类型
+ */
+enum tt_bound
+{
+    bound_none=0,
+    bound_upper=1,      // 分数不超过value（所有着法都没超过alpha）
+    bound_lower=2,      // 分数不低于value（发生了beta截断）
+    bound_exact=3       // 精确值
+};
+
+/**
+ * @brief 一次探测的结果
+ */
+struct tt_entry
+{
+    int move;       // 最好的着法（调用方的着法编码），没有时为-1
+    int value;      // 分数
+    int depth;      // 搜索深度
+    int bound;      // 边界类型（tt_bound）
+};
+
+class transposition_table
+{
+public:
+    /**
+     * @param mb 表的大小（MB，按2的幂向下取整，至少一个桶）
+     */
+    explicit transposition_table(size_t mb)
+    {
+        size_t n=1;
+        while(n*2*sizeof(bucket)<=mb*1024*1024)
+            n*=2;
+        // vector不保证64字节对齐，多申请一个桶再手动对齐
+        storage.resize((n+1)*sizeof(bucket));
+        uintptr_t p=(uintptr_t)storage.data();
+        buckets=(bucket*)((p+63)&~(uintptr_t)63);
+        for(size_t i=0;i<n;i++)
+            new(&buckets[i]) bucket;
+        mask=n-1;
+        generation=0;
+        clear();
+    }
+
+    /**
+     * @brief 清空（不能与搜索同时进行）
+     */
+    void clear()
+    {
+        for(size_t i=0;i<=mask;i++)
+            for(int j=0;j<4;j++)
+            {
+                buckets[i].slots[j].check.store(0,std::memory_order_relaxed);
+                buckets[i].slots[j].data.store(0,std::memory_order_relaxed);
+            }
+    }
+
+    /**
+     * @brief 开始新的一次思考：代数加一，之前的项在替换时优先被覆盖（在搜索线程启动前调用）
+     */
+    void new_search() { generation=(generation+1)&63; }
+
+    size_t size_bytes() const { return (mask+1)*sizeof(bucket); }
+
+    /**
+     * @brief 查找局面key
+     * @return bool 找到时返回true并填写out
+     */
+    bool probe(uint64_t key,tt_entry &out) const
+    {
+        const bucket &b=buckets[key&mask];
+        for(int j=0;j<4;j++)
+        {
+            uint64_t data=b.slots[j].data.load(std::memory_order_relaxed);
+            uint64_t check=b.slots[j].check.load(std::memory_order_relaxed);
+            if((check^data)==key&&data)
+            {
+                unpack(data,out);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief 保存局面key的搜索结果
+     */
+    void store(uint64_t key,int move,int value,int depth,int bound)
+    {
+        bucket &b=buckets[key&mask];
+        int victim=0,worst=1<<30;
+        for(int j=0;j<4;j++)
+        {
+            uint64_t data=b.slots[j].data.load(std::memory_order_relaxed);
+            uint64_t check=b.slots[j].check.load(std::memory_order_relaxed);
+            if(!data)
+            {
+                victim=j;
+                break;
+            }
+            tt_entry old;
+            unpack(data,old);
+            if((check^data)==key)
+            {
+                // 同一局面：浅得多的非精确结果不覆盖深的结果
+                if(bound!=bound_exact&&old.depth>depth+2)
+                    return;
+                victim=j;
+                break;
+            }
+            int age=(generation-(int)(data>>58)+64)&63;
+            int worth=old.depth-4*age;
+            if(worth<worst)
+            {
+                worst=worth;
+                victim=j;
+            }
+        }
+        uint64_t data=pack(move,value,depth,bound);
+        b.slots[victim].data.store(data,std::memory_order_relaxed);
+        b.slots[victim].check.store(key^data,std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 必胜/必败分数存入时换算为相对于当前层，win为必胜分数，limit为最大层数
+     */
+    static int to_tt(int value,int ply,int win,int limit)
+    {
+        if(value>=win-limit)
+            return value+ply;
+        if(value<=-win+limit)
+            return value-ply;
+        return value;
+    }
+
+    static int from_tt(int value,int ply,int win,int limit)
+    {
+        if(value>=win-limit)
+            return value-ply;
+        if(value<=-win+limit)
+            return value+ply;
+        return value;
+    }
+
+private:
+    // data的位：着法+1 [0,16)，分数+2^23 [16,40)，深度 [40,48)，边界 [48,50)，代数 [58,64)
+    uint64_t pack(int move,int value,int depth,int bound) const
+    {
+        return (uint64_t)(uint16_t)(move+1)
+            |(uint64_t)((uint32_t)(value+(1<<23))&0xFFFFFF)<<16
+            |(uint64_t)(uint8_t)depth<<40
+            |(uint64_t)bound<<48
+            |(uint64_t)generation<<58;
+    }
+
+    static void unpack(uint64_t data,tt_entry &out)
+    {
+        out.move=(int)(data&0xFFFF)-1;
+        out.value=(int)(data>>16&0xFFFFFF)-(1<<23);
+        out.depth=(int)(data>>40&0xFF);
+        out.bound=(int)(data>>48&3);
+    }
+
+    struct slot
+    {
+        std::atomic<uint64_t> check;    // key^data
+        std::atomic<uint64_t> data;
+    };
+
+    struct bucket
+    {
+        slot slots[4];
+    };
+
+    std::vector<char> storage;  // 未对齐的原始内存
+    bucket* buckets;            // 对齐到64字节的桶数组
+    size_t mask;                // 桶数-1
+    int generation;             // 当前代数（6位）
+};
+
+#endif // TRANSPOSITION_H
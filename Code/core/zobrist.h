@@ -0,0 +1,67 @@
+/**
+ * @file zobrist.h
+ * @brief 局面的64位Zobrist键（gobang_core库）
+ *
+ * 每种颜色的每个格子对应一个随机数，局面的键是盘面上所有棋子对应随机数的异或。
+ * 落子和悔棋都只需要异或一次，不同落子顺序到达的同一局面得到同一个键。
+ * 轮到哪一方由棋子数决定，所以键里不需要另外包含轮次。
+ *
+ * 随机数用splitmix64由固定种子生成，每次运行、每台机器都相同（开局库等持久化数据可以直接保存键）
+ */
+
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include<stdint.h>
+
+#include "game_board.h"
+
+class zobrist_table
+{
+public:
+    zobrist_table()
+    {
+        uint64_t state=0x9E3779B97F4A7C15ull;
+        for(int color=0;color<2;color++)
+            for(int cell=0;cell<board_cells;cell++)
+                keys[color][cell]=next(state);
+    }
+
+    /**
+     * @brief color的棋子在cell上对应的随机数
+     */
+    uint64_t operator()(int color,int cell) const { return keys[color][cell]; }
+
+    /**
+     * @brief 由落子顺序重新计算整个棋局的键（不在热点路径上使用，game_board::key()是增量维护的）
+     */
+    uint64_t key(const game_board &game) const
+    {
+        uint64_t k=0;
+        for(int i=0;i<game.moves();i++)
+            k^=keys[i%2?stone_white:stone_black][game.move(i)];
+        return k;
+    }
+
+private:
+    static uint64_t next(uint64_t &state)
+    {
+        uint64_t z=(state+=0x9E3779B97F4A7C15ull);
+        z=(z^(z>>30))*0xBF58476D1CE4E5B9ull;
+        z=(z^(z>>27))*0x94D049BB133111EBull;
+        return z^(z>>31);
+    }
+
+    uint64_t keys[2][board_cells];
+};
+
+/**
+ * @brief 全局共用的一张随机数表（第一次调用时生成）
+ */
+inline const zobrist_table& zobrist()
+{
+    static const zobrist_table table;
+    return table;
+}
+
+#endif // ZOBRIST_H
@@ -0,0 +1,171 @@
+/**
+ * @file archive.cpp
+ * @brief 对局归档工具：把对局日志整理进归档目录，按时间、玩家、结果、局面分页查询（Linux下直接用g++编译）
+ *
+ * 用法:
+ *   ./archive build 日志 目录
+ *       把日志中新结束的对局整理成段文件（目录不存在时创建），可以在服务器运行时定期执行
+ *   ./archive recent 目录 [偏移=0] [条数=20]
+ *   ./archive player 目录 IP [偏移=0] [条数=20]
+ *   ./archive winner 目录 胜方(0白 1黑 2和棋或中止) [偏移=0] [条数=20]
+ *   ./archive position 目录 偏移 条数 x,y ...
+ *       按给出的落子顺序（黑先）摆出局面，列出出现过这个局面（含对称的局面）的对局
+ *   ./archive show 目录 对局ID
+ *       列出一局的落子
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include<errno.h>
+#include<sys/stat.h>
+#include<arpa/inet.h>
+
+#include "game_archive.h"
+
+using namespace std;
+
+static double now_sec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+static int build(const char* journal_path,const char* dir)
+{
+    if(mkdir(dir,0755)!=0&&errno!=EEXIST)
+    {
+        perror(dir);
+        return 1;
+    }
+    archive_build_stats st;
+    double start=now_sec();
+    if(!archive_build(journal_path,dir,&st))
+    {
+        fprintf(stderr,"cannot archive %s into %s\n",journal_path,dir);
+        return 1;
+    }
+    printf("scanned %llu bytes (%llu records) in %.2f s: %llu games archived (%llu aborted), %d new segments, %zu still open\n",
+        (unsigned long long)st.scanned,(unsigned long long)st.records,now_sec()-start,
+        (unsigned long long)st.games,(unsigned long long)st.aborted,st.segments,st.open);
+    return 0;
+}
+
+static void print_page(size_t total,size_t offset,const vector<archive_ref> &refs,double ms)
+{
+    static const char* ends[]={"aborted","finished","surrender","leave"};
+    static const char* winners[]={"white","black","none"};
+    printf("%zu games, showing %zu-%zu (%.3f ms)\n",total,refs.empty()?0:offset+1,offset+refs.size(),ms);
+    for(size_t i=0;i<refs.size();i++)
+    {
+        const archive_game &g=*refs[i].game;
+        char ip[2][INET_ADDRSTRLEN];
+        for(int k=0;k<2;k++)
+        {
+            struct in_addr a;
+            a.s_addr=g.ip[k];
+            inet_ntop(AF_INET,&a,ip[k],sizeof(ip[k]));
+        }
+        time_t t=g.time;
+        char when[32];
+        strftime(when,sizeof(when),"%Y-%m-%d %H:%M:%S",localtime(&t));
+        printf("%12llu  %s  %s:%u vs %s:%u  black=%s  rule=%d  %s  winner=%s  %d moves\n",(unsigned long long)g.id,when,
+            ip[0],g.port[0],ip[1],g.port[1],g.black==archive_no_black?"-":g.black?"guest":"master",g.rule,
+            g.end<4?ends[g.end]:"?",g.winner<3?winners[g.winner]:"?",g.moves);
+    }
+}
+
+static int query(const char* dir,char kind,const char* arg,size_t offset,size_t limit,int argc,char* argv[])
+{
+    game_archive archive;
+    if(!archive.open(dir))
+    {
+        fprintf(stderr,"cannot open archive %s\n",dir);
+        return 1;
+    }
+    vector<archive_ref> refs;
+    size_t total=0;
+    double start=now_sec();
+    switch(kind)
+    {
+        case 'r':total=archive.recent(offset,limit,refs);break;
+        case 'p':
+        {
+            struct in_addr ip;
+            if(inet_pton(AF_INET,arg,&ip)!=1)
+            {
+                fprintf(stderr,"bad IP %s\n",arg);
+                return 1;
+            }
+            total=archive.by_player(ip.s_addr,offset,limit,refs);
+        }break;
+        case 'w':total=archive.by_winner(atoi(arg),offset,limit,refs);break;
+        case 'm':
+        {
+            uint8_t moves[board_cells];
+            bool used[board_cells]={false};
+            int n=0;
+            for(int i=0;i<argc&&n<board_cells;i++)
+            {
+                int x,y;
+                if(sscanf(argv[i],"%d,%d",&x,&y)!=2||x<0||x>=board_size||y<0||y>=board_size||used[x*board_size+y])
+                {
+                    fprintf(stderr,"bad move %s\n",argv[i]);
+                    return 1;
+                }
+                used[x*board_size+y]=true;
+                moves[n++]=(uint8_t)(x*board_size+y);
+            }
+            total=archive.by_position(archive_position_key(moves,n),offset,limit,refs);
+        }break;
+    }
+    print_page(total,offset,refs,(now_sec()-start)*1000);
+    return 0;
+}
+
+static int show(const char* dir,const char* id)
+{
+    game_archive archive;
+    if(!archive.open(dir))
+    {
+        fprintf(stderr,"cannot open archive %s\n",dir);
+        return 1;
+    }
+    archive_ref ref;
+    if(!archive.find(strtoull(id,NULL,10),ref))
+    {
+        fprintf(stderr,"game %s not found\n",id);
+        return 1;
+    }
+    vector<archive_ref> refs(1,ref);
+    print_page(1,0,refs,0);
+    for(int i=0;i<ref.game->moves;i++)
+        printf("%s%d,%d",i?" ":"",ref.moves[i]/board_size,ref.moves[i]%board_size);
+    printf("\n");
+    return 0;
+}
+
+int main(int argc,char* argv[])
+{
+    if(argc==4&&strcmp(argv[1],"build")==0)
+        return build(argv[2],argv[3]);
+    if(argc>=3&&strcmp(argv[1],"recent")==0)
+        return query(argv[2],'r',NULL,argc>3?atol(argv[3]):0,argc>4?atol(argv[4]):20,0,NULL);
+    if(argc>=4&&strcmp(argv[1],"player")==0)
+        return query(argv[2],'p',argv[3],argc>4?atol(argv[4]):0,argc>5?atol(argv[5]):20,0,NULL);
+    if(argc>=4&&strcmp(argv[1],"winner")==0)
+        return query(argv[2],'w',argv[3],argc>4?atol(argv[4]):0,argc>5?atol(argv[5]):20,0,NULL);
+    if(argc>=6&&strcmp(argv[1],"position")==0)
+        return query(argv[2],'m',NULL,atol(argv[3]),atol(argv[4]),argc-5,argv+5);
+    if(argc==4&&strcmp(argv[1],"show")==0)
+        return show(argv[2],argv[3]);
+    fprintf(stderr,"usage: %s build JOURNAL DIR\n"
+        "       %s recent DIR [offset] [count]\n"
+        "       %s player DIR IP [offset] [count]\n"
+        "       %s winner DIR 0|1|2 [offset] [count]\n"
+        "       %s position DIR offset count x,y ...\n"
+        "       %s show DIR ID\n",argv[0],argv[0],argv[0],argv[0],argv[0],argv[0]);
+    return 1;
+}
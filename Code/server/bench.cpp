@@ -0,0 +1,1290 @@
+/**
+ * @file bench.cpp
+ * @brief 服务器数据结构基准测试
+ *
+ * 不依赖网络，直接测量服务器热点路径上的数据结构开销：
+ * - 连接表：10万连接下，每步落子转发需要的查找（std::map两次查找 vs fd_table+对手指针）
+ * - 连接表：连接建立/断开的churn开销
+ * - 大厅：全量列出所有空闲房间 vs 名字索引上的前缀过滤+分页查询
+ * - 定时器：每个连接一个定时器，重新设置+按刻度推进（std::set vs 分层时间轮）
+ * - 权威棋盘：落子转发加上查房间、校验落点和五连判定之后的开销
+ * - 对局日志：在权威棋盘之上再把每步落子记入日志、每轮整批提交给组提交线程的开销，
+ *   读回文件逐条比对，并检查截断在任意位置时只保留完整的记录
+ * - 对局归档：生成一份含开局、先后手、落子、悔棋、认输、离开、中止的日志，分几次（切在记录中间）增量整理，
+ *   按时间、玩家、结果、局面查询，与直接遍历生成的对局比对，并测量查询耗时
+ * - 观战推送：同一批事件发给一个房间的所有观众，逐个复制 vs 共享数据段（只编码一次，排入引用）
+ * - 快速匹配：10万人排队时新玩家找对手的开销（分桶的匹配队列 vs 遍历队列）和窗口放宽时重新找对手的开销
+ * - 运行指标：一次计数、一次直方图记录、一次读时钟的开销，多个线程的直方图合并后的总数、边界计数和分位数
+ *
+ * 日志读回、归档查询、观战推送的字节流、匹配结果或指标合并结果不一致时以非0退出
+ *
+ * 用法: ./bench [连接数] [落子次数] [归档对局数]
+ */
+
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<time.h>
+#include<map>
+#include<set>
+#include<vector>
+#include<string>
+#include<algorithm>
+#include<unordered_map>
+#include<functional>
+#include<deque>
+#include<memory>
+#include<thread>
+#include<atomic>
+#include<math.h>
+#include<unistd.h>
+#include<sys/stat.h>
+
+#include "conn_table.h"
+#include "lobby_index.h"
+#include "timer_wheel.h"
+#include "room_table.h"
+#include "game_board.h"
+#include "game_journal.h"
+#include "game_archive.h"
+#include "protocol.h"
+#include "match_queue.h"
+#include "metrics.h"
+
+using namespace std;
+
+/* ==================== 计时工具 ==================== */
+
+static double now_sec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec+ts.tv_nsec/1e9;
+}
+
+/* ==================== 旧实现：std::map连接表 ==================== */
+
+struct old_info
+{
+    int opponent_fd;
+    bool prepare;
+    bool master;
+    int room_num;
+    old_info():opponent_fd(0),prepare(0),master(false),room_num(-1){}
+};
+
+struct old_buffer
+{
+    string out;
+    bool dirty;
+    old_buffer():dirty(false){}
+};
+
+/* ==================== 新实现：fd_table连接表 ==================== */
+
+struct new_conn;
+
+struct new_info
+{
+    new_conn* opponent;
+    bool prepare;
+    bool master;
+    int room_num;
+    new_info():opponent(NULL),prepare(0),master(false),room_num(-1){}
+};
+
+struct new_conn
+{
+    int fd;
+    new_info info;
+    old_buffer buf;
+    new_conn():fd(-1){}
+};
+
+/* ==================== 基准测试 ==================== */
+
+/**
+ * @brief 落子转发：查发送者 -> 找对手 -> 追加到对手的输出队列
+ */
+static void bench_relay(int n,int moves)
+{
+    // 连接i与i^1配对，fd从4开始（0-2为标准流，3为监听套接字）
+    vector<int>fds(n);
+    for(int i=0;i<n;i++)
+        fds[i]=4+i;
+
+    // 随机的落子者序列（两种实现使用同一序列）
+    vector<int>order(moves);
+    srand(12345);
+    for(int i=0;i<moves;i++)
+        order[i]=fds[rand()%n];
+
+    map<int,old_info>hash_client;
+    map<int,old_buffer>client_bufs;
+    for(int i=0;i<n;i++)
+    {
+        hash_client[fds[i]].opponent_fd=fds[i^1];
+        client_bufs[fds[i]];
+    }
+
+    fd_table<new_conn>conns;
+    for(int i=0;i<n;i++)
+        conns.insert(fds[i])->fd=fds[i];
+    for(int i=0;i<n;i++)
+        conns.find(fds[i])->info.opponent=conns.find(fds[i^1]);
+
+    const char msg[]="OM77\n";
+    size_t sink=0;
+
+    double t0=now_sec();
+    for(int i=0;i<moves;i++)
+    {
+        old_buffer &b=client_bufs[hash_client[order[i]].opponent_fd];
+        b.out.append(msg,sizeof(msg)-1);
+        if(b.out.size()>4096)
+        {
+            sink+=b.out.size();
+            b.out.clear();
+        }
+    }
+    double t_map=now_sec()-t0;
+
+    t0=now_sec();
+    for(int i=0;i<moves;i++)
+    {
+        old_buffer &b=conns.find(order[i])->info.opponent->buf;
+        b.out.append(msg,sizeof(msg)-1);
+        if(b.out.size()>4096)
+        {
+            sink+=b.out.size();
+            b.out.clear();
+        }
+    }
+    double t_tab=now_sec()-t0;
+
+    printf("relay    %7d conns %9d moves: map %7.1f ns/move   fd_table %7.1f ns/move   (%.2fx)  [%zu]\n",
+        n,moves,t_map*1e9/moves,t_tab*1e9/moves,t_map/t_tab,sink);
+}
+
+/**
+ * @brief 连接churn：断开一个随机连接并在同一fd上重新接入
+ */
+static void bench_churn(int n,int ops)
+{
+    vector<int>order(ops);
+    srand(54321);
+    for(int i=0;i<ops;i++)
+        order[i]=4+rand()%n;
+
+    map<int,old_info>hash_client;
+    map<int,old_buffer>client_bufs;
+    vector<int>client_fds;
+    for(int i=0;i<n;i++)
+    {
+        hash_client[4+i];
+        client_bufs[4+i];
+        client_fds.push_back(4+i);
+    }
+
+    fd_table<new_conn>conns;
+    for(int i=0;i<n;i++)
+        conns.insert(4+i)->fd=4+i;
+
+    // 旧实现断开连接时需要在client_fds中线性查找删除；为了可比只测1/100的操作量后换算
+    int old_ops=max(1,ops/100);
+    double t0=now_sec();
+    for(int i=0;i<old_ops;i++)
+    {
+        int fd=order[i];
+        hash_client.erase(fd);
+        client_bufs.erase(fd);
+        client_fds.erase(find(client_fds.begin(),client_fds.end(),fd));
+        hash_client[fd];
+        client_bufs[fd];
+        client_fds.push_back(fd);
+    }
+    double t_map=(now_sec()-t0)/old_ops;
+
+    t0=now_sec();
+    for(int i=0;i<ops;i++)
+    {
+        int fd=order[i];
+        conns.erase(fd);
+        conns.insert(fd)->fd=fd;
+    }
+    double t_tab=(now_sec()-t0)/ops;
+
+    printf("churn    %7d conns %9d ops:   map %7.1f ns/op     fd_table %7.1f ns/op     (%.2fx)\n",
+        n,ops,t_map*1e9,t_tab*1e9,t_map/t_tab);
+}
+
+/**
+ * @brief 大厅查询：全量序列化所有房间（原R请求）vs 名字索引分页（Q请求，每页20条）
+ */
+static void bench_lobby(int rooms,int queries)
+{
+    const char* words[]={"alpha","beta","gamma","delta","快来","高手","新手","room"};
+    map<uint64_t,string>lobby;
+    name_index index;
+    srand(777);
+    for(int i=0;i<rooms;i++)
+    {
+        char name[64];
+        snprintf(name,sizeof(name),"%s%d",words[rand()%8],rand()%100000);
+        lobby[i+1]=name;
+        index.insert(name,i+1);
+    }
+
+    // 全量：遍历所有房间拼接/N、/F帧
+    size_t sink=0;
+    int full_queries=max(1,queries/100);
+    double t0=now_sec();
+    for(int q=0;q<full_queries;q++)
+    {
+        string out;
+        char id[24];
+        for(map<uint64_t,string>::iterator it=lobby.begin();it!=lobby.end();it++)
+        {
+            snprintf(id,sizeof(id),"%llu",(unsigned long long)it->first);
+            out.append("/N").append(it->second).append(1,'\n').append("/F").append(id).append(1,'\n');
+        }
+        sink+=out.size();
+    }
+    double t_full=(now_sec()-t0)/full_queries;
+
+    // 分页：随机前缀、随机页
+    vector<uint64_t>ids;
+    t0=now_sec();
+    for(int q=0;q<queries;q++)
+    {
+        ids.clear();
+        string prefix=words[q%8];
+        if(q%3==0)
+            prefix+=(char)('1'+q%9);
+        size_t total=index.page(prefix,(q*37)%200,20,ids);
+        string out;
+        for(size_t i=0;i<ids.size();i++)
+            out.append("L+").append(lobby[ids[i]]).append(1,'\n');
+        sink+=out.size()+total;
+    }
+    double t_page=(now_sec()-t0)/queries;
+
+    printf("lobby    %7d rooms %9d queries: full list %9.1f us/query   page(20) %6.2f us/query   (%.0fx)  [%zu]\n",
+        rooms,queries,t_full*1e6,t_page*1e6,t_full/t_page,sink);
+}
+
+/**
+ * @brief 定时器：n个连接各挂一个定时器，每步随机重新设置一个（如收到请求后推迟检查），
+ *        每n/100步推进一个刻度并触发到期的定时器（到期后重新设置，模拟周期性心跳检查）
+ */
+static void bench_timers(int n,int ops)
+{
+    const uint64_t period=150;      // 心跳检查周期（刻度）
+    vector<int>order(ops);
+    vector<uint64_t>delay(ops);
+    srand(4242);
+    for(int i=0;i<ops;i++)
+    {
+        order[i]=rand()%n;
+        delay[i]=1+rand()%period;
+    }
+    int step=max(1,n/100);
+    size_t fired=0;
+    
+    // std::set<(到期刻度, 连接)>：每次重新设置O(log n)
+    set<pair<uint64_t,int> >timers;
+    vector<uint64_t>expire(n);
+    uint64_t now=0;
+    for(int i=0;i<n;i++)
+    {
+        expire[i]=1+i%period;
+        timers.insert(make_pair(expire[i],i));
+    }
+    double t0=now_sec();
+    for(int i=0;i<ops;i++)
+    {
+        int c=order[i];
+        timers.erase(make_pair(expire[c],c));
+        expire[c]=now+delay[i];
+        timers.insert(make_pair(expire[c],c));
+        if(i%step==0)
+        {
+            now++;
+            while(!timers.empty()&&timers.begin()->first<=now)
+            {
+                int d=timers.begin()->second;
+                timers.erase(timers.begin());
+                expire[d]=now+period;
+                timers.insert(make_pair(expire[d],d));
+                fired++;
+            }
+        }
+    }
+    double t_set=now_sec()-t0;
+    
+    // 分层时间轮：每次重新设置O(1)
+    timer_wheel wheel;
+    vector<timer_node>nodes(n);
+    for(int i=0;i<n;i++)
+    {
+        nodes[i].data=i;
+        wheel.schedule(&nodes[i],1+i%period);
+    }
+    t0=now_sec();
+    for(int i=0;i<ops;i++)
+    {
+        wheel.schedule(&nodes[order[i]],wheel.current()+delay[i]);
+        if(i%step==0)
+        {
+            wheel.advance(wheel.current()+1,[&](timer_node* t)
+            {
+                wheel.schedule(t,wheel.current()+period);
+                fired++;
+            });
+        }
+    }
+    double t_wheel=now_sec()-t0;
+    
+    printf("timers   %7d conns %9d ops:   set %7.1f ns/op     wheel %7.1f ns/op        (%.2fx)  [%zu]\n",
+        n,ops,t_set*1e9/ops,t_wheel*1e9/ops,t_set/t_wheel,fired);
+}
+
+/**
+ * @brief 权威棋盘：每步落子在转发前查房间、校验并落在棋盘上（含五连判定），与只转发对比
+ *
+ * 每个房间按一个固定的排列依次落子，五连或下满后清空棋盘重新开始
+ */
+static void bench_game(int n,int moves)
+{
+    int pairs=n/2;
+    vector<int>order(moves);
+    srand(2468);
+    for(int i=0;i<moves;i++)
+        order[i]=4+rand()%n;
+
+    fd_table<new_conn>conns;
+    for(int i=0;i<n;i++)
+        conns.insert(4+i)->fd=4+i;
+    for(int i=0;i<n;i++)
+        conns.find(4+i)->info.opponent=conns.find(4+(i^1));
+
+    // 每个房间一张棋盘，房间ID记在ids[room_num]中
+    slot_map<game_board>boards;
+    vector<room_id_t>ids(pairs);
+    for(int r=0;r<pairs;r++)
+    {
+        ids[r]=boards.insert(game_board());
+        conns.find(4+2*r)->info.room_num=r;
+        conns.find(4+2*r+1)->info.room_num=r;
+    }
+
+    const char msg[]="OM77\n";
+    size_t sink=0;
+
+    double t0=now_sec();
+    for(int i=0;i<moves;i++)
+    {
+        old_buffer &b=conns.find(order[i])->info.opponent->buf;
+        b.out.append(msg,sizeof(msg)-1);
+        if(b.out.size()>4096)
+        {
+            sink+=b.out.size();
+            b.out.clear();
+        }
+    }
+    double t_relay=now_sec()-t0;
+
+    const int step=97;
+    size_t games=0;
+    t0=now_sec();
+    for(int i=0;i<moves;i++)
+    {
+        new_conn* c=conns.find(order[i]);
+        int r=c->info.room_num;
+        game_board* board=boards.find(ids[r]);
+        // 第k步落在(k*step+r)%225：step与225互素，一局内不会重复，各房间的顺序也不同
+        int result=board->play((board->moves()*step+r)%board_cells);
+        if(result==play_illegal)
+            continue;
+        old_buffer &b=c->info.opponent->buf;
+        b.out.append(msg,sizeof(msg)-1);
+        if(b.out.size()>4096)
+        {
+            sink+=b.out.size();
+            b.out.clear();
+        }
+        if(result!=play_ok)
+        {
+            board->reset();
+            games++;
+        }
+    }
+    double t_game=now_sec()-t0;
+
+    printf("game     %7d conns %9d moves: relay %7.1f ns/move   +board %7.1f ns/move   (+%.1f ns, %zu games)  [%zu]\n",
+        n,moves,t_relay*1e9/moves,t_game*1e9/moves,(t_game-t_relay)*1e9/moves,games,sink);
+}
+
+/**
+ * @brief 观战推送：房间每轮积累的一批事件发给所有观众（一半使用二进制帧），
+ * 逐个观众编码并复制到输出队列（与send_text相同）vs 编码一次、排入共享数据段（与watch_flush相同）
+ *
+ * 每轮之后排空所有观众的队列（相当于写出），排空前比对两种做法每个观众待写出的字节
+ * @return bool 全部一致时返回true
+ */
+static bool bench_fanout(int watchers,int events)
+{
+    const int tick=4;           // 一轮事件处理中一个房间的事件数
+    vector<string>copies(watchers);
+    vector<deque<shared_ptr<const string> > >shared(watchers);
+
+    // 落子和偶尔的悔棋、胜负，与服务器观战帧的格式相同
+    vector<string>batches;
+    srand(8642);
+    const char coords[]="0123456789abcde";
+    for(int i=0;i<events;i+=tick)
+    {
+        string batch;
+        for(int k=i;k<min(events,i+tick);k++)
+        {
+            char msg[16];
+            int r=rand()%64;
+            if(r==0)
+                snprintf(msg,sizeof(msg),"GB%d\n",1+rand()%2);
+            else if(r==1)
+                snprintf(msg,sizeof(msg),"GW%d\n",rand()%3);
+            else
+                snprintf(msg,sizeof(msg),"GM%c%c\n",coords[rand()%board_size],coords[rand()%board_size]);
+            batch+=msg;
+        }
+        batches.push_back(batch);
+    }
+
+    bool ok=true;
+    size_t sink=0,copy_peak=0,shared_peak=0;
+    double t_copy=0,t_shared=0;
+    for(size_t b=0;b<batches.size();b++)
+    {
+        const string &batch=batches[b];
+        double t0=now_sec();
+        for(int w=0;w<watchers;w++)
+        {
+            if(w&1)
+                proto_from_frames(batch.data(),batch.size(),copies[w]);
+            else
+                copies[w].append(batch);
+        }
+        t_copy+=now_sec()-t0;
+
+        t0=now_sec();
+        shared_ptr<const string> text=make_shared<const string>(batch);
+        string frames;
+        proto_from_frames(batch.data(),batch.size(),frames);
+        shared_ptr<const string> bin=make_shared<const string>(std::move(frames));
+        for(int w=0;w<watchers;w++)
+            shared[w].push_back(w&1?bin:text);
+        t_shared+=now_sec()-t0;
+
+        // 排队中的内存：逐个复制时每个观众一份，共享时每种编码一份加上每个观众的引用
+        size_t copy_bytes=0;
+        for(int w=0;w<watchers;w++)
+            copy_bytes+=copies[w].size();
+        copy_peak=max(copy_peak,copy_bytes);
+        shared_peak=max(shared_peak,text->size()+bin->size()+(size_t)watchers*sizeof(shared_ptr<const string>));
+
+        for(int w=0;w<watchers;w++)
+        {
+            string joined;
+            for(size_t k=0;k<shared[w].size();k++)
+                joined.append(*shared[w][k]);
+            if(joined!=copies[w])
+                ok=false;
+            sink+=joined.size();
+            copies[w].clear();
+            shared[w].clear();
+        }
+    }
+
+    long long sends=(long long)watchers*batches.size();
+    printf("fanout   %7d watchers %7d events: copy %6.1f ns/watcher  shared %6.1f ns/watcher  (%.2fx)  queued %zu KB vs %zu KB   %s  [%zu]\n",
+        watchers,events,t_copy*1e9/sends,t_shared*1e9/sends,t_copy/t_shared,copy_peak/1024,shared_peak/1024,
+        ok?"streams equal":"STREAM MISMATCH",sink);
+    return ok;
+}
+
+/**
+ * @brief 快速匹配：n人排队时的配对吞吐，分桶的匹配队列 vs 逐个遍历队列找最接近的对手
+ *
+ * 先让n个玩家排队（初始窗口为负，不会配对）；然后不断加入新玩家，每个新玩家用正常的窗口找对手，
+ * 配对后再补一个只排队的玩家，队列始终保持n人；最后推进时间，让排队的玩家放宽窗口重新找对手直到清空。
+ * 检查每对的分差不超过当时的窗口、每个玩家最多配对一次、队列人数与配对的结果一致
+ * @return bool 全部一致时返回true
+ */
+static bool bench_match(int n,int arrivals)
+{
+    const int window=100,widen=50;
+    const long long widen_ms=5000;
+    int total=n+2*arrivals;
+    vector<int>rating(total);
+    srand(9753);
+    for(int i=0;i<total;i++)        // 近似正态分布：均值1500，标准差约200
+        rating[i]=1500+(rand()%201+rand()%201+rand()%201-300)*2;
+
+    match_queue queue(-1,widen,widen_ms);
+    vector<char>state(total,0);     // 0未加入 1排队 2已配对
+    bool ok=true;
+    size_t pairs=0;
+    long long diff_sum=0;
+    auto record=[&](const match_pair &p,int limit)
+    {
+        int a=(int)p.host,b=(int)p.guest;
+        int diff=abs(rating[a]-rating[b]);
+        if(state[a]!=1||state[b]==2||a==b||diff>limit||p.host_rating!=rating[a]||p.guest_rating!=rating[b])
+            ok=false;
+        state[a]=state[b]=2;
+        pairs++;
+        diff_sum+=diff;
+    };
+
+    match_pair p;
+    int next=0;
+    for(;next<n;next++)
+    {
+        if(queue.push(next,rating[next],0,p))
+            ok=false;
+        state[next]=1;
+    }
+
+    // 新玩家找对手；配对后补一个只排队的玩家（把窗口临时设为负）
+    double t0=now_sec();
+    for(int i=0;i<arrivals;i++)
+    {
+        queue.configure(window,widen,widen_ms);
+        int id=next++;
+        if(!queue.push(id,rating[id],0,p))
+        {
+            state[id]=1;
+            continue;
+        }
+        if(p.guest!=(uint64_t)id)
+            ok=false;
+        state[id]=1;
+        record(p,window);
+        queue.configure(-1,widen,widen_ms);
+        id=next++;
+        if(queue.push(id,rating[id],0,p))
+            ok=false;
+        state[id]=1;
+    }
+    double t_push=now_sec()-t0;
+    size_t push_pairs=pairs;
+    double push_diff=pairs?(double)diff_sum/pairs:0;
+    size_t queued=queue.size();
+
+    // 逐个遍历：同样大小的队列，每个新玩家扫描整个队列（只做一部分，O(n)）
+    int naive_arrivals=min(arrivals,2000);
+    vector<pair<int,int> >naive;    // (等级分, 玩家)
+    for(int i=0;i<n;i++)
+        naive.push_back(make_pair(rating[i],i));
+    size_t naive_pairs=0;
+    long long naive_diff=0;
+    t0=now_sec();
+    for(int i=0;i<naive_arrivals;i++)
+    {
+        int r=rating[n+i];
+        int best=-1,best_diff=window+1;
+        for(size_t k=0;k<naive.size();k++)
+        {
+            int diff=abs(naive[k].first-r);
+            if(diff<best_diff)
+            {
+                best_diff=diff;
+                best=(int)k;
+            }
+        }
+        if(best>=0)
+        {
+            naive_pairs++;
+            naive_diff+=best_diff;
+            naive[best]=make_pair(rating[n+arrivals+i],n+arrivals+i);    // 补一个排队的玩家
+        }
+        else
+            naive.push_back(make_pair(r,n+i));
+    }
+    double t_naive=now_sec()-t0;
+
+    // 推进时间：排队的玩家每widen_ms放宽一次窗口，直到全部配对（最后可能剩一人）
+    queue.configure(window,widen,widen_ms);
+    vector<match_pair>out;
+    long long now=0;
+    size_t advance_pairs=pairs;
+    t0=now_sec();
+    while(queue.size()>1&&now<=widen_ms*(match_window_limit/widen+1))
+    {
+        now+=widen_ms;
+        out.clear();
+        queue.advance(now,out);
+        for(size_t i=0;i<out.size();i++)
+            record(out[i],queue.window(now));
+    }
+    double t_advance=now_sec()-t0;
+    advance_pairs=pairs-advance_pairs;
+
+    size_t left=0;
+    for(int i=0;i<next;i++)
+        if(state[i]==1)
+            left++;
+    if(left!=queue.size()||left>1||2*pairs+left!=(size_t)next||queued!=(size_t)n)
+        ok=false;
+
+    printf("match    %7d queued %8d arrivals: queue %6.1f ns/arrival (%zu paired, avg diff %.1f)   scan %8.1f ns/arrival (avg diff %.1f)   (%.0fx)\n",
+        n,arrivals,t_push*1e9/arrivals,push_pairs,push_diff,t_naive*1e9/naive_arrivals,naive_pairs?(double)naive_diff/naive_pairs:0,
+        (t_naive/naive_arrivals)/(t_push/arrivals));
+    printf("match    widening %zu queued: %zu pairs in %lld s of waiting, %.1f ms (%.1f ns/pair)   %s\n",
+        queued,advance_pairs,now/1000,t_advance*1e3,advance_pairs?t_advance*1e9/advance_pairs:0,ok?"pairs ok":"PAIRING MISMATCH");
+    return ok;
+}
+
+/**
+ * @brief 运行指标：热路径上一次计数和一次直方图记录的开销
+ *
+ * 单写者计数器（relaxed读加写）vs 原子加（lock前缀），直方图记录和读时钟各自的开销；
+ * 再让4个线程各自计数、记录到自己的直方图，合并后与逐个记下的值比对总数、总和、各边界以下的个数，
+ * 并检查分位数（取桶的上界）不小于真实值、相对误差不超过1/16
+ * @return bool 全部一致时返回true
+ */
+static bool bench_metrics(int ops)
+{
+    const int writers=4;
+    metric_counter counter;
+    atomic<uint64_t> locked(0);
+    latency_histogram hist;
+
+    double t0=now_sec();
+    for(int i=0;i<ops;i++)
+        counter.add();
+    double t_counter=now_sec()-t0;
+
+    t0=now_sec();
+    for(int i=0;i<ops;i++)
+        locked.fetch_add(1,memory_order_relaxed);
+    double t_locked=now_sec()-t0;
+
+    // 延迟大致在几微秒到几毫秒之间（对数均匀），预先生成避免把随机数的开销算进去
+    vector<uint64_t>values(1<<16);
+    srand(3141);
+    for(size_t i=0;i<values.size();i++)
+        values[i]=(uint64_t)(1000*pow(2.0,rand()%12+rand()/(RAND_MAX+1.0)));
+    t0=now_sec();
+    for(int i=0;i<ops;i++)
+        hist.record(values[i&(values.size()-1)]);
+    double t_record=now_sec()-t0;
+
+    uint64_t clock_sink=0;
+    t0=now_sec();
+    for(int i=0;i<ops;i++)
+        clock_sink+=metrics_now_ns();
+    double t_clock=now_sec()-t0;
+
+    bool ok=counter.value()==(uint64_t)ops&&locked.load()==(uint64_t)ops;
+
+    // 多个写者各自记录，合并后与全部的值比对
+    int per=max(ops/writers,1);
+    vector<metric_counter*>counters;
+    vector<latency_histogram*>hists;
+    vector<vector<uint64_t> >seen(writers);
+    for(int w=0;w<writers;w++)
+    {
+        counters.push_back(new metric_counter());
+        hists.push_back(new latency_histogram());
+    }
+    vector<thread>threads;
+    for(int w=0;w<writers;w++)
+        threads.push_back(thread([&,w]()
+        {
+            unsigned seed=w+1;
+            for(int i=0;i<per;i++)
+            {
+                uint64_t v=rand_r(&seed)%(1<<(rand_r(&seed)%34));
+                counters[w]->add();
+                hists[w]->record(v);
+                seen[w].push_back(v);
+            }
+        }));
+    for(size_t i=0;i<threads.size();i++)
+        threads[i].join();
+
+    histogram_snapshot merged;
+    vector<uint64_t>all;
+    uint64_t sum=0,count=0;
+    for(int w=0;w<writers;w++)
+    {
+        merged.merge(*hists[w]);
+        count+=counters[w]->value();
+        all.insert(all.end(),seen[w].begin(),seen[w].end());
+        delete counters[w];
+        delete hists[w];
+    }
+    sort(all.begin(),all.end());
+    for(size_t i=0;i<all.size();i++)
+        sum+=all[i];
+    if(count!=all.size()||merged.count()!=all.size()||merged.sum()!=sum)
+        ok=false;
+    for(int k=0;k<=34;k++)
+    {
+        uint64_t below=lower_bound(all.begin(),all.end(),1ULL<<k)-all.begin();
+        if(merged.count_below(1ULL<<k)!=below)
+            ok=false;
+    }
+    double worst=0;
+    const double qs[]={0.5,0.9,0.99,0.999};
+    for(int i=0;i<4;i++)
+    {
+        uint64_t exact=all[min((size_t)(qs[i]*all.size()),all.size()-1)];
+        uint64_t q=merged.quantile(qs[i]);
+        if(q<=exact||q>exact+exact/16+1)
+            ok=false;
+        worst=max(worst,(double)(q-exact)/(exact+1));
+    }
+
+    printf("metrics  %8d ops: counter %5.2f ns (lock add %5.2f ns)  histogram %5.2f ns  clock %5.2f ns   %d writers merged, quantile error %.1f%%   %s  [%llu]\n",
+        ops,t_counter*1e9/ops,t_locked*1e9/ops,t_record*1e9/ops,t_clock*1e9/ops,writers,worst*100,
+        ok?"merge ok":"MERGE MISMATCH",(unsigned long long)(clock_sink&0xff));
+    return ok;
+}
+
+/**
+ * @brief 对局日志：权威棋盘的落子循环上加记日志，每轮（tick步）整批提交，与不记日志对比
+ *
+ * 日志写入真实文件并同步（组提交），结束后读回比对每一条记录；
+ * 再把文件截断在每个字节处，检查校验只保留完整的记录
+ * @return bool 全部一致时返回true
+ */
+static bool bench_journal(int n,int moves,const char* path)
+{
+    const int tick=64;          // 一轮事件处理中的落子数
+    int pairs=n/2;
+    vector<int>order(moves);
+    srand(1357);
+    for(int i=0;i<moves;i++)
+        order[i]=rand()%pairs;
+
+    vector<game_board>boards(pairs);
+    vector<room_id_t>ids(pairs);
+    for(int r=0;r<pairs;r++)
+        ids[r]=((room_id_t)1<<32)|r;        // 代数1、反应堆0，与服务器的房间ID同样大小
+
+    const int step=97;
+    size_t sink=0;
+    double t_play[2];
+    vector<double>submit_us;
+    vector<journal_record>expect;
+    game_journal journal;
+    unlink(path);
+    if(!journal.open(path))
+    {
+        perror(path);
+        return false;
+    }
+
+    for(int pass=0;pass<2;pass++)
+    {
+        for(int r=0;r<pairs;r++)
+            boards[r].reset();
+        string batch,out;
+        double t0=now_sec();
+        for(int i=0;i<moves;i++)
+        {
+            int r=order[i];
+            int cell=(boards[r].moves()*step+r)%board_cells;
+            int result=boards[r].play(cell);
+            out.append("OM77\n",5);
+            if(pass)
+            {
+                journal_record rec;
+                rec.kind=jk_move;
+                rec.room=ids[r];
+                rec.value=cell;
+                journal_append(batch,rec);
+                if(result!=play_ok)
+                {
+                    rec.kind=jk_result;
+                    rec.value=result==play_five?boards[r].at(cell):2;
+                    journal_append(batch,rec);
+                }
+            }
+            if(result!=play_ok)
+                boards[r].reset();
+            if(i%tick==tick-1||i==moves-1)
+            {
+                sink+=out.size();
+                out.clear();
+                if(pass)
+                {
+                    double s0=now_sec();
+                    journal.submit(batch,i==moves-1);
+                    submit_us.push_back((now_sec()-s0)*1e6);
+                }
+            }
+        }
+        t_play[pass]=now_sec()-t0;
+    }
+    double t0=now_sec();
+    journal.sync();
+    double t_sync=now_sec()-t0;
+    uint64_t syncs=journal.sync_count(),bytes=journal.byte_count();
+    journal.close();
+
+    // 读回：按相同的顺序重放，逐条比对
+    FILE* f=fopen(path,"rb");
+    string data;
+    char chunk[65536];
+    size_t got;
+    while(f&&(got=fread(chunk,1,sizeof(chunk),f))>0)
+        data.append(chunk,got);
+    if(f)
+        fclose(f);
+    bool ok=journal_valid_size(data.data(),data.size())==data.size();
+    size_t pos=journal_header;
+    journal_record rec;
+    for(int r=0;r<pairs;r++)
+        boards[r].reset();
+    size_t records=0;
+    for(int i=0;i<moves&&ok;i++)
+    {
+        int r=order[i];
+        int cell=(boards[r].moves()*step+r)%board_cells;
+        int result=boards[r].play(cell);
+        ok=journal_parse(data.data(),data.size(),pos,rec)&&rec.kind==jk_move&&rec.room==ids[r]&&rec.value==(uint32_t)cell;
+        records++;
+        if(ok&&result!=play_ok)
+        {
+            ok=journal_parse(data.data(),data.size(),pos,rec)&&rec.kind==jk_result&&rec.room==ids[r]&&
+                rec.value==(uint32_t)(result==play_five?boards[r].at(cell):2);
+            records++;
+            boards[r].reset();
+        }
+    }
+    ok=ok&&pos==data.size();
+
+    // 每种记录各一条，截断在每个字节处：校验结果必须恰好是某条记录的结尾
+    string small(journal_magic,journal_header);
+    vector<size_t>ends(1,small.size());
+    for(int k=jk_start;k<=jk_result;k++)
+    {
+        journal_record x;
+        x.kind=k;
+        x.room=ids[k%pairs]+((room_id_t)k<<40);
+        x.value=k==jk_start?0:k==jk_move?224:k==jk_undo?2:1;     // 开局记录没有value
+        x.time=1700000000+k;
+        x.rule=1;
+        x.ip[0]=0x0100007f;
+        x.ip[1]=0x0200a8c0;
+        x.port[0]=4396;
+        x.port[1]=65535;
+        journal_append(small,x);
+        ends.push_back(small.size());
+        size_t p=ends[ends.size()-2];
+        journal_record y;
+        ok=ok&&journal_parse(small.data(),small.size(),p,y)&&p==small.size()&&y.kind==x.kind&&y.room==x.room&&
+            y.value==x.value&&(k!=jk_start||(y.time==x.time&&y.rule==x.rule&&y.ip[1]==x.ip[1]&&y.port[1]==x.port[1]));
+    }
+    for(size_t len=journal_header;len<=small.size();len++)
+    {
+        size_t valid=journal_valid_size(small.data(),len);
+        ok=ok&&valid<=len&&binary_search(ends.begin(),ends.end(),valid)&&(valid==len||len<ends.back());
+    }
+    unlink(path);
+
+    printf("journal  %7d games %9d moves: board %7.1f ns/move   +journal %7.1f ns/move   (+%.1f ns, %.1f bytes/move)\n",
+        pairs,moves,t_play[0]*1e9/moves,t_play[1]*1e9/moves,(t_play[1]-t_play[0])*1e9/moves,(double)bytes/moves);
+    sort(submit_us.begin(),submit_us.end());
+    printf("journal  %d moves/tick: %zu records, %llu fdatasync (%.1f ticks/sync), submit p50 %.2f us p99 %.2f us, final sync %.1f ms   %s  [%zu]\n",
+        tick,records,(unsigned long long)syncs,syncs?(moves/(double)tick)/syncs:0.0,
+        submit_us[submit_us.size()/2],submit_us[submit_us.size()*99/100],t_sync*1e3,
+        ok?"readback ok":"READBACK MISMATCH",sink);
+    return ok;
+}
+
+/**
+ * @brief 对局归档：生成日志，分三次增量整理，查询结果与直接遍历生成的对局比对
+ *
+ * 同时进行的房间有tables个，每局的前两步取自少数几种开局（局面查询有大量匹配），
+ * 玩家IP取自players个，结束方式混合五连、和棋、认输、离开（含选定先后手之前）、悔棋和中止，
+ * 另有一局开局后再无消息、超过一天后按中止收录
+ * @return bool 全部一致时返回true
+ */
+static bool bench_archive(int n,const char* journal_path,const char* dir)
+{
+    const int tables=20000,players=100000;
+    const uint32_t base=1700000000;
+    struct expect_game
+    {
+        archive_game g;
+        vector<uint8_t> moves;
+    };
+    struct table
+    {
+        bool active,aborting;
+        size_t game;            // 在games中的下标
+        vector<uint8_t> plan;   // 计划的落子
+        int end;                // 计划的结束方式
+    };
+    vector<expect_game> games;
+    vector<bool> finished;
+    vector<table> t(tables);
+    for(int i=0;i<tables;i++)
+        t[i].active=t[i].aborting=false;
+    vector<uint32_t> ips(players);
+    srand(2468);
+    for(int i=0;i<players;i++)
+        ips[i]=(uint32_t)rand()*2654435761u^(uint32_t)i;
+
+    string data(journal_magic,journal_header);
+    auto emit=[&](journal_record &r){ journal_append(data,r); };
+    auto start=[&](room_id_t room,uint32_t time)
+    {
+        expect_game e;
+        memset(&e.g,0,sizeof(e.g));
+        e.g.id=data.size();
+        e.g.time=time;
+        int a=rand()%players,b=rand()%100?rand()%players:a;
+        e.g.ip[0]=ips[a];
+        e.g.ip[1]=ips[b];
+        e.g.port[0]=(uint16_t)(1024+rand()%60000);
+        e.g.port[1]=(uint16_t)(1024+rand()%60000);
+        e.g.rule=(uint8_t)(rand()%rule_count);
+        e.g.black=archive_no_black;
+        e.g.winner=archive_no_winner;
+        journal_record r;
+        r.kind=jk_start;
+        r.room=room;
+        r.time=time;
+        r.rule=e.g.rule;
+        r.ip[0]=e.g.ip[0];
+        r.ip[1]=e.g.ip[1];
+        r.port[0]=e.g.port[0];
+        r.port[1]=e.g.port[1];
+        emit(r);
+        games.push_back(e);
+        finished.push_back(false);
+        return games.size()-1;
+    };
+
+    // 一局开局后再无消息（服务器中途退出），开局时间比其他对局早一天以上
+    {
+        size_t z=start(((room_id_t)7<<32)|tables,base-100000);
+        for(int k=0;k<3;k++)
+        {
+            journal_record r;
+            r.kind=jk_move;
+            r.room=((room_id_t)7<<32)|tables;
+            r.value=100+k;
+            emit(r);
+            games[z].moves.push_back((uint8_t)(100+k));
+        }
+        finished[z]=true;   // 整理时按中止收录
+    }
+
+    int started=0;
+    while(started<n)
+    {
+        int i=rand()%tables;
+        table &x=t[i];
+        room_id_t room=((room_id_t)1<<32)|i;
+        if(!x.active)
+        {
+            if(x.aborting)      // 同一房间开新局，上一局中止
+                finished[x.game]=true;
+            x.game=start(room,base+started/100);
+            x.active=true;
+            x.aborting=false;
+            started++;
+            // 计划：天元，周围8格之一，之后随机的空位
+            x.plan.clear();
+            x.plan.push_back(112);
+            static const int around[8]={-16,-15,-14,-1,1,14,15,16};
+            x.plan.push_back((uint8_t)(112+around[rand()%8]));
+            int len=5+rand()%50;
+            while((int)x.plan.size()<len)
+            {
+                uint8_t c=(uint8_t)(rand()%board_cells);
+                if(find(x.plan.begin(),x.plan.end(),c)==x.plan.end())
+                    x.plan.push_back(c);
+            }
+            x.end=rand()%10;
+            continue;
+        }
+        expect_game &e=games[x.game];
+        journal_record r;
+        r.room=room;
+        if(e.g.black==archive_no_black)
+        {
+            if(x.end==9&&rand()%4==0)       // 选定先后手之前离开
+            {
+                r.kind=jk_leave;
+                r.value=(uint8_t)stone_none;
+                e.g.end=ae_leave;
+                e.g.winner=archive_no_winner;
+                finished[x.game]=true;
+                x.active=false;
+            }
+            else
+            {
+                r.kind=jk_color;
+                r.value=rand()%2;
+                e.g.black=(uint8_t)r.value;
+            }
+        }
+        else if(e.moves.size()<x.plan.size())
+        {
+            if(!e.moves.empty()&&rand()%40==0)
+            {
+                int back=e.moves.size()>=2&&rand()%2?2:1;
+                r.kind=jk_undo;
+                r.value=back;
+                e.moves.resize(e.moves.size()-back);
+            }
+            else
+            {
+                r.kind=jk_move;
+                r.value=x.plan[e.moves.size()];
+                e.moves.push_back((uint8_t)r.value);
+            }
+        }
+        else
+        {
+            int last=e.moves.size()%2?stone_black:stone_white;
+            x.active=false;
+            if(x.end<6)
+            {
+                r.kind=jk_result;
+                r.value=x.end==0?2:last;
+                e.g.end=ae_result;
+                e.g.winner=(uint8_t)r.value;
+            }
+            else if(x.end<8)
+            {
+                r.kind=jk_surrender;
+                r.value=rand()%2;
+                e.g.end=ae_surrender;
+                e.g.winner=(uint8_t)(1-r.value);
+            }
+            else if(x.end==8)
+            {
+                r.kind=jk_leave;
+                r.value=rand()%2;
+                e.g.end=ae_leave;
+                e.g.winner=(uint8_t)(1-r.value);
+            }
+            else
+            {
+                x.aborting=true;    // 不发结果，等同一房间的下一局开局
+                continue;
+            }
+            finished[x.game]=true;
+        }
+        emit(r);
+    }
+
+    // 分三次写入并整理，切点在记录中间
+    mkdir(dir,0755);
+    unlink(archive_state::path(dir).c_str());
+    for(int i=0;unlink(archive_segment_path(dir,i).c_str())==0;i++)
+        ;
+    unlink(journal_path);
+    double t_build=0;
+    bool ok=true;
+    archive_build_stats total;
+    size_t cuts[4]={0,data.size()/3+1,data.size()*2/3+3,data.size()};
+    for(int k=0;k<3&&ok;k++)
+    {
+        FILE* f=fopen(journal_path,k?"ab":"wb");
+        ok=f&&fwrite(data.data()+cuts[k],1,cuts[k+1]-cuts[k],f)==cuts[k+1]-cuts[k];
+        if(f)
+            fclose(f);
+        archive_build_stats st;
+        double t0=now_sec();
+        ok=ok&&archive_build(journal_path,dir,&st);
+        t_build+=now_sec()-t0;
+        total.games+=st.games;
+        total.aborted+=st.aborted;
+        total.segments+=st.segments;
+        total.open=st.open;
+    }
+    unlink(journal_path);
+
+    game_archive archive;
+    ok=ok&&archive.open(dir);
+    uint64_t bytes=0;
+    for(int i=0;i<total.segments;i++)
+    {
+        struct stat sb;
+        if(stat(archive_segment_path(dir,i).c_str(),&sb)==0)
+            bytes+=sb.st_size;
+    }
+
+    // 期望的对局（按ID）
+    unordered_map<uint64_t,size_t> by_id;
+    vector<uint64_t> all;
+    for(size_t i=0;i<games.size();i++)
+        if(finished[i])
+        {
+            by_id[games[i].g.id]=i;
+            all.push_back(games[i].g.id);
+        }
+    sort(all.begin(),all.end());
+    ok=ok&&archive.games()==all.size()&&total.games==all.size();
+
+    // 翻完所有页，ID集合与期望一致，每一局的字段和落子都一致
+    auto same=[&](const archive_ref &ref)
+    {
+        unordered_map<uint64_t,size_t>::iterator it=by_id.find(ref.game->id);
+        if(it==by_id.end())
+            return false;
+        const expect_game &e=games[it->second];
+        const archive_game &g=*ref.game;
+        return g.time==e.g.time&&g.ip[0]==e.g.ip[0]&&g.ip[1]==e.g.ip[1]&&g.port[0]==e.g.port[0]&&g.port[1]==e.g.port[1]&&
+            g.rule==e.g.rule&&g.black==e.g.black&&g.end==e.g.end&&g.winner==e.g.winner&&g.moves==e.moves.size()&&
+            memcmp(ref.moves,e.moves.data(),g.moves)==0;
+    };
+    auto check=[&](vector<uint64_t> expect,size_t page_size,
+                   const std::function<size_t(size_t,size_t,vector<archive_ref>&)> &query)
+    {
+        vector<uint64_t> got;
+        vector<archive_ref> refs;
+        size_t total_count=query(0,page_size,refs);
+        bool good=total_count==expect.size();
+        for(size_t off=0;good&&off<total_count;off+=page_size)
+        {
+            good=query(off,page_size,refs)==total_count&&refs.size()==min(page_size,total_count-off);
+            for(size_t i=0;good&&i<refs.size();i++)
+            {
+                good=same(refs[i]);
+                got.push_back(refs[i].game->id);
+            }
+        }
+        sort(got.begin(),got.end());
+        sort(expect.begin(),expect.end());
+        return good&&got==expect;
+    };
+
+    ok=ok&&check(all,100,[&](size_t o,size_t l,vector<archive_ref> &r){ return archive.recent(o,l,r); });
+    for(int w=0;w<3&&ok;w++)
+    {
+        vector<uint64_t> expect;
+        for(size_t i=0;i<all.size();i++)
+            if(games[by_id[all[i]]].g.winner==w)
+                expect.push_back(all[i]);
+        ok=check(expect,100,[&](size_t o,size_t l,vector<archive_ref> &r){ return archive.by_winner(w,o,l,r); });
+    }
+    unordered_map<uint32_t,vector<uint64_t> > by_ip;
+    for(size_t i=0;i<all.size();i++)
+    {
+        const archive_game &g=games[by_id[all[i]]].g;
+        by_ip[g.ip[0]].push_back(all[i]);
+        if(g.ip[1]!=g.ip[0])
+            by_ip[g.ip[1]].push_back(all[i]);
+    }
+    for(int q=0;q<200&&ok;q++)
+    {
+        uint32_t ip=ips[rand()%players];
+        ok=check(by_ip[ip],7,[&](size_t o,size_t l,vector<archive_ref> &r){ return archive.by_player(ip,o,l,r); });
+    }
+    // 局面：取某一局的前几步，遍历所有对局第同样步数时的局面
+    for(int q=0;q<20&&ok;q++)
+    {
+        const expect_game* pick;
+        do
+            pick=&games[by_id[all[rand()%all.size()]]];
+        while(pick->moves.empty());
+        const expect_game &src=*pick;
+        int plies=1+rand()%min<int>(6,src.moves.size());
+        if(q%2)     // 一半用对称变换后的落子查询
+        {
+            vector<uint8_t> m(src.moves.begin(),src.moves.begin()+plies);
+            int sym=1+rand()%7;
+            for(int j=0;j<plies;j++)
+                m[j]=(uint8_t)book_transform(sym,m[j]);
+            ok=archive_position_key(m.data(),plies)==archive_position_key(src.moves.data(),plies);
+        }
+        uint64_t key=archive_position_key(src.moves.data(),plies);
+        vector<uint64_t> expect;
+        for(size_t i=0;i<all.size();i++)
+        {
+            const expect_game &e=games[by_id[all[i]]];
+            if((int)e.moves.size()>=plies&&archive_position_key(e.moves.data(),plies)==key)
+                expect.push_back(all[i]);
+        }
+        ok=ok&&check(expect,100,[&](size_t o,size_t l,vector<archive_ref> &r){ return archive.by_position(key,o,l,r); });
+    }
+    archive_ref ref;
+    ok=ok&&archive.find(all.back(),ref)&&same(ref)&&!archive.find(all.back()+1,ref);
+
+    // 查询耗时：随机的玩家、局面和深处的页
+    const int queries=2000;
+    double us[4]={0,0,0,0},worst[4]={0,0,0,0};
+    size_t sink=0;
+    vector<archive_ref> refs;
+    for(int q=0;q<queries;q++)
+    {
+        const expect_game* pick;
+        do
+            pick=&games[by_id[all[rand()%all.size()]]];
+        while(pick->moves.empty());
+        const expect_game &src=*pick;
+        int plies=1+rand()%min<int>(8,src.moves.size());
+        for(int kind=0;kind<4;kind++)
+        {
+            double t0=now_sec();
+            switch(kind)
+            {
+                case 0:sink+=archive.recent(rand()%all.size(),20,refs);break;
+                case 1:sink+=archive.by_player(src.g.ip[rand()%2],0,20,refs);break;
+                case 2:sink+=archive.by_winner(rand()%3,rand()%(all.size()/4+1),20,refs);break;
+                case 3:sink+=archive.by_position(archive_position_key(src.moves.data(),plies),0,20,refs);break;
+            }
+            for(size_t i=0;i<refs.size();i++)
+                sink+=refs[i].game->moves?refs[i].moves[0]:0;
+            double d=(now_sec()-t0)*1e6;
+            us[kind]+=d;
+            worst[kind]=max(worst[kind],d);
+        }
+    }
+
+    archive.close();
+    unlink(archive_state::path(dir).c_str());
+    for(int i=0;i<total.segments;i++)
+        unlink(archive_segment_path(dir,i).c_str());
+    rmdir(dir);
+
+    printf("archive  %zu games (%llu aborted, %zu open) in %d segments: journal %.1f MB, archive %.1f MB, build %.2f s (3 incremental runs)\n",
+        all.size(),(unsigned long long)total.aborted,total.open,total.segments,data.size()/1e6,bytes/1e6,t_build);
+    static const char* names[4]={"recent","player","winner","position"};
+    printf("archive  page of 20:");
+    for(int kind=0;kind<4;kind++)
+        printf("  %s avg %.1f us max %.1f us",names[kind],us[kind]/queries,worst[kind]);
+    printf("   %s  [%zu]\n",ok?"queries ok":"QUERY MISMATCH",sink);
+    return ok;
+}
+
+int main(int argc,char* argv[])
+{
+    int n=argc>1?atoi(argv[1]):100000;
+    int moves=argc>2?atoi(argv[2]):10000000;
+    n&=~1;      // 两两配对
+    if(n<2)
+        n=2;
+
+    bench_relay(n,moves);
+    bench_churn(n,moves/10);
+    bench_lobby(n,moves/100);
+    bench_timers(n,moves/10);
+    bench_game(n,moves);
+    bool ok=bench_fanout(min(n,10000),moves/2000);
+    ok=bench_match(n,moves/10)&&ok;
+    ok=bench_metrics(moves)&&ok;
+    ok=bench_journal(n,moves,"bench.journal")&&ok;
+    ok=bench_archive(argc>3?atoi(argv[3]):1000000,"bench.journal","bench.archive")&&ok;
+    return ok?0:1;
+}
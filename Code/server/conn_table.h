@@ -0,0 +1,123 @@
+/**
+ * @file conn_table.h
+ * @brief 以套接字描述符为下标的连接表
+ *
+ * 套接字描述符是从小到大分配、不断复用的小整数，直接用作数组下标即可O(1)定位连接，
+ * 不需要std::map的O(log n)查找，也不会像map::operator[]那样为任意整数插入空记录。
+ *
+ * - 连接对象从整块分配的对象池（slab）中取出，关闭后归还空闲链表复用，地址在使用期间不变，
+ *   因此可以在连接之间直接保存指针（如对手指针）
+ * - 在线连接另外记录在一个紧凑数组中，删除时与末尾元素交换，O(1)维护在线集合
+ */
+
+#ifndef CONN_TABLE_H
+#define CONN_TABLE_H
+
+#include<stddef.h>
+#include<vector>
+
+template<class T>
+class fd_table
+{
+public:
+    fd_table(){}
+
+    ~fd_table()
+    {
+        for(size_t i=0;i<chunks.size();i++)
+            delete[] chunks[i];
+    }
+
+    /**
+     * @brief 查找fd对应的对象
+     * @param fd 套接字描述符
+     * @return T* 不在表中返回NULL（不会插入新记录）
+     */
+    T* find(int fd) const
+    {
+        if(fd<0||(size_t)fd>=by_fd.size())
+            return NULL;
+        return by_fd[fd];
+    }
+
+    /**
+     * @brief 为fd分配一个默认初始化的对象（已存在时直接返回原对象）
+     * @param fd 套接字描述符
+     * @return T* 对象指针，在erase之前保持有效
+     */
+    T* insert(int fd)
+    {
+        if((size_t)fd>=by_fd.size())
+        {
+            size_t n=by_fd.size()?by_fd.size():64;
+            while(n<=(size_t)fd)
+                n*=2;
+            by_fd.resize(n,NULL);
+            pos.resize(n,-1);
+        }
+        if(by_fd[fd])
+            return by_fd[fd];
+
+        // 空闲链表为空时整块申请一批对象
+        if(free_list.empty())
+        {
+            T* chunk=new T[chunk_size];
+            chunks.push_back(chunk);
+            for(int i=chunk_size-1;i>=0;i--)
+                free_list.push_back(chunk+i);
+        }
+        T* obj=free_list.back();
+        free_list.pop_back();
+
+        by_fd[fd]=obj;
+        pos[fd]=(int)live.size();
+        live.push_back(fd);
+        return obj;
+    }
+
+    /**
+     * @brief 移除fd对应的对象并归还对象池（对象被重置为默认值）
+     * @param fd 套接字描述符
+     */
+    void erase(int fd)
+    {
+        T* obj=find(fd);
+        if(!obj)
+            return;
+        *obj=T();
+        free_list.push_back(obj);
+        by_fd[fd]=NULL;
+
+        // 与末尾元素交换后删除
+        int p=pos[fd];
+        int last=live.back();
+        live[p]=last;
+        pos[last]=p;
+        live.pop_back();
+        pos[fd]=-1;
+    }
+
+    /**
+     * @brief 表中的对象个数
+     */
+    size_t size() const { return live.size(); }
+
+    /**
+     * @brief 表中所有的fd（无序）
+     */
+    const std::vector<int>& fds() const { return live; }
+
+private:
+    static const int chunk_size=256;    // 每次整块分配的对象个数
+
+    std::vector<T*> by_fd;          // fd -> 对象指针（NULL表示不在表中）
+    std::vector<int> pos;           // fd -> 在live中的下标
+    std::vector<int> live;          // 在表中的fd
+    std::vector<T*> free_list;      // 空闲对象
+    std::vector<T*> chunks;         // 整块分配的对象数组，析构时统一释放
+
+    fd_table(const fd_table&);
+    fd_table& operator=(const fd_table&);
+};
+
+#endif // CONN_TABLE_H
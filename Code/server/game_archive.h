@@ -0,0 +1,731 @@
+/**
+ * @file game_archive.h
+ * @brief 对局归档：从对局日志（game_journal.h）整理出已结束的对局，带索引的只读段文件，mmap后直接查询
+ *
+ * 归档是一个目录：
+ * - archive.state：文本状态，记录日志已扫描到的偏移、段数和扫描结束时仍未结束的对局
+ * - seg-000000.gar、seg-000001.gar……：每次整理生成一个或几个段（每段最多archive_segment_games局），
+ *   后生成的段里是后结束的对局，查询按段从新到旧进行
+ *
+ * 段文件（小端，下面的结构体原样写入，每节按8字节对齐，打开时用mmap直接映射，不做解析）：
+ * - archive_header：魔数、版本、各节的条数
+ * - archive_game数组：按对局ID（开局记录在日志中的偏移，即开局的先后）升序
+ * - archive_player数组：双方IP -> 对局下标，按IP升序、同一IP内从新到旧
+ * - 结果索引：对局下标按胜方（白、黑、无）分组，组内从新到旧，各组起点在文件头中
+ * - 局面索引：一局中每一步之后（含开局前的空棋盘之外）局面的规范Zobrist键（8种对称取最小，同opening_book.h），
+ *   键数组升序，与之平行的对局下标数组在同一个键内从新到旧
+ * - 落子数组：各局的落子（格子下标，每步1字节）依次拼接
+ *
+ * 所有查询都是对映射数组的二分查找加顺序读取一页，开销与页大小和段数有关，与对局总数无关；
+ * 只有被访问的页面才会读入内存，打开数千万局的归档也只是映射文件。
+ *
+ * 整理是增量的：从上次仍未结束的最早一局的开局记录重新扫描，只收录这次扫描中结束的对局。
+ * 同一房间出现新的开局时，上一局未结束的记为中止；开局时间比日志中最新的开局早一天以上仍未结束的
+ * （服务器在对局中途退出）也记为中止。段和状态文件都先写临时文件再改名，整理中途退出不会破坏已有的归档。
+ */
+
+#ifndef GAME_ARCHIVE_H
+#define GAME_ARCHIVE_H
+
+#include<stdint.h>
+#include<stddef.h>
+#include<stdio.h>
+#include<string.h>
+#include<unistd.h>
+#include<fcntl.h>
+#include<sys/mman.h>
+#include<sys/stat.h>
+#include<string>
+#include<vector>
+#include<set>
+#include<algorithm>
+#include<unordered_map>
+
+#include "game_journal.h"
+#include "opening_book.h"   // symmetric_keys（局面的规范键）
+
+const int archive_version=1;
+const uint32_t archive_segment_games=1<<20;     // 每段最多的对局数
+const uint64_t archive_stale_seconds=24*3600;   // 超过这么久仍未结束的对局记为中止
+const uint8_t archive_no_black=255;             // 未选定先后手
+const uint8_t archive_no_winner=2;              // 和棋或中止（胜方：0白 1黑，同jk_result）
+
+/**
+ * @brief 对局的结束方式
+ */
+enum archive_end
+{
+    ae_aborted=0,       // 中止：没有结果记录（同一房间开了新局，或服务器中途退出）
+    ae_result=1,        // 五连或下满（jk_result）
+    ae_surrender=2,     // 认输
+    ae_leave=3          // 离开或断线
+};
+
+/**
+ * @brief 段文件头（64字节）
+ */
+struct archive_header
+{
+    char magic[8];              // "GOARCH\0\0"
+    uint32_t version;           // archive_version
+    uint32_t game_count;        // 对局数
+    uint64_t position_count;    // 局面索引的条数
+    uint64_t move_bytes;        // 落子数组的字节数
+    uint32_t player_count;      // 玩家索引的条数
+    uint32_t winner_first[4];   // 结果索引中胜方为白、黑、无的三组的起点，[3]为末尾
+    uint32_t reserved[3];
+};
+
+/**
+ * @brief 一局棋（40字节）
+ */
+struct archive_game
+{
+    uint64_t id;                // 开局记录在日志中的偏移（同一个日志内唯一，按开局先后递增）
+    uint32_t time;              // 开局时间（Unix秒）
+    uint32_t moves_first;       // 第一步在落子数组中的偏移
+    uint32_t ip[2];             // 房主、客人的IPv4（网络字节序）
+    uint16_t port[2];
+    uint8_t moves;              // 步数（悔棋撤销的步不算）
+    uint8_t rule;               // 规则（game_rule）
+    uint8_t black;              // 执黑的一方（0房主 1客人），未选定先后手时为archive_no_black
+    uint8_t end;                // 结束方式（archive_end）
+    uint8_t winner;             // 胜方（stone_black/stone_white，和棋或中止为archive_no_winner）
+    uint8_t reserved[3];
+};
+
+/**
+ * @brief 玩家索引的一条（8字节）
+ */
+struct archive_player
+{
+    uint32_t ip;                // IPv4（网络字节序）
+    uint32_t game;              // 对局在段中的下标
+};
+
+static_assert(sizeof(archive_header)==64&&sizeof(archive_game)==40&&sizeof(archive_player)==8,
+    "archive structures are written to disk as-is");
+
+const char archive_magic[8]={'G','O','A','R','C','H',0,0};
+
+/**
+ * @brief 段文件中各节的偏移（由文件头中的条数决定）
+ */
+struct archive_layout
+{
+    size_t games,players,winners,keys,key_games,moves,end;
+
+    explicit archive_layout(const archive_header &h)
+    {
+        games=sizeof(archive_header);
+        players=align(games+(size_t)h.game_count*sizeof(archive_game));
+        winners=align(players+(size_t)h.player_count*sizeof(archive_player));
+        keys=align(winners+(size_t)h.game_count*sizeof(uint32_t));
+        key_games=align(keys+h.position_count*sizeof(uint64_t));
+        moves=align(key_games+h.position_count*sizeof(uint32_t));
+        end=moves+h.move_bytes;
+    }
+
+    static size_t align(size_t n) { return (n+7)&~(size_t)7; }
+};
+
+/**
+ * @brief 按落子顺序求局面的规范键（黑方先手）
+ */
+inline uint64_t archive_position_key(const uint8_t* moves,int n)
+{
+    symmetric_keys k;
+    for(int i=0;i<n;i++)
+        k.add(i%2?stone_white:stone_black,moves[i]);
+    int symmetry;
+    return k.canonical(&symmetry);
+}
+
+/* ==================== 写入 ==================== */
+
+/**
+ * @brief 把一组已结束的对局写成一个段文件（先写path.tmp，同步后改名）
+ * @param games 对局（会按ID排序；moves_first为在moves中的偏移）
+ * @param moves 落子
+ * @return bool 写入失败时返回false
+ */
+inline bool archive_write_segment(const char* path,std::vector<archive_game> &games,const std::string &moves)
+{
+    std::sort(games.begin(),games.end(),[](const archive_game &a,const archive_game &b){ return a.id<b.id; });
+
+    // 落子按排序后的顺序重新拼接
+    std::string packed;
+    packed.reserve(moves.size());
+    for(size_t i=0;i<games.size();i++)
+    {
+        uint32_t first=games[i].moves_first;
+        games[i].moves_first=(uint32_t)packed.size();
+        packed.append(moves,first,games[i].moves);
+    }
+
+    uint32_t n=(uint32_t)games.size();
+    std::vector<archive_player> players;
+    players.reserve(2*n);
+    std::vector<uint32_t> winners(n);
+    uint32_t winner_count[3]={0,0,0};
+    struct position { uint64_t key; uint32_t game; };
+    std::vector<position> positions;
+    for(uint32_t i=0;i<n;i++)
+    {
+        const archive_game &g=games[i];
+        archive_player p;
+        p.game=i;
+        p.ip=g.ip[0];
+        players.push_back(p);
+        if(g.ip[1]!=g.ip[0])
+        {
+            p.ip=g.ip[1];
+            players.push_back(p);
+        }
+        winner_count[std::min(g.winner,archive_no_winner)]++;
+
+        // 每一步之后的局面（同一局中的局面各不相同）
+        symmetric_keys k;
+        const uint8_t* m=(const uint8_t*)packed.data()+g.moves_first;
+        for(int j=0;j<g.moves;j++)
+        {
+            k.add(j%2?stone_white:stone_black,m[j]);
+            position e;
+            int symmetry;
+            e.key=k.canonical(&symmetry);
+            e.game=i;
+            positions.push_back(e);
+        }
+    }
+
+    // 同一IP、同一结果、同一局面内都是从新到旧
+    std::sort(players.begin(),players.end(),[](const archive_player &a,const archive_player &b)
+        { return a.ip!=b.ip?a.ip<b.ip:a.game>b.game; });
+    std::sort(positions.begin(),positions.end(),[](const position &a,const position &b)
+        { return a.key!=b.key?a.key<b.key:a.game>b.game; });
+    archive_header h;
+    memset(&h,0,sizeof(h));
+    memcpy(h.magic,archive_magic,sizeof(h.magic));
+    h.version=archive_version;
+    h.game_count=n;
+    h.position_count=positions.size();
+    h.move_bytes=packed.size();
+    h.player_count=(uint32_t)players.size();
+    h.winner_first[0]=0;
+    for(int w=0;w<3;w++)
+        h.winner_first[w+1]=h.winner_first[w]+winner_count[w];
+    uint32_t fill[3]={h.winner_first[0],h.winner_first[1],h.winner_first[2]};
+    for(uint32_t i=n;i-->0;)
+        winners[fill[std::min(games[i].winner,archive_no_winner)]++]=i;
+
+    std::vector<uint64_t> keys(positions.size());
+    std::vector<uint32_t> key_games(positions.size());
+    for(size_t i=0;i<positions.size();i++)
+    {
+        keys[i]=positions[i].key;
+        key_games[i]=positions[i].game;
+    }
+    std::vector<position>().swap(positions);
+
+    std::string tmp=std::string(path)+".tmp";
+    FILE* f=fopen(tmp.c_str(),"wb");
+    if(!f)
+        return false;
+    archive_layout layout(h);
+    const char zero[8]={0};
+    size_t at=0;
+    bool ok=true;
+    auto put=[&](size_t offset,const void* data,size_t size)
+    {
+        if(offset>at)
+            ok=ok&&fwrite(zero,1,offset-at,f)==offset-at;
+        ok=ok&&(size==0||fwrite(data,1,size,f)==size);
+        at=offset+size;
+    };
+    put(0,&h,sizeof(h));
+    put(layout.games,games.data(),games.size()*sizeof(archive_game));
+    put(layout.players,players.data(),players.size()*sizeof(archive_player));
+    put(layout.winners,winners.data(),winners.size()*sizeof(uint32_t));
+    put(layout.keys,keys.data(),keys.size()*sizeof(uint64_t));
+    put(layout.key_games,key_games.data(),key_games.size()*sizeof(uint32_t));
+    put(layout.moves,packed.data(),packed.size());
+    ok=fflush(f)==0&&ok&&fsync(fileno(f))==0;
+    ok=fclose(f)==0&&ok;
+    return ok&&rename(tmp.c_str(),path)==0;
+}
+
+/**
+ * @brief 整理的统计
+ */
+struct archive_build_stats
+{
+    uint64_t scanned;           // 本次扫描的日志字节数
+    uint64_t records;           // 本次扫描的记录数
+    uint64_t games;             // 新收录的对局数
+    uint64_t aborted;           // 其中记为中止的
+    int segments;               // 新写的段数
+    size_t open;                // 仍未结束的对局数
+
+    archive_build_stats():scanned(0),records(0),games(0),aborted(0),segments(0),open(0){}
+};
+
+/**
+ * @brief 段文件的路径
+ */
+inline std::string archive_segment_path(const std::string &dir,int index)
+{
+    char name[32];
+    snprintf(name,sizeof(name),"/seg-%06d.gar",index);
+    return dir+name;
+}
+
+/**
+ * @brief 归档目录的整理状态（archive.state）
+ */
+struct archive_state
+{
+    uint64_t scanned;           // 日志已扫描到的偏移
+    int segments;               // 段数
+    std::set<uint64_t> open;    // 扫描结束时仍未结束的对局的ID（开局记录的偏移）
+
+    archive_state():scanned(0),segments(0){}
+
+    static std::string path(const std::string &dir) { return dir+"/archive.state"; }
+
+    /**
+     * @brief 读取状态，文件不存在时为空的归档
+     * @return bool 文件存在但格式不对时返回false
+     */
+    bool load(const std::string &dir)
+    {
+        *this=archive_state();
+        FILE* f=fopen(path(dir).c_str(),"r");
+        if(!f)
+            return true;
+        unsigned long long scanned_offset,id;
+        bool ok=fscanf(f,"scanned %llu segments %d open",&scanned_offset,&segments)==2;
+        scanned=scanned_offset;
+        while(ok&&fscanf(f,"%llu",&id)==1)
+            open.insert(id);
+        fclose(f);
+        return ok&&segments>=0;
+    }
+
+    bool save(const std::string &dir) const
+    {
+        std::string tmp=path(dir)+".tmp";
+        FILE* f=fopen(tmp.c_str(),"w");
+        if(!f)
+            return false;
+        fprintf(f,"scanned %llu segments %d open",(unsigned long long)scanned,segments);
+        for(std::set<uint64_t>::const_iterator it=open.begin();it!=open.end();++it)
+            fprintf(f," %llu",(unsigned long long)*it);
+        fprintf(f,"\n");
+        bool ok=fflush(f)==0&&fsync(fileno(f))==0;
+        ok=fclose(f)==0&&ok;
+        return ok&&rename(tmp.c_str(),path(dir).c_str())==0;
+    }
+};
+
+/**
+ * @brief 把日志中新结束的对局整理进归档目录（目录需已存在）
+ * @return bool 日志或归档目录无法读写时返回false
+ *
+ * 可以在服务器运行时执行：日志末尾正在写入的不完整记录留到下一次整理
+ */
+inline bool archive_build(const char* journal_path,const std::string &dir,archive_build_stats* stats=NULL)
+{
+    archive_build_stats local;
+    archive_build_stats &st=stats?*stats:local;
+    archive_state state;
+    if(!state.load(dir))
+        return false;
+
+    int fd=open(journal_path,O_RDONLY|O_CLOEXEC);
+    if(fd<0)
+        return false;
+    struct stat sb;
+    if(fstat(fd,&sb)!=0||(size_t)sb.st_size<journal_header)
+    {
+        close(fd);
+        return false;
+    }
+    size_t length=sb.st_size;
+    void* base=mmap(NULL,length,PROT_READ,MAP_PRIVATE,fd,0);
+    close(fd);
+    if(base==MAP_FAILED)
+        return false;
+    const char* data=(const char*)base;
+    if(memcmp(data,journal_magic,journal_header)!=0)
+    {
+        munmap(base,length);
+        return false;
+    }
+    madvise(base,length,MADV_SEQUENTIAL);
+
+    uint64_t prev_scanned=std::max<uint64_t>(state.scanned,journal_header);
+    size_t pos=state.open.empty()?prev_scanned:std::min<uint64_t>(*state.open.begin(),prev_scanned);
+
+    // 正在整理的对局：房间ID -> 下标（-1表示这一局之前已经收录，跳过它的记录）
+    struct building { archive_game game; std::string moves; };
+    std::vector<building> live;
+    std::vector<size_t> free_live;
+    std::unordered_map<room_id_t,long> rooms;
+
+    std::vector<archive_game> done;
+    std::string done_moves;
+    bool ok=true;
+    auto flush=[&]()
+    {
+        if(done.empty())
+            return;
+        ok=ok&&archive_write_segment(archive_segment_path(dir,state.segments).c_str(),done,done_moves);
+        if(ok)
+        {
+            state.segments++;
+            st.segments++;
+        }
+        done.clear();
+        done_moves.clear();
+    };
+    auto finish=[&](long slot,int end,int winner)
+    {
+        building &b=live[slot];
+        b.game.end=(uint8_t)end;
+        b.game.winner=(uint8_t)winner;
+        b.game.moves=(uint8_t)std::min<size_t>(b.moves.size(),board_cells);
+        b.game.moves_first=(uint32_t)done_moves.size();
+        done_moves.append(b.moves,0,b.game.moves);
+        done.push_back(b.game);
+        st.games++;
+        st.aborted+=end==ae_aborted;
+        free_live.push_back(slot);
+        if(done.size()>=archive_segment_games)
+            flush();
+    };
+    // 颜色为color的一方认输或离开时的胜方
+    auto other=[](uint32_t color)->int
+    {
+        return color==stone_black?(int)stone_white:color==stone_white?(int)stone_black:(int)archive_no_winner;
+    };
+
+    uint64_t newest=0;
+    size_t start_pos=pos;
+    journal_record r;
+    size_t at=pos;
+    while(ok&&journal_parse(data,length,pos,r))
+    {
+        st.records++;
+        if(r.kind==jk_start)
+        {
+            std::unordered_map<room_id_t,long>::iterator it=rooms.find(r.room);
+            if(it!=rooms.end()&&it->second>=0)
+                finish(it->second,ae_aborted,archive_no_winner);
+            newest=std::max(newest,r.time);
+            if(at<prev_scanned&&!state.open.count(at))
+            {
+                rooms[r.room]=-1;
+                at=pos;
+                continue;
+            }
+            long slot;
+            if(!free_live.empty())
+            {
+                slot=free_live.back();
+                free_live.pop_back();
+            }
+            else
+            {
+                slot=live.size();
+                live.push_back(building());
+            }
+            building &b=live[slot];
+            memset(&b.game,0,sizeof(b.game));
+            b.game.id=at;
+            b.game.time=(uint32_t)r.time;
+            b.game.ip[0]=r.ip[0];
+            b.game.ip[1]=r.ip[1];
+            b.game.port[0]=r.port[0];
+            b.game.port[1]=r.port[1];
+            b.game.rule=(uint8_t)r.rule;
+            b.game.black=archive_no_black;
+            b.moves.clear();
+            rooms[r.room]=slot;
+            at=pos;
+            continue;
+        }
+        at=pos;
+
+        std::unordered_map<room_id_t,long>::iterator it=rooms.find(r.room);
+        if(it==rooms.end()||it->second<0)
+            continue;
+        long slot=it->second;
+        building &b=live[slot];
+        switch(r.kind)
+        {
+            case jk_color:b.game.black=(uint8_t)(r.value?1:0);break;
+            case jk_move:
+                if(r.value<(uint32_t)board_cells&&b.moves.size()<(size_t)board_cells)
+                    b.moves.push_back((char)r.value);
+                break;
+            case jk_undo:b.moves.resize(b.moves.size()-std::min<size_t>(r.value,b.moves.size()));break;
+            case jk_result:finish(slot,ae_result,std::min<uint32_t>(r.value,archive_no_winner));it->second=-1;break;
+            case jk_surrender:finish(slot,ae_surrender,other(r.value));it->second=-1;break;
+            case jk_leave:finish(slot,ae_leave,other(r.value));it->second=-1;break;
+        }
+    }
+
+    // 扫描结束时仍未结束的对局：太久的记为中止，其余留到下一次
+    state.open.clear();
+    for(std::unordered_map<room_id_t,long>::iterator it=rooms.begin();ok&&it!=rooms.end();++it)
+    {
+        if(it->second<0)
+            continue;
+        const archive_game &g=live[it->second].game;
+        if(g.time+archive_stale_seconds<newest)
+            finish(it->second,ae_aborted,archive_no_winner);
+        else
+            state.open.insert(g.id);
+    }
+    flush();
+    munmap(base,length);
+
+    st.scanned=pos-start_pos;
+    st.open=state.open.size();
+    state.scanned=pos;
+    return ok&&state.save(dir);
+}
+
+/* ==================== 查询 ==================== */
+
+/**
+ * @brief 查询结果中的一局：对局记录和它的落子
+ */
+struct archive_ref
+{
+    const archive_game* game;
+    const uint8_t* moves;
+};
+
+class game_archive
+{
+public:
+    game_archive(){}
+    ~game_archive() { close(); }
+
+    /**
+     * @brief 映射归档目录中的所有段（之前打开的先关闭）
+     * @return bool 状态文件或某个段无法读取、格式不对时返回false
+     */
+    bool open(const std::string &dir)
+    {
+        close();
+        archive_state state;
+        if(!state.load(dir))
+            return false;
+        for(int i=0;i<state.segments;i++)
+        {
+            segment s;
+            if(!map(archive_segment_path(dir,i).c_str(),s))
+            {
+                close();
+                return false;
+            }
+            segs.push_back(s);
+        }
+        return true;
+    }
+
+    void close()
+    {
+        for(size_t i=0;i<segs.size();i++)
+            munmap((void*)segs[i].base,segs[i].length);
+        segs.clear();
+    }
+
+    size_t segments() const { return segs.size(); }
+
+    /**
+     * @brief 对局总数
+     */
+    uint64_t games() const
+    {
+        uint64_t n=0;
+        for(size_t i=0;i<segs.size();i++)
+            n+=segs[i].h->game_count;
+        return n;
+    }
+
+    /**
+     * @brief 所有对局，从新到旧的第[offset, offset+limit)局
+     * @return size_t 匹配的总数
+     */
+    size_t recent(size_t offset,size_t limit,std::vector<archive_ref> &out) const
+    {
+        return page(offset,limit,out,
+            [](const segment &s,size_t &lo,size_t &hi){ lo=0; hi=s.h->game_count; },
+            [](const segment &s,size_t i){ return (uint32_t)(s.h->game_count-1-i); });
+    }
+
+    /**
+     * @brief 有ip一方参加的对局，从新到旧
+     */
+    size_t by_player(uint32_t ip,size_t offset,size_t limit,std::vector<archive_ref> &out) const
+    {
+        return page(offset,limit,out,
+            [ip](const segment &s,size_t &lo,size_t &hi)
+            {
+                const archive_player* end=s.players+s.h->player_count;
+                std::pair<const archive_player*,const archive_player*> r=std::equal_range(s.players,end,ip,cmp_player());
+                lo=r.first-s.players;
+                hi=r.second-s.players;
+            },
+            [](const segment &s,size_t i){ return s.players[i].game; });
+    }
+
+    /**
+     * @brief 胜方为winner（stone_black/stone_white，archive_no_winner为和棋和中止）的对局，从新到旧
+     */
+    size_t by_winner(int winner,size_t offset,size_t limit,std::vector<archive_ref> &out) const
+    {
+        if(winner<0||winner>2)
+            return 0;
+        return page(offset,limit,out,
+            [winner](const segment &s,size_t &lo,size_t &hi){ lo=s.h->winner_first[winner]; hi=s.h->winner_first[winner+1]; },
+            [](const segment &s,size_t i){ return s.winners[i]; });
+    }
+
+    /**
+     * @brief 出现过规范键为key的局面的对局（archive_position_key，对称的局面算同一个），从新到旧
+     */
+    size_t by_position(uint64_t key,size_t offset,size_t limit,std::vector<archive_ref> &out) const
+    {
+        return page(offset,limit,out,
+            [key](const segment &s,size_t &lo,size_t &hi)
+            {
+                const uint64_t* end=s.keys+s.h->position_count;
+                std::pair<const uint64_t*,const uint64_t*> r=std::equal_range(s.keys,end,key);
+                lo=r.first-s.keys;
+                hi=r.second-s.keys;
+            },
+            [](const segment &s,size_t i){ return s.key_games[i]; });
+    }
+
+    /**
+     * @brief 按对局ID查找
+     */
+    bool find(uint64_t id,archive_ref &out) const
+    {
+        for(size_t i=segs.size();i-->0;)
+        {
+            const segment &s=segs[i];
+            const archive_game* end=s.games+s.h->game_count;
+            const archive_game* g=std::lower_bound(s.games,end,id,
+                [](const archive_game &a,uint64_t v){ return a.id<v; });
+            if(g!=end&&g->id==id)
+            {
+                out.game=g;
+                out.moves=s.moves+g->moves_first;
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    game_archive(const game_archive&);
+    game_archive& operator=(const game_archive&);
+
+    struct segment
+    {
+        const char* base;
+        size_t length;
+        const archive_header* h;
+        const archive_game* games;
+        const archive_player* players;
+        const uint32_t* winners;
+        const uint64_t* keys;
+        const uint32_t* key_games;
+        const uint8_t* moves;
+    };
+
+    struct cmp_player
+    {
+        bool operator()(const archive_player &a,uint32_t ip) const { return a.ip<ip; }
+        bool operator()(uint32_t ip,const archive_player &a) const { return ip<a.ip; }
+    };
+
+    static bool map(const char* path,segment &s)
+    {
+        int fd=::open(path,O_RDONLY|O_CLOEXEC);
+        if(fd<0)
+            return false;
+        struct stat sb;
+        if(fstat(fd,&sb)!=0||(size_t)sb.st_size<sizeof(archive_header))
+        {
+            ::close(fd);
+            return false;
+        }
+        s.length=sb.st_size;
+        void* p=mmap(NULL,s.length,PROT_READ,MAP_SHARED,fd,0);
+        ::close(fd);
+        if(p==MAP_FAILED)
+            return false;
+        s.base=(const char*)p;
+        s.h=(const archive_header*)p;
+        if(memcmp(s.h->magic,archive_magic,sizeof(archive_magic))!=0||s.h->version!=(uint32_t)archive_version||
+           archive_layout(*s.h).end!=s.length||s.h->winner_first[3]!=s.h->game_count)
+        {
+            munmap(p,s.length);
+            return false;
+        }
+        archive_layout layout(*s.h);
+        s.games=(const archive_game*)(s.base+layout.games);
+        s.players=(const archive_player*)(s.base+layout.players);
+        s.winners=(const uint32_t*)(s.base+layout.winners);
+        s.keys=(const uint64_t*)(s.base+layout.keys);
+        s.key_games=(const uint32_t*)(s.base+layout.key_games);
+        s.moves=(const uint8_t*)(s.base+layout.moves);
+        // 索引的访问是随机的，不需要预读
+        madvise(p,s.length,MADV_RANDOM);
+        return true;
+    }
+
+    /**
+     * @brief 按段从新到旧分页：range给出段内匹配的下标区间，game把区间内的下标换成对局下标
+     */
+    template<class Range,class Game>
+    size_t page(size_t offset,size_t limit,std::vector<archive_ref> &out,Range range,Game game) const
+    {
+        out.clear();
+        size_t total=0;
+        for(size_t k=segs.size();k-->0;)
+        {
+            const segment &s=segs[k];
+            size_t lo,hi;
+            range(s,lo,hi);
+            total+=hi-lo;
+            if(offset>=hi-lo)
+            {
+                offset-=hi-lo;
+                continue;
+            }
+            for(size_t i=lo+offset;i<hi&&out.size()<limit;i++)
+            {
+                uint32_t g=game(s,i);
+                if(g>=s.h->game_count)
+                    continue;
+                archive_ref r;
+                r.game=s.games+g;
+                r.moves=s.moves+r.game->moves_first;
+                out.push_back(r);
+            }
+            offset=0;
+        }
+        return total;
+    }
+
+    std::vector<segment> segs;
+};
+
+#endif // GAME_ARCHIVE_H
@@ -0,0 +1,421 @@
+/**
+ * @file game_journal.h
+ * @brief 对局日志：只追加的二进制文件，记录每个房间的开局、先后手、落子、悔棋、认输、离开和结果
+ *
+ * 文件格式：4字节文件头"GJ01"，之后是一条接一条的记录，没有分隔符：
+ *
+ *     | 类型(1字节) | 房间ID(varint) | 负载 |
+ *
+ * varint为无符号LEB128（每字节低7位为数据，最高位为1表示后面还有字节）。负载按类型：
+ * - jk_start   开局：时间(varint，Unix秒) 规则(1字节) 房主IPv4(4字节) 房主端口(varint) 客人IPv4(4字节) 客人端口(varint)
+ * - jk_color   先后手：执黑的一方（1字节，0房主 1客人）
+ * - jk_move    落子：格子下标（varint，x*15+y）
+ * - jk_undo    悔棋：撤销的步数（varint，1或2）
+ * - jk_surrender / jk_leave  认输 / 离开：该方的颜色（1字节，stone_black/stone_white，选定先后手之前离开为stone_none）
+ * - jk_result  结果：1黑胜 0白胜 2和棋（1字节，五连或下满时）
+ * 一步落子通常7字节（类型1 + 房间ID 5 + 格子1~2）。同一房间可以先后进行多局，每局从jk_start开始。
+ *
+ * 写入分两层：
+ * - 反应堆线程在处理消息时只把记录追加到本线程的内存批次（一次string追加），一轮事件处理结束后整批提交
+ * - 提交线程把所有线程提交的批次合并，一次write加一次fdatasync（组提交）；同步期间到达的批次合并进下一次。
+ *   落子的转发不等待同步，磁盘再慢也只会让每次同步的批次变大，不会拖慢事件循环
+ *
+ * 打开已有文件时逐条校验记录，丢弃崩溃时没写完的尾部（截断到最后一条完整记录）后继续追加。
+ * 运行中write或fdatasync失败时截断回上一次同步成功的位置，打印错误后停止记录（之后的批次直接丢弃），
+ * 已同步的字节数不再增加，等待同步的调用方随即返回。
+ */
+
+#ifndef GAME_JOURNAL_H
+#define GAME_JOURNAL_H
+
+#include<stdint.h>
+#include<stddef.h>
+#include<stdio.h>
+#include<string.h>
+#include<unistd.h>
+#include<errno.h>
+#include<fcntl.h>
+#include<sys/stat.h>
+#include<string>
+#include<atomic>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+
+#include "room_table.h"
+
+/**
+ * @brief 记录的类型
+ */
+enum journal_kind
+{
+    jk_start=1,
+    jk_color=2,
+    jk_move=3,
+    jk_undo=4,
+    jk_surrender=5,
+    jk_leave=6,
+    jk_result=7
+};
+
+const char journal_magic[4]={'G','J','0','1'};
+const size_t journal_header=sizeof(journal_magic);
+
+/**
+ * @brief 一条记录（解码后）
+ *
+ * value按类型为执黑的一方、格子下标、悔棋步数、颜色或结果；time、rule、ip、port只有jk_start使用
+ */
+struct journal_record
+{
+    int kind;
+    room_id_t room;
+    uint32_t value;
+    uint64_t time;
+    int rule;
+    uint32_t ip[2];         // 网络字节序，0房主 1客人
+    uint16_t port[2];       // 主机字节序
+
+    journal_record():kind(0),room(0),value(0),time(0),rule(0) { ip[0]=ip[1]=0; port[0]=port[1]=0; }
+};
+
+/* ==================== 编码 ==================== */
+
+inline void journal_put_varint(std::string &out,uint64_t v)
+{
+    char b[10];
+    int n=0;
+    while(v>=0x80)
+    {
+        b[n++]=(char)(v|0x80);
+        v>>=7;
+    }
+    b[n++]=(char)v;
+    out.append(b,n);
+}
+
+/**
+ * @brief 读取一个varint，数据不完整或超过10字节时返回false（p不变）
+ */
+inline bool journal_get_varint(const unsigned char* &p,const unsigned char* end,uint64_t &v)
+{
+    uint64_t x=0;
+    const unsigned char* q=p;
+    for(int shift=0;q<end&&shift<64;shift+=7)
+    {
+        unsigned char b=*q++;
+        x|=(uint64_t)(b&0x7f)<<shift;
+        if(!(b&0x80))
+        {
+            v=x;
+            p=q;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief 把一条记录编码后追加到out
+ */
+inline void journal_append(std::string &out,const journal_record &r)
+{
+    out.push_back((char)r.kind);
+    journal_put_varint(out,r.room);
+    switch(r.kind)
+    {
+        case jk_start:
+            journal_put_varint(out,r.time);
+            out.push_back((char)r.rule);
+            for(int i=0;i<2;i++)
+            {
+                out.append((const char*)&r.ip[i],4);
+                journal_put_varint(out,r.port[i]);
+            }
+            break;
+        case jk_move:
+        case jk_undo:
+            journal_put_varint(out,r.value);
+            break;
+        default:
+            out.push_back((char)r.value);
+            break;
+    }
+}
+
+/**
+ * @brief 从data[pos]解码一条记录，成功时pos移到下一条
+ * @return bool 数据不完整或类型非法时返回false（pos不变）
+ */
+inline bool journal_parse(const char* data,size_t len,size_t &pos,journal_record &r)
+{
+    const unsigned char* p=(const unsigned char*)data+pos;
+    const unsigned char* end=(const unsigned char*)data+len;
+    if(p>=end||*p<jk_start||*p>jk_result)
+        return false;
+    r=journal_record();
+    r.kind=*p++;
+    uint64_t v;
+    if(!journal_get_varint(p,end,v))
+        return false;
+    r.room=v;
+    switch(r.kind)
+    {
+        case jk_start:
+        {
+            if(!journal_get_varint(p,end,r.time)||p>=end)
+                return false;
+            r.rule=*p++;
+            for(int i=0;i<2;i++)
+            {
+                if(end-p<4)
+                    return false;
+                memcpy(&r.ip[i],p,4);
+                p+=4;
+                if(!journal_get_varint(p,end,v)||v>0xffff)
+                    return false;
+                r.port[i]=(uint16_t)v;
+            }
+        }break;
+        case jk_move:
+        case jk_undo:
+        {
+            if(!journal_get_varint(p,end,v)||v>0xffffffffu)
+                return false;
+            r.value=(uint32_t)v;
+        }break;
+        default:
+        {
+            if(p>=end)
+                return false;
+            r.value=*p++;
+        }break;
+    }
+    pos=p-(const unsigned char*)data;
+    return true;
+}
+
+/**
+ * @brief 校验日志内容：文件头正确时返回最后一条完整记录的结尾，否则返回0
+ */
+inline size_t journal_valid_size(const char* data,size_t len)
+{
+    if(len<journal_header||memcmp(data,journal_magic,journal_header)!=0)
+        return 0;
+    size_t pos=journal_header;
+    journal_record r;
+    while(journal_parse(data,len,pos,r))
+        ;
+    return pos;
+}
+
+/* ==================== 组提交 ==================== */
+
+class game_journal
+{
+public:
+    game_journal():fd(-1),failed(false),end(0),stopping(false),submitted(0),durable(0),commits(0){}
+    ~game_journal() { close(); }
+
+    /**
+     * @brief 打开（或创建）日志文件并启动提交线程
+     * @return bool 无法打开，或已有文件不是对局日志时返回false
+     */
+    bool open(const char* path)
+    {
+        close();
+        int f=::open(path,O_RDWR|O_CREAT|O_CLOEXEC,0644);
+        if(f<0)
+            return false;
+
+        // 读出已有内容，截掉没写完的尾部
+        struct stat st;
+        std::string old;
+        if(fstat(f,&st)==0&&st.st_size>0)
+        {
+            old.resize(st.st_size);
+            if(pread(f,&old[0],old.size(),0)!=(ssize_t)old.size())
+            {
+                ::close(f);
+                return false;
+            }
+        }
+        size_t valid=old.empty()?0:journal_valid_size(old.data(),old.size());
+        if(!old.empty()&&valid==0)      // 不是对局日志，不覆盖
+        {
+            ::close(f);
+            return false;
+        }
+        if(valid==0)
+        {
+            if(pwrite(f,journal_magic,journal_header,0)!=(ssize_t)journal_header)
+            {
+                ::close(f);
+                return false;
+            }
+            valid=journal_header;
+        }
+        if(ftruncate(f,valid)!=0||lseek(f,0,SEEK_END)<0||fdatasync(f)!=0)
+        {
+            ::close(f);
+            return false;
+        }
+
+        fd=f;
+        failed=false;
+        end=valid;
+        stopping=false;
+        writer=std::thread(&game_journal::run,this);
+        return true;
+    }
+
+    /**
+     * @brief 日志已打开且没有因写入失败而停止
+     */
+    bool is_open() const { return fd>=0&&!failed.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief 提交一批记录（反应堆线程在一轮事件处理结束时调用），提交后batch被清空
+     * @param wait 提交线程正持有锁时是否等待；不等待时batch留到下一轮再提交
+     *        （事件循环至少每个时间轮刻度醒来一次，记录最多晚一个刻度交给提交线程）
+     * @return bool batch已提交（或为空）
+     *
+     * 只在锁内交换或追加字符串，不等待写入
+     */
+    bool submit(std::string &batch,bool wait=false)
+    {
+        if(batch.empty())
+            return true;
+        std::unique_lock<std::mutex> lock(m,std::defer_lock);
+        if(wait)
+            lock.lock();
+        else if(!lock.try_lock())
+            return false;
+        if(failed.load(std::memory_order_relaxed))
+        {
+            lock.unlock();
+            batch.clear();
+            return true;
+        }
+        submitted+=batch.size();
+        if(pending.empty())
+            pending.swap(batch);
+        else
+            pending.append(batch);
+        lock.unlock();
+        batch.clear();
+        cv.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 等待此前提交的记录全部写入并同步（测试和退出时使用）
+     * @return bool 写入或同步失败、日志已停止时返回false
+     */
+    bool sync()
+    {
+        std::unique_lock<std::mutex> lock(m);
+        uint64_t target=submitted;
+        done_cv.wait(lock,[&]{ return durable>=target||fd<0||failed.load(std::memory_order_relaxed); });
+        return durable>=target;
+    }
+
+    /**
+     * @brief 写入剩余的记录后停止提交线程并关闭文件
+     */
+    void close()
+    {
+        if(fd<0)
+            return;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopping=true;
+        }
+        cv.notify_one();
+        writer.join();
+        ::close(fd);
+        fd=-1;
+    }
+
+    /**
+     * @brief 同步（fdatasync）的次数和已同步的字节数
+     */
+    uint64_t sync_count() { std::lock_guard<std::mutex> lock(m); return commits; }
+    uint64_t byte_count() { std::lock_guard<std::mutex> lock(m); return durable; }
+
+private:
+    game_journal(const game_journal&);
+    game_journal& operator=(const game_journal&);
+
+    void run()
+    {
+        std::string batch;
+        std::unique_lock<std::mutex> lock(m);
+        for(;;)
+        {
+            cv.wait(lock,[&]{ return stopping||!pending.empty(); });
+            if(pending.empty())
+                break;
+            batch.swap(pending);
+            uint64_t target=submitted;
+            lock.unlock();
+
+            // 一次写入、一次同步，覆盖这段时间里所有线程提交的记录
+            size_t off=0;
+            errno=0;
+            while(off<batch.size())
+            {
+                ssize_t n=write(fd,batch.data()+off,batch.size()-off);
+                if(n<0&&errno==EINTR)
+                    continue;
+                if(n<=0)
+                    break;
+                off+=n;
+            }
+            const char* error=NULL;
+            if(off<batch.size())
+                error="write";
+            else if(fdatasync(fd)!=0)
+                error="fdatasync";
+            if(error)
+            {
+                // 去掉这一批写了一部分的记录，文件停在上一次同步成功的位置
+                int code=errno?errno:EIO;
+                bool truncated=ftruncate(fd,end)==0&&fdatasync(fd)==0;
+                printf("[%d][Journal]<%s failed: %s, %s, games are no longer recorded>\n",__LINE__,error,strerror(code),
+                    truncated?"truncated to the last sync":"truncate failed");
+            }
+            else
+                end+=batch.size();
+            batch.clear();
+
+            lock.lock();
+            if(error)
+            {
+                failed=true;
+                pending.clear();
+            }
+            else
+            {
+                durable=target;
+                commits++;
+            }
+            done_cv.notify_all();
+        }
+    }
+
+    int fd;
+    std::atomic<bool> failed;           // 写入或同步失败后停止记录（在m内设置，反应堆线程不加锁读取）
+    off_t end;                          // 上一次同步成功后的文件长度（只由提交线程使用）
+    std::thread writer;
+    std::mutex m;
+    std::condition_variable cv;         // 有新的批次或要求停止
+    std::condition_variable done_cv;    // 同步完成
+    std::string pending;                // 已提交、尚未写入的记录（m保护）
+    bool stopping;
+    uint64_t submitted;                 // 已提交的字节数（m保护）
+    uint64_t durable;                   // 已同步的字节数（m保护）
+    uint64_t commits;                   // 同步次数（m保护）
+};
+
+#endif // GAME_JOURNAL_H
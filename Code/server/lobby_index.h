@@ -0,0 +1,79 @@
+/**
+ * @file lobby_index.h
+ * @brief 按房间名排序的空闲房间索引（支持前缀过滤和分页）
+ *
+ * 底层是带子树大小的红黑树（GNU pb_ds顺序统计树），键为(房间名, 房间ID)：
+ * - 插入、删除O(log n)
+ * - 前缀匹配的房间在树中是连续的一段，用两次order_of_key求出这一段的起止名次，O(log n)
+ * - 按名次定位第offset个匹配的房间O(log n)，之后顺序取limit个
+ *
+ * 因此一次分页查询的开销是O(log n + limit)，与房间总数无关
+ */
+
+#ifndef LOBBY_INDEX_H
+#define LOBBY_INDEX_H
+
+#include<stdint.h>
+#include<string>
+#include<vector>
+#include<utility>
+#include<ext/pb_ds/assoc_container.hpp>
+#include<ext/pb_ds/tree_policy.hpp>
+
+class name_index
+{
+public:
+    typedef std::pair<std::string,uint64_t> key_type;   // (房间名, 房间ID)
+
+    void insert(const std::string &name,uint64_t id) { tree.insert(key_type(name,id)); }
+    void erase(const std::string &name,uint64_t id) { tree.erase(key_type(name,id)); }
+    size_t size() const { return tree.size(); }
+
+    /**
+     * @brief 分页查询房间名以prefix开头的房间
+     * @param prefix 房间名前缀（空串匹配所有房间）
+     * @param offset 跳过前offset个匹配的房间
+     * @param limit 最多返回的房间个数
+     * @param out 输出：按房间名排序的房间ID
+     * @return size_t 匹配的房间总数
+     */
+    size_t page(const std::string &prefix,size_t offset,size_t limit,std::vector<uint64_t> &out) const
+    {
+        size_t first=tree.order_of_key(key_type(prefix,0));
+        size_t last=tree.size();
+        std::string next;
+        if(successor(prefix,next))
+            last=tree.order_of_key(key_type(next,0));
+
+        size_t total=last-first;
+        if(offset>=total)
+            return total;
+        tree_type::const_iterator it=tree.find_by_order(first+offset);
+        for(size_t i=first+offset;i<last&&out.size()<limit;i++,++it)
+            out.push_back(it->second);
+        return total;
+    }
+
+private:
+    typedef __gnu_pbds::tree<key_type,__gnu_pbds::null_type,std::less<key_type>,
+        __gnu_pbds::rb_tree_tag,__gnu_pbds::tree_order_statistics_node_update> tree_type;
+
+    /**
+     * @brief 求比所有以prefix开头的字符串都大的最小字符串（去掉末尾的0xff后最后一个字节加一）
+     * @return bool prefix为空或全是0xff时没有上界，返回false
+     */
+    static bool successor(const std::string &prefix,std::string &next)
+    {
+        next=prefix;
+        while(!next.empty()&&(unsigned char)next[next.size()-1]==0xff)
+            next.erase(next.size()-1);
+        if(next.empty())
+            return false;
+        next[next.size()-1]=(char)((unsigned char)next[next.size()-1]+1);
+        return true;
+    }
+
+    tree_type tree;
+};
+
+#endif // LOBBY_INDEX_H
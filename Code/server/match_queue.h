@@ -0,0 +1,264 @@
+/**
+ * @file match_queue.h
+ * @brief 快速匹配队列：按等级分分桶，等待越久可以接受的分差越大
+ *
+ * - 等级分按match_bucket_width分桶，非空的桶放在有序表中，桶内按排队先后排列（链表，出队O(1)）
+ * - 查找对手：在有序表中二分找到自己所在的桶，取两侧最近的非空桶中最早排队的玩家，
+ *   选分差小的一个（相同时选等得久的），O(log n)；同一个桶内不再细分，只按先来后到
+ * - 可接受的分差（窗口）从window开始，每排队widen_ms毫秒放宽widen，放宽到match_window_limit为止
+ * - 配对只看发起查找一方的窗口：新加入的玩家用初始窗口找对手，排队的玩家每次放宽时重新找一次，
+ *   放宽时刻放在小根堆中，推进时间时只处理到期的玩家
+ *
+ * 玩家用调用方给出的64位标识区分（服务器中为fd），同一标识同时只能排队一次
+ */
+
+#ifndef MATCH_QUEUE_H
+#define MATCH_QUEUE_H
+
+#include<stdint.h>
+#include<math.h>
+#include<map>
+#include<list>
+#include<queue>
+#include<vector>
+#include<functional>
+#include<unordered_map>
+
+const int match_rating_initial=1500;    // 新玩家的等级分
+const int match_bucket_width=25;        // 每个桶的分数范围
+const int match_window_limit=4000;      // 窗口放宽到这个分差后不再放宽（已覆盖所有等级分）
+const int elo_k=32;                     // 一局棋等级分变化的上限
+
+/**
+ * @brief 按一局棋的结果更新双方的等级分（Elo）
+ * @param a 一方的等级分
+ * @param b 另一方的等级分
+ * @param score a的得分：1胜 0.5和 0负
+ */
+inline void elo_update(int &a,int &b,double score)
+{
+    double expect=1.0/(1.0+pow(10.0,(b-a)/400.0));
+    int delta=(int)lround(elo_k*(score-expect));
+    a+=delta;
+    b-=delta;
+}
+
+/**
+ * @brief 一次配对：等得久的一方做房主
+ */
+struct match_pair
+{
+    uint64_t host;
+    uint64_t guest;
+    int host_rating;
+    int guest_rating;
+};
+
+class match_queue
+{
+public:
+    explicit match_queue(int window=100,int widen=50,long long widen_ms=5000)
+    {
+        configure(window,widen,widen_ms);
+    }
+
+    /**
+     * @brief 设置初始窗口和放宽速度（只影响之后计算的窗口）
+     */
+    void configure(int window,int widen,long long widen_ms)
+    {
+        window0=window;
+        widen_step=widen;
+        widen_period=widen_ms>0?widen_ms:1;
+    }
+
+    size_t size() const { return players.size(); }
+    bool contains(uint64_t player) const { return players.count(player)!=0; }
+
+    /**
+     * @brief 排队waited毫秒之后可以接受的分差
+     */
+    int window(long long waited) const
+    {
+        long long w=window0+widen_step*(waited/widen_period);
+        return w<match_window_limit?(int)w:match_window_limit;
+    }
+
+    /**
+     * @brief 加入队列：先用初始窗口找对手，找到时直接配对（对手出队），否则排队
+     * @param player 玩家标识（已在队列中时什么也不做，返回false）
+     * @param rating 等级分
+     * @param now 当前时间（毫秒）
+     * @param out 配对成功时输出配对
+     * @return bool 配对成功返回true
+     */
+    bool push(uint64_t player,int rating,long long now,match_pair &out)
+    {
+        if(contains(player))
+            return false;
+        handle found;
+        if(find(player,rating,window(0),found))
+        {
+            const entry &e=*found.it;
+            out.host=e.player;
+            out.guest=player;
+            out.host_rating=e.rating;
+            out.guest_rating=rating;
+            erase(found);
+            return true;
+        }
+
+        entry e;
+        e.player=player;
+        e.rating=rating;
+        e.since=now;
+        e.next_due=now+widen_period;
+        bucket &b=buckets[key_of(rating)];
+        handle h;
+        h.key=key_of(rating);
+        h.it=b.insert(b.end(),e);
+        players[player]=h;
+        if(window(0)<match_window_limit)
+            due.push(due_type(e.next_due,player));
+        return false;
+    }
+
+    /**
+     * @brief 离开队列
+     * @return bool 不在队列中时返回false
+     */
+    bool remove(uint64_t player)
+    {
+        std::unordered_map<uint64_t,handle>::iterator it=players.find(player);
+        if(it==players.end())
+            return false;
+        erase(it->second);
+        return true;
+    }
+
+    /**
+     * @brief 推进到now：窗口到期放宽的玩家重新找一次对手
+     * @param out 追加本次产生的配对
+     */
+    void advance(long long now,std::vector<match_pair> &out)
+    {
+        while(!due.empty()&&due.top().first<=now)
+        {
+            due_type d=due.top();
+            due.pop();
+            std::unordered_map<uint64_t,handle>::iterator it=players.find(d.second);
+            if(it==players.end()||it->second.it->next_due!=d.first)
+                continue;   // 已出队，或出队后重新排队（以新的放宽时刻为准）
+
+            handle self=it->second;
+            entry &e=*self.it;
+            long long waited=now-e.since;
+            int w=window(waited);
+            handle found;
+            if(find(e.player,e.rating,w,found))
+            {
+                const entry &f=*found.it;
+                match_pair p;
+                bool older=f.since<e.since||(f.since==e.since&&f.player<e.player);
+                p.host=older?f.player:e.player;
+                p.guest=older?e.player:f.player;
+                p.host_rating=older?f.rating:e.rating;
+                p.guest_rating=older?e.rating:f.rating;
+                out.push_back(p);
+                erase(found);
+                erase(self);
+                continue;
+            }
+            if(w<match_window_limit)
+            {
+                e.next_due=e.since+(waited/widen_period+1)*widen_period;
+                due.push(due_type(e.next_due,e.player));
+            }
+        }
+    }
+
+private:
+    struct entry
+    {
+        uint64_t player;
+        int rating;
+        long long since;        // 开始排队的时间
+        long long next_due;     // 下一次放宽窗口的时间
+    };
+    typedef std::list<entry> bucket;
+    struct handle
+    {
+        int key;                // 所在的桶
+        bucket::iterator it;
+    };
+    typedef std::pair<long long,uint64_t> due_type;     // (放宽时刻, 玩家)
+
+    static int key_of(int rating)
+    {
+        return rating>=0?rating/match_bucket_width:-((-rating+match_bucket_width-1)/match_bucket_width);
+    }
+
+    /**
+     * @brief 找self以外与rating分差不超过window、最接近的玩家
+     */
+    bool find(uint64_t self,int rating,int window,handle &found)
+    {
+        bool ok=false;
+        int best=0;
+        long long best_since=0;
+        int key=key_of(rating);
+
+        // 不小于自己的桶：自己只可能在第一个桶中，跳过
+        for(std::map<int,bucket>::iterator hi=buckets.lower_bound(key);hi!=buckets.end();++hi)
+        {
+            bucket::iterator it=hi->second.begin();
+            if(it->player==self)
+                ++it;
+            if(it==hi->second.end())
+                continue;
+            consider(hi->first,it,rating,window,ok,best,best_since,found);
+            break;
+        }
+
+        // 小于自己的桶：最近的一个
+        std::map<int,bucket>::iterator lo=buckets.lower_bound(key);
+        if(lo!=buckets.begin())
+        {
+            --lo;
+            consider(lo->first,lo->second.begin(),rating,window,ok,best,best_since,found);
+        }
+        return ok;
+    }
+
+    static void consider(int key,bucket::iterator it,int rating,int window,bool &ok,int &best,long long &best_since,handle &found)
+    {
+        int diff=it->rating>rating?it->rating-rating:rating-it->rating;
+        if(diff>window)
+            return;
+        if(ok&&(diff>best||(diff==best&&it->since>=best_since)))
+            return;
+        ok=true;
+        best=diff;
+        best_since=it->since;
+        found.key=key;
+        found.it=it;
+    }
+
+    void erase(const handle &h)
+    {
+        std::map<int,bucket>::iterator b=buckets.find(h.key);
+        players.erase(h.it->player);
+        b->second.erase(h.it);
+        if(b->second.empty())
+            buckets.erase(b);
+    }
+
+    int window0;
+    int widen_step;
+    long long widen_period;
+    std::map<int,bucket> buckets;                       // 非空的桶，按分数排列
+    std::unordered_map<uint64_t,handle> players;        // 玩家 -> 所在的位置
+    std::priority_queue<due_type,std::vector<due_type>,std::greater<due_type> > due;   // 放宽时刻（出队的玩家留到到期时丢弃）
+};
+
+#endif // MATCH_QUEUE_H
@@ -0,0 +1,230 @@
+/**
+ * @file metrics.h
+ * @brief 运行指标：计数器、延迟直方图和Prometheus文本格式输出
+ *
+ * - 每个反应堆线程各自持有一份指标，只由本线程写入：计数器用relaxed的读加写（不带lock前缀），
+ *   热路径上的开销与普通的加法相同；读取方（指标线程）逐线程读出后相加，不需要加锁
+ * - 延迟直方图按HDR直方图的方式分桶：32纳秒以下每纳秒一个桶，以上每个2的幂区间分16个桶，
+ *   相对误差不超过1/16；记录一次只是一次前导零计数和一个桶加一
+ * - 输出为Prometheus文本格式（0.0.4），时间单位为秒；直方图的le边界取2的幂纳秒，与桶的边界对齐，
+ *   另外输出几个分位数
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include<stdint.h>
+#include<stdio.h>
+#include<time.h>
+#include<atomic>
+#include<string>
+
+/**
+ * @brief 单调时钟的当前纳秒数
+ */
+inline uint64_t metrics_now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return (uint64_t)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+/**
+ * @brief 单写者计数器（只由所属线程增加，任意线程读取）
+ */
+class metric_counter
+{
+public:
+    metric_counter():v(0){}
+
+    void add(uint64_t n=1) { v.store(v.load(std::memory_order_relaxed)+n,std::memory_order_relaxed); }
+    uint64_t value() const { return v.load(std::memory_order_relaxed); }
+
+private:
+    metric_counter(const metric_counter&);
+    metric_counter& operator=(const metric_counter&);
+
+    std::atomic<uint64_t> v;
+};
+
+const int histogram_exact=32;       // 小于这个值（纳秒）的每个值一个桶
+const int histogram_sub_bits=4;     // 每个2的幂区间分2^4=16个桶
+const int histogram_max_exp=47;     // 超过2^48纳秒（约78小时）的值都记在最后一个桶
+const int histogram_buckets=histogram_exact+(histogram_max_exp-4)*(1<<histogram_sub_bits);
+
+/**
+ * @brief 值所在的桶
+ */
+inline int histogram_index(uint64_t v)
+{
+    if(v<(uint64_t)histogram_exact)
+        return (int)v;
+    int e=63-__builtin_clzll(v);
+    if(e>histogram_max_exp)
+        return histogram_buckets-1;
+    return histogram_exact+(e-5)*(1<<histogram_sub_bits)+(int)((v>>(e-histogram_sub_bits))&((1<<histogram_sub_bits)-1));
+}
+
+/**
+ * @brief 桶的上界（不含）
+ */
+inline uint64_t histogram_upper(int i)
+{
+    if(i<histogram_exact)
+        return i+1;
+    int e=5+(i-histogram_exact)/(1<<histogram_sub_bits);
+    uint64_t s=(i-histogram_exact)%(1<<histogram_sub_bits);
+    return ((1<<histogram_sub_bits)+s+1)<<(e-histogram_sub_bits);
+}
+
+/**
+ * @brief 单写者延迟直方图（纳秒）
+ */
+class latency_histogram
+{
+public:
+    latency_histogram():sum(0)
+    {
+        for(int i=0;i<histogram_buckets;i++)
+            counts[i].store(0,std::memory_order_relaxed);
+    }
+
+    void record(uint64_t ns)
+    {
+        std::atomic<uint64_t> &c=counts[histogram_index(ns)];
+        c.store(c.load(std::memory_order_relaxed)+1,std::memory_order_relaxed);
+        sum.store(sum.load(std::memory_order_relaxed)+ns,std::memory_order_relaxed);
+    }
+
+private:
+    latency_histogram(const latency_histogram&);
+    latency_histogram& operator=(const latency_histogram&);
+    friend class histogram_snapshot;
+
+    std::atomic<uint64_t> counts[histogram_buckets];
+    std::atomic<uint64_t> sum;      // 所有记录值的和（纳秒）
+};
+
+/**
+ * @brief 若干个直方图合并后的读数
+ *
+ * 读取时写入方仍在记录，各桶之间不是同一时刻的值，但每个桶单调不减，相邻两次读取的差值有意义
+ */
+class histogram_snapshot
+{
+public:
+    histogram_snapshot():total(0),sum_ns(0)
+    {
+        for(int i=0;i<histogram_buckets;i++)
+            counts[i]=0;
+    }
+
+    void merge(const latency_histogram &h)
+    {
+        for(int i=0;i<histogram_buckets;i++)
+        {
+            uint64_t n=h.counts[i].load(std::memory_order_relaxed);
+            counts[i]+=n;
+            total+=n;
+        }
+        sum_ns+=h.sum.load(std::memory_order_relaxed);
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t sum() const { return sum_ns; }
+
+    /**
+     * @brief 小于limit纳秒的记录数（limit取桶的边界时是精确值）
+     */
+    uint64_t count_below(uint64_t limit) const
+    {
+        uint64_t n=0;
+        for(int i=0;i<histogram_buckets&&histogram_upper(i)<=limit;i++)
+            n+=counts[i];
+        return n;
+    }
+
+    /**
+     * @brief 分位数（纳秒，取所在桶的上界，没有记录时为0）
+     * @param q 0到1之间
+     */
+    uint64_t quantile(double q) const
+    {
+        if(total==0)
+            return 0;
+        uint64_t rank=(uint64_t)(q*total);
+        if(rank>=total)
+            rank=total-1;
+        uint64_t n=0;
+        for(int i=0;i<histogram_buckets;i++)
+        {
+            n+=counts[i];
+            if(n>rank)
+                return histogram_upper(i);
+        }
+        return histogram_upper(histogram_buckets-1);
+    }
+
+private:
+    uint64_t counts[histogram_buckets];
+    uint64_t total;
+    uint64_t sum_ns;
+};
+
+/* ==================== Prometheus文本格式 ==================== */
+
+/**
+ * @brief 输出一个指标族的HELP和TYPE行
+ * @param type "counter"、"gauge"或"histogram"
+ */
+inline void metrics_family(std::string &out,const char* name,const char* type,const char* help)
+{
+    out.append("# HELP ").append(name).append(" ").append(help).append("\n");
+    out.append("# TYPE ").append(name).append(" ").append(type).append("\n");
+}
+
+/**
+ * @brief 输出一个样本
+ * @param labels 不含花括号的标签（如type="move"），NULL表示没有标签
+ */
+inline void metrics_sample(std::string &out,const char* name,const char* labels,double value)
+{
+    char num[32];
+    snprintf(num,sizeof(num),"%.15g",value);
+    out.append(name);
+    if(labels)
+        out.append("{").append(labels).append("}");
+    out.append(" ").append(num).append("\n");
+}
+
+/**
+ * @brief 输出一个直方图（秒），以及名为{name}_quantile的分位数gauge
+ *
+ * le从2^10纳秒（约1微秒）到2^33纳秒（约8.6秒），每个2的幂一个边界
+ */
+inline void metrics_histogram(std::string &out,const char* name,const char* help,const histogram_snapshot &h)
+{
+    std::string bucket=std::string(name)+"_bucket";
+    metrics_family(out,name,"histogram",help);
+    for(int k=10;k<=33;k++)
+    {
+        char le[40];
+        snprintf(le,sizeof(le),"le=\"%.9g\"",(double)(1ULL<<k)/1e9);
+        metrics_sample(out,bucket.c_str(),le,(double)h.count_below(1ULL<<k));
+    }
+    metrics_sample(out,bucket.c_str(),"le=\"+Inf\"",(double)h.count());
+    metrics_sample(out,(std::string(name)+"_sum").c_str(),NULL,h.sum()/1e9);
+    metrics_sample(out,(std::string(name)+"_count").c_str(),NULL,(double)h.count());
+
+    static const char* quantiles[]={"0.5","0.9","0.99","0.999"};
+    static const double values[]={0.5,0.9,0.99,0.999};
+    std::string qname=std::string(name)+"_quantile";
+    metrics_family(out,qname.c_str(),"gauge",help);
+    for(int i=0;i<4;i++)
+    {
+        std::string label=std::string("quantile=\"")+quantiles[i]+"\"";
+        metrics_sample(out,qname.c_str(),label.c_str(),h.quantile(values[i])/1e9);
+    }
+}
+
+#endif // METRICS_H
@@ -0,0 +1,136 @@
+/**
+ * @file room_table.h
+ * @brief 带代数（generation）的房间槽位表
+ *
+ * 房间ID是64位整数，由三部分组成：
+ *
+ *     | 代数(32位) | 反应堆编号(8位) | 槽位下标(24位) |
+ *
+ * - 槽位下标：O(1)定位房间，房间关闭后槽位进入空闲链表复用，其他房间的ID不受影响
+ * - 代数：槽位每次被释放时加一，旧ID与复用后的新ID不同，过期的加入请求不会落到新房间里
+ * - 反应堆编号：房间所在的线程，加入请求无需查表即可路由
+ *
+ * 代数从1开始（跳过0），因此合法的房间ID永远不为0，0可以表示“不在任何房间”
+ */
+
+#ifndef ROOM_TABLE_H
+#define ROOM_TABLE_H
+
+#include<stdint.h>
+#include<stddef.h>
+#include<vector>
+
+typedef uint64_t room_id_t;
+
+const int room_slot_bits=24;    // 槽位下标位数（每个线程最多约1677万个房间）
+const int room_tag_bits=8;      // 反应堆编号位数（最多256个线程）
+
+/**
+ * @brief 从房间ID中取出反应堆编号
+ */
+inline int room_tag(room_id_t id)
+{
+    return (int)((id>>room_slot_bits)&((1u<<room_tag_bits)-1));
+}
+
+template<class T>
+class slot_map
+{
+public:
+    slot_map():tag(0),count(0){}
+
+    /**
+     * @brief 设置写入ID中的反应堆编号
+     * @param t 反应堆编号（0~255）
+     */
+    void set_tag(int t) { tag=(uint32_t)t&((1u<<room_tag_bits)-1); }
+
+    /**
+     * @brief 插入一个对象
+     * @param value 对象
+     * @return room_id_t 新对象的ID（槽位已满时返回0）
+     */
+    room_id_t insert(const T& value)
+    {
+        uint32_t index;
+        if(!free_slots.empty())
+        {
+            index=free_slots.back();
+            free_slots.pop_back();
+        }
+        else
+        {
+            if(slots.size()>=(1u<<room_slot_bits))
+                return 0;
+            index=(uint32_t)slots.size();
+            slots.push_back(slot());
+        }
+        slot &s=slots[index];
+        s.used=true;
+        s.value=value;
+        count++;
+        return make_id(s.gen,index);
+    }
+
+    /**
+     * @brief 按ID查找对象
+     * @param id 房间ID
+     * @return T* ID无效、已删除或属于其他线程时返回NULL
+     */
+    T* find(room_id_t id)
+    {
+        if(room_tag(id)!=(int)tag)
+            return NULL;
+        uint32_t index=(uint32_t)(id&((1u<<room_slot_bits)-1));
+        if(index>=slots.size())
+            return NULL;
+        slot &s=slots[index];
+        if(!s.used||s.gen!=(uint32_t)(id>>32))
+            return NULL;
+        return &s.value;
+    }
+
+    /**
+     * @brief 删除对象，槽位代数加一后归还空闲链表
+     * @param id 房间ID
+     */
+    void erase(room_id_t id)
+    {
+        if(!find(id))
+            return;
+        uint32_t index=(uint32_t)(id&((1u<<room_slot_bits)-1));
+        slot &s=slots[index];
+        s.used=false;
+        s.value=T();
+        if(++s.gen==0)      // 回绕时跳过0
+            s.gen=1;
+        free_slots.push_back(index);
+        count--;
+    }
+
+    /**
+     * @brief 表中的对象个数
+     */
+    size_t size() const { return count; }
+
+private:
+    struct slot
+    {
+        uint32_t gen;       // 代数
+        bool used;          // 槽位是否被占用
+        T value;
+        slot():gen(1),used(false){}
+    };
+
+    room_id_t make_id(uint32_t gen,uint32_t index) const
+    {
+        return ((room_id_t)gen<<32)|((room_id_t)tag<<room_slot_bits)|index;
+    }
+
+    uint32_t tag;                       // 反应堆编号
+    size_t count;                       // 占用的槽位数
+    std::vector<slot> slots;            // 槽位数组
+    std::vector<uint32_t> free_slots;   // 空闲槽位下标
+};
+
+#endif // ROOM_TABLE_H
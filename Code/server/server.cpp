@@ -7,11 +7,25 @@
  * - 客户端连接管理（连接、断开、状态维护）
  * - 房间系统（创建、加入、退出、列表刷新）
  * - 游戏消息转发（落子、聊天、悔棋、认输等）
+ * - 权威棋盘：每个房间在服务器上保存棋盘，校验回合与落点、判定五连并下发结果，客户端只负责显示
  * - 准备状态和先后手选择的同步
+ * - 消息分帧：每条消息以'\n'结尾，每个连接拥有独立的输入缓冲区
+ * - 多反应堆：N个事件循环线程各自监听同一端口（SO_REUSEPORT），各自持有一份连接和房间分片
+ * - 两种事件循环后端：epoll（默认）和io_uring（--backend uring，多次接收+缓冲区环，发送批量提交）
+ * - 协议协商：客户端发送"V2"后该连接改用长度前缀的二进制帧（见core/protocol.h），旧客户端保持文本协议
+ * - 定时器：分层时间轮（timerfd驱动）负责心跳、大厅空闲连接清理和对局中断线判负
+ * - 对局日志：开局、先后手、落子、悔棋、认输、离开和结果追加到二进制日志，每轮事件处理的记录整批提交，组提交同步（见game_journal.h）
+ * - 对局归档查询：按时间、玩家IP、结果和局面分页查询由archive工具整理好的归档（见game_archive.h）
+ * - 观战：房间可以有任意多的观众，加入时先收到棋盘快照；每轮的对局事件合并成一块引用计数的共享缓冲区，
+ *   排入所有观众的输出队列而不逐个复制；跟不上的观众改为在输出队列回落后补发快照
+ * - 快速匹配：按等级分分桶的匹配队列，等得越久可以接受的分差越大，配对后直接建房（见match_queue.h）
+ * - 运行指标：每个线程各自计数（连接、房间、各类消息、收发字节、短写）并记录事件循环延迟和落子转发延迟的直方图，
+ *   --metrics指定的本地端口或Unix套接字上以Prometheus文本格式输出（见metrics.h）
  * 
  * 运行环境：Linux系统
- * 编译命令：g++ server.cpp -o server
- * 启动方式：./server [端口号]  (默认端口4396)
+ * 编译命令：make
+ * 启动方式：./server [端口号] [--threads N] [--backend epoll|uring] [--journal 文件|none] [--archive 目录] [--metrics 端口|路径]
+ *          (默认端口4396，默认1个线程，epoll，日志写入games.journal，不提供归档查询，不输出运行指标)
  */
 
 /* ==================== 头文件包含 ==================== */
@@ -29,6 +43,14 @@
 #include<sys/epoll.h>   // epoll多路复用（epoll_create, epoll_ctl, epoll_wait）
 #include<fcntl.h>       // 文件控制（open, O_RDONLY等）
 #include<error.h>       // 错误处理
+#include<errno.h>       // 错误码（EAGAIN, EINTR等）
+#include<time.h>        // 单调时钟（clock_gettime）
+#include<signal.h>      // 信号处理（忽略SIGPIPE）
+#include<sys/eventfd.h> // eventfd（跨线程唤醒事件循环）
+#include<sys/timerfd.h> // timerfd（驱动时间轮）
+#include<sys/uio.h>     // writev（共享数据段与私有输出一起写出）
+#include<sys/stat.h>    // 文件状态（归档整理后重新映射）
+#include<sys/un.h>      // Unix套接字地址（运行指标）
 
 // C++ STL头文件
 #include<iostream>      // 输入输出流
@@ -36,6 +58,24 @@
 #include<algorithm>     // 算法（remove等）
 #include<map>           // 关联容器（哈希映射）
 #include<queue>         // 队列（未使用）
+#include<thread>        // 反应堆线程
+#include<mutex>         // 互斥锁（大厅目录、迁移信箱）
+#include<atomic>        // 原子计数（在线人数）
+#include<memory>        // shared_ptr（大厅快照）
+#include<unordered_map> // 合并大厅事件
+#include<deque>         // io_uring请求状态（扩容时元素地址不变）
+
+#include "conn_table.h" // 以fd为下标的连接表
+#include "room_table.h" // 带代数的房间槽位表
+#include "lobby_index.h" // 按房间名排序的空闲房间索引
+#include "protocol.h"   // 二进制协议编解码（与客户端共用）
+#include "uring.h"      // io_uring封装（io_uring后端）
+#include "timer_wheel.h" // 分层时间轮（心跳与超时）
+#include "game_board.h" // 权威棋盘（落子校验与胜负判定）
+#include "game_journal.h" // 对局日志（组提交）
+#include "game_archive.h" // 对局归档（只读查询）
+#include "match_queue.h"  // 快速匹配队列
+#include "metrics.h"    // 运行指标（计数器、直方图、Prometheus格式）
 
 
 using namespace std;
@@ -47,40 +87,413 @@ using namespace std;
  */
 #define msg_size 1024
 
+/**
+ * @brief 时间轮一个刻度的毫秒数（timerfd的触发周期）
+ */
+const int timer_tick_ms=100;
+
 /* ==================== 函数前向声明 ==================== */
 
+struct connection;
+struct room_information;
+
 /**
  * @brief 处理客户端刷新房间列表请求
- * @param client_fd 发起请求的客户端套接字
+ * @param c 发起请求的客户端连接
  */
-void R_signal(int client_fd);//处理客户端刷新战局的请求
+void R_signal(connection* c);//处理客户端刷新战局的请求
 
 /**
  * @brief 处理客户端创建房间请求
  * @param msg 包含房间名的消息字符串
- * @param fd 发起请求的客户端套接字
+ * @param c 发起请求的客户端连接
  */
-void C_signal(char* msg,int fd);//处理客户端创建房间的请求
+void C_signal(char* msg,connection* c);//处理客户端创建房间的请求
 
 /**
  * @brief 处理客户端退出房间请求
- * @param client_fd 发起请求的客户端套接字
+ * @param c 发起请求的客户端连接
  */
-void E_signal(int client_fd);//处理客户端退出房间的请求
+void E_signal(connection* c);//处理客户端退出房间的请求
 
 /**
  * @brief 处理客户端加入房间请求
- * @param fd 发起请求的客户端套接字
+ * @param c 发起请求的客户端连接
  * @param msg 包含目标房间信息的消息字符串
  */
-void J_signal(int fd,char* msg);//处理客户端加入房间的请求
+void J_signal(connection* c,char* msg);//处理客户端加入房间的请求
 
 /**
  * @brief 处理客户端更新对手状态请求
- * @param fd 发起请求的客户端套接字
+ * @param c 发起请求的客户端连接
+ */
+void U_signal(connection* c);//处理客户端更新对手准备状态的请求
+
+/**
+ * @brief 处理客户端订阅/退订大厅推送请求
+ * @param c 发起请求的客户端连接
+ * @param msg 消息字符串（"S"订阅，"S0"退订）
+ */
+void S_signal(connection* c,char* msg);//处理客户端订阅大厅推送的请求
+
+/**
+ * @brief 处理客户端分页查询房间列表请求
+ * @param c 发起请求的客户端连接
+ * @param msg 消息字符串，格式为 "Q{偏移}/{条数}/{房间名前缀}"
+ */
+void Q_signal(connection* c,char* msg);//处理客户端分页查询房间的请求
+
+/**
+ * @brief 处理客户端查询对局归档的请求
+ * @param c 发起请求的客户端连接
+ * @param msg 消息字符串，格式为 "A{类型}{偏移}/{条数}/{参数}" 或 "AG{对局ID}"
+ */
+void A_signal(connection* c,char* msg);//处理客户端查询对局归档的请求
+
+/**
+ * @brief 处理客户端观战请求
+ * @param c 发起请求的客户端连接
+ * @param msg 消息字符串，格式为 "G{房间ID}"（观战）或 "G"（停止观战）
+ */
+void G_signal(connection* c,char* msg);//处理客户端观战的请求
+
+/**
+ * @brief 处理客户端快速匹配请求
+ * @param c 发起请求的客户端连接
+ * @param msg 消息字符串，格式为 "M"、"M{规则}"（排队）或 "M-"（取消）
+ */
+void M_signal(connection* c,char* msg);//处理客户端快速匹配的请求
+
+/**
+ * @brief 读取客户端数据直到EAGAIN，追加到该连接的输入缓冲区并分发完整帧
+ * @param c 客户端连接
+ * @return bool 连接已关闭或出错返回true
+ */
+bool read_client(connection* c);
+
+/**
+ * @brief 从连接的输入缓冲区中切分出所有完整帧并逐一处理
+ * @param c 客户端连接
+ * @return bool 协议错误（半帧超过最大长度）返回false
+ */
+bool dispatch_frames(connection* c);
+
+/**
+ * @brief 从v2连接的输入缓冲区中切分出所有完整的二进制帧并逐一处理
+ * @param c 客户端连接
+ * @return bool 协议错误（长度字段非法）返回false
+ * 
+ * 对手也是v2连接时对战消息原样转发；其余帧转换成文本消息后交给handle_msg
+ */
+bool dispatch_binary(connection* c);
+
+/**
+ * @brief 处理一条完整的客户端消息（一帧）
+ * @param c 发送消息的客户端连接
+ * @param msg 以'\0'结尾的消息字符串（不含帧分隔符）
+ */
+void handle_msg(connection* c,char* msg);
+
+/**
+ * @brief 向客户端发送一帧消息（文本连接自动追加帧分隔符'\n'，v2连接编码为二进制帧）
+ * @param c 目标客户端连接（NULL时忽略，如没有对手）
+ * @param msg 消息内容
+ * @param len 消息长度
+ */
+void send_msg(connection* c,const char* msg,size_t len);
+void send_msg(connection* c,const char* msg);
+
+/**
+ * @brief 向客户端发送已经分好帧的文本数据（每帧已带'\n'；文本连接原样追加，v2连接逐帧编码）
+ * @param c 目标客户端连接
+ * @param data 数据
+ * @param len 数据长度
+ */
+void send_frames(connection* c,const char* data,size_t len);
+
+/**
+ * @brief 向v2客户端发送已经编码好的二进制帧（原样追加到输出队列）
+ * @param c 目标客户端连接
+ * @param data 数据
+ * @param len 数据长度
+ */
+void send_binary(connection* c,const char* data,size_t len);
+
+/**
+ * @brief 把多个连接共用的数据排入输出队列（只增加引用计数，不复制）
+ * @param c 目标客户端连接
+ * @param data 已按该连接的协议版本编码好的数据，排入后不能再修改
+ */
+void send_shared(connection* c,const shared_ptr<const string> &data);
+
+/**
+ * @brief 输出队列追加数据之后的公共处理：登记本轮待刷新，检查高水位
+ * @param c 客户端连接
+ */
+void queue_output(connection* c);
+
+/**
+ * @brief 尽可能多地把输出队列写入套接字
+ * @param c 客户端连接
+ * 
+ * 写不完（EAGAIN）时注册EPOLLOUT，等可写时继续；全部写完后注销EPOLLOUT
+ */
+void flush_client(connection* c);
+
+/**
+ * @brief 用write尽可能多地写出输出队列（epoll后端）
+ * @param c 客户端连接
+ * @return bool 写入出错（已标记断开）返回false
+ */
+bool write_client(connection* c);
+
+/**
+ * @brief 一轮事件处理结束后，批量刷新本轮产生了输出的连接并关闭待断开的连接
+ */
+void flush_pending();
+
+/**
+ * @brief 标记连接在本轮结束时断开（重复标记只记录一次）
+ * @param c 客户端连接
+ */
+void mark_closing(connection* c);
+
+/**
+ * @brief 关闭客户端连接并清理其所有状态
+ * @param fd 客户端套接字
+ */
+void close_client(int fd);
+
+/**
+ * @brief 把连接从当前反应堆线程移交给目标线程（本轮结束时执行）
+ * @param fd 客户端套接字
+ */
+void hand_over(int fd);
+
+/**
+ * @brief 接管其他反应堆线程迁移过来的连接（eventfd可读时执行）
+ */
+void adopt_clients();
+
+/**
+ * @brief 开始接收客户端数据（epoll注册可读事件；io_uring提交多次接收请求）
+ * @param c 客户端连接
+ */
+void watch_client(connection* c);
+
+/**
+ * @brief epoll事件循环
+ * @param server_fd 监听套接字
+ * @param event_fd 唤醒本线程的eventfd
+ */
+void epoll_loop(int server_fd,int event_fd);
+
+/**
+ * @brief 记录连接的一次请求（心跳应答除外），按处理后的房间状态更新双方的应答计时
+ * @param c 客户端连接
+ */
+void touch_client(connection* c);
+
+/**
+ * @brief 对局中是否轮到该玩家应答：选择先后手、应答对手的悔棋请求，或轮到自己落子
+ * @param room 玩家所在的房间
+ * @param c 玩家的连接
+ */
+bool on_turn(room_information* room,connection* c);
+
+/**
+ * @brief 为连接设置下一次检查的时间
+ * @param c 客户端连接
+ * @param tick 检查时刻（时间轮刻度）
+ */
+void schedule_check(connection* c,uint64_t tick);
+
+/**
+ * @brief 时间轮推进到当前时刻，处理到期的连接检查（timerfd可读时执行）
+ */
+void run_timers();
+
+/**
+ * @brief 检查连接的心跳与超时：发送心跳、清理空闲连接、判定对局中断线的一方
+ * @param c 客户端连接
+ */
+void check_client(connection* c);
+
+/**
+ * @brief 判定对局中的一方已离开：替它通知对手（与客户端主动退出发送的OR相同），然后断开
+ * @param c 离开的一方
+ * @param reason 日志中的原因
+ */
+void abandon_client(connection* c,const char* reason);
+
+/**
+ * @brief 对战消息的权威校验：检查并更新房间的对局状态
+ * @param c 发送者的连接
+ * @param op 消息类型（proto_op中的对战消息）
+ * @param arg 落子的格子下标或悔棋应答（1同意 0拒绝），负载非法时为-1
+ * @param outcome 输出：这条消息结束了对局时为对局结果（1黑胜 0白胜 2和棋），否则为-1
+ * @return bool 消息合法、应当转发给对手时返回true
+ */
+bool game_check(connection* c,int op,int arg,int &outcome);
+
+/**
+ * @brief 向房间双方下发对局结果（W消息），在结束对局的那步落子转发之后调用
+ */
+void game_over(connection* c,int outcome);
+
+/**
+ * @brief 记录一条对局日志（追加到本线程的批次，本轮事件处理结束时提交）
+ * @param room 房间ID
+ * @param kind 记录类型（journal_kind）
+ * @param value 格子下标、悔棋步数、颜色、结果等（见game_journal.h）
+ */
+void journal_event(room_id_t room,int kind,uint32_t value);
+
+/**
+ * @brief 记录开局：时间、规则和双方的地址
+ * @param id 房间ID
+ * @param room 房间
+ */
+void journal_start(room_id_t id,room_information* room);
+
+/**
+ * @brief 为本线程创建io_uring实例和接收缓冲区环
+ * @return bool 内核不支持时返回false（回退到epoll）
+ */
+bool uring_setup();
+
+/**
+ * @brief io_uring事件循环
+ * @param server_fd 监听套接字
+ * @param event_fd 唤醒本线程的eventfd
+ */
+void uring_loop(int server_fd,int event_fd);
+
+/**
+ * @brief 处理暂停期间缓存的数据，并在需要时重新提交多次接收请求（io_uring后端的read_client）
+ * @param c 客户端连接
+ * @return bool 协议错误返回true
+ */
+bool uring_read(connection* c);
+
+/**
+ * @brief 没有发送请求在途时，把输出队列整体提交为一个发送请求（io_uring后端）
+ * @param c 客户端连接
+ * @return bool 始终返回true（发送错误在完成事件中处理）
+ */
+bool uring_send(connection* c);
+
+/**
+ * @brief 连接离开本线程的io_uring：取消多次接收请求
+ * @param c 客户端连接
+ * @param closing 即将关闭套接字（不必等在途的请求结束）
+ * @return bool 连接已离开（之后的完成事件按旧连接丢弃）；移交时还有请求在途返回false
+ */
+bool uring_release(connection* c,bool closing);
+
+/**
+ * @brief 把本轮合并后的大厅事件推送给本线程的订阅者
+ */
+void lobby_deliver();
+
+/**
+ * @brief 把一批大厅推送帧发给本线程的所有订阅者（v2订阅者的二进制帧只编码一次）
+ * @param batch 文本帧
+ */
+void lobby_broadcast(const string &batch);
+
+/**
+ * @brief 本轮产生了大厅变化时，唤醒其他有订阅者的线程推送
+ */
+void lobby_wake();
+
+/**
+ * @brief 退订大厅推送
+ * @param c 客户端连接
+ */
+void lobby_unsubscribe(connection* c);
+
+/**
+ * @brief 对局状态变化：记入对局日志，并广播给房间的观众
+ * @param id 房间ID
+ * @param kind 记录类型（journal_kind）
+ * @param value 格子下标、悔棋步数、颜色、结果等（见game_journal.h）
+ */
+void game_event(room_id_t id,int kind,uint32_t value);
+
+/**
+ * @brief 把本轮各房间合并后的观战事件推送给观众（每轮结束时执行）
+ */
+void watch_deliver();
+
+/**
+ * @brief 停止观战（未观战时什么也不做）
+ * @param c 客户端连接
+ */
+void watch_leave(connection* c);
+
+/**
+ * @brief 积压的观众输出队列回落之后：补发当前棋盘的快照，恢复逐条推送
+ * @param c 观众的连接
+ */
+void watch_resync(connection* c);
+
+/**
+ * @brief 把一个对局事件追加到房间本轮待推送的观战事件中（房间没有观众时什么也不做）
+ * @param id 房间ID
+ * @param kind 记录类型（journal_kind），开局和选定先后手时推送整个棋盘的快照
+ * @param value 同game_event
+ */
+void watch_event(room_id_t id,int kind,uint32_t value);
+
+/**
+ * @brief 离开快速匹配队列（不在队列中时什么也不做）
+ * @param c 客户端连接
+ */
+void match_leave(connection* c);
+
+/**
+ * @brief 匹配队列推进到当前时刻：窗口放宽的玩家重新找对手，配对的直接建房（匹配线程每个刻度执行）
+ */
+void match_advance();
+
+/**
+ * @brief 对局结束时按结果更新双方的等级分
+ * @param room 房间
+ * @param winner 胜方（1黑 0白 2和棋）
+ */
+void rate_game(room_information* room,int winner);
+
+/**
+ * @brief 统计一条收到的消息（按类型计数）
+ * @param msg 文本消息
  */
-void U_signal(int fd);//处理客户端更新对手准备状态的请求
+void count_msg(const char* msg);
 
+/**
+ * @brief 给对手排入了一步转发的落子：记下读到它的时刻（已有未写出的落子时保留更早的）
+ * @param c 对手的连接
+ */
+void relay_mark(connection* c);
+
+/**
+ * @brief 输出队列已全部写出：记录其中最早一步落子从读到到写出的延迟
+ * @param c 客户端连接
+ */
+void relay_done(connection* c);
+
+/**
+ * @brief 打开运行指标的监听套接字
+ * @param where 端口号（监听127.0.0.1），或以'/'开头的Unix套接字路径
+ * @return int 监听套接字，失败返回-1
+ */
+int metrics_listen(const char* where);
+
+/**
+ * @brief 运行指标线程：每个连接回复一次当前的指标（HTTP/1.0，Prometheus文本格式）后关闭
+ * @param listen_fd 监听套接字（阻塞）
+ */
+void metrics_serve(int listen_fd);
 
 /**
  * @brief 初始化服务器套接字和地址结构
@@ -106,22 +519,127 @@ void initialization_server(struct sockaddr_in& server_addr,int &server_fd,int ar
     // 设置地址族为IPv4
     server_addr.sin_family=AF_INET;
     
-    // 根据命令行参数设置端口号
-    switch(argc)
+    // 根据命令行参数设置端口号（第一个参数不是"--"开头的选项时视为端口号）
+    if(argc>=2&&argv[1][0]!='-')     // 用户指定了端口号
     {
-        case 2:     // 用户指定了端口号
-        {
-            // 将字符串端口转换为整数，再转换为网络字节序
-            server_addr.sin_port=htons(atoi(argv[1]));
-            // 绑定到所有可用网络接口
-            server_addr.sin_addr.s_addr=INADDR_ANY;
-        }break;
-        default:    // 使用默认端口4396
-        {
-            server_addr.sin_port=htons(4396);
-            server_addr.sin_addr.s_addr=INADDR_ANY;
-        }
+        // 将字符串端口转换为整数，再转换为网络字节序
+        server_addr.sin_port=htons(atoi(argv[1]));
+        // 绑定到所有可用网络接口
+        server_addr.sin_addr.s_addr=INADDR_ANY;
+    }
+    else                            // 使用默认端口4396
+    {
+        server_addr.sin_port=htons(4396);
+        server_addr.sin_addr.s_addr=INADDR_ANY;
+    }
+}
+
+/**
+ * @brief 服务器运行参数
+ * 
+ * 可通过命令行覆盖：
+ * ./server [端口号] [--threads N] [--backend epoll|uring] [--out-high 字节] [--out-low 字节] [--out-limit 字节] [--out-grace 毫秒]
+ *          [--heartbeat 毫秒] [--idle-timeout 毫秒] [--abandon-timeout 毫秒] [--journal 文件|none] [--archive 目录]
+ *          [--watch-lag 字节] [--match-window 分差] [--match-widen 分差] [--metrics 端口|路径]
+ */
+struct server_options
+{
+    size_t out_high;        // 输出队列高水位：超过后暂停读取该客户端的请求
+    size_t out_low;         // 输出队列低水位：回落到此值以下后恢复读取
+    size_t out_limit;       // 输出队列硬上限：超过后立即断开
+    long long out_grace;    // 允许持续高于高水位的最长时间（毫秒），超时断开
+    int threads;            // 反应堆线程数
+    bool uring;             // 使用io_uring事件循环（内核不支持时回退到epoll）
+    long long heartbeat;    // 心跳间隔（毫秒）：v2连接静默这么久后发送心跳，连续3个间隔没有任何数据视为断线
+    long long idle_timeout; // 不在对局中的连接无操作多久后断开（毫秒）
+    long long abandon_timeout;  // 对局中无操作多久后判定离开（毫秒）
+    const char* journal;    // 对局日志文件（"none"表示不记录）
+    const char* archive;    // 对局归档目录（NULL表示不提供归档查询）
+    size_t watch_lag;       // 观众的输出队列超过此值后不再逐条推送，回落到低水位以下时补发快照
+    int match_window;       // 快速匹配刚排队时可以接受的等级分差
+    int match_widen;        // 每排队match_widen_ms毫秒，可以接受的分差放宽多少
+    const char* metrics;    // 运行指标的端口号（只监听127.0.0.1）或Unix套接字路径（NULL表示不输出）
+    
+    server_options():out_high(64*1024),out_low(16*1024),out_limit(1024*1024),out_grace(5000),threads(1),uring(false),
+        heartbeat(15000),idle_timeout(600000),abandon_timeout(300000),journal("games.journal"),archive(NULL),watch_lag(32*1024),
+        match_window(100),match_widen(50),metrics(NULL){}
+};
+
+server_options options;//服务器运行参数
+
+/**
+ * @brief 解析命令行中的"--"选项
+ * @param argc 命令行参数个数
+ * @param argv 命令行参数数组
+ */
+void parse_options(int argc,char *argv[])
+{
+    for(int i=1;i+1<argc;i++)
+    {
+        if(strcmp(argv[i],"--out-high")==0)
+            options.out_high=strtoul(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"--out-low")==0)
+            options.out_low=strtoul(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"--out-limit")==0)
+            options.out_limit=strtoul(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"--out-grace")==0)
+            options.out_grace=atoll(argv[++i]);
+        else if(strcmp(argv[i],"--threads")==0)
+            options.threads=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--backend")==0)
+            options.uring=strcmp(argv[++i],"uring")==0;
+        else if(strcmp(argv[i],"--heartbeat")==0)
+            options.heartbeat=atoll(argv[++i]);
+        else if(strcmp(argv[i],"--idle-timeout")==0)
+            options.idle_timeout=atoll(argv[++i]);
+        else if(strcmp(argv[i],"--abandon-timeout")==0)
+            options.abandon_timeout=atoll(argv[++i]);
+        else if(strcmp(argv[i],"--journal")==0)
+            options.journal=argv[++i];
+        else if(strcmp(argv[i],"--archive")==0)
+            options.archive=argv[++i];
+        else if(strcmp(argv[i],"--watch-lag")==0)
+            options.watch_lag=strtoul(argv[++i],NULL,10);
+        else if(strcmp(argv[i],"--match-window")==0)
+            options.match_window=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--match-widen")==0)
+            options.match_widen=atoi(argv[++i]);
+        else if(strcmp(argv[i],"--metrics")==0)
+            options.metrics=argv[++i];
     }
+    
+    if(options.threads<1)
+        options.threads=1;
+    if(options.threads>(1<<room_tag_bits))     // 房间ID中线程编号只有8位
+        options.threads=1<<room_tag_bits;
+    
+    // 保证 低水位 <= 高水位 <= 硬上限
+    if(options.out_low>options.out_high)
+        options.out_low=options.out_high;
+    if(options.out_limit<options.out_high)
+        options.out_limit=options.out_high;
+    
+    // 观众在暂停读取之前就降级为快照：低水位 <= 降级阈值 <= 高水位
+    options.watch_lag=min(max(options.watch_lag,options.out_low),options.out_high);
+    
+    options.match_window=max(options.match_window,0);
+    options.match_widen=max(options.match_widen,0);
+    
+    // 超时至少一个时间轮刻度
+    options.heartbeat=max(options.heartbeat,(long long)timer_tick_ms);
+    options.idle_timeout=max(options.idle_timeout,(long long)timer_tick_ms);
+    options.abandon_timeout=max(options.abandon_timeout,(long long)timer_tick_ms);
+}
+
+/**
+ * @brief 获取单调时钟的当前毫秒数
+ * @return long long 毫秒时间戳（不受系统时间调整影响）
+ */
+long long now_ms()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ts.tv_sec*1000LL+ts.tv_nsec/1000000;
 }
 
 /**
@@ -144,17 +662,17 @@ void Error_msg(string msg)
  */
 struct client_information
 {
-	int opponent_fd;    // 对手的套接字描述符（0表示没有对手）
+	connection* opponent;   // 对手的连接（NULL表示没有对手），转发落子时无需再查表
 	bool prepare;       // 准备状态（true:已准备, false:未准备）
     bool master;        // 是否为房间创建者（房主）
-    int room_num;       // 所在房间的索引号（-1表示不在任何房间）
+    room_id_t room_id;  // 所在房间的ID（0表示不在任何房间）
     
     /**
      * @brief 默认构造函数
      * 
      * 初始化为：无对手、未准备、非房主、不在房间
      */
-	client_information() :opponent_fd(0), prepare(0),room_num(-1),master(false){}
+	client_information() :opponent(NULL), prepare(0),room_id(0),master(false){}
 };
 
 /**
@@ -168,79 +686,368 @@ struct room_information
     string room_name;   // 房间名称（由创建者设定）
     int master_fd;      // 房间中主人（创建者）的套接字
     
+    int phase;          // 对局阶段（game_phase）
+    int black_fd;       // 执黑一方的套接字（选定先后手之后有效）
+    int back_fd;        // 发起悔棋、正在等待对手应答的一方（-1表示没有）
+    game_board board;   // 权威棋盘
+    
+    vector<connection*> watchers;   // 观众（连接的watch_pos为自己的下标，离开时与末尾元素交换）
+    string watch_batch;             // 本轮尚未推送给观众的事件（文本帧，本轮结束时整批推送）
+    
+    uint32_t player_ip[2];  // 选定先后手时双方的IP（下标为颜色：0白 1黑），对局结束时按它更新等级分
+    
     /**
      * @brief 带参数构造函数
      * @param name 房间名称
      * @param fd 房主的套接字
      */
-    room_information(string name,int fd):room_name(name),master_fd(fd),client_fd(-1){}
+    room_information(string name,int fd):room_name(name),master_fd(fd),client_fd(-1),phase(0),black_fd(-1),back_fd(-1){ player_ip[0]=player_ip[1]=0; }
+    room_information():master_fd(-1),client_fd(-1),phase(0),black_fd(-1),back_fd(-1){ player_ip[0]=player_ip[1]=0; }
 };
 
-/* ==================== 全局数据容器 ==================== */
+/**
+ * @brief 房间的对局阶段
+ */
+enum game_phase
+{
+    phase_idle=0,       // 未开始（等待双方准备）
+    phase_choose=1,     // 双方已准备，等待选择先后手
+    phase_play=2        // 对局中
+};
+
+/**
+ * @brief 输出队列中多个连接共用的一段数据
+ * 
+ * 观战事件每轮只编码一次，同一块缓冲区按引用计数排入每个观众的输出队列，
+ * 最后一个观众写完后释放
+ */
+struct shared_output
+{
+    shared_ptr<const string> data;
+    size_t off;         // 已写出的字节数
+};
 
 /**
- * @brief 客户端信息映射表
+ * @brief 连接收发缓冲结构体
  * 
- * 键: 客户端套接字描述符
- * 值: 该客户端的游戏状态信息
- * 用于快速查询任意客户端的状态
+ * TCP是字节流，一次read可能只读到半条消息，也可能读到多条粘在一起的消息，
+ * 因此每个连接需要独立的输入缓冲区保存尚未组成完整帧的字节。
+ * 帧格式：消息内容 + '\n'（v2连接为 长度 + 操作码 + 负载，见core/protocol.h）
+ * 
+ * 输出方向同理：非阻塞套接字的write可能只写出一部分甚至返回EAGAIN，
+ * 未写出的数据保存在输出队列中，等EPOLLOUT可写事件到来时继续发送。
  */
-map<int,client_information>hash_client;//每一个套接字对应一个客户端信息
+struct client_buffer
+{
+    string in;          // 已读入但尚未组成完整帧的数据
+    bool framed;        // 是否收到过带'\n'分隔符的帧（旧版客户端不发送分隔符）
+    int version;        // 协议版本（1:文本帧，2:二进制帧，收到"V2"后切换）
+    
+    deque<shared_output> shared;    // 共享数据段，整体排在out之前（send_shared排入时先把out中未写出的部分封成一段）
+    size_t shared_bytes;    // shared中尚未写出的字节数
+    string out;         // 输出队列（尚未写入套接字的数据）
+    size_t out_off;     // 输出队列中已写出部分的偏移
+    size_t in_flight;   // 已提交给io_uring但尚未发送完成的字节数（epoll后端始终为0）
+    bool dirty;         // 本轮事件处理中是否有新的输出（已加入待刷新列表）
+    bool want_out;      // 是否已注册EPOLLOUT
+    bool paused;        // 输出队列超过高水位，暂停读取该客户端的请求
+    bool closing;       // 已决定断开，等本轮事件处理结束后关闭
+    long long over_since;   // 输出队列开始超过高水位的时间（0表示未超过）
+    
+    int migrate_to;     // 即将迁移到的反应堆线程编号（-1表示不迁移）
+    string replay;      // 触发迁移的消息，由目标线程接管后重新处理
+    
+    uint64_t relay_since;   // 输出队列中最早一步转发的落子被读到的时刻（纳秒，0表示没有）
+    
+    client_buffer():framed(false),version(1),shared_bytes(0),out_off(0),in_flight(0),dirty(false),want_out(false),paused(false),closing(false),over_since(0),migrate_to(-1),relay_since(0){}
+    
+    /**
+     * @brief 输出队列中尚未写出的字节数（含正在发送的部分）
+     */
+    size_t pending() const { return shared_bytes+out.size()-out_off+in_flight; }
+};
 
 /**
- * @brief 客户端地址映射表
+ * @brief 连接结构体
  * 
- * 键: 客户端套接字描述符
- * 值: 该客户端的网络地址信息（IP、端口等）
- * 用于获取客户端的IP地址等信息
+ * 一个已连接客户端的全部状态，存放在以fd为下标的连接表中
  */
-map<int,struct sockaddr_in>client_addrs;//每一个套接字对应一个客户端的ip地址等信息
+struct connection
+{
+    int fd;                     // 客户端套接字
+    struct sockaddr_in addr;    // 客户端地址（IP、端口等）
+    client_information info;    // 游戏状态
+    client_buffer buf;          // 收发缓冲区（与游戏状态分开，E_signal重置游戏状态时不会丢失未处理的数据）
+    int sub_pos;                // 在本线程大厅订阅列表中的下标（-1表示未订阅）
+    timer_node timer;           // 心跳与超时检查的定时器（迁移时不随连接复制，由目标线程重新设置）
+    uint64_t last_rx;           // 最后一次收到数据的刻度（含心跳应答）
+    uint64_t last_active;       // 最后一次收到请求的刻度（不含心跳）
+    uint64_t turn_since;        // 对局中开始轮到自己应答（落子、应答悔棋或选择先后手）的刻度（0表示未轮到）
+    room_id_t watch_room;       // 正在观战的房间（0表示未观战；观众不占房间的座位，info.room_id为0）
+    int watch_pos;              // 在房间观众列表中的下标
+    bool watch_lag;             // 输出队列积压，暂停逐条推送，回落后补发快照
+    int match_rule;             // 正在快速匹配队列中排队的规则（-1表示未排队；只在匹配线程上排队）
+    
+    connection():fd(-1),sub_pos(-1),last_rx(0),last_active(0),turn_since(0),watch_room(0),watch_pos(-1),watch_lag(false),match_rule(-1){ memset(&addr,0,sizeof(addr)); }
+};
 
 /**
- * @brief 房间列表
+ * @brief 大厅事件（推送给订阅者的增量）
  * 
- * 存储所有已创建的房间
- * 索引即为房间号
+ * 帧格式：
+ * - L+{房间ID}/{房主IP}/{房间名}  房间变为空闲（新建、客人离开、房主易主）
+ * - Lf{房间ID}                    房间已满
+ * - L-{房间ID}                    房间关闭
  */
-vector<room_information>rooms;//房间
+struct lobby_event
+{
+    char kind;          // '+'、'f'、'-'
+    room_id_t id;       // 房间ID
+    string frame;       // 序列化后的帧（含'\n'）
+};
 
 /**
- * @brief 所有已连接客户端的套接字列表
+ * @brief 消息类型（运行指标的标签）
  * 
- * 用于统计在线人数和遍历客户端
+ * 前6种与协议中的转发操作码（op_move到op_surrender）顺序相同，二进制转发路径直接用操作码换算
  */
-vector<int>client_fds;//所有客户端套接字
+enum msg_kind
+{
+    mk_move,mk_chat,mk_back,mk_back_reply,mk_leave,mk_surrender,
+    mk_prepare,mk_color,mk_refresh,mk_create,mk_exit,mk_join,mk_update,mk_subscribe,mk_query,mk_archive,mk_watch,mk_match,
+    mk_heartbeat,mk_version,mk_other,
+    msg_kind_count
+};
+const char* const msg_kind_names[msg_kind_count]={
+    "move","chat","back","back_reply","leave","surrender",
+    "prepare","color","refresh","create","exit","join","update","subscribe","query","archive","watch","match",
+    "heartbeat","version","other"
+};
 
-/* ==================== 主函数 ==================== */
+/**
+ * @brief 一个反应堆线程的运行指标
+ * 
+ * 只由所属线程写入，指标线程读取各线程的值后相加；独占缓存行，不与其他线程写入的数据共享
+ */
+struct alignas(64) thread_metrics
+{
+    metric_counter accepted;        // 接入的连接
+    metric_counter closed;          // 关闭的连接（迁移走的不算）
+    metric_counter rooms_created;   // 创建的房间
+    metric_counter rooms_closed;    // 关闭的房间
+    metric_counter messages[msg_kind_count];    // 收到的各类消息
+    metric_counter bytes_in;        // 从套接字读到的字节
+    metric_counter bytes_out;       // 写入套接字的字节
+    metric_counter writes;          // 写套接字的次数（write/writev调用或提交的发送请求）
+    metric_counter short_writes;    // 没能写完的次数（epoll后端：写到EAGAIN时输出队列还有剩余；io_uring后端：只发出一部分，内核通常自行补发，很少出现）
+    latency_histogram loop_lag;     // 事件循环每轮从醒来到刷新完输出的时间
+    latency_histogram relay_latency;    // 落子从读到到写给对手的时间
+};
 
 /**
- * @brief 服务器主函数
- * @param argc 命令行参数个数
- * @param argv 命令行参数数组（argv[1]可指定端口号）
- * @return int 程序退出码
+ * @brief 反应堆（事件循环线程）的跨线程部分
  * 
- * 服务器工作流程：
- * 1. 初始化服务器套接字
- * 2. 设置套接字选项并绑定端口
- * 3. 开始监听连接
- * 4. 创建epoll实例并注册服务器套接字
- * 5. 进入事件循环，处理连接和消息
+ * 每个反应堆线程拥有独立的epoll实例、监听套接字和连接/房间分片（见下方thread_local变量），
+ * 只有迁移信箱需要加锁，投递后通过eventfd唤醒目标线程
+ * 
+ * 玩家加入另一个线程上的房间时，连接连同它的收发缓冲区整体移交给房间所在的线程，
+ * 保证同一房间的两名玩家总在同一个线程上，落子转发无需加锁
  */
-int main(int argc,char* argv[])
-{   
-    // 打开空设备文件，用于处理文件描述符耗尽的情况
-    // 这是一种优雅处理EMFILE错误的技巧
-    int idle_fd=open("/dev/null",O_RDONLY|O_CLOEXEC);
+struct reactor
+{
+    int event_fd;               // 唤醒该线程的eventfd
+    mutex mailbox_mutex;        // 保护mailbox
+    vector<connection> mailbox; // 其他线程迁移过来、尚未接管的连接（含未处理的输入和未写出的输出）
     
-    // 服务器和客户端套接字
-    int server_fd,client_fd;
+    vector<lobby_event> lobby_inbox;    // 待推送给本线程订阅者的大厅事件（由lobby_mutex保护）
+    atomic<bool> lobby_pending;         // lobby_inbox非空
+    atomic<int> subscribers;            // 本线程上订阅大厅推送的连接数
     
-    // 服务器和客户端地址结构
-    struct sockaddr_in server_addr,client_addr;
+    thread_metrics metrics;             // 本线程的运行指标
+    
+    reactor():event_fd(eventfd(0,EFD_NONBLOCK|EFD_CLOEXEC)),lobby_pending(false),subscribers(0){}
+};
 
-    socklen_t client_sz;    // 客户端地址结构大小
+/**
+ * @brief 大厅中的房间条目
+ * 
+ * 房间本身属于某个反应堆线程（线程编号编码在房间ID中），大厅目录只记录刷新列表所需的信息
+ */
+struct lobby_room
+{
+    string room_name;           // 房间名称
+    string master_ip;           // 房主IP（点分十进制，登记时转换一次）
+    bool full;                  // 房间是否已有客人
+};
+
+/* ==================== 全局数据容器 ==================== */
+
+/**
+ * @brief 所有反应堆线程
+ * 
+ * 下标即线程编号，启动后不再变化
+ */
+vector<reactor*>reactors;//反应堆线程
+
+/**
+ * @brief 大厅目录（所有线程的房间）
+ * 
+ * 键: 房间ID（即客户端加入房间时使用的标识）
+ * 值: 房间条目
+ * 由lobby_mutex保护，只在创建、加入、退出房间和刷新列表时访问，落子转发不会访问
+ */
+map<room_id_t,lobby_room>lobby;//大厅目录
+mutex lobby_mutex;//保护大厅目录
+int free_rooms=0;//空闲房间数（随大厅目录增量维护，由lobby_mutex保护）
+name_index free_index;//按房间名排序的空闲房间索引，用于前缀过滤和分页（由lobby_mutex保护）
+const int lobby_page_max=100;//分页查询每页最多的房间数
+
+/**
+ * @brief 大厅快照
+ * 
+ * 所有空闲房间序列化后的帧，请求直接整块追加到输出队列
+ * 大厅目录变化（创建、加入、退出房间）时置空，下一次请求时重建
+ * 快照建好后只读，请求在锁内只复制指针，锁外再复制数据
+ */
+struct lobby_cache
+{
+    string list;        // R请求的格式：/N{房间名}、/I{房主IP}、/F{房间ID}
+    string sync;        // 订阅时全量同步的格式：L+{房间ID}/{房主IP}/{房间名}
+    string sync_bin;    // sync编码后的二进制帧（发给v2订阅者）
+};
+shared_ptr<const lobby_cache>lobby_snapshot;//由lobby_mutex保护
+
+atomic<int>online_count(0);//所有线程的在线人数
+
+/**
+ * @brief 对局日志
+ * 
+ * 所有反应堆线程共用一个提交线程：各线程每轮提交本轮的记录，提交线程合并后一次写入、一次同步
+ */
+game_journal journal;//对局日志（未打开时不记录）
+
+/**
+ * @brief 对局归档
+ * 
+ * 归档由archive工具在服务器之外整理（./archive build 日志 目录），服务器只映射和查询。
+ * 查询时检查状态文件，整理过后（状态文件被替换）重新映射；正在使用旧映射的查询持有旧的快照直到结束
+ */
+mutex archive_mutex;//保护归档快照
+shared_ptr<const game_archive>archive_snapshot;//由archive_mutex保护
+struct stat archive_state_stat;//映射归档时状态文件的信息（由archive_mutex保护）
+
+/**
+ * @brief 快速匹配
+ * 
+ * 每种规则一个匹配队列，只由匹配线程（第match_home个反应堆线程）访问，不需要加锁：
+ * 其他线程上的玩家排队时与加入房间一样先迁移过来，配对的双方总在同一个线程上，直接建房
+ */
+const int match_home=0;//匹配线程
+const long long match_widen_ms=5000;//匹配窗口放宽的周期（毫秒）
+match_queue match_queues[rule_count];//按规则分开的匹配队列（只由匹配线程访问）
+
+/**
+ * @brief 等级分
+ * 
+ * 键: 玩家IP（与对局归档一样按IP区分玩家），没有记录的玩家为match_rating_initial
+ * 选定先后手之后结束的对局（五连、下满、认输、离开）按Elo更新双方的等级分，同一IP的两方不计；
+ * 只保存在内存中，服务器重启后重新开始
+ */
+unordered_map<uint32_t,int>ratings;//等级分
+mutex rating_mutex;//保护等级分
+
+/* ==================== 线程私有数据容器（每个反应堆线程一份分片） ==================== */
+
+thread_local int reactor_id;//当前线程的反应堆编号
+
+/**
+ * @brief 连接表
+ * 
+ * 下标: 客户端套接字描述符
+ * 值: 该客户端的连接状态（游戏状态、地址、收发缓冲区）
+ * 查找O(1)，在线集合的加入和删除O(1)
+ */
+thread_local fd_table<connection>conns;//每一个套接字对应一个连接
+
+/**
+ * @brief 房间表
+ * 
+ * 存储本线程上已创建的房间，按房间ID O(1)创建、查找和删除
+ * 删除房间不会改变其他房间的ID
+ */
+thread_local slot_map<room_information>rooms;//房间
+
+/**
+ * @brief 本轮事件处理中产生了输出的连接
+ * 
+ * 同一轮中发往同一客户端的多条消息只触发一次write
+ */
+thread_local vector<int>dirty_fds;//待刷新输出队列的客户端套接字
+
+/**
+ * @brief 本轮事件处理中决定断开的连接
+ * 
+ * 处理函数执行过程中不能直接关闭连接（调用方可能还在使用它），统一在本轮结束时关闭
+ */
+thread_local vector<int>closing_fds;//待关闭的客户端套接字
+
+/**
+ * @brief 本轮事件处理中决定迁移到其他线程的连接
+ */
+thread_local vector<int>migrating_fds;//待迁移的客户端套接字
+
+thread_local int epoll_fd;//epoll实例描述符
+thread_local int idle_fd;//预留的文件描述符（文件描述符耗尽时腾出一个用于拒绝连接）
+thread_local bool uring_backend=false;//本线程使用io_uring事件循环
+thread_local int timer_fd;//按刻度周期触发的timerfd
+
+thread_local thread_metrics* stats;//本线程的运行指标（即reactors[reactor_id]->metrics）
+thread_local uint64_t loop_start;//本轮事件循环醒来的时刻（纳秒），本轮读到的消息都以它为读到的时刻
+
+/**
+ * @brief 本线程的时间轮
+ * 
+ * 每个连接挂一个定时器，到期时检查心跳与超时后重新设置；
+ * 收到数据只更新时间戳，不操作时间轮
+ */
+thread_local timer_wheel timers;
+
+/**
+ * @brief 本线程上订阅了大厅推送的连接
+ * 
+ * 连接的sub_pos记录自己在列表中的下标，退订时与末尾元素交换，O(1)
+ */
+thread_local vector<connection*>lobby_subs;//大厅订阅者
+
+thread_local string journal_batch;//本轮事件处理中产生的对局日志记录（本轮结束时整批提交）
+
+thread_local vector<room_id_t>watch_rooms;//本轮有观战事件待推送的房间
+
+thread_local bool lobby_touched=false;//本轮产生了大厅事件或在线人数变化，需要唤醒其他线程推送
+thread_local int last_online=-1;//上一次推送给本线程订阅者的在线人数
+thread_local int last_free=-1;//上一次推送给本线程订阅者的空闲房间数
+
+/* ==================== 主函数 ==================== */
+
+/**
+ * @brief 创建本线程的监听套接字
+ * @param argc 命令行参数个数
+ * @param argv 命令行参数数组（argv[1]可指定端口号）
+ * @return int 监听套接字
+ * 
+ * 1. 初始化服务器套接字
+ * 2. 设置套接字选项并绑定端口（SO_REUSEPORT：每个线程一个监听套接字，由内核分配新连接）
+ * 3. 开始监听连接
+ */
+int open_listener(int argc,char* argv[])
+{
+    // 服务器套接字
+    int server_fd;
+    
+    // 服务器地址结构
+    struct sockaddr_in server_addr;
+    
     int ret=0;;             // 函数返回值
-    char msg[msg_size];     // 消息缓冲区
     
     // 初始化服务器套接字和地址
     initialization_server(server_addr,server_fd,argc,argv);
@@ -250,17 +1057,124 @@ int main(int argc,char* argv[])
     int optset=1;
     ret=setsockopt(server_fd,SOL_SOCKET,SO_REUSEADDR,&optset,sizeof(optset));assert(ret==0);
     
+    // 允许多个线程的监听套接字绑定同一端口，内核按连接哈希分配给各线程
+    ret=setsockopt(server_fd,SOL_SOCKET,SO_REUSEPORT,&optset,sizeof(optset));assert(ret==0);
+    
     // 绑定服务器地址到套接字
     ret=bind(server_fd,(struct sockaddr*)&server_addr,sizeof(server_addr));assert(ret==0);
     
-    // 开始监听，等待队列长度为5
-    ret=listen(server_fd,5);assert(ret==0);
+    // 开始监听，等待队列取系统上限：队列过短时大量并发接入会溢出，
+    // 被丢弃的握手要等秒级的重传才能完成
+    ret=listen(server_fd,SOMAXCONN);assert(ret==0);
+    (void)ret;
+    return server_fd;
+}
+
+/**
+ * @brief 登记新接入的客户端连接（两种后端共用）
+ * @param client_fd 客户端套接字（非阻塞）
+ * @param client_addr 客户端地址
+ */
+void accept_client(int client_fd,const struct sockaddr_in &client_addr)
+{
+    // 打印新连接信息（inet_ntoa使用静态缓冲区，多线程下改用inet_ntop）
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET,&client_addr.sin_addr,ip,sizeof(ip));
+    printf("[%d][Client%d]<IP:%s><PT:%d><***CONNECT***>\n",__LINE__,reactor_id,ip,ntohs(client_addr.sin_port));
+    
+    // 为该客户端创建默认信息记录并保存地址信息
+    connection* c=conns.insert(client_fd);
+    c->fd=client_fd;
+    c->addr=client_addr;
+    c->last_rx=c->last_active=timers.current();
+    online_count++;
+    lobby_touched=true;
+    stats->accepted.add();
+    
+    // 开始接收数据，并开始心跳与超时检查
+    watch_client(c);
+    schedule_check(c,timers.current()+options.heartbeat/timer_tick_ms);
+}
+
+/**
+ * @brief 文件描述符耗尽（EMFILE）时接受并立即关闭一个连接
+ * @param server_fd 监听套接字
+ * 
+ * 使用预留的idle_fd：关闭它腾出一个描述符，接受连接后立即关闭，再重新预留，
+ * 避免监听套接字一直可读而空转
+ */
+void drop_connection(int server_fd)
+{
+    close(idle_fd);                             // 关闭预留fd
+    idle_fd=accept(server_fd,NULL,NULL);        // 接受连接（会立即获得fd）
+    close(idle_fd);                             // 关闭该连接
+    idle_fd=open("/dev/null",O_RDONLY|O_NONBLOCK);  // 重新打开预留fd
+}
+
+/**
+ * @brief 反应堆线程主循环
+ * @param id 反应堆线程编号
+ * @param argc 命令行参数个数
+ * @param argv 命令行参数数组（argv[1]可指定端口号）
+ * 
+ * 创建监听套接字后按启动参数进入epoll或io_uring事件循环；
+ * 两种后端共用全部处理函数，只有等待事件、读写套接字的方式不同
+ */
+void reactor_loop(int id,int argc,char* argv[])
+{   
+    reactor_id=id;
+    stats=&reactors[id]->metrics;
+    rooms.set_tag(id);      // 本线程创建的房间ID中带上线程编号
+    int event_fd=reactors[id]->event_fd;
+    
+    // 打开空设备文件，用于处理文件描述符耗尽的情况
+    // 这是一种优雅处理EMFILE错误的技巧
+    idle_fd=open("/dev/null",O_RDONLY|O_CLOEXEC);
+    
+    int server_fd=open_listener(argc,argv);
+    
+    // 时间轮由timerfd按刻度周期驱动（两种后端都把它当作普通的可读描述符）
+    timer_fd=timerfd_create(CLOCK_MONOTONIC,TFD_NONBLOCK|TFD_CLOEXEC);
+    struct itimerspec period;
+    period.it_interval.tv_sec=0;
+    period.it_interval.tv_nsec=timer_tick_ms*1000000L;
+    period.it_value=period.it_interval;
+    timerfd_settime(timer_fd,0,&period,NULL);
+    timers.start(now_ms()/timer_tick_ms);
+    
+    if(options.uring)
+    {
+        if(uring_setup())
+        {
+            uring_loop(server_fd,event_fd);
+            return;
+        }
+        printf("[%d][Reactor%d]<io_uring unavailable, fall back to epoll>\n",__LINE__,reactor_id);
+    }
+    epoll_loop(server_fd,event_fd);
+}
+
+/**
+ * @brief epoll事件循环
+ * @param server_fd 监听套接字
+ * @param event_fd 唤醒本线程的eventfd
+ * 
+ * 每轮：epoll_wait等待事件 -> 接受连接 / 接管迁移过来的连接 / 读取并处理消息 / 继续发送 -> 批量刷新输出
+ */
+void epoll_loop(int server_fd,int event_fd)
+{
+    // 客户端套接字
+    int client_fd;
+    
+    // 客户端地址结构
+    struct sockaddr_in client_addr;
+
+    socklen_t client_sz;    // 客户端地址结构大小
 
     // ========== epoll初始化 ==========
     
     struct epoll_event event;               // 单个epoll事件
     vector<struct epoll_event>events(16);   // 事件数组，初始容量16
-    int epoll_fd;                           // epoll实例描述符
 
     // 创建epoll实例（参数在Linux 2.6.8后被忽略，但必须大于0）
     epoll_fd=epoll_create(5555);
@@ -271,6 +1185,16 @@ int main(int argc,char* argv[])
 
     // 将服务器套接字添加到epoll监控
     epoll_ctl(epoll_fd,EPOLL_CTL_ADD,server_fd,&event);
+    
+    // 注册eventfd，其他线程迁移连接过来时用它唤醒本线程
+    event.data.fd=event_fd;
+    event.events=EPOLLIN;
+    epoll_ctl(epoll_fd,EPOLL_CTL_ADD,event_fd,&event);
+    
+    // 注册timerfd，每个刻度推进一次时间轮
+    event.data.fd=timer_fd;
+    event.events=EPOLLIN;
+    epoll_ctl(epoll_fd,EPOLL_CTL_ADD,timer_fd,&event);
 
 
     // ========== 主事件循环 ==========
@@ -290,287 +1214,2571 @@ int main(int argc,char* argv[])
             Error_msg("epoll_wait");
         }
         
-        // 没有事件，继续等待
-        if(event_cnt==0)
+        // 没有事件，继续等待
+        if(event_cnt==0)
+            continue;
+        loop_start=metrics_now_ns();
+        
+        // 动态扩容：如果事件数组满了，扩大一倍
+        if((size_t)event_cnt==events.size())
+            events.resize(events.size()*2);
+        
+        // 遍历所有触发的事件
+        for(int i=0;i<event_cnt;i++)
+        {
+            // ========== 处理新客户端连接 ==========
+            if(events[i].data.fd==server_fd)
+            {
+                client_sz=sizeof(client_addr);
+                
+                // accept4: 接受连接并设置非阻塞标志
+                client_fd=accept4(server_fd,(struct sockaddr*)&client_addr,&client_sz,O_NONBLOCK);
+                //client_fd=accept(server_fd,(struct sockaddr*)&client_addr,&client_sz);
+
+                // 接受连接失败处理
+                if(client_fd==-1)
+                {
+                    // EMFILE: 文件描述符耗尽
+                    // 使用预留的idle_fd优雅处理
+                    if(errno==EMFILE)
+                    {
+                        drop_connection(server_fd);
+                        continue;
+                    }
+                    else
+                    Error_msg("accept4?");
+                    continue;
+                }
+                
+                accept_client(client_fd,client_addr);
+            }
+            // ========== 接管其他线程迁移过来的连接 ==========
+            else if(events[i].data.fd==event_fd)
+            {
+                adopt_clients();
+            }
+            // ========== 时间轮刻度：心跳与超时检查 ==========
+            else if(events[i].data.fd==timer_fd)
+            {
+                run_timers();
+            }
+            else
+            {
+                // 无效套接字、已决定断开或即将迁移的连接，跳过
+                connection* c=conns.find(events[i].data.fd);
+                if(!c||c->buf.closing||c->buf.migrate_to>=0)
+                    continue;
+                
+                // ========== 套接字可写：继续发送输出队列 ==========
+                if(events[i].events&EPOLLOUT)
+                    flush_client(c);
+                
+                // ========== 处理客户端消息 ==========
+                if(events[i].events&(EPOLLIN|EPOLLHUP|EPOLLERR))
+                {
+                    // 边缘触发模式下必须一直读到EAGAIN，否则剩余数据要等到下一次边沿才会通知
+                    // 读取过程中每条完整的帧都会立即分发处理
+                    // 读到EOF、读取错误或协议违规（超长帧）时标记断开
+                    if(read_client(c))
+                        mark_closing(c);
+                }
+            }
+        }
+        
+        // ========== 本轮结束：批量发送输出并关闭待断开的连接 ==========
+        flush_pending();
+        stats->loop_lag.record(metrics_now_ns()-loop_start);
+    }
+    
+    // 清理资源（实际上不会执行到这里，因为是无限循环）
+    close(server_fd);
+    close(epoll_fd);
+}
+
+/**
+ * @brief 服务器主函数
+ * @param argc 命令行参数个数
+ * @param argv 命令行参数数组（argv[1]可指定端口号，--threads N 指定反应堆线程数）
+ * @return int 程序退出码
+ * 
+ * 创建N个反应堆，第0个在主线程上运行，其余各自启动一个线程
+ */
+int main(int argc,char* argv[])
+{
+    parse_options(argc,argv);
+    for(int i=0;i<rule_count;i++)
+        match_queues[i].configure(options.match_window,options.match_widen,match_widen_ms);
+    
+    // 对端已关闭时write会触发SIGPIPE（默认终止进程），改为由write返回错误处理
+    signal(SIGPIPE,SIG_IGN);
+    
+    // 打开对局日志（打不开时照常服务，只是不记录）
+    if(strcmp(options.journal,"none")!=0&&!journal.open(options.journal))
+        printf("[%d][Server]<journal %s unavailable, games are not recorded>\n",__LINE__,options.journal);
+    
+    for(int i=0;i<options.threads;i++)
+        reactors.push_back(new reactor());
+    
+    // 运行指标由单独的线程回复（打不开时照常服务）
+    if(options.metrics)
+    {
+        int metrics_fd=metrics_listen(options.metrics);
+        if(metrics_fd<0)
+            printf("[%d][Server]<metrics %s unavailable>\n",__LINE__,options.metrics);
+        else
+            thread(metrics_serve,metrics_fd).detach();
+    }
+    
+    vector<thread>threads;
+    for(int i=1;i<options.threads;i++)
+        threads.push_back(thread(reactor_loop,i,argc,argv));
+    
+    reactor_loop(0,argc,argv);
+    
+    for(size_t i=0;i<threads.size();i++)
+        threads[i].join();
+    return 0;
+}
+
+/* ==================== 分帧与消息分发 ==================== */
+
+bool read_client(connection* c)
+{
+    char msg[msg_size];
+    
+    if(uring_backend)
+        return uring_read(c);
+    
+    while(1)
+    {
+        // 输出队列积压（背压）：暂不读取新请求，数据留在内核缓冲区，低于低水位后再继续
+        // 即将迁移的连接同样不再读取，剩余数据由目标线程读取
+        if(c->buf.paused||c->buf.closing||c->buf.migrate_to>=0)
+            return false;
+        
+        ssize_t ret=read(c->fd,msg,sizeof(msg));
+        if(ret>0)
+        {
+            // 每读到一块数据就切分处理，缓冲区中只会残留不足一帧的数据
+            stats->bytes_in.add(ret);
+            c->buf.in.append(msg,ret);
+            if(!dispatch_frames(c))
+                return true;
+            continue;
+        }
+        if(ret==0)              // 对端关闭连接
+            return true;
+        if(errno==EINTR)        // 被信号中断，继续读
+            continue;
+        if(errno==EAGAIN||errno==EWOULDBLOCK)   // 内核缓冲区已读空
+            return false;
+        return true;            // 其他读取错误
+    }
+}
+
+bool dispatch_frames(connection* c)
+{
+    char msg[msg_size];
+    client_buffer &buf=c->buf;
+    size_t start=0,pos;
+    
+    // 收到任何数据（包括心跳应答）都说明对端仍然在线
+    c->last_rx=timers.current();
+    
+    if(buf.version>=2)
+        return dispatch_binary(c);
+    
+    // 逐个切出以'\n'结尾的完整帧
+    while((pos=buf.in.find('\n',start))!=string::npos)
+    {
+        size_t len=pos-start;
+        buf.framed=true;
+        
+        // 兼容"\r\n"结尾
+        if(len>0&&buf.in[pos-1]=='\r')
+            len--;
+        
+        // 超长帧直接丢弃（处理函数按msg_size的缓冲区设计）
+        if(len<msg_size)
+        {
+            memcpy(msg,buf.in.data()+start,len);
+            msg[len]='\0';
+            
+            // 版本协商：回复"V2"后改用二进制帧，缓冲区中剩余的数据已经是二进制帧
+            if(strcmp(msg,"V2")==0)
+            {
+                stats->messages[mk_version].add();
+                send_msg(c,msg,len);
+                buf.version=2;
+                buf.in.erase(0,pos+1);
+                return dispatch_binary(c);
+            }
+            count_msg(msg);
+            handle_msg(c,msg);
+        }
+        start=pos+1;
+        
+        // 连接即将迁移：这条消息交给目标线程重新处理，之后的数据原样留在缓冲区一并移交
+        if(buf.migrate_to>=0)
+        {
+            buf.replay=msg;
+            buf.in.erase(0,start);
+            return true;
+        }
+    }
+    buf.in.erase(0,start);
+    
+    // 旧版客户端不发送分隔符：从未见过'\n'时，沿用原来"一次读取即一条消息"的处理方式
+    if(!buf.framed)
+    {
+        size_t len=min(buf.in.size(),(size_t)msg_size-1);
+        if(len==0)
+            return true;
+        memcpy(msg,buf.in.data(),len);
+        msg[len]='\0';
+        buf.in.clear();
+        count_msg(msg);
+        handle_msg(c,msg);
+        if(buf.migrate_to>=0)
+            buf.replay=msg;
+        return true;
+    }
+    
+    // 剩余的半帧已经超过一帧的最大长度，视为协议错误
+    return buf.in.size()<msg_size;
+}
+
+bool dispatch_binary(connection* c)
+{
+    char msg[msg_size];
+    client_buffer &buf=c->buf;
+    size_t start=0;
+    long size;
+    string text;
+    
+    while((size=proto_frame_size(buf.in.data()+start,buf.in.size()-start))>0)
+    {
+        const char* frame=buf.in.data()+start;
+        start+=size;
+        
+        // 对战消息（落子等）：对手也是v2连接时，经权威棋盘校验后整帧原样转发，不转换成文本
+        connection* opponent=c->info.opponent;
+        uint8_t op=frame[proto_header];
+        if(proto_is_relay(op)&&opponent&&opponent->buf.version>=2)
+        {
+            stats->messages[mk_move+(op-op_move)].add();
+            int arg=size==(long)proto_header+2?(unsigned char)frame[proto_header+1]:-1;
+            int outcome;
+            if(game_check(c,op,arg,outcome))
+            {
+                send_binary(opponent,frame,size);
+                if(op==op_move)
+                    relay_mark(opponent);
+                if(outcome>=0)
+                    game_over(c,outcome);
+            }
+            touch_client(c);
+            continue;
+        }
+        
+        // 其余消息转换成文本后交给原来的处理函数（非法帧直接丢弃）
+        text.clear();
+        if(!proto_to_text(frame,size,text)||text.size()>=msg_size)
+            continue;
+        memcpy(msg,text.data(),text.size());
+        msg[text.size()]='\0';
+        count_msg(msg);
+        handle_msg(c,msg);
+        
+        // 连接即将迁移：与文本帧相同，这条消息交给目标线程重新处理
+        if(buf.migrate_to>=0)
+        {
+            buf.replay=msg;
+            buf.in.erase(0,start);
+            return true;
+        }
+    }
+    buf.in.erase(0,start);
+    
+    // 长度字段非法，视为协议错误
+    return size==0;
+}
+
+void handle_msg(connection* c,char* msg)
+{
+    // 心跳应答只用来确认在线（已在收到数据时记录），不算作操作
+    if(msg[0]=='H'&&msg[1]=='\0')
+        return;
+    
+    // ========== 处理对战消息（O开头）==========
+    // 'O'开头的消息为opponent消息，先由权威棋盘校验并更新对局状态，合法的消息原样转发给对手
+    if(msg[0]=='O')//当消息头字母为O时候，代表为opponent消息
+    {
+        int op=-1,arg=-1;
+        switch(msg[1])
+        {
+            case 'M':   // Move: 落子消息（OMxy）
+            {
+                int x=proto_coord_value(msg[2]);
+                int y=x>=0?proto_coord_value(msg[3]):-1;
+                op=op_move;
+                if(y>=0&&msg[4]=='\0')
+                    arg=x*board_size+y;
+            }break;
+            case 'B':   // Back: 悔棋请求（OB）或应答（OB1同意/OB0拒绝）
+            {
+                op=msg[2]=='\0'?op_back:op_back_reply;
+                if(msg[2]=='1'||msg[2]=='0')
+                    arg=msg[2]-'0';
+            }break;
+            case 'N':op=op_chat;break;      // Note: 聊天消息
+            case 'R':op=op_leave;break;     // Run away: 对手退出消息
+            case 'S':op=op_surrender;break; // Surrender: 认输消息
+        }
+        
+        int outcome;
+        if(op>=0&&game_check(c,op,arg,outcome))
+        {
+            send_msg(c->info.opponent,msg);
+            if(op==op_move)
+                relay_mark(c->info.opponent);
+            if(outcome>=0)
+                game_over(c,outcome);
+        }
+    }
+    
+    // ========== 处理准备和先后手消息 ==========
+    //以下三个if语句中消息处理分别表示接受到客户端的准备请求（服务器这边会更新准备信息）、原地转发先手并给对手传送后手的消息
+    
+    // 处理准备/取消准备消息
+    // 只在对局开始前接受：选择先后手和对局中切换准备状态会清空权威棋盘、重新开局
+    room_information* room=strcmp(msg,"prepare")==0?rooms.find(c->info.room_id):NULL;
+    if(room&&room->phase==phase_idle)
+    {
+        // 切换准备状态
+        c->info.prepare=!c->info.prepare;
+        
+        // 检查是否双方都已准备
+        // 条件：己方已准备 && 有对手 && 对手已准备
+        connection* opponent=c->info.opponent;
+        if(c->info.prepare&&opponent&&opponent->info.prepare)
+        {   
+            // v2连接开局后回到未准备状态，下一局需要重新准备；
+            // 文本协议的旧客户端在对局结束时自己发送"prepare"取消准备，保持原来的切换方式
+            if(c->buf.version>=2)
+                c->info.prepare=false;
+            if(opponent->buf.version>=2)
+                opponent->info.prepare=false;
+            
+            // 清空权威棋盘，等待选择先后手
+            room->phase=phase_choose;
+            room->black_fd=-1;
+            room->back_fd=-1;
+            room->board.reset();
+            game_event(c->info.room_id,jk_start,0);
+            
+            // 通知双方游戏开始
+            //printf("[%d]game_start",__LINE__);
+            send_msg(c,"/Zstart");
+            send_msg(opponent,"/Zstart");
+        }
+    }
+    
+    // 处理选择先后手消息（每局只接受先到的一次选择，双方同时选择时后到的被忽略）
+    if(strcmp(msg,"color1")==0||strcmp(msg,"color0")==0)
+    {
+        connection* opponent=c->info.opponent;
+        room_information* room=opponent?rooms.find(c->info.room_id):NULL;
+        if(room&&room->phase==phase_choose)
+        {
+            bool black=msg[5]=='1';
+            room->phase=phase_play;
+            room->black_fd=black?c->fd:opponent->fd;
+            room->player_ip[black?stone_black:stone_white]=c->addr.sin_addr.s_addr;
+            room->player_ip[black?stone_white:stone_black]=opponent->addr.sin_addr.s_addr;
+            game_event(c->info.room_id,jk_color,room->black_fd==room->master_fd?0:1);
+            
+            // 先告知房间的规则（旧客户端在这个阶段忽略不认识的消息），再发送先后手：发送者为所选颜色，对手为另一种颜色
+            char rule_msg[3]={'K',(char)('0'+room->board.rule()),'\0'};
+            send_msg(c,rule_msg);
+            send_msg(opponent,rule_msg);
+            send_msg(c,black?"c1":"c0");
+            send_msg(opponent,black?"c0":"c1");
+        }
+    }
+    
+    // ========== 处理系统命令消息 ==========
+    // 这些消息用于游戏开始前的客户端-服务器交互
+    //特殊信息处理，一般是用于游戏开始前的客户端服务端交互
+    switch(msg[0])
+    {
+        case 'R':R_signal(c);break;     // Refresh: 刷新房间列表
+        case 'C':C_signal(msg,c);break; // Create: 创建房间
+        case 'E':E_signal(c);break;     // Exit: 退出房间
+        case 'J':J_signal(c,msg);break; // Join: 加入房间
+        case 'U':U_signal(c);break;     // Update: 更新对手状态
+        case 'S':S_signal(c,msg);break; // Subscribe: 订阅大厅推送
+        case 'Q':Q_signal(c,msg);break; // Query: 分页查询房间
+        case 'A':A_signal(c,msg);break; // Archive: 查询对局归档
+        case 'G':G_signal(c,msg);break; // Gallery: 观战
+        case 'M':M_signal(c,msg);break; // Match: 快速匹配
+        //default:break;
+    }
+    
+    // 按处理后的对局状态更新应答计时（聊天、刷新等不改变对局状态的消息不影响计时）
+    touch_client(c);
+    
+    // 调试输出（已注释）
+    //printf("[%d][CLient%d]:%s\n",__LINE__,c->fd,msg);
+}
+
+void send_msg(connection* c,const char* msg,size_t len)
+{
+    // 没有对手等无效目标直接忽略
+    if(!c||c->buf.closing)
+        return;
+    
+    // 消息与分隔符追加到输出队列，本轮结束时统一写出
+    if(c->buf.version>=2)
+        proto_from_text(msg,len,c->buf.out);
+    else
+    {
+        c->buf.out.append(msg,len);
+        c->buf.out+='\n';
+    }
+    queue_output(c);
+}
+
+void send_msg(connection* c,const char* msg)
+{
+    send_msg(c,msg,strlen(msg));
+}
+
+void send_frames(connection* c,const char* data,size_t len)
+{
+    if(!c||c->buf.closing)
+        return;
+    if(c->buf.version>=2)
+        proto_from_frames(data,len,c->buf.out);
+    else
+        c->buf.out.append(data,len);
+    queue_output(c);
+}
+
+void send_binary(connection* c,const char* data,size_t len)
+{
+    if(!c||c->buf.closing)
+        return;
+    c->buf.out.append(data,len);
+    queue_output(c);
+}
+
+void send_shared(connection* c,const shared_ptr<const string> &data)
+{
+    if(!c||c->buf.closing||data->empty())
+        return;
+    client_buffer &buf=c->buf;
+    
+    // 之前排入的私有输出先封成一段，保持先后顺序（之后的私有输出继续追加到out，排在共享段之后）
+    if(buf.out.size()>buf.out_off)
+    {
+        shared_output own;
+        own.data=make_shared<const string>(buf.out_off?buf.out.substr(buf.out_off):std::move(buf.out));
+        own.off=0;
+        buf.shared_bytes+=own.data->size();
+        buf.shared.push_back(own);
+        buf.out.clear();
+        buf.out_off=0;
+    }
+    shared_output seg;
+    seg.data=data;
+    seg.off=0;
+    buf.shared_bytes+=data->size();
+    buf.shared.push_back(seg);
+    queue_output(c);
+}
+
+void queue_output(connection* c)
+{
+    client_buffer &buf=c->buf;
+    if(!buf.dirty)
+    {
+        buf.dirty=true;
+        dirty_fds.push_back(c->fd);
+    }
+    
+    // ========== 高水位检查 ==========
+    size_t pending=buf.pending();
+    if(pending<=options.out_high)
+        return;
+    
+    // 超过硬上限：立即断开，避免一个慢客户端无限占用内存
+    if(pending>options.out_limit)
+    {
+        printf("[%d][CLient]<FD:%d><***SLOW CONSUMER %zu bytes***>\n",__LINE__,c->fd,pending);
+        mark_closing(c);
+        return;
+    }
+    
+    // 超过高水位：暂停读取该客户端的请求；持续超过宽限时间则断开
+    buf.paused=true;
+    long long now=now_ms();
+    if(buf.over_since==0)
+        buf.over_since=now;
+    else if(now-buf.over_since>options.out_grace)
+    {
+        printf("[%d][CLient]<FD:%d><***SLOW CONSUMER %lldms***>\n",__LINE__,c->fd,now-buf.over_since);
+        mark_closing(c);
+    }
+}
+
+/* ==================== 输出队列与连接管理 ==================== */
+
+void flush_client(connection* c)
+{
+    client_buffer &buf=c->buf;
+    buf.dirty=false;
+    
+    // 写出输出队列（io_uring后端为提交发送请求，发送完成后再次调用本函数）
+    if(!(uring_backend?uring_send(c):write_client(c)))
+        return;
+    
+    // 回落到低水位以下：解除积压状态，恢复读取（边缘触发不会再次通知，需要主动读）
+    if(buf.pending()<=options.out_low)
+    {
+        buf.over_since=0;
+        if(c->watch_lag)
+            watch_resync(c);
+        if(buf.paused)
+        {
+            buf.paused=false;
+            if(read_client(c))
+                mark_closing(c);
+        }
+    }
+}
+
+bool write_client(connection* c)
+{
+    client_buffer &buf=c->buf;
+    
+    while(buf.pending()>0)
+    {
+        ssize_t ret;
+        stats->writes.add();
+        if(buf.shared.empty())
+            ret=write(c->fd,buf.out.data()+buf.out_off,buf.pending());
+        else
+        {
+            // 共享数据段和私有输出按顺序一次writev写出，共享段不复制
+            struct iovec iov[16];
+            int n=0;
+            for(;(size_t)n<buf.shared.size()&&n<15;n++)
+            {
+                const shared_output &seg=buf.shared[n];
+                iov[n].iov_base=(void*)(seg.data->data()+seg.off);
+                iov[n].iov_len=seg.data->size()-seg.off;
+            }
+            if((size_t)n==buf.shared.size()&&buf.out.size()>buf.out_off)
+            {
+                iov[n].iov_base=(void*)(buf.out.data()+buf.out_off);
+                iov[n].iov_len=buf.out.size()-buf.out_off;
+                n++;
+            }
+            ret=writev(c->fd,iov,n);
+        }
+        if(ret>0)
+        {
+            // 先消耗共享段，剩余部分属于out
+            stats->bytes_out.add(ret);
+            size_t left=ret;
+            while(left>0&&!buf.shared.empty())
+            {
+                shared_output &seg=buf.shared.front();
+                size_t k=min(left,seg.data->size()-seg.off);
+                seg.off+=k;
+                buf.shared_bytes-=k;
+                left-=k;
+                if(seg.off==seg.data->size())
+                    buf.shared.pop_front();
+            }
+            buf.out_off+=left;
+            continue;
+        }
+        if(ret<0&&errno==EINTR)
+            continue;
+        if(ret<0&&(errno==EAGAIN||errno==EWOULDBLOCK))
+            break;
+        // 写入出错（如对端已重置连接）
+        mark_closing(c);
+        return false;
+    }
+    
+    // 已写出的部分从队列中移除
+    if(buf.pending()==0)
+    {
+        buf.out.clear();
+        buf.out_off=0;
+        relay_done(c);
+    }
+    else if(buf.out_off>=buf.out.size()/2)
+    {
+        buf.out.erase(0,buf.out_off);
+        buf.out_off=0;
+    }
+    
+    // 写不完时注册EPOLLOUT，写完后注销，避免可写事件空转
+    bool want_out=buf.pending()>0;
+    if(want_out)
+        stats->short_writes.add();
+    if(want_out!=buf.want_out)
+    {
+        struct epoll_event event;
+        event.data.fd=c->fd;
+        event.events=EPOLLIN|EPOLLET|(want_out?(uint32_t)EPOLLOUT:0);
+        epoll_ctl(epoll_fd,EPOLL_CTL_MOD,c->fd,&event);
+        buf.want_out=want_out;
+    }
+    return true;
+}
+
+void flush_pending()
+{
+    // 本轮各房间的观战事件和大厅事件合并后与其他输出一起写出
+    watch_deliver();
+    lobby_deliver();
+    
+    // 关闭连接会产生新的大厅事件，推送后还需要再刷新一次
+    while(!dirty_fds.empty()||!migrating_fds.empty()||!closing_fds.empty())
+    {
+        // 刷新过程中恢复读取的客户端可能产生新的输出，因此按下标遍历
+        for(size_t i=0;i<dirty_fds.size();i++)
+        {
+            connection* c=conns.find(dirty_fds[i]);
+            if(c&&c->buf.dirty&&!c->buf.closing)
+                flush_client(c);
+        }
+        dirty_fds.clear();
+        
+        for(size_t i=0;i<migrating_fds.size();i++)
+            hand_over(migrating_fds[i]);
+        migrating_fds.clear();
+        
+        for(size_t i=0;i<closing_fds.size();i++)
+            close_client(closing_fds[i]);
+        closing_fds.clear();
+        
+        watch_deliver();
+        lobby_deliver();
+    }
+    
+    lobby_wake();
+    
+    // 本轮的对局日志整批交给提交线程（此时本轮的输出已经写出，不等待同步）
+    journal.submit(journal_batch);
+}
+
+void mark_closing(connection* c)
+{
+    if(c->buf.closing)
+        return;
+    c->buf.closing=true;
+    closing_fds.push_back(c->fd);
+    
+    // 即将断开的玩家不再参与配对
+    match_leave(c);
+}
+
+void close_client(int fd)
+{
+    connection* c=conns.find(fd);
+    if(!c)
+        return;
+    
+    printf("[%d][CLient]<FD:%d><***CLOSE***>\n",__LINE__,fd);
+    
+    // 处理退出房间逻辑
+    E_signal(c);
+    lobby_unsubscribe(c);
+    watch_leave(c);
+    match_leave(c);
+    timers.cancel(&c->timer);
+    
+    // 从epoll中移除（io_uring后端为取消接收请求）并关闭套接字
+    if(uring_backend)
+        uring_release(c,true);
+    else
+        epoll_ctl(epoll_fd,EPOLL_CTL_DEL,fd,NULL);
+    close(fd);
+    
+    // 从连接表中移除（O(1)）
+    conns.erase(fd);
+    online_count--;
+    lobby_touched=true;
+    stats->closed.add();
+}
+
+void hand_over(int fd)
+{
+    connection* c=conns.find(fd);
+    if(!c||c->buf.closing||c->buf.migrate_to<0)
+        return;
+    
+    // io_uring后端：先取消接收请求并等在途的发送完成，请求全部结束后由完成事件重新加入待迁移列表
+    if(uring_backend&&!uring_release(c,false))
+        return;
+    
+    reactor &target=*reactors[c->buf.migrate_to];
+    lobby_unsubscribe(c);
+    watch_leave(c);
+    match_leave(c);
+    timers.cancel(&c->timer);
+    
+    // 打包连接状态：未处理的输入、未写出的输出都随连接一起移交
+    // 迁移的连接不在任何房间中，没有其他连接指向它
+    connection m=*c;
+    m.buf.migrate_to=-1;
+    m.buf.dirty=false;
+    m.buf.want_out=false;
+    
+    // 从本线程的epoll和分片中移除（不关闭套接字）
+    if(!uring_backend)
+        epoll_ctl(epoll_fd,EPOLL_CTL_DEL,fd,NULL);
+    conns.erase(fd);
+    
+    // 投递到目标线程的信箱并唤醒它
+    {
+        lock_guard<mutex> lock(target.mailbox_mutex);
+        target.mailbox.push_back(m);
+    }
+    uint64_t one=1;
+    write(target.event_fd,&one,sizeof(one));
+}
+
+void adopt_clients()
+{
+    char msg[msg_size];
+    uint64_t cnt;
+    reactor &self=*reactors[reactor_id];
+    read(self.event_fd,&cnt,sizeof(cnt));
+    
+    vector<connection>batch;
+    {
+        lock_guard<mutex> lock(self.mailbox_mutex);
+        batch.swap(self.mailbox);
+    }
+    
+    for(size_t i=0;i<batch.size();i++)
+    {
+        int fd=batch[i].fd;
+        connection* c=conns.insert(fd);
+        *c=batch[i];
+        
+        // 加入本线程的事件循环和时间轮
+        watch_client(c);
+        schedule_check(c,timers.current()+options.heartbeat/timer_tick_ms);
+        
+        // 迁移前尚未写出的输出
+        if(c->buf.pending()>0)
+        {
+            c->buf.dirty=true;
+            dirty_fds.push_back(fd);
+        }
+        
+        // 重新处理触发迁移的消息，然后处理随连接移交过来的剩余数据
+        size_t len=min(c->buf.replay.size(),(size_t)msg_size-1);
+        memcpy(msg,c->buf.replay.data(),len);
+        msg[len]='\0';
+        c->buf.replay.clear();
+        handle_msg(c,msg);
+        
+        if(!dispatch_frames(c)||read_client(c))
+            mark_closing(c);
+    }
+}
+
+/* ==================== 心跳与超时 ==================== */
+
+/*
+ * 每个连接在时间轮上只挂一个定时器，到期时统一检查（最长间隔一个心跳周期）：
+ * - v2连接静默超过一个心跳间隔：发送心跳帧，客户端收到后立即应答
+ * - v2连接连续3个心跳间隔没有任何数据：对端已失联（半开连接）
+ * - 对局中轮到一方应答（落子、应答悔棋请求或选择先后手）后超过离开时间仍没有应答，或已失联：
+ *   判定离开，替它通知对手后断开
+ * - 超过空闲时间没有任何请求（对局中为双方都没有）：断开，释放连接和它创建的空房间
+ * 旧版（文本协议）客户端不认识心跳帧，不发送心跳，只按无操作时间判定。
+ * 
+ * 收到数据时只更新last_rx/last_active两个时间戳，不操作时间轮；
+ * 定时器到期时如果期间有过活动，按新的时间戳重新设置即可
+ */
+
+void touch_client(connection* c)
+{
+    c->last_active=timers.current();
+    
+    // 计时从开始轮到该方时算起，轮到期间的聊天等请求不会重新计时
+    connection* players[2]={c,c->info.opponent};
+    room_information* room=players[1]?rooms.find(c->info.room_id):NULL;
+    for(int i=0;i<2;i++)
+    {
+        if(!players[i])
+            continue;
+        if(!room||!on_turn(room,players[i]))
+            players[i]->turn_since=0;
+        else if(players[i]->turn_since==0)
+            players[i]->turn_since=c->last_active;
+    }
+}
+
+bool on_turn(room_information* room,connection* c)
+{
+    if(room->phase==phase_choose)       // 双方都可以选择，先到的有效
+        return true;
+    if(room->phase!=phase_play)
+        return false;
+    if(room->back_fd!=-1)
+        return room->back_fd!=c->fd;
+    return (room->board.to_move()==stone_black)==(c->fd==room->black_fd);
+}
+
+void schedule_check(connection* c,uint64_t tick)
+{
+    c->timer.data=c->fd;
+    timers.schedule(&c->timer,tick);
+}
+
+void run_timers()
+{
+    uint64_t cnt;
+    read(timer_fd,&cnt,sizeof(cnt));
+    timers.advance(now_ms()/timer_tick_ms,[](timer_node* n)
+    {
+        connection* c=conns.find((int)n->data);
+        if(c&&&c->timer==n)
+            check_client(c);
+    });
+    
+    if(reactor_id==match_home)
+        match_advance();
+}
+
+void check_client(connection* c)
+{
+    if(c->buf.closing)
+        return;
+    
+    uint64_t now=timers.current();
+    uint64_t heartbeat=options.heartbeat/timer_tick_ms;
+    uint64_t next=now+heartbeat;
+    
+    // 即将迁移：由目标线程重新设置
+    if(c->buf.migrate_to>=0)
+    {
+        schedule_check(c,next);
+        return;
+    }
+    
+    connection* opponent=c->info.opponent;
+    bool playing=opponent!=NULL;
+    
+    // 对端失联：连续3个心跳间隔没有收到任何数据（只有v2连接会应答心跳）
+    if(c->buf.version>=2&&now-c->last_rx>=3*heartbeat)
+    {
+        if(playing)
+            abandon_client(c,"LOST");
+        else
+        {
+            printf("[%d][CLient]<FD:%d><***LOST***>\n",__LINE__,c->fd);
+            mark_closing(c);
+        }
+        return;
+    }
+    
+    // 对局中轮到自己应答后，超过离开时间仍没有应答
+    uint64_t deadline=UINT64_MAX;
+    if(playing&&c->turn_since)
+    {
+        deadline=c->turn_since+(uint64_t)(options.abandon_timeout/timer_tick_ms);
+        if(now>=deadline)
+        {
+            abandon_client(c,"ABANDON");
+            return;
+        }
+    }
+    
+    // 空闲：自己（对局中为双方）超过空闲时间没有任何请求；观众只看不发，观战和排队匹配期间不算空闲
+    uint64_t quiet=playing?max(c->last_active,opponent->last_active):c->last_active;
+    if(!c->watch_room&&c->match_rule<0)
+        deadline=min(deadline,quiet+(uint64_t)(options.idle_timeout/timer_tick_ms));
+    if(now>=deadline)
+    {
+        printf("[%d][CLient]<FD:%d><***IDLE***>\n",__LINE__,c->fd);
+        mark_closing(c);
+        return;
+    }
+    
+    // 静默超过一个心跳间隔：发送心跳
+    if(c->buf.version>=2&&now-c->last_rx>=heartbeat)
+        send_msg(c,"H",1);
+    
+    // 下一次检查：一个心跳间隔后，或超时的时刻（取较早者）
+    schedule_check(c,min(next,deadline));
+}
+
+void abandon_client(connection* c,const char* reason)
+{
+    printf("[%d][CLient]<FD:%d><***%s***>\n",__LINE__,c->fd,reason);
+    
+    // 与客户端主动退出时发给对手的消息相同，对手的界面按原来的流程处理
+    send_msg(c->info.opponent,"OR");
+    
+    // 断开时由close_client调用E_signal退出房间（对手成为房主）
+    mark_closing(c);
+}
+
+/* ==================== 权威棋盘 ==================== */
+
+/*
+ * 房间的对局状态只由服务器维护，客户端发来的对战消息都要先经过game_check：
+ * - 落子：必须在对局中、没有待应答的悔棋、轮到发送者，且落在空位上；五连或下满时结束对局
+ * - 悔棋请求：对局中且棋盘不为空；应答：只接受被请求一方的应答，同意时按客户端相同的规则撤销
+ *   （轮到请求方时撤销两步，否则撤销一步，撤销后总是轮到请求方）
+ * - 认输、退出：结束对局
+ * 不合法的消息直接丢弃，不转发给对手；改变了对局状态的消息同时记入对局日志并推送给观众（game_event）
+ */
+
+/**
+ * @brief 连接在房间对局中的颜色，尚未选定先后手时为stone_none
+ */
+int player_color(room_information* room,connection* c)
+{
+    if(room->black_fd<0)
+        return stone_none;
+    return c->fd==room->black_fd?stone_black:stone_white;
+}
+
+void journal_event(room_id_t room,int kind,uint32_t value)
+{
+    if(!journal.is_open())
+        return;
+    journal_record r;
+    r.kind=kind;
+    r.room=room;
+    r.value=value;
+    journal_append(journal_batch,r);
+}
+
+void journal_start(room_id_t id,room_information* room)
+{
+    if(!journal.is_open())
+        return;
+    journal_record r;
+    r.kind=jk_start;
+    r.room=id;
+    r.time=time(NULL);
+    r.rule=room->board.rule();
+    int fds[2]={room->master_fd,room->client_fd};
+    for(int i=0;i<2;i++)
+    {
+        connection* p=conns.find(fds[i]);
+        if(p)
+        {
+            r.ip[i]=p->addr.sin_addr.s_addr;
+            r.port[i]=ntohs(p->addr.sin_port);
+        }
+    }
+    journal_append(journal_batch,r);
+}
+
+void game_event(room_id_t id,int kind,uint32_t value)
+{
+    if(kind==jk_start)
+        journal_start(id,rooms.find(id));
+    else
+        journal_event(id,kind,value);
+    watch_event(id,kind,value);
+    
+    // 选定先后手之后结束的对局计入等级分：认输、离开时记录的是输的一方
+    if(kind==jk_result)
+        rate_game(rooms.find(id),value);
+    else if((kind==jk_surrender||kind==jk_leave)&&(int)value!=stone_none)
+        rate_game(rooms.find(id),value==stone_black?stone_white:stone_black);
+}
+
+void rate_game(room_information* room,int winner)
+{
+    if(!room||room->player_ip[0]==room->player_ip[1])
+        return;
+    lock_guard<mutex> lock(rating_mutex);
+    int &black=ratings.insert(make_pair(room->player_ip[stone_black],match_rating_initial)).first->second;
+    int &white=ratings.insert(make_pair(room->player_ip[stone_white],match_rating_initial)).first->second;
+    elo_update(black,white,winner==stone_black?1:winner==stone_white?0:0.5);
+}
+
+bool game_check(connection* c,int op,int arg,int &outcome)
+{
+    outcome=-1;
+    connection* opponent=c->info.opponent;
+    room_information* room=opponent?rooms.find(c->info.room_id):NULL;
+    if(!room)
+        return false;
+    
+    switch(op)
+    {
+        case op_move:
+        {
+            if(room->phase!=phase_play||room->back_fd!=-1)
+                return false;
+            if((room->board.to_move()==stone_black)!=(c->fd==room->black_fd))
+                return false;
+            int result=room->board.play(arg);
+            if(result<0)            // 非法落子，或连珠规则下黑方的禁手
+                return false;
+            game_event(c->info.room_id,jk_move,arg);
+            if(result!=play_ok)
+            {
+                room->phase=phase_idle;
+                outcome=result==play_five?room->board.at(arg):2;
+                game_event(c->info.room_id,jk_result,outcome);
+            }
+            return true;
+        }
+        case op_back:
+        {
+            if(room->phase!=phase_play||room->back_fd!=-1||room->board.moves()==0)
+                return false;
+            room->back_fd=c->fd;
+            return true;
+        }
+        case op_back_reply:
+        {
+            if(room->phase!=phase_play||room->back_fd!=opponent->fd||arg<0)
+                return false;
+            room->back_fd=-1;
+            if(arg)
+            {
+                // 轮到发起方时撤销双方各一步，否则只撤销发起方的一步；只按实际撤销的步数记录
+                // （白方在黑方只下了一步时悔棋，棋盘上只有一步可撤，与客户端的处理相同）
+                bool requester_black=opponent->fd==room->black_fd;
+                int count=0;
+                if((room->board.to_move()==stone_black)==requester_black)
+                    count+=room->board.undo();
+                count+=room->board.undo();
+                if(count>0)
+                    game_event(c->info.room_id,jk_undo,count);
+            }
+            return true;
+        }
+        case op_surrender:
+        {
+            if(room->phase!=phase_play)
+                return false;
+            room->phase=phase_idle;
+            game_event(c->info.room_id,jk_surrender,player_color(room,c));
+            return true;
+        }
+        case op_leave:
+        {
+            if(room->phase!=phase_idle)
+                game_event(c->info.room_id,jk_leave,player_color(room,c));
+            room->phase=phase_idle;
+            return true;
+        }
+        case op_chat:
+            return true;
+    }
+    return false;
+}
+
+void game_over(connection* c,int outcome)
+{
+    char msg[4]={'W',(char)('0'+outcome),'\0'};
+    send_msg(c,msg);
+    send_msg(c->info.opponent,msg);
+}
+
+/* ==================== io_uring后端 ==================== */
+
+/*
+ * 与epoll后端共用全部处理函数，只替换等待事件和读写套接字的方式：
+ * - 监听套接字一个多次接受请求，eventfd和timerfd各一个多次poll请求
+ * - 每个连接一个多次接收请求，数据写入内核从缓冲区环中挑选的缓冲区，追加到输入缓冲区后立即归还
+ * - 每个连接同一时刻最多一个发送请求，发送期间新的输出继续在输出队列中累积，完成后整体再发
+ * - 一轮中产生的所有请求在下一次io_uring_enter时一次提交，同时等待新的完成事件
+ *
+ * 完成事件的user_data编码为 类型(8位) | 代数(24位) | fd(32位)。
+ * fd关闭后可能立即被新连接复用，代数与当前不同的完成事件属于已关闭的旧连接，直接丢弃
+ */
+
+enum uring_kind
+{
+    ud_accept=1,    // 多次接受连接
+    ud_event,       // eventfd可读（多次poll）
+    ud_recv,        // 多次接收
+    ud_send,        // 发送
+    ud_cancel,      // 取消接收（结果不需要处理）
+    ud_timer        // timerfd可读（多次poll）
+};
+
+const unsigned uring_entries=4096;          // 提交队列长度
+const unsigned uring_cq_entries=16384;      // 完成队列长度
+const unsigned uring_buffers=1024;          // 接收缓冲区个数
+const unsigned uring_buffer_size=4096;      // 每个接收缓冲区的字节数
+const unsigned short uring_group=0;         // 接收缓冲区组编号
+const uint32_t uring_gen_mask=0xffffff;     // user_data中代数的位数
+
+/**
+ * @brief 每个fd在io_uring后端中的请求状态
+ * 
+ * 不随连接关闭而清除：旧连接在途的发送请求仍在使用data，要等它的完成事件到来
+ */
+struct uring_slot
+{
+    uint32_t gen;           // 代数：fd上的连接每关闭或移交一次加一
+    bool recv_armed;        // 当前连接的多次接收请求仍然有效
+    bool cancelling;        // 已提交取消接收的请求
+    bool sending;           // 有发送请求在途（可能属于已关闭的旧连接）
+    string data;            // 在途发送的数据，发送完成前不能改动
+    shared_ptr<const string> shared;    // 在途发送的是共享数据段时持有它的引用（此时不用data）
+    size_t off;             // 在途数据中已发送的字节数
+    
+    uring_slot():gen(0),recv_armed(false),cancelling(false),sending(false),off(0){}
+    
+    const string& bytes() const { return shared?*shared:data; }
+};
+
+thread_local io_ring ring;//本线程的io_uring实例
+
+/**
+ * @brief fd -> 请求状态
+ * 
+ * 使用deque：扩容时已有元素不移动，在途发送引用的data地址保持不变
+ */
+thread_local deque<uring_slot>uring_slots;
+
+uring_slot& uring_slot_of(int fd)
+{
+    if((size_t)fd>=uring_slots.size())
+        uring_slots.resize(fd+1);
+    return uring_slots[fd];
+}
+
+/**
+ * @brief 生成请求的user_data（带上fd当前的代数）
+ */
+uint64_t uring_ud(int kind,int fd)
+{
+    return ((uint64_t)kind<<56)|((uint64_t)uring_slot_of(fd).gen<<32)|(uint32_t)fd;
+}
+
+bool uring_setup()
+{
+    if(!ring.init(uring_entries,uring_cq_entries))
+        return false;
+    if(!ring.setup_buffers(uring_group,uring_buffers,uring_buffer_size))
+        return false;
+    uring_backend=true;
+    return true;
+}
+
+/**
+ * @brief 提交连接的多次接收请求（已提交、暂停读取、即将断开或迁移时什么也不做）
+ * @param c 客户端连接
+ */
+void uring_arm(connection* c)
+{
+    uring_slot &s=uring_slot_of(c->fd);
+    if(s.recv_armed||c->buf.paused||c->buf.closing||c->buf.migrate_to>=0)
+        return;
+    ring.recv_multishot(c->fd,uring_ud(ud_recv,c->fd));
+    s.recv_armed=true;
+    s.cancelling=false;
+}
+
+/**
+ * @brief 取消连接的多次接收请求（已提交过取消时不重复提交）
+ * @param c 客户端连接
+ */
+void uring_cancel(connection* c)
+{
+    uring_slot &s=uring_slot_of(c->fd);
+    if(!s.recv_armed||s.cancelling)
+        return;
+    ring.cancel(uring_ud(ud_recv,c->fd),(uint64_t)ud_cancel<<56);
+    s.cancelling=true;
+}
+
+bool uring_read(connection* c)
+{
+    // 暂停读取期间，接收请求取消之前收到的数据留在输入缓冲区中，恢复时先处理
+    if(c->buf.paused||c->buf.closing||c->buf.migrate_to>=0)
+        return false;
+    if(!c->buf.in.empty()&&!dispatch_frames(c))
+        return true;
+    uring_arm(c);
+    return false;
+}
+
+bool uring_send(connection* c)
+{
+    client_buffer &buf=c->buf;
+    uring_slot &s=uring_slot_of(c->fd);
+    if(s.sending||(buf.shared.empty()&&buf.out.size()==buf.out_off))
+        return true;
+    
+    // 共享数据段排在前面：按段逐个发送，发送请求持有引用直到完成
+    if(!buf.shared.empty())
+    {
+        shared_output &seg=buf.shared.front();
+        s.shared=seg.data;
+        s.off=seg.off;
+        buf.shared_bytes-=seg.data->size()-seg.off;
+        buf.shared.pop_front();
+        buf.in_flight=s.shared->size()-s.off;
+        s.sending=true;
+        stats->writes.add();
+        ring.send(c->fd,s.shared->data()+s.off,s.shared->size()-s.off,uring_ud(ud_send,c->fd));
+        return true;
+    }
+    
+    // 输出队列整体移交给发送请求（交换字符串，不复制），之后的输出重新累积
+    if(buf.out_off==0)
+        s.data.swap(buf.out);
+    else
+        s.data.assign(buf.out,buf.out_off,string::npos);
+    buf.out.clear();
+    buf.out_off=0;
+    buf.in_flight=s.data.size();
+    s.off=0;
+    s.sending=true;
+    stats->writes.add();
+    ring.send(c->fd,s.data.data(),s.data.size(),uring_ud(ud_send,c->fd));
+    return true;
+}
+
+bool uring_release(connection* c,bool closing)
+{
+    uring_slot &s=uring_slot_of(c->fd);
+    uring_cancel(c);
+    if(!closing&&(s.recv_armed||s.sending))
+        return false;
+    
+    // 之后到来的完成事件代数不同，按旧连接丢弃
+    s.gen=(s.gen+1)&uring_gen_mask;
+    s.recv_armed=false;
+    s.cancelling=false;
+    return true;
+}
+
+/**
+ * @brief 连接的接收请求结束或发送完成后，继续读取，或者在请求全部结束后移交给目标线程
+ * @param c 客户端连接
+ */
+void uring_resume(connection* c)
+{
+    uring_slot &s=uring_slot_of(c->fd);
+    if(c->buf.closing)
+        return;
+    if(c->buf.migrate_to>=0)
+    {
+        if(!s.recv_armed&&!s.sending)
+            migrating_fds.push_back(c->fd);
+        return;
+    }
+    if(!s.recv_armed&&read_client(c))
+        mark_closing(c);
+}
+
+/**
+ * @brief 处理接收请求的完成事件
+ * @param fd 客户端套接字
+ * @param gen 请求提交时的代数
+ * @param res 收到的字节数（0为对端关闭，负数为错误码）
+ * @param flags 完成事件标志（含缓冲区编号）
+ */
+void uring_received(int fd,uint32_t gen,int res,uint32_t flags)
+{
+    uring_slot &s=uring_slot_of(fd);
+    connection* c=gen==s.gen?conns.find(fd):NULL;
+    if(c&&!(flags&IORING_CQE_F_MORE))     // 多次接收请求已结束
+    {
+        s.recv_armed=false;
+        s.cancelling=false;
+    }
+    
+    // 数据追加到输入缓冲区后立即归还缓冲区
+    if(flags&IORING_CQE_F_BUFFER)
+    {
+        unsigned short bid=(unsigned short)(flags>>IORING_CQE_BUFFER_SHIFT);
+        if(c&&res>0)
+        {
+            stats->bytes_in.add(res);
+            c->buf.in.append(ring.buffer(bid),res);
+        }
+        ring.recycle(bid);
+    }
+    if(!c)
+        return;
+    
+    // 对端关闭连接或读取错误（缓冲区用完、被取消时只需重新提交）
+    if(res==0||(res<0&&res!=-ENOBUFS&&res!=-ECANCELED))
+    {
+        mark_closing(c);
+        return;
+    }
+    
+    if(res>0)
+    {
+        // 暂停读取、即将断开或迁移：数据留在输入缓冲区，取消接收请求
+        if(c->buf.paused||c->buf.closing||c->buf.migrate_to>=0)
+            uring_cancel(c);
+        else if(!dispatch_frames(c))
+        {
+            mark_closing(c);
+            return;
+        }
+    }
+    uring_resume(c);
+}
+
+/**
+ * @brief 处理发送请求的完成事件
+ * @param fd 客户端套接字
+ * @param gen 请求提交时的代数
+ * @param res 发送的字节数（负数为错误码）
+ */
+void uring_sent(int fd,uint32_t gen,int res)
+{
+    uring_slot &s=uring_slot_of(fd);
+    connection* c=gen==s.gen?conns.find(fd):NULL;
+    
+    if(res>0)
+        stats->bytes_out.add(res);
+    
+    // 只发出了一部分：继续发送剩余部分
+    const string &bytes=s.bytes();
+    if(c&&res>0&&s.off+res<bytes.size())
+    {
+        stats->short_writes.add();
+        stats->writes.add();
+        s.off+=res;
+        c->buf.in_flight=bytes.size()-s.off;
+        ring.send(fd,bytes.data()+s.off,bytes.size()-s.off,uring_ud(ud_send,fd));
+        return;
+    }
+    
+    s.sending=false;
+    s.data.clear();
+    s.shared.reset();
+    s.off=0;
+    if(c)
+    {
+        c->buf.in_flight=0;
+        if(res<0)       // 发送出错（如对端已重置连接）
+        {
+            mark_closing(c);
+            return;
+        }
+        if(c->buf.pending()==0)
+            relay_done(c);
+    }
+    
+    // 发送期间累积的输出（fd已被新连接复用时，新连接的输出也在等这次发送结束）
+    c=conns.find(fd);
+    if(!c||c->buf.closing)
+        return;
+    flush_client(c);
+    uring_resume(c);
+}
+
+/**
+ * @brief 处理一个完成事件
+ * @param cqe 完成事件
+ * @param server_fd 监听套接字
+ * @param event_fd 唤醒本线程的eventfd
+ */
+void uring_complete(const struct io_uring_cqe &cqe,int server_fd,int event_fd)
+{
+    int kind=(int)(cqe.user_data>>56);
+    uint32_t gen=(uint32_t)(cqe.user_data>>32)&uring_gen_mask;
+    int fd=(int)(uint32_t)cqe.user_data;
+    bool more=cqe.flags&IORING_CQE_F_MORE;
+    
+    switch(kind)
+    {
+        case ud_accept:
+        {
+            if(cqe.res>=0)
+            {
+                struct sockaddr_in client_addr;
+                socklen_t client_sz=sizeof(client_addr);
+                memset(&client_addr,0,sizeof(client_addr));
+                getpeername(cqe.res,(struct sockaddr*)&client_addr,&client_sz);
+                accept_client(cqe.res,client_addr);
+            }
+            else if(cqe.res==-EMFILE||cqe.res==-ENFILE)
+                drop_connection(server_fd);
+            
+            // 多次接受请求出错后会结束，重新提交
+            if(!more)
+                ring.accept_multishot(server_fd,(uint64_t)ud_accept<<56);
+        }break;
+        case ud_event:
+        {
+            adopt_clients();
+            if(!more)
+                ring.poll_multishot(event_fd,(uint64_t)ud_event<<56);
+        }break;
+        case ud_timer:
+        {
+            run_timers();
+            if(!more)
+                ring.poll_multishot(timer_fd,(uint64_t)ud_timer<<56);
+        }break;
+        case ud_recv:uring_received(fd,gen,cqe.res,cqe.flags);break;
+        case ud_send:uring_sent(fd,gen,cqe.res);break;
+    }
+}
+
+void uring_loop(int server_fd,int event_fd)
+{
+    ring.accept_multishot(server_fd,(uint64_t)ud_accept<<56);
+    ring.poll_multishot(event_fd,(uint64_t)ud_event<<56);
+    ring.poll_multishot(timer_fd,(uint64_t)ud_timer<<56);
+    
+    while(1)
+    {
+        // 一次系统调用：提交上一轮产生的所有请求（接收、发送、取消），并等待至少一个完成事件
+        if(ring.submit(1)<0&&errno!=EINTR&&errno!=EBUSY)
+            Error_msg("io_uring_enter");
+        loop_start=metrics_now_ns();
+        
+        // 处理所有已完成的事件（先复制再移除，处理过程中可能提交新请求）
+        struct io_uring_cqe* cqe;
+        while((cqe=ring.peek())!=NULL)
+        {
+            struct io_uring_cqe ev=*cqe;
+            ring.seen();
+            uring_complete(ev,server_fd,event_fd);
+        }
+        
+        // 本轮结束：批量刷新输出（生成发送请求）并关闭待断开的连接
+        flush_pending();
+        stats->loop_lag.record(metrics_now_ns()-loop_start);
+    }
+}
+
+void watch_client(connection* c)
+{
+    if(uring_backend)
+    {
+        uring_arm(c);
+        return;
+    }
+    
+    // 配置客户端套接字的epoll事件：可读事件 + 边缘触发模式
+    // （边缘触发模式下，ADD时若已可读会立即通知）
+    struct epoll_event event;
+    event.data.fd=c->fd;
+    event.events=EPOLLIN|EPOLLET;
+    epoll_ctl(epoll_fd,EPOLL_CTL_ADD,c->fd,&event);
+}
+
+/* ==================== 大厅目录 ==================== */
+
+/*
+ * 以下函数修改大厅目录，调用时需持有lobby_mutex
+ * 每次修改都同步维护空闲房间数、使快照失效，并向订阅者发布增量事件
+ */
+
+/**
+ * @brief 发布一条大厅事件到所有有订阅者的线程
+ * @param kind 事件类型（'+'、'f'、'-'）
+ * @param id 房间ID
+ * @param entry 房间条目（kind为'+'时使用）
+ */
+void lobby_publish(char kind,room_id_t id,const lobby_room* entry)
+{
+    lobby_event ev;
+    char head[32];
+    snprintf(head,sizeof(head),"L%c%llu",kind,(unsigned long long)id);
+    ev.kind=kind;
+    ev.id=id;
+    ev.frame=head;
+    if(kind=='+')
+        ev.frame.append(1,'/').append(entry->master_ip).append(1,'/').append(entry->room_name);
+    ev.frame+='\n';
+    
+    for(size_t i=0;i<reactors.size();i++)
+    {
+        if(reactors[i]->subscribers==0)
+            continue;
+        reactors[i]->lobby_inbox.push_back(ev);
+        reactors[i]->lobby_pending=true;
+    }
+    lobby_touched=true;
+}
+
+/**
+ * @brief 登记新房间
+ * @param id 房间ID
+ * @param entry 房间条目
+ */
+void lobby_insert(room_id_t id,const lobby_room &entry)
+{
+    lobby[id]=entry;
+    if(!entry.full)
+    {
+        free_rooms++;
+        free_index.insert(entry.room_name,id);
+        lobby_publish('+',id,&entry);
+    }
+    lobby_snapshot.reset();
+}
+
+/**
+ * @brief 注销房间
+ * @param id 房间ID
+ */
+void lobby_erase(room_id_t id)
+{
+    map<room_id_t,lobby_room>::iterator it=lobby.find(id);
+    if(it==lobby.end())
+        return;
+    if(!it->second.full)    // 已满的房间不在订阅者的列表中，无需通知
+    {
+        free_rooms--;
+        free_index.erase(it->second.room_name,id);
+        lobby_publish('-',id,NULL);
+    }
+    lobby.erase(it);
+    lobby_snapshot.reset();
+}
+
+/**
+ * @brief 更新房间条目（是否已满、房主IP）
+ * @param id 房间ID
+ * @param full 房间是否已有客人
+ * @param master_ip 新的房主IP（NULL表示不变）
+ */
+void lobby_update(room_id_t id,bool full,const char* master_ip)
+{
+    map<room_id_t,lobby_room>::iterator it=lobby.find(id);
+    if(it==lobby.end())
+        return;
+    if(it->second.full!=full)
+    {
+        free_rooms+=full?-1:1;
+        if(full)
+            free_index.erase(it->second.room_name,id);
+        else
+            free_index.insert(it->second.room_name,id);
+    }
+    it->second.full=full;
+    if(master_ip)
+        it->second.master_ip=master_ip;
+    lobby_publish(full?'f':'+',id,&it->second);
+    lobby_snapshot.reset();
+}
+
+/**
+ * @brief 按需重建大厅快照
+ * @return shared_ptr<const lobby_cache> 当前快照
+ */
+shared_ptr<const lobby_cache> lobby_frames()
+{
+    if(lobby_snapshot)
+        return lobby_snapshot;
+    
+    lobby_cache *frames=new lobby_cache;
+    frames->list.reserve(free_rooms*48);
+    frames->sync.reserve(free_rooms*48);
+    char id[24];
+    for(map<room_id_t,lobby_room>::iterator it=lobby.begin();it!=lobby.end();it++)
+    {
+        if(it->second.full)     // 只列出空闲房间
+            continue;
+        snprintf(id,sizeof(id),"%llu",(unsigned long long)it->first);
+        // 格式: /N{房间名}\n/I{IP地址}\n/F{房间ID}\n
+        frames->list.append("/N").append(it->second.room_name).append(1,'\n');
+        frames->list.append("/I").append(it->second.master_ip).append(1,'\n');
+        frames->list.append("/F").append(id).append(1,'\n');
+        // 格式: L+{房间ID}/{IP地址}/{房间名}\n
+        frames->sync.append("L+").append(id).append(1,'/').append(it->second.master_ip)
+            .append(1,'/').append(it->second.room_name).append(1,'\n');
+    }
+    proto_from_frames(frames->sync.data(),frames->sync.size(),frames->sync_bin);
+    lobby_snapshot.reset(frames);
+    return lobby_snapshot;
+}
+
+/* ==================== 大厅推送 ==================== */
+
+/**
+ * @brief 取出本线程待推送的大厅事件并合并（调用时需持有lobby_mutex）
+ * @param batch 输出：合并后的帧
+ * 
+ * 同一房间在一轮中的多条事件只保留最后一条；
+ * 本轮新出现又被占满或关闭的房间，订阅者从未见过，整条省略。
+ * 在线人数或空闲房间数与上次推送的不同时追加 L#{在线人数}/{空闲房间数}
+ */
+void lobby_collect(string &batch)
+{
+    reactor &self=*reactors[reactor_id];
+    vector<lobby_event>events;
+    events.swap(self.lobby_inbox);
+    self.lobby_pending=false;
+    
+    if(events.size()==1)
+        batch+=events[0].frame;
+    else if(!events.empty())
+    {
+        // 房间ID -> (本轮第一条事件类型, 最后一条事件下标)
+        unordered_map<room_id_t,pair<char,size_t> >seen;
+        for(size_t i=0;i<events.size();i++)
+        {
+            unordered_map<room_id_t,pair<char,size_t> >::iterator it=seen.find(events[i].id);
+            if(it==seen.end())
+                seen[events[i].id]=make_pair(events[i].kind,i);
+            else
+                it->second.second=i;
+        }
+        for(size_t i=0;i<events.size();i++)
+        {
+            pair<char,size_t> &e=seen[events[i].id];
+            if(e.second!=i)
+                continue;
+            if(e.first=='+'&&events[i].kind!='+')
+                continue;
+            batch+=events[i].frame;
+        }
+    }
+    
+    int online=online_count.load();
+    if(online!=last_online||free_rooms!=last_free)
+    {
+        char msg[64];
+        snprintf(msg,sizeof(msg),"L#%d/%d\n",online,free_rooms);
+        batch+=msg;
+        last_online=online;
+        last_free=free_rooms;
+    }
+}
+
+/**
+ * @brief 把本轮合并后的大厅事件推送给本线程的订阅者（每轮结束时执行）
+ */
+void lobby_deliver()
+{
+    if(lobby_subs.empty())
+        return;
+    reactor &self=*reactors[reactor_id];
+    if(!self.lobby_pending&&online_count.load()==last_online)
+        return;
+    
+    string batch;
+    {
+        lock_guard<mutex> lock(lobby_mutex);
+        lobby_collect(batch);
+    }
+    if(batch.empty())
+        return;
+    lobby_broadcast(batch);
+}
+
+void lobby_broadcast(const string &batch)
+{
+    string bin;
+    for(size_t i=0;i<lobby_subs.size();i++)
+    {
+        connection* c=lobby_subs[i];
+        if(c->buf.version<2)
+        {
+            send_frames(c,batch.data(),batch.size());
+            continue;
+        }
+        if(bin.empty())
+            proto_from_frames(batch.data(),batch.size(),bin);
+        send_binary(c,bin.data(),bin.size());
+    }
+}
+
+/**
+ * @brief 本轮产生了大厅变化时，唤醒其他有订阅者的线程推送（每轮结束时执行）
+ */
+void lobby_wake()
+{
+    if(!lobby_touched)
+        return;
+    lobby_touched=false;
+    
+    uint64_t one=1;
+    for(size_t i=0;i<reactors.size();i++)
+    {
+        if(i!=(size_t)reactor_id&&reactors[i]->subscribers>0)
+            write(reactors[i]->event_fd,&one,sizeof(one));
+    }
+}
+
+/**
+ * @brief 退订大厅推送（未订阅时什么也不做）
+ * @param c 客户端连接
+ */
+void lobby_unsubscribe(connection* c)
+{
+    if(c->sub_pos<0)
+        return;
+    connection* last=lobby_subs.back();
+    lobby_subs[c->sub_pos]=last;
+    last->sub_pos=c->sub_pos;
+    lobby_subs.pop_back();
+    c->sub_pos=-1;
+    reactors[reactor_id]->subscribers--;
+}
+
+/* ==================== 观战 ==================== */
+
+/*
+ * 观众不占房间的座位，房间记录观众列表，观众的连接记录所观战的房间（两者在同一个反应堆线程上，
+ * 观战其他线程的房间时与加入房间一样先迁移连接）。推送给观众的帧：
+ * - GS{房间ID}/{规则}/{阶段}/{落子序列}  棋盘快照（阶段见game_phase，落子序列黑先，每步两个坐标字符，同OM）：
+ *                                      开始观战、开局、选定先后手和积压后恢复时发送
+ * - GM{x}{y}   落子
+ * - GB{步数}   同意悔棋后撤销的步数
+ * - GW{胜方}   对局结束：1黑胜 0白胜 2和棋（认输、离开时为对方胜，选定先后手之前离开为2）
+ * - G-         房间已关闭，观战结束
+ *
+ * 一轮中一个房间的事件先追加到房间的watch_batch，本轮结束时编码一次（文本和二进制各一份，按需生成），
+ * 以共享数据段排入每个观众的输出队列，所有观众引用同一块内存，推送的开销与观众数成正比而与事件的字节数无关。
+ * 输出队列超过--watch-lag的观众不再接收后续事件（不会无限积压，也不会因为超过高水位被断开），
+ * 队列回落到低水位以下时补发一次快照后恢复逐条推送
+ */
+
+/**
+ * @brief 把房间当前棋盘的快照（GS帧）追加到out
+ */
+void watch_snapshot(room_id_t id,room_information* room,string &out)
+{
+    char head[64];
+    int len=snprintf(head,sizeof(head),"GS%llu/%d/%d/",(unsigned long long)id,room->board.rule(),room->phase);
+    out.append(head,len);
+    for(int i=0;i<room->board.moves();i++)
+    {
+        out+=proto_coord_char(room->board.move(i)/board_size);
+        out+=proto_coord_char(room->board.move(i)%board_size);
+    }
+    out+='\n';
+}
+
+void watch_event(room_id_t id,int kind,uint32_t value)
+{
+    room_information* room=rooms.find(id);
+    if(!room||room->watchers.empty())
+        return;
+    if(room->watch_batch.empty())
+        watch_rooms.push_back(id);
+    
+    char msg[16];
+    switch(kind)
+    {
+        case jk_start:
+        case jk_color:
+            watch_snapshot(id,room,room->watch_batch);
+            return;
+        case jk_move:
+            msg[0]='G';
+            msg[1]='M';
+            msg[2]=proto_coord_char(value/board_size);
+            msg[3]=proto_coord_char(value%board_size);
+            msg[4]='\0';
+            break;
+        case jk_undo:snprintf(msg,sizeof(msg),"GB%u",value);break;
+        case jk_result:snprintf(msg,sizeof(msg),"GW%u",value);break;
+        default:        // 认输、离开：对方胜
+            snprintf(msg,sizeof(msg),"GW%d",(int)value==stone_black?stone_white:(int)value==stone_white?stone_black:2);
+            break;
+    }
+    room->watch_batch.append(msg).append(1,'\n');
+}
+
+/**
+ * @brief 把房间积累的观战事件编码一次，以共享数据段推送给所有未积压的观众
+ */
+void watch_flush(room_information* room)
+{
+    if(room->watch_batch.empty())
+        return;
+    shared_ptr<const string> text=make_shared<const string>(std::move(room->watch_batch));
+    shared_ptr<const string> bin;
+    room->watch_batch.clear();
+    
+    for(size_t i=0;i<room->watchers.size();i++)
+    {
+        connection* w=room->watchers[i];
+        if(w->watch_lag)
+            continue;
+        if(w->buf.version<2)
+            send_shared(w,text);
+        else
+        {
+            if(!bin)
+            {
+                string frames;
+                proto_from_frames(text->data(),text->size(),frames);
+                bin=make_shared<const string>(std::move(frames));
+            }
+            send_shared(w,bin);
+        }
+        
+        // 跟不上的观众：停止逐条推送，等输出队列回落后补发快照
+        if(w->buf.pending()>options.watch_lag)
+            w->watch_lag=true;
+    }
+}
+
+void watch_deliver()
+{
+    for(size_t i=0;i<watch_rooms.size();i++)
+    {
+        room_information* room=rooms.find(watch_rooms[i]);
+        if(room)
+            watch_flush(room);
+    }
+    watch_rooms.clear();
+}
+
+void watch_resync(connection* c)
+{
+    room_information* room=c->watch_room?rooms.find(c->watch_room):NULL;
+    if(!room)
+    {
+        c->watch_lag=false;
+        return;
+    }
+    
+    // 本轮还没推送的事件先推给其他观众（c仍处于积压状态，不会收到），快照已经包含这些事件
+    watch_flush(room);
+    c->watch_lag=false;
+    
+    string snapshot;
+    watch_snapshot(c->watch_room,room,snapshot);
+    send_frames(c,snapshot.data(),snapshot.size());
+}
+
+void watch_leave(connection* c)
+{
+    if(!c->watch_room)
+        return;
+    room_information* room=rooms.find(c->watch_room);
+    if(room)
+    {
+        connection* last=room->watchers.back();
+        room->watchers[c->watch_pos]=last;
+        last->watch_pos=c->watch_pos;
+        room->watchers.pop_back();
+    }
+    c->watch_room=0;
+    c->watch_pos=-1;
+    c->watch_lag=false;
+}
+
+/**
+ * @brief 房间关闭：推送剩余的事件和G-，观众全部结束观战
+ */
+void watch_close(room_information* room)
+{
+    if(room->watchers.empty())
+        return;
+    watch_flush(room);
+    vector<connection*> watchers;
+    watchers.swap(room->watchers);
+    for(size_t i=0;i<watchers.size();i++)
+    {
+        connection* w=watchers[i];
+        w->watch_room=0;
+        w->watch_pos=-1;
+        w->watch_lag=false;
+        send_msg(w,"G-");
+    }
+}
+
+/**
+ * @brief 客户端IP转换为点分十进制字符串
+ * @param c 客户端连接
+ */
+string peer_ip(connection* c)
+{
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET,&c->addr.sin_addr,ip,sizeof(ip));
+    return ip;
+}
+
+/* ==================== 快速匹配 ==================== */
+
+/*
+ * 玩家发送M后进入匹配队列（其他线程上的玩家先迁移到匹配线程），排队期间不按空闲时间断开。
+ * 新排队的玩家立即用初始窗口找对手，之后每个刻度推进一次队列，窗口到期放宽的玩家重新找对手（见match_queue.h）。
+ * 配对后直接在匹配线程上建房：等得久的一方做房主，双方已在房间中，不需要再创建、刷新和加入；
+ * 房间登记到大厅目录时已满，可以观战，客人离开后与普通房间一样变为空闲。发给玩家的帧：
+ * - MQ{等级分}/{排队人数}           已排队（重复排队同一种规则时再次回复）
+ * - MF{房间ID}/{1房主 0客人}/{对手等级分}  配对成功，已进入房间，之后与普通房间相同（准备、选先后手……）
+ */
+
+const char match_room_name[]="快速匹配";//快速匹配房间的名称
+
+/**
+ * @brief 玩家的等级分
+ */
+int player_rating(connection* c)
+{
+    lock_guard<mutex> lock(rating_mutex);
+    unordered_map<uint32_t,int>::iterator it=ratings.find(c->addr.sin_addr.s_addr);
+    return it==ratings.end()?match_rating_initial:it->second;
+}
+
+/**
+ * @brief 配对成功：在匹配线程上建房，双方进入房间并收到MF
+ * @param rule 对局规则
+ * @param p 配对（玩家标识为fd）
+ */
+void match_start(int rule,const match_pair &p)
+{
+    connection* host=conns.find((int)p.host);
+    connection* guest=conns.find((int)p.guest);
+    if(!host||!guest)       // 离开队列与连接状态同步维护，不会发生
+        return;
+    host->match_rule=-1;
+    guest->match_rule=-1;
+    
+    room_information room(match_room_name,host->fd);
+    room.board.set_rule(rule);
+    room.client_fd=guest->fd;
+    room_id_t id=rooms.insert(room);
+    if(id==0)
+    {
+        send_msg(host,"/Zerror");
+        send_msg(guest,"/Zerror");
+        return;
+    }
+    stats->rooms_created.add();
+    
+    // 与房主创建房间、客人加入之后的状态相同
+    host->info.room_id=id;
+    host->info.master=true;
+    host->info.opponent=guest;
+    guest->info.room_id=id;
+    guest->info.opponent=host;
+    touch_client(host);
+    {
+        lobby_room entry;
+        entry.room_name=match_room_name;
+        entry.master_ip=peer_ip(host);
+        entry.full=true;
+        lock_guard<mutex> lock(lobby_mutex);
+        lobby_insert(id,entry);
+    }
+    
+    char msg[64];
+    snprintf(msg,sizeof(msg),"MF%llu/1/%d",(unsigned long long)id,p.guest_rating);
+    send_msg(host,msg);
+    snprintf(msg,sizeof(msg),"MF%llu/0/%d",(unsigned long long)id,p.host_rating);
+    send_msg(guest,msg);
+}
+
+void match_leave(connection* c)
+{
+    if(c->match_rule<0)
+        return;
+    match_queues[c->match_rule].remove(c->fd);
+    c->match_rule=-1;
+}
+
+void match_advance()
+{
+    vector<match_pair> pairs;
+    long long now=now_ms();
+    for(int rule=0;rule<rule_count;rule++)
+    {
+        pairs.clear();
+        match_queues[rule].advance(now,pairs);
+        for(size_t i=0;i<pairs.size();i++)
+            match_start(rule,pairs[i]);
+    }
+}
+
+/* ==================== 运行指标 ==================== */
+
+/*
+ * 热路径上只有本线程的计数器加一（不带lock前缀）；直方图每轮事件循环记录一次循环延迟，
+ * 每次写出带落子的输出队列记录一次转发延迟，各多一次读时钟（vDSO，不进内核）。
+ * 转发延迟从本轮事件循环醒来（读到落子的那一轮）算起，到写出它的write返回为止（io_uring后端为发送完成）；
+ * 对手的输出队列积压时，算到整个队列写完为止。
+ */
+
+void count_msg(const char* msg)
+{
+    int kind=mk_other;
+    switch(msg[0])
+    {
+        case 'O':
+            switch(msg[1])
+            {
+                case 'M':kind=mk_move;break;
+                case 'N':kind=mk_chat;break;
+                case 'B':kind=msg[2]=='\0'?mk_back:mk_back_reply;break;
+                case 'R':kind=mk_leave;break;
+                case 'S':kind=mk_surrender;break;
+            }
+            break;
+        case 'p':if(strcmp(msg,"prepare")==0)kind=mk_prepare;break;
+        case 'c':if(strncmp(msg,"color",5)==0)kind=mk_color;break;
+        case 'H':if(msg[1]=='\0')kind=mk_heartbeat;break;
+        case 'R':kind=mk_refresh;break;
+        case 'C':kind=mk_create;break;
+        case 'E':kind=mk_exit;break;
+        case 'J':kind=mk_join;break;
+        case 'U':kind=mk_update;break;
+        case 'S':kind=mk_subscribe;break;
+        case 'Q':kind=mk_query;break;
+        case 'A':kind=mk_archive;break;
+        case 'G':kind=mk_watch;break;
+        case 'M':kind=mk_match;break;
+    }
+    stats->messages[kind].add();
+}
+
+void relay_mark(connection* c)
+{
+    if(c&&!c->buf.closing&&c->buf.relay_since==0)
+        c->buf.relay_since=loop_start;
+}
+
+void relay_done(connection* c)
+{
+    if(c->buf.relay_since==0)
+        return;
+    stats->relay_latency.record(metrics_now_ns()-c->buf.relay_since);
+    c->buf.relay_since=0;
+}
+
+/**
+ * @brief 汇总所有线程的运行指标，生成Prometheus文本格式
+ * @return string 指标文本
+ */
+string metrics_text()
+{
+    uint64_t accepted=0,closed=0,rooms_created=0,rooms_closed=0,bytes_in=0,bytes_out=0,writes=0,short_writes=0;
+    uint64_t messages[msg_kind_count]={0};
+    histogram_snapshot loop_lag,relay_latency;
+    for(size_t i=0;i<reactors.size();i++)
+    {
+        // 先读关闭数再读创建数，读取期间新建又关闭的房间不会使房间数变成负数
+        const thread_metrics &m=reactors[i]->metrics;
+        rooms_closed+=m.rooms_closed.value();
+        rooms_created+=m.rooms_created.value();
+        closed+=m.closed.value();
+        accepted+=m.accepted.value();
+        bytes_in+=m.bytes_in.value();
+        bytes_out+=m.bytes_out.value();
+        writes+=m.writes.value();
+        short_writes+=m.short_writes.value();
+        for(int k=0;k<msg_kind_count;k++)
+            messages[k]+=m.messages[k].value();
+        loop_lag.merge(m.loop_lag);
+        relay_latency.merge(m.relay_latency);
+    }
+    
+    string out;
+    metrics_family(out,"gobang_connections","gauge","Connected clients.");
+    metrics_sample(out,"gobang_connections",NULL,online_count.load());
+    metrics_family(out,"gobang_connections_accepted_total","counter","Accepted client connections.");
+    metrics_sample(out,"gobang_connections_accepted_total",NULL,(double)accepted);
+    metrics_family(out,"gobang_connections_closed_total","counter","Closed client connections.");
+    metrics_sample(out,"gobang_connections_closed_total",NULL,(double)closed);
+    metrics_family(out,"gobang_rooms","gauge","Open rooms.");
+    metrics_sample(out,"gobang_rooms",NULL,rooms_created-rooms_closed);
+    metrics_family(out,"gobang_rooms_created_total","counter","Created rooms.");
+    metrics_sample(out,"gobang_rooms_created_total",NULL,(double)rooms_created);
+    metrics_family(out,"gobang_messages_total","counter","Received client messages by type.");
+    for(int k=0;k<msg_kind_count;k++)
+    {
+        string label=string("type=\"")+msg_kind_names[k]+"\"";
+        metrics_sample(out,"gobang_messages_total",label.c_str(),(double)messages[k]);
+    }
+    metrics_family(out,"gobang_received_bytes_total","counter","Bytes read from client sockets.");
+    metrics_sample(out,"gobang_received_bytes_total",NULL,(double)bytes_in);
+    metrics_family(out,"gobang_sent_bytes_total","counter","Bytes written to client sockets.");
+    metrics_sample(out,"gobang_sent_bytes_total",NULL,(double)bytes_out);
+    metrics_family(out,"gobang_writes_total","counter","Socket writes (write/writev calls or io_uring send requests).");
+    metrics_sample(out,"gobang_writes_total",NULL,(double)writes);
+    metrics_family(out,"gobang_short_writes_total","counter","Writes that left output queued because the socket send buffer was full.");
+    metrics_sample(out,"gobang_short_writes_total",NULL,(double)short_writes);
+    metrics_histogram(out,"gobang_loop_lag_seconds","Time from event loop wakeup until the iteration's output is flushed.",loop_lag);
+    metrics_histogram(out,"gobang_relay_latency_seconds","Time from reading a move to writing it to the opponent.",relay_latency);
+    return out;
+}
+
+int metrics_listen(const char* where)
+{
+    int fd;
+    if(where[0]=='/')
+    {
+        struct sockaddr_un addr;
+        memset(&addr,0,sizeof(addr));
+        addr.sun_family=AF_UNIX;
+        if(strlen(where)>=sizeof(addr.sun_path))
+            return -1;
+        strcpy(addr.sun_path,where);
+        
+        // 上次运行留下的套接字文件（只删除套接字，不删除同名的普通文件）
+        struct stat st;
+        if(stat(where,&st)==0&&S_ISSOCK(st.st_mode))
+            unlink(where);
+        
+        fd=socket(AF_UNIX,SOCK_STREAM|SOCK_CLOEXEC,0);
+        if(fd>=0&&bind(fd,(struct sockaddr*)&addr,sizeof(addr))==0&&listen(fd,16)==0)
+            return fd;
+    }
+    else
+    {
+        // 只监听本机回环地址，不对外暴露
+        struct sockaddr_in addr;
+        memset(&addr,0,sizeof(addr));
+        addr.sin_family=AF_INET;
+        addr.sin_port=htons(atoi(where));
+        addr.sin_addr.s_addr=htonl(INADDR_LOOPBACK);
+        
+        int optset=1;
+        fd=socket(AF_INET,SOCK_STREAM|SOCK_CLOEXEC,IPPROTO_TCP);
+        if(fd>=0&&setsockopt(fd,SOL_SOCKET,SO_REUSEADDR,&optset,sizeof(optset))==0
+            &&bind(fd,(struct sockaddr*)&addr,sizeof(addr))==0&&listen(fd,16)==0)
+            return fd;
+    }
+    if(fd>=0)
+        close(fd);
+    return -1;
+}
+
+void metrics_serve(int listen_fd)
+{
+    while(1)
+    {
+        int fd=accept4(listen_fd,NULL,NULL,SOCK_CLOEXEC);
+        if(fd<0)
+        {
+            // 描述符耗尽等错误：稍后再试，避免空转
+            if(errno!=EINTR&&errno!=ECONNABORTED)
+                usleep(100000);
             continue;
+        }
         
-        // 动态扩容：如果事件数组满了，扩大一倍
-        if((size_t)event_cnt==events.size())
-            events.resize(events.size()*2);
+        // 读掉请求（不解析，任何请求都回复全部指标），对端不发送或不接收时最多等1秒
+        struct timeval tv;
+        tv.tv_sec=1;
+        tv.tv_usec=0;
+        setsockopt(fd,SOL_SOCKET,SO_RCVTIMEO,&tv,sizeof(tv));
+        setsockopt(fd,SOL_SOCKET,SO_SNDTIMEO,&tv,sizeof(tv));
+        char request[1024];
+        ssize_t ret=read(fd,request,sizeof(request));
+        (void)ret;
         
-        // 遍历所有触发的事件
-        for(int i=0;i<event_cnt;i++)
+        string body=metrics_text();
+        char head[160];
+        snprintf(head,sizeof(head),"HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",body.size());
+        string reply=string(head)+body;
+        size_t off=0;
+        while(off<reply.size())
         {
-            // ========== 处理新客户端连接 ==========
-            if(events[i].data.fd==server_fd)
-            {
-                client_sz=sizeof(client_sz);
-                
-                // accept4: 接受连接并设置非阻塞标志
-                client_fd=accept4(server_fd,(struct sockaddr*)&client_addr,&client_sz,O_NONBLOCK);
-                //client_fd=accept(server_fd,(struct sockaddr*)&client_addr,&client_sz);
-
-                // 接受连接失败处理
-                if(client_fd==-1)
-                {
-                    // EMFILE: 文件描述符耗尽
-                    // 使用预留的idle_fd优雅处理
-                    if(errno==EMFILE)
-                    {
-                        close(idle_fd);                             // 关闭预留fd
-                        idle_fd=accept(server_fd,NULL,NULL);        // 接受连接（会立即获得fd）
-                        close(idle_fd);                             // 关闭该连接
-                        idle_fd=open("/dev/null",O_RDONLY|O_NONBLOCK);  // 重新打开预留fd
-                        continue;
-                    }
-                    else
-                    Error_msg("accept4?");
-                }
-                
-                // 打印新连接信息
-                printf("[%d][Client]<IP:%s><PT:%d><***CONNECT***>\n",__LINE__,inet_ntoa(client_addr.sin_addr),ntohs(client_addr.sin_port));
-                
-                // 保存客户端地址信息
-                client_addrs[client_fd]=client_addr;
-                
-                // 配置客户端套接字的epoll事件
-                event.data.fd=client_fd;
-                event.events=EPOLLIN|EPOLLET;   // 可读事件 + 边缘触发模式
-                
-                // 将客户端套接字添加到epoll监控
-                epoll_ctl(epoll_fd,EPOLL_CTL_ADD,client_fd,&event);
-                
-                // 记录客户端套接字
-                client_fds.push_back(client_fd);
-
-                // 为该客户端创建默认信息记录
-                hash_client[client_fd];//**************r
-            }
-            // ========== 处理客户端消息 ==========
-            else if(events[i].events&EPOLLIN)
-            {
-                client_fd=events[i].data.fd;
-                
-                // 无效套接字，跳过
-                if(client_fd<0)
-                    continue;
-                
-                // 清空消息缓冲区并读取数据
-                memset(msg,0,sizeof(msg));
-                ret=read(client_fd,msg,sizeof(msg));
-
-                // ========== 处理客户端断开连接 ==========
-                // ret <= 0: 连接关闭或读取错误
-                if(ret<=0)
-                {   
-                    printf("[%d][CLient]<FD:%d><***CLOSE***>\n",__LINE__,client_fd);
-                    
-                    // 处理退出房间逻辑
-                    E_signal(client_fd);
-                    
-                    // 关闭套接字
-                    close(client_fd);
-                    
-                    // 从epoll中移除
-                    epoll_ctl(epoll_fd,EPOLL_CTL_DEL,client_fd,NULL);
-
-                    // 从客户端列表中移除
-                   client_fds.erase(remove(client_fds.begin(),client_fds.end(),client_fd),client_fds.end());
-                   continue;
-                }
-                
-                // ========== 处理对战消息（O开头）==========
-                // 'O'开头的消息为opponent消息，需要转发给对手
-                if(msg[0]=='O')//当消息头字母为O时候，代表为opponent消息，此类消息直接原地传回对手客户端处理
-                switch(msg[1])
-                {
-                    case 'M':   // Move: 落子消息
-                    {
-                        // 转发给对手
-                        write(hash_client[client_fd].opponent_fd,msg,strlen(msg));
-                    }break;
-                    case 'B':   // Back: 悔棋消息
-                    {
-                        write(hash_client[client_fd].opponent_fd,msg,strlen(msg));
-                    }break;
-                    case 'N':   // Note: 聊天消息
-                    {
-                        write(hash_client[client_fd].opponent_fd,msg,strlen(msg));
-                    }break;
-                    case 'R':   // Run away: 对手退出消息
-                    {
-                        write(hash_client[client_fd].opponent_fd,msg,strlen(msg));
-                    }break;
-                    case 'S':   // Surrender: 认输消息
-                    {
-                        write(hash_client[client_fd].opponent_fd,msg,strlen(msg));
-                    }
-                }
-                
-                // ========== 处理准备和先后手消息 ==========
-                //以下三个if语句中消息处理分别表示接受到客户端的准备请求（服务器这边会更新准备信息）、原地转发先手并给对手传送后手的消息
-                
-                // 处理准备/取消准备消息
-                if(strcmp(msg,"prepare")==0)
-                {
-                    // 切换准备状态
-                    hash_client[client_fd].prepare=!hash_client[client_fd].prepare;
-                    
-                    // 检查是否双方都已准备
-                    // 条件：己方已准备 && 有对手 && 对手已准备
-                    if(hash_client[client_fd].prepare&&hash_client[client_fd].opponent_fd>0&&hash_client[hash_client[client_fd].opponent_fd].prepare)
-                    {   
-                        // 通知双方游戏开始
-                        //printf("[%d]game_start",__LINE__);
-                        write(client_fd,"/Zstart",strlen("/Zstart"));
-                        write(hash_client[client_fd].opponent_fd,"/Zstart",strlen("/Zstart"));
-                    }
-                }
-                
-                // 处理选择黑棋（先手）消息
-                if(strcmp(msg,"color1")==0)
-                {
-                    // 发送者为黑棋（先手）
-                    write(client_fd,"c1",strlen("c1"));
-                    // 对手为白棋（后手）
-                    write(hash_client[client_fd].opponent_fd,"c0",strlen("c0"));
-                }
-                
-                // 处理选择白棋（后手）消息
-                if(strcmp(msg,"color0")==0)
-                {
-                    // 发送者为白棋（后手）
-                    write(client_fd,"c0",strlen("c0"));
-                    // 对手为黑棋（先手）
-                    write(hash_client[client_fd].opponent_fd,"c1",strlen("c1"));
-                }
-                
-                // ========== 处理系统命令消息 ==========
-                // 这些消息用于游戏开始前的客户端-服务器交互
-                //特殊信息处理，一般是用于游戏开始前的客户端服务端交互
-                switch(msg[0])
-                {
-                    case 'R':R_signal(client_fd);break;     // Refresh: 刷新房间列表
-                    case 'C':C_signal(msg,client_fd);break; // Create: 创建房间
-                    case 'E':E_signal(client_fd);break;     // Exit: 退出房间
-                    case 'J':J_signal(client_fd,msg);break; // Join: 加入房间
-                    case 'U':U_signal(client_fd);break;     // Update: 更新对手状态
-                    //default:break;
-                }
-                
-                // 调试输出（已注释）
-                //printf("[%d][CLient%d]<%d>:%s\n",__LINE__,client_fd,ret,msg);
-                //write(client_fd,msg,strlen(msg));
-            }
+            ret=write(fd,reply.data()+off,reply.size()-off);
+            if(ret>0)
+                off+=ret;
+            else if(ret<0&&errno==EINTR)
+                continue;
+            else
+                break;
         }
+        close(fd);
     }
-    
-    // 清理资源（实际上不会执行到这里，因为是无限循环）
-    close(server_fd);
-    close(epoll_fd);
-    return 0;
 }
 
 /* ==================== 消息处理函数实现 ==================== */
 
 /**
  * @brief 处理刷新房间列表请求（R信号）
- * @param client_fd 发起请求的客户端套接字
+ * @param c 发起请求的客户端连接
  * 
  * 响应流程：
- * 1. 统计空闲房间数量（没有客人加入的房间）
- * 2. 发送在线人数和空闲房间数
- * 3. 对每个空闲房间，发送房间名、房主IP、房主FD
+ * 1. 发送在线人数和空闲房间数（两者都是增量维护的计数，不需要遍历）
+ * 2. 追加大厅快照（所有空闲房间的房间名、房主IP、房间ID）
+ * 
+ * 整个响应追加到输出队列后在本轮结束时一次write写出；
+ * 快照只在房间创建、加入、退出后的第一次刷新时重建
  * 
  * 响应数据格式：
  * - /S{在线人数}/S{空闲房间数}
- * - 对于每个空闲房间：/N{房间名}/I{IP地址}/F{套接字FD}
+ * - 对于每个空闲房间：/N{房间名}/I{IP地址}/F{房间ID}
  */
-void R_signal(int client_fd)
+void R_signal(connection* c)
 {
-    int sum=0;  // 空闲房间计数
-
-    char msg_[1024];
+    char msg_[64];
+    shared_ptr<const lobby_cache>frames;
+    int sum;
     
-    // 统计空闲房间数量
-    // client_fd == -1 表示房间没有客人，即为空闲
-    for(auto x:rooms)
     {
-        if(x.client_fd==-1)
-            sum++;
+        lock_guard<mutex> lock(lobby_mutex);
+        frames=lobby_frames();
+        sum=free_rooms;
     }
     
-    // 发送在线人数和空闲房间数
+    // 释放锁之后再写入输出队列
     // 格式: /S{在线人数}/S{空闲房间数}
-    memset(msg_,0,sizeof(msg_));
-    sprintf(msg_,"/S%ld/S%d",client_fds.size(),sum);
-    //printf("[%d]%d\n",__LINE__,sum);
-    write(client_fd,msg_,strlen(msg_));
+    int len=snprintf(msg_,sizeof(msg_),"/S%d/S%d",online_count.load(),sum);
+    send_msg(c,msg_,len);
+    send_frames(c,frames->list.data(),frames->list.size());
+}
+
+/**
+ * @brief 处理订阅大厅推送请求（S信号）
+ * @param c 发起请求的客户端连接
+ * @param msg "S"订阅（已订阅时重新全量同步），"S1"只订阅增量（配合Q分页查询使用），"S0"退订
+ * 
+ * 订阅后先收到一次全量同步（"S1"时只有L#）：
+ * - L*                           清空列表
+ * - L+{房间ID}/{房主IP}/{房间名}  每个空闲房间一条
+ * - L#{在线人数}/{空闲房间数}
+ * 之后只收到增量事件（见lobby_event），每轮事件循环合并后推送一次。
+ * 创建或加入房间时自动退订
+ */
+void S_signal(connection* c,char* msg)
+{
+    lobby_unsubscribe(c);
+    if(msg[1]=='0')
+        return;
+    
+    reactor &self=*reactors[reactor_id];
+    string batch;
+    shared_ptr<const lobby_cache>frames;
     
-    // 发送每个空闲房间的详细信息
-    for(auto x:rooms)
+    // 快照和订阅登记在同一把锁内完成：之后发布的事件一定进入本线程的待推送队列
     {
-        if(x.client_fd==-1)     // 只发送空闲房间
-        {   
-            // 发送房间名
-            // 格式: /N{房间名}
-            memset(msg_,0,sizeof(msg_));
-            sprintf(msg_,"/N%s",x.room_name.c_str());
-            //printf("[%d]%s\n",__LINE__,msg_);
-            write(client_fd,msg_,strlen(msg_));
-            
-            // 发送房主IP地址
-            // 格式: /I{IP地址}
-            memset(msg_,0,sizeof(msg_));
-            sprintf(msg_,"/I%s",inet_ntoa(client_addrs[x.master_fd].sin_addr));
-            //printf("[%d]%s\n",__LINE__,msg_);
-            write(client_fd,msg_,strlen(msg_));
+        lock_guard<mutex> lock(lobby_mutex);
+        lobby_collect(batch);       // 先把之前的事件推送给已有订阅者，新订阅者不会收到比快照旧的事件
+        frames=lobby_frames();
+        self.subscribers++;
+    }
+    if(!batch.empty())
+        lobby_broadcast(batch);
+    
+    c->sub_pos=lobby_subs.size();
+    lobby_subs.push_back(c);
+    
+    char counts[64];
+    int len=snprintf(counts,sizeof(counts),"L#%d/%d\n",last_online,last_free);
+    if(msg[1]!='1')
+    {
+        send_frames(c,"L*\n",3);
+        if(c->buf.version>=2)
+            send_binary(c,frames->sync_bin.data(),frames->sync_bin.size());
+        else
+            send_frames(c,frames->sync.data(),frames->sync.size());
+    }
+    send_frames(c,counts,len);
+}
+
+/**
+ * @brief 处理分页查询房间列表请求（Q信号）
+ * @param c 发起请求的客户端连接
+ * @param msg 消息字符串，格式为 "Q{偏移}/{条数}/{房间名前缀}"（省略时为第一页、20条、不过滤）
+ * 
+ * 只返回房间名以指定前缀开头的空闲房间中、按房间名排序后的第[偏移, 偏移+条数)个，
+ * 条数最多lobby_page_max；查询走名字索引，开销与页大小成正比，与房间总数无关
+ * 
+ * 响应数据格式（与大厅推送共用L帧，客户端按同一套规则处理）：
+ * - LQ{匹配总数}/{偏移}/{本页条数}
+ * - 本页每个房间：L+{房间ID}/{房主IP}/{房间名}
+ */
+void Q_signal(connection* c,char* msg)
+{
+    // 解析偏移和条数
+    size_t offset=0,limit=20;
+    char* p=msg+1;
+    if(*p>='0'&&*p<='9')
+        offset=strtoul(p,&p,10);
+    if(*p=='/')
+    {
+        p++;
+        if(*p>='0'&&*p<='9')
+            limit=strtoul(p,&p,10);
+    }
+    if(*p=='/')
+        p++;
+    string prefix=p;    // 剩余部分为房间名前缀（可以为空）
+    if(limit>(size_t)lobby_page_max)
+        limit=lobby_page_max;
+    
+    string frames;
+    char head[64];
+    vector<room_id_t>ids;
+    ids.reserve(limit);
+    {
+        lock_guard<mutex> lock(lobby_mutex);
+        size_t total=free_index.page(prefix,offset,limit,ids);
+        snprintf(head,sizeof(head),"LQ%zu/%zu/%zu\n",total,offset,ids.size());
+        frames=head;
+        for(size_t i=0;i<ids.size();i++)
+        {
+            const lobby_room &entry=lobby[ids[i]];
+            snprintf(head,sizeof(head),"L+%llu/",(unsigned long long)ids[i]);
+            frames.append(head).append(entry.master_ip).append(1,'/').append(entry.room_name).append(1,'\n');
+        }
+    }
+    send_frames(c,frames.data(),frames.size());
+}
+
+/**
+ * @brief 当前的归档快照（整理过后重新映射），未配置或无法打开时返回空指针
+ * 
+ * 每次查询stat一次状态文件；整理工具改名替换状态文件，inode或修改时间变化即说明有了新的段
+ */
+shared_ptr<const game_archive> current_archive()
+{
+    if(!options.archive)
+        return shared_ptr<const game_archive>();
+    struct stat st;
+    if(stat(archive_state::path(options.archive).c_str(),&st)!=0)
+        return shared_ptr<const game_archive>();
+    
+    lock_guard<mutex> lock(archive_mutex);
+    if(archive_snapshot&&st.st_ino==archive_state_stat.st_ino&&st.st_mtim.tv_sec==archive_state_stat.st_mtim.tv_sec&&
+       st.st_mtim.tv_nsec==archive_state_stat.st_mtim.tv_nsec)
+        return archive_snapshot;
+    
+    shared_ptr<game_archive> archive=make_shared<game_archive>();
+    if(!archive->open(options.archive))
+    {
+        printf("[%d][Server]<archive %s unavailable>\n",__LINE__,options.archive);
+        return archive_snapshot;    // 继续使用旧的快照（可能为空）
+    }
+    archive_snapshot=archive;
+    archive_state_stat=st;
+    return archive_snapshot;
+}
 
-            // 发送房主套接字FD（用于加入房间时标识目标）
-            // 格式: /F{套接字FD}
-            memset(msg_,0,sizeof(msg_));
-            sprintf(msg_,"/F%d",x.master_fd);
-            //printf("[%d]%s\n",__LINE__,msg_);
-            write(client_fd,msg_,strlen(msg_));
+/**
+ * @brief 处理查询对局归档请求（A信号）
+ * @param c 发起请求的客户端连接
+ * @param msg 消息字符串：
+ * - "A{类型}{偏移}/{条数}/{参数}"：分页查询，从新到旧，条数最多lobby_page_max
+ *   类型 r：所有对局（无参数）；p：参数为玩家IP；w：参数为胜方（0白 1黑 2和棋或中止）；
+ *   m：参数为一个局面的落子序列（黑先，每步两个坐标字符，同OM消息），对称的局面算同一个
+ * - "AG{对局ID}"：取一局的落子
+ * 
+ * 查询走归档的索引，开销与页大小成正比，与归档中的对局总数无关
+ * 
+ * 响应数据格式：
+ * - AQ{匹配总数}/{偏移}/{本页条数}
+ * - 本页每局：A+{对局ID}/{开局时间}/{房主IP}/{客人IP}/{执黑 0房主 1客人 -未选}/{规则}/{结束方式 f五连或下满 s认输 l离开 a中止}{胜方}/{步数}
+ * - AG的响应：AM{对局ID}/{落子序列}
+ * 归档未配置、参数不合法或对局不存在时返回/Zerror
+ */
+void A_signal(connection* c,char* msg)
+{
+    shared_ptr<const game_archive> archive=current_archive();
+    if(!archive)
+    {
+        send_msg(c,"/Zerror");
+        return;
+    }
+    
+    char type=msg[1];
+    char* p=msg+2;
+    char head[160];
+    
+    // 取一局的落子
+    if(type=='G')
+    {
+        archive_ref ref;
+        char* end;
+        unsigned long long id=strtoull(p,&end,10);
+        if(end==p||*end!='\0'||!archive->find(id,ref))
+        {
+            send_msg(c,"/Zerror");
+            return;
+        }
+        string frame;
+        int len=snprintf(head,sizeof(head),"AM%llu/",id);
+        frame.append(head,len);
+        for(int i=0;i<ref.game->moves;i++)
+        {
+            frame+=proto_coord_char(ref.moves[i]/board_size);
+            frame+=proto_coord_char(ref.moves[i]%board_size);
+        }
+        frame+='\n';
+        send_frames(c,frame.data(),frame.size());
+        return;
+    }
+    
+    // 解析偏移和条数（同Q信号）
+    size_t offset=0,limit=20;
+    if(*p>='0'&&*p<='9')
+        offset=strtoul(p,&p,10);
+    if(*p=='/')
+    {
+        p++;
+        if(*p>='0'&&*p<='9')
+            limit=strtoul(p,&p,10);
+    }
+    if(*p=='/')
+        p++;
+    if(limit>(size_t)lobby_page_max)
+        limit=lobby_page_max;
+    
+    vector<archive_ref>refs;
+    refs.reserve(limit);
+    size_t total;
+    switch(type)
+    {
+        case 'r':total=archive->recent(offset,limit,refs);break;
+        case 'p':
+        {
+            struct in_addr ip;
+            if(inet_pton(AF_INET,p,&ip)!=1)
+            {
+                send_msg(c,"/Zerror");
+                return;
+            }
+            total=archive->by_player(ip.s_addr,offset,limit,refs);
+        }break;
+        case 'w':
+        {
+            if(p[0]<'0'||p[0]>'2'||p[1]!='\0')
+            {
+                send_msg(c,"/Zerror");
+                return;
+            }
+            total=archive->by_winner(p[0]-'0',offset,limit,refs);
+        }break;
+        case 'm':
+        {
+            // 落子序列：每步两个坐标字符，不能重复落在同一格
+            uint8_t moves[board_cells];
+            bool used[board_cells]={false};
+            int n=0;
+            for(;p[0]&&n<board_cells;p+=2)
+            {
+                int x=proto_coord_value(p[0]);
+                int y=x>=0?proto_coord_value(p[1]):-1;
+                if(y<0||used[x*board_size+y])
+                {
+                    send_msg(c,"/Zerror");
+                    return;
+                }
+                used[x*board_size+y]=true;
+                moves[n++]=(uint8_t)(x*board_size+y);
+            }
+            if(n==0||p[0])
+            {
+                send_msg(c,"/Zerror");
+                return;
+            }
+            total=archive->by_position(archive_position_key(moves,n),offset,limit,refs);
+        }break;
+        default:
+            send_msg(c,"/Zerror");
+            return;
+    }
+    
+    string frames;
+    int len=snprintf(head,sizeof(head),"AQ%zu/%zu/%zu\n",total,offset,refs.size());
+    frames.append(head,len);
+    static const char ends[]={'a','f','s','l'};
+    for(size_t i=0;i<refs.size();i++)
+    {
+        const archive_game &g=*refs[i].game;
+        char ip[2][INET_ADDRSTRLEN];
+        for(int k=0;k<2;k++)
+        {
+            struct in_addr a;
+            a.s_addr=g.ip[k];
+            inet_ntop(AF_INET,&a,ip[k],sizeof(ip[k]));
         }
+        char black=g.black==archive_no_black?'-':(char)('0'+g.black);
+        len=snprintf(head,sizeof(head),"A+%llu/%u/%s/%s/%c/%d/%c%d/%d\n",(unsigned long long)g.id,g.time,ip[0],ip[1],
+            black,g.rule,g.end<sizeof(ends)?ends[g.end]:'a',g.winner,g.moves);
+        frames.append(head,len);
     }
+    send_frames(c,frames.data(),frames.size());
 }
 
 /**
  * @brief 处理创建房间请求（C信号）
- * @param msg 消息字符串，格式为 "C:{房间名}"
- * @param fd 创建者的套接字
+ * @param msg 消息字符串，格式为 "C:{房间名}"（无禁手）或 "C{规则}:{房间名}"（规则为game_rule，1为连珠）
+ * @param c 创建者的连接
  * 
  * 处理流程：
- * 1. 从消息中提取房间名（跳过前两个字符"C:"）
- * 2. 创建房间信息对象并添加到房间列表
+ * 1. 从消息中提取规则和房间名（跳过"C:"或"C{规则}:"前缀），不认识的规则丢弃请求；已在房间中时返回/Zerror
+ * 2. 创建房间信息对象并添加到房间列表，权威棋盘按房间的规则判定禁手和胜负
  * 3. 更新创建者的客户端信息（设置房间号和房主标志）
  */
-void C_signal(char* msg,int fd)
+void C_signal(char* msg,connection* c)
 {   
+    int rule=rule_freestyle;
+    const char* name=msg+2;
+    if(msg[1]!=':')
+    {
+        rule=msg[1]-'0';
+        name=msg+3;
+        if(rule<0||rule>=rule_count||msg[2]!=':')
+            return;
+    }
+    
+    // 已在房间中（房主或客人）：先退出才能创建，否则原房间的座位和对手引用会失效
+    if(c->info.room_id!=0)
+    {
+        send_msg(c,"/Zerror");
+        return;
+    }
+    
+    // 进入房间后不再需要大厅推送，也不再观战、排队匹配
+    lobby_unsubscribe(c);
+    watch_leave(c);
+    match_leave(c);
+    
     char buf[1024];
     memset(buf,0,sizeof(buf));
     
-    // 提取房间名（从msg[2]开始，跳过"C:"前缀）
-    for(int i=2;msg[i]!='\0';i++)
-        buf[i-2]=msg[i];
+    // 提取房间名
+    for(int i=0;name[i]!='\0';i++)
+        buf[i]=name[i];
     
     //printf("[%d]%s\n",__LINE__,buf);
     
     // 创建房间对象（房间名、房主FD）
-    room_information room(buf,fd);
+    room_information room(buf,c->fd);
+    room.board.set_rule(rule);
     
-    // 添加到房间列表
-    rooms.push_back(room);
+    // 添加到房间表（房间固定在创建者所在的反应堆线程上）
+    room_id_t id=rooms.insert(room);
+    if(id==0)
+        return;
+    stats->rooms_created.add();
     
     // 更新创建者的客户端信息
-    hash_client[fd].room_num=rooms.size()-1;    // 房间号为列表最后一个索引
-    hash_client[fd].master=true;                // 标记为房主
+    c->info.room_id=id;         // 记录房间ID
+    c->info.master=true;        // 标记为房主
+    
+    // 登记到大厅目录
+    lobby_room entry;
+    entry.room_name=buf;
+    entry.master_ip=peer_ip(c);
+    entry.full=false;
+    lock_guard<mutex> lock(lobby_mutex);
+    lobby_insert(id,entry);
 }
 
 /**
  * @brief 处理退出房间请求（E信号）
- * @param fd 退出者的套接字
+ * @param c 退出者的连接
  * 
  * 退出逻辑（根据退出者身份不同）：
  * 
@@ -583,130 +3791,300 @@ void C_signal(char* msg,int fd)
  * 
  * 3. 如果退出者是房主：
  *    a. 房间有客人时：客人升级为新房主
- *    b. 房间无客人时：删除整个房间，更新后续房间的索引
+ *    b. 房间无客人时：删除整个房间（O(1)，其他房间的ID不变）
  */
-void E_signal(int fd)
+void E_signal(connection* c)
 {   
-    char msg[1024];
-    memset(msg,0,sizeof(msg));
+    client_information &me=c->info;
     
     // 不在任何房间，无需处理
-    if(hash_client[fd].room_num==-1)
+    if(me.room_id==0)
         return ;
     
+    room_information* room=rooms.find(me.room_id);
+    
     // ===== 情况1: 退出者是客人（非房主）=====
-    if(!hash_client[fd].master)
+    if(!me.master)
     {
-        // 将房间的客人位置设为空
-        rooms[hash_client[fd].room_num].client_fd=-1;
+        // 将房间的客人位置设为空，未结束的对局作废
+        if(room)
+        {
+            if(room->phase!=phase_idle)
+                game_event(me.room_id,jk_leave,player_color(room,c));
+            room->client_fd=-1;
+            room->phase=phase_idle;
+        }
+        {
+            lock_guard<mutex> lock(lobby_mutex);
+            lobby_update(me.room_id,false,NULL);
+        }
         
         // 清除房主对该客人的引用
-        // hash_client[fd].room_num=-1;
-        // hash_client[fd].prepare=0;
-        // hash_client[fd].opponent_fd=0;
-        hash_client[hash_client[fd].opponent_fd].opponent_fd=0;
-        
-        // 可选：通知房主客人已离开（已注释）
-        //sprintf(msg,"/O0");
-        //write(hash_client[fd].opponent_fd,msg,strlen(msg));
+        if(me.opponent)
+            me.opponent->info.opponent=NULL;
         
         // 重置退出者的客户端信息
-        hash_client[fd]=client_information();
+        me=client_information();
         return ;
     }
     // ===== 情况2: 退出者是房主 =====
     else
     {
-        // 情况2a: 房间有客人，客人升级为新房主
-        if(hash_client[fd].opponent_fd>0)
+        // 情况2a: 房间有客人，客人升级为新房主（房间ID不变）
+        if(me.opponent)
         {
-            int client_fd=hash_client[fd].opponent_fd;  // 获取客人FD
-            int room_num=hash_client[fd].room_num;      // 获取房间号
+            connection* guest=me.opponent;  // 获取客人连接
             
             // 清除客人对原房主的引用
-            hash_client[client_fd].opponent_fd=0;
+            guest->info.opponent=NULL;
             // 客人升级为新房主
-            hash_client[client_fd].master=true;
+            guest->info.master=true;
             // 更新房间的房主信息
-            rooms[room_num].master_fd=client_fd;
-            // 房间客人位置设为空
-            rooms[room_num].client_fd=-1;
+            room->master_fd=guest->fd;
+            // 房间客人位置设为空，未结束的对局作废
+            if(room->phase!=phase_idle)
+                game_event(me.room_id,jk_leave,player_color(room,c));
+            room->client_fd=-1;
+            room->phase=phase_idle;
+            
+            // 大厅目录中更新房主IP，房间重新变为空闲
+            string ip=peer_ip(guest);
+            lock_guard<mutex> lock(lobby_mutex);
+            lobby_update(me.room_id,false,ip.c_str());
         }
         // 情况2b: 房间无客人，删除房间
         else
         {
-            int r=hash_client[fd].room_num;
-            
-            // 从房间列表中删除该房间
-            rooms.erase(rooms.begin()+r,rooms.begin()+r+1);
-            
-            // 更新后续房间中所有玩家的房间号（因为索引发生了变化）
-            for(int i=r;i<rooms.size();i++)
+            if(room)
             {
-                // 更新客人的房间号
-                if(rooms[i].client_fd>0)
-                    hash_client[rooms[i].client_fd].room_num=i;
-                // 更新房主的房间号
-                hash_client[rooms[i].master_fd].room_num=i;
+                watch_close(room);
+                stats->rooms_closed.add();
             }
+            rooms.erase(me.room_id);
+            lock_guard<mutex> lock(lobby_mutex);
+            lobby_erase(me.room_id);
         }
         
-        // 重置退出者的客户��信息
-        hash_client[fd]=client_information();
+        // 重置退出者的客户端信息
+        me=client_information();
     }
 }
 
 /**
  * @brief 处理加入房间请求（J信号）
- * @param fd 加入者的套接字
- * @param msg 消息字符串，格式为 "J{目标房主的FD}"
+ * @param c 加入者的连接
+ * @param msg 消息字符串，格式为 "J{目标房间ID}"
  * 
  * 加入流程：
- * 1. 从消息中提取目标房主的FD
+ * 1. 从消息中提取目标房间ID
  * 2. 验证目标房间是否有效且可加入
  * 3. 建立双向的对手引用
  * 4. 更新房间信息
  * 5. 返回成功/失败响应
  * 
  * 失败条件：
- * - 目标FD无效（<=0）
- * - 目标不在任何房间（room_num < 0）
- * - 房间已满（opponent_fd > 0）
+ * - 房间ID无效，或房间已关闭（槽位复用后代数不同，旧ID不会匹配新房间）
+ * - 房间已满（已有对手）
+ * - 加入者自己已在某个房间中
+ * 
+ * 房间在其他反应堆线程上时，先把加入者的连接迁移到房间所在的线程，
+ * 由目标线程重新处理这条J消息
  */
-void J_signal(int fd,char* msg)
+void J_signal(connection* c,char* msg)
 {
-    int sum=0;
+    room_id_t id=0;
+    
+    // 加入房间（无论成败）都退订大厅推送、停止观战和排队匹配，失败后客户端重新订阅即可全量同步
+    lobby_unsubscribe(c);
+    watch_leave(c);
+    match_leave(c);
+    
+    // 解析目标房间ID（从msg[1]开始，跳过'J'前缀；超过20位的数字不是合法ID）
+    int i;
+    for(i=1;msg[i]>='0'&&msg[i]<='9'&&i<=20;i++)
+        id=id*10+msg[i]-'0';
+    
+    // 在大厅目录中确认房间存在且空闲，避免为无效请求迁移连接
+    bool vacant=false;
+    if(msg[i]<'0'||msg[i]>'9')
+    {
+        lock_guard<mutex> lock(lobby_mutex);
+        map<room_id_t,lobby_room>::iterator it=lobby.find(id);
+        vacant=it!=lobby.end()&&!it->second.full;
+    }
+    
+    // 房间所在的线程编码在房间ID中
+    int target=room_tag(id);
+    
+    // 房间不存在、已满，或加入者已经在房间中
+    if(!vacant||target>=(int)reactors.size()||c->info.room_id!=0)
+    {
+        send_msg(c,"/Zerror");
+        return;
+    }
     
-    // 解析目标房主的FD（从msg[1]开始，跳过'J'前缀）
-    for(int i=1;msg[i]!='\0';i++)
-        sum=sum*10+msg[i]-'0';
+    // 房间在其他线程上：迁移连接（本轮结束时移交）
+    if(target!=reactor_id)
+    {
+        c->buf.migrate_to=target;
+        migrating_fds.push_back(c->fd);
+        return;
+    }
     
     // 验证加入条件
-    // sum: 目标房主FD
-    // hash_client[sum].room_num < 0: 目标不在房间
-    // hash_client[sum].opponent_fd > 0: 房间已有人
-    if(sum<=0||hash_client[sum].room_num<0||hash_client[sum].opponent_fd>0)
+    // room: 按ID查找，已关闭或槽位已被复用的房间查不到
+    // client_fd != -1: 房间已有人
+    room_information* room=rooms.find(id);
+    connection* master=room?conns.find(room->master_fd):NULL;
+    if(!room||room->client_fd!=-1||!master)
     {
         // 返回错误响应
-        write(fd,"/Zerror",strlen("/Zerror"));
+        send_msg(c,"/Zerror");
         return;
     }
     
     // 建立双向对手引用
-    hash_client[sum].opponent_fd=fd;    // 房主的对手设为加入者
-    hash_client[fd].opponent_fd=sum;    // 加入者的对手设为房主
+    master->info.opponent=c;    // 房主的对手设为加入者
+    c->info.opponent=master;    // 加入者的对手设为房主
     
     // 更新房间信息
-    rooms[hash_client[sum].room_num].client_fd=fd;  // 设置房间的客人
-    hash_client[fd].room_num=hash_client[sum].room_num; // 设置加入者的房间号
+    room->client_fd=c->fd;      // 设置房间的客人
+    c->info.room_id=id;         // 设置加入者的房间ID
+    {
+        lock_guard<mutex> lock(lobby_mutex);
+        lobby_update(id,true,NULL);
+    }
     
     // 返回成功响应
-    write(fd,"/Zsuccess",strlen("/Zsuccess"));
+    send_msg(c,"/Zsuccess");
+}
+
+/**
+ * @brief 处理观战请求（G信号）
+ * @param c 观众的连接
+ * @param msg 消息字符串，格式为 "G{房间ID}"（观战，同时停止之前的观战）或 "G"（停止观战）
+ * 
+ * 观战不占房间的座位，房间已满或对局中都可以观战；已在房间中的玩家不能观战。
+ * 成功时先收到房间当前棋盘的快照（GS帧），之后收到这个房间的对局事件（见观战一节）；
+ * 房间不存在时返回/Zerror。与加入房间一样，房间在其他反应堆线程上时先迁移连接，由目标线程重新处理
+ */
+void G_signal(connection* c,char* msg)
+{
+    watch_leave(c);
+    if(msg[1]=='\0')
+        return;
+    
+    room_id_t id=0;
+    int i;
+    for(i=1;msg[i]>='0'&&msg[i]<='9'&&i<=20;i++)
+        id=id*10+msg[i]-'0';
+    
+    // 在大厅目录中确认房间存在，避免为无效请求迁移连接
+    bool exists=false;
+    if(msg[i]=='\0')
+    {
+        lock_guard<mutex> lock(lobby_mutex);
+        exists=lobby.find(id)!=lobby.end();
+    }
+    int target=room_tag(id);
+    if(!exists||target>=(int)reactors.size()||c->info.room_id!=0)
+    {
+        send_msg(c,"/Zerror");
+        return;
+    }
+    
+    // 观战期间不需要大厅推送，也不再排队匹配
+    lobby_unsubscribe(c);
+    match_leave(c);
+    
+    // 房间在其他线程上：迁移连接（本轮结束时移交）
+    if(target!=reactor_id)
+    {
+        c->buf.migrate_to=target;
+        migrating_fds.push_back(c->fd);
+        return;
+    }
+    
+    room_information* room=rooms.find(id);
+    if(!room)
+    {
+        send_msg(c,"/Zerror");
+        return;
+    }
+    
+    // 本轮之前的事件先推送给已有的观众，新观众从快照开始
+    watch_flush(room);
+    c->watch_room=id;
+    c->watch_pos=room->watchers.size();
+    room->watchers.push_back(c);
+    
+    string snapshot;
+    watch_snapshot(id,room,snapshot);
+    send_frames(c,snapshot.data(),snapshot.size());
+}
+
+/**
+ * @brief 处理快速匹配请求（M信号）
+ * @param c 请求者的连接
+ * @param msg 消息字符串，格式为 "M"（无禁手）、"M{规则}"（排队，同时退出另一种规则的队列）或 "M-"（取消排队）
+ * 
+ * 已在房间中或规则不合法时返回/Zerror；排队时退订大厅推送、停止观战，回复MQ，配对后收到MF（见快速匹配一节）
+ */
+void M_signal(connection* c,char* msg)
+{
+    if(msg[1]=='-'&&msg[2]=='\0')
+    {
+        match_leave(c);
+        return;
+    }
+    
+    int rule=rule_freestyle;
+    if(msg[1]!='\0')
+    {
+        rule=msg[1]-'0';
+        if(rule<0||rule>=rule_count||msg[2]!='\0')
+        {
+            send_msg(c,"/Zerror");
+            return;
+        }
+    }
+    if(c->info.room_id!=0)
+    {
+        send_msg(c,"/Zerror");
+        return;
+    }
+    lobby_unsubscribe(c);
+    watch_leave(c);
+    
+    // 匹配队列在匹配线程上：迁移连接（本轮结束时移交），由匹配线程重新处理
+    if(reactor_id!=match_home)
+    {
+        c->buf.migrate_to=match_home;
+        migrating_fds.push_back(c->fd);
+        return;
+    }
+    
+    int rating=player_rating(c);
+    if(c->match_rule!=rule)
+    {
+        match_leave(c);
+        match_pair p;
+        if(match_queues[rule].push(c->fd,rating,now_ms(),p))
+        {
+            match_start(rule,p);
+            return;
+        }
+        c->match_rule=rule;
+    }
+    
+    char reply[64];
+    snprintf(reply,sizeof(reply),"MQ%d/%zu",rating,match_queues[rule].size());
+    send_msg(c,reply);
 }
 
 /**
  * @brief 处理更新对手状态请求（U信号）
- * @param fd 请求者的套接字
+ * @param c 请求者的连接
  * 
  * 响应格式：
  * /Z{是否有对手(1/0)}/Z{对手准备状态}/Z{对手IP}/Z{对手FD}
@@ -714,20 +4092,21 @@ void J_signal(int fd,char* msg)
  * 有对手时：返回对手的详细信息
  * 无对手时：返回 /Z0/Z /Z /Z （占位符）
  */
-void U_signal(int fd)
+void U_signal(connection* c)
 {
     char msg[1024];
     memset(msg,0,sizeof(msg));
     
     // 检查是否有对手
-    if(hash_client[fd].opponent_fd>0)
+    connection* opponent=c->info.opponent;
+    if(opponent)
     {
         // 有对手：返回对手的详细信息
         // 格式: /Z1/Z{准备状态}/Z{IP地址}/Z{FD}
         sprintf(msg,"/Z1/Z%d/Z%s/Z%d",
-            hash_client[hash_client[fd].opponent_fd].prepare,   // 对手准备状态
-            inet_ntoa(client_addrs[hash_client[fd].opponent_fd].sin_addr),  // 对手IP
-            hash_client[fd].opponent_fd);   // 对手FD
+            opponent->info.prepare, // 对手准备状态
+            peer_ip(opponent).c_str(),  // 对手IP
+            opponent->fd);          // 对手FD
     }
     else
     {
@@ -735,5 +4114,5 @@ void U_signal(int fd)
         sprintf(msg,"/Z0/Z /Z /Z ");
     }
     
-    write(fd,msg,strlen(msg));
+    send_msg(c,msg);
 }
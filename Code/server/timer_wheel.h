@@ -0,0 +1,207 @@
+/**
+ * @file timer_wheel.h
+ * @brief 分层时间轮（每个连接一个定时器，增删O(1)）
+ *
+ * 时间以刻度（tick）为单位，共4层、每层64个槽：
+ * - 第0层每槽1个刻度，覆盖未来64个刻度
+ * - 第k层每槽64^k个刻度，到达该层的一轮边界时整槽下放到低一层（级联）
+ * 4层可以覆盖64^4个刻度（100ms一刻度约19天），更远的到期时间放在最高层的最后一槽。
+ *
+ * 定时器节点嵌入在所属对象中（侵入式双向链表），增加、取消都不需要分配内存；
+ * 推进一个刻度只处理当前槽，和定时器总数无关，10万连接各挂一个定时器也没有额外开销。
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include<stdint.h>
+#include<stddef.h>
+
+/**
+ * @brief 定时器节点
+ *
+ * 复制时不复制链表指针：所属对象被复制（如连接迁移到其他线程）后，副本处于未挂入状态，
+ * 原节点必须先取消。被赋值时保留自身的链表状态
+ */
+struct timer_node
+{
+    timer_node* prev;
+    timer_node* next;
+    uint64_t expire;        // 到期的刻度
+    uint64_t data;          // 供回调找到所属对象（如连接的fd）
+
+    timer_node():prev(NULL),next(NULL),expire(0),data(0){}
+    timer_node(const timer_node&):prev(NULL),next(NULL),expire(0),data(0){}
+    timer_node& operator=(const timer_node&) { return *this; }
+
+    /**
+     * @brief 是否已挂入时间轮
+     */
+    bool linked() const { return next!=NULL; }
+};
+
+class timer_wheel
+{
+public:
+    timer_wheel():now(0),count(0)
+    {
+        for(int l=0;l<levels;l++)
+            for(int s=0;s<slots;s++)
+                clear(&wheel[l][s]);
+    }
+
+    /**
+     * @brief 当前刻度
+     */
+    uint64_t current() const { return now; }
+
+    /**
+     * @brief 挂入的定时器个数
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @brief 设置起始刻度（只能在没有定时器时调用）
+     */
+    void start(uint64_t tick) { if(count==0) now=tick; }
+
+    /**
+     * @brief 设置（或重新设置）定时器
+     * @param n 定时器节点（已挂入时先取消）
+     * @param expire 到期刻度（不晚于当前刻度时在下一个刻度触发）
+     */
+    void schedule(timer_node* n,uint64_t expire)
+    {
+        cancel(n);
+        n->expire=expire>now?expire:now+1;
+        place(n);
+        count++;
+    }
+
+    /**
+     * @brief 取消定时器（未挂入时什么也不做）
+     */
+    void cancel(timer_node* n)
+    {
+        if(!n->linked())
+            return;
+        unlink(n);
+        count--;
+    }
+
+    /**
+     * @brief 推进到指定刻度，依次触发到期的定时器
+     * @param to 目标刻度
+     * @param fire 回调 fire(timer_node*)，调用前节点已取消，回调中可以重新设置任意定时器
+     */
+    template<class F>
+    void advance(uint64_t to,F fire)
+    {
+        while(now<to)
+        {
+            now++;
+            int index=(int)(now&mask);
+
+            // 第0层转完一轮：依次把高层当前槽下放
+            if(index==0)
+            {
+                for(int l=1;l<levels;l++)
+                {
+                    int s=(int)((now>>(l*bits))&mask);
+                    cascade(l,s);
+                    if(s!=0)
+                        break;
+                }
+            }
+
+            // 当前槽整体摘下后逐个触发（回调中取消同一槽的其他节点也是安全的）
+            timer_node due;
+            clear(&due);
+            splice(&wheel[0][index],&due);
+            while(due.next!=&due)
+            {
+                timer_node* n=due.next;
+                unlink(n);
+                count--;
+                fire(n);
+            }
+        }
+    }
+
+private:
+    static const int bits=6;
+    static const int slots=1<<bits;
+    static const uint64_t mask=slots-1;
+    static const int levels=4;
+
+    static void clear(timer_node* head) { head->prev=head->next=head; }
+
+    static void unlink(timer_node* n)
+    {
+        n->prev->next=n->next;
+        n->next->prev=n->prev;
+        n->prev=n->next=NULL;
+    }
+
+    static void push(timer_node* head,timer_node* n)
+    {
+        n->prev=head->prev;
+        n->next=head;
+        head->prev->next=n;
+        head->prev=n;
+    }
+
+    /**
+     * @brief 把from链表整体移到to（to原来为空）
+     */
+    static void splice(timer_node* from,timer_node* to)
+    {
+        if(from->next==from)
+            return;
+        to->next=from->next;
+        to->prev=from->prev;
+        to->next->prev=to;
+        to->prev->next=to;
+        clear(from);
+    }
+
+    /**
+     * @brief 按到期时间与当前刻度的距离选择层和槽
+     */
+    void place(timer_node* n)
+    {
+        uint64_t delta=n->expire-now;
+        for(int l=0;l<levels;l++)
+        {
+            if(delta<((uint64_t)1<<((l+1)*bits)))
+            {
+                push(&wheel[l][(n->expire>>(l*bits))&mask],n);
+                return;
+            }
+        }
+        // 超出时间轮范围：放在最高层最远的一槽，级联时再重新计算
+        push(&wheel[levels-1][((now>>((levels-1)*bits))-1)&mask],n);
+    }
+
+    /**
+     * @brief 把第l层第s槽的定时器按新的距离重新放置
+     */
+    void cascade(int l,int s)
+    {
+        timer_node list;
+        clear(&list);
+        splice(&wheel[l][s],&list);
+        while(list.next!=&list)
+        {
+            timer_node* n=list.next;
+            unlink(n);
+            place(n);
+        }
+    }
+
+    timer_node wheel[levels][slots];    // 每个槽是带哨兵的循环链表
+    uint64_t now;
+    size_t count;
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,274 @@
+/**
+ * @file uring.h
+ * @brief io_uring的最小封装（直接使用系统调用，不依赖liburing）
+ *
+ * 只提供服务器事件循环用到的几种请求：
+ * - 多次接受连接（multishot accept）：一个请求持续产生新连接
+ * - 多次接收（multishot recv）+ 提供的缓冲区环（provided buffer ring）：
+ *   一个请求持续产生数据，缓冲区由内核从环中挑选，不需要为每个连接预留接收缓冲区
+ * - 发送、多次poll（用于eventfd）、取消
+ *
+ * 请求先写入提交队列，由submit()一次系统调用批量提交并等待完成事件，
+ * 一轮事件循环中所有连接的发送只需要一次系统调用。
+ *
+ * 需要Linux 6.0及以上（multishot recv和缓冲区环）
+ */
+
+#ifndef URING_H
+#define URING_H
+
+#include<stdint.h>
+#include<stddef.h>
+#include<stdlib.h>
+#include<string.h>
+#include<errno.h>
+#include<poll.h>
+#include<unistd.h>
+#include<sys/mman.h>
+#include<sys/socket.h>
+#include<sys/syscall.h>
+#include<linux/io_uring.h>
+
+class io_ring
+{
+public:
+    io_ring():ring_fd(-1),ring_ptr(NULL),ring_len(0),sqes(NULL),sqes_len(0),
+        buf_ring(NULL),buf_ring_len(0),buf_mem(NULL),buf_count(0),buf_size(0),buf_tail(0){}
+
+    ~io_ring()
+    {
+        if(buf_ring)
+            munmap(buf_ring,buf_ring_len);
+        free(buf_mem);
+        if(sqes)
+            munmap(sqes,sqes_len);
+        if(ring_ptr)
+            munmap(ring_ptr,ring_len);
+        if(ring_fd>=0)
+            close(ring_fd);
+    }
+
+    /**
+     * @brief 创建io_uring实例
+     * @param entries 提交队列长度
+     * @param cq_entries 完成队列长度
+     * @return bool 内核不支持（或被禁用）时返回false
+     */
+    bool init(unsigned entries,unsigned cq_entries)
+    {
+        struct io_uring_params p;
+        memset(&p,0,sizeof(p));
+        p.flags=IORING_SETUP_CQSIZE;
+        p.cq_entries=cq_entries;
+        ring_fd=(int)syscall(__NR_io_uring_setup,entries,&p);
+        if(ring_fd<0)
+            return false;
+        if(!(p.features&IORING_FEAT_SINGLE_MMAP))
+            return false;
+
+        // 提交队列和完成队列共用一次映射
+        size_t sq_len=p.sq_off.array+p.sq_entries*sizeof(unsigned);
+        size_t cq_len=p.cq_off.cqes+p.cq_entries*sizeof(struct io_uring_cqe);
+        ring_len=sq_len>cq_len?sq_len:cq_len;
+        void* ptr=mmap(NULL,ring_len,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,ring_fd,IORING_OFF_SQ_RING);
+        if(ptr==MAP_FAILED)
+            return false;
+        ring_ptr=(char*)ptr;
+
+        sqes_len=p.sq_entries*sizeof(struct io_uring_sqe);
+        ptr=mmap(NULL,sqes_len,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,ring_fd,IORING_OFF_SQES);
+        if(ptr==MAP_FAILED)
+        {
+            sqes=NULL;
+            return false;
+        }
+        sqes=(struct io_uring_sqe*)ptr;
+
+        sq_head=(unsigned*)(ring_ptr+p.sq_off.head);
+        sq_tail=(unsigned*)(ring_ptr+p.sq_off.tail);
+        sq_mask=*(unsigned*)(ring_ptr+p.sq_off.ring_mask);
+        sq_entries=p.sq_entries;
+        cq_head=(unsigned*)(ring_ptr+p.cq_off.head);
+        cq_tail=(unsigned*)(ring_ptr+p.cq_off.tail);
+        cq_mask=*(unsigned*)(ring_ptr+p.cq_off.ring_mask);
+        cqes=(struct io_uring_cqe*)(ring_ptr+p.cq_off.cqes);
+
+        // 提交队列的下标数组固定为恒等映射，之后只需移动队尾
+        unsigned* array=(unsigned*)(ring_ptr+p.sq_off.array);
+        for(unsigned i=0;i<sq_entries;i++)
+            array[i]=i;
+        local_tail=*sq_tail;
+        return true;
+    }
+
+    /**
+     * @brief 注册提供给多次接收使用的缓冲区环
+     * @param group 缓冲区组编号
+     * @param count 缓冲区个数（2的幂，不超过32768）
+     * @param size 每个缓冲区的字节数
+     * @return bool 内核不支持时返回false
+     */
+    bool setup_buffers(unsigned short group,unsigned count,unsigned size)
+    {
+        buf_ring_len=count*sizeof(struct io_uring_buf);
+        void* ptr=mmap(NULL,buf_ring_len,PROT_READ|PROT_WRITE,MAP_PRIVATE|MAP_ANONYMOUS,-1,0);
+        if(ptr==MAP_FAILED)
+            return false;
+        buf_ring=(struct io_uring_buf_ring*)ptr;
+
+        struct io_uring_buf_reg reg;
+        memset(&reg,0,sizeof(reg));
+        reg.ring_addr=(uint64_t)(uintptr_t)buf_ring;
+        reg.ring_entries=count;
+        reg.bgid=group;
+        if(syscall(__NR_io_uring_register,ring_fd,IORING_REGISTER_PBUF_RING,&reg,1)<0)
+            return false;
+
+        buf_mem=(char*)malloc((size_t)count*size);
+        if(!buf_mem)
+            return false;
+        buf_group=group;
+        buf_count=count;
+        buf_size=size;
+        for(unsigned i=0;i<count;i++)
+            recycle((unsigned short)i);
+        return true;
+    }
+
+    /**
+     * @brief 完成事件中的缓冲区编号对应的内存
+     */
+    char* buffer(unsigned short bid) const { return buf_mem+(size_t)bid*buf_size; }
+
+    /**
+     * @brief 缓冲区中的数据处理完后归还缓冲区环
+     */
+    void recycle(unsigned short bid)
+    {
+        // 不用buf_ring->bufs：C++下头文件中的柔性数组被放在偏移8处，与内核看到的布局不一致
+        struct io_uring_buf* b=(struct io_uring_buf*)buf_ring+(buf_tail&(buf_count-1));
+        b->addr=(uint64_t)(uintptr_t)buffer(bid);
+        b->len=buf_size;
+        b->bid=bid;
+        buf_tail++;
+        __atomic_store_n(&buf_ring->tail,buf_tail,__ATOMIC_RELEASE);
+    }
+
+    /* ========== 请求 ========== */
+
+    void accept_multishot(int fd,uint64_t user_data)
+    {
+        struct io_uring_sqe* sqe=get_sqe(IORING_OP_ACCEPT,fd,user_data);
+        sqe->accept_flags=SOCK_NONBLOCK|SOCK_CLOEXEC;
+        sqe->ioprio=IORING_ACCEPT_MULTISHOT;
+    }
+
+    void recv_multishot(int fd,uint64_t user_data)
+    {
+        struct io_uring_sqe* sqe=get_sqe(IORING_OP_RECV,fd,user_data);
+        sqe->ioprio=IORING_RECV_MULTISHOT;
+        sqe->flags=IOSQE_BUFFER_SELECT;
+        sqe->buf_group=buf_group;
+    }
+
+    void send(int fd,const char* data,size_t len,uint64_t user_data)
+    {
+        struct io_uring_sqe* sqe=get_sqe(IORING_OP_SEND,fd,user_data);
+        sqe->addr=(uint64_t)(uintptr_t)data;
+        sqe->len=(unsigned)len;
+        sqe->msg_flags=MSG_NOSIGNAL;
+    }
+
+    void poll_multishot(int fd,uint64_t user_data)
+    {
+        struct io_uring_sqe* sqe=get_sqe(IORING_OP_POLL_ADD,fd,user_data);
+        sqe->poll32_events=POLLIN;
+        sqe->len=IORING_POLL_ADD_MULTI;
+    }
+
+    void cancel(uint64_t target,uint64_t user_data)
+    {
+        struct io_uring_sqe* sqe=get_sqe(IORING_OP_ASYNC_CANCEL,-1,user_data);
+        sqe->addr=target;
+    }
+
+    /* ========== 提交与完成 ========== */
+
+    /**
+     * @brief 提交所有排队的请求，并等待至少wait_nr个完成事件
+     * @return int 系统调用失败返回-1（errno为EINTR时可直接重试）
+     */
+    int submit(unsigned wait_nr)
+    {
+        __atomic_store_n(sq_tail,local_tail,__ATOMIC_RELEASE);
+        unsigned pending=local_tail-__atomic_load_n(sq_head,__ATOMIC_ACQUIRE);
+        return (int)syscall(__NR_io_uring_enter,ring_fd,pending,wait_nr,
+            wait_nr?IORING_ENTER_GETEVENTS:0,NULL,0);
+    }
+
+    /**
+     * @brief 取下一个完成事件（不移除）
+     * @return io_uring_cqe* 没有时返回NULL
+     */
+    struct io_uring_cqe* peek()
+    {
+        unsigned head=*cq_head;
+        if(head==__atomic_load_n(cq_tail,__ATOMIC_ACQUIRE))
+            return NULL;
+        return &cqes[head&cq_mask];
+    }
+
+    /**
+     * @brief 移除peek取到的完成事件
+     */
+    void seen()
+    {
+        __atomic_store_n(cq_head,*cq_head+1,__ATOMIC_RELEASE);
+    }
+
+private:
+    /**
+     * @brief 取一个清零的提交队列项（队列满时先提交已有的请求）
+     */
+    struct io_uring_sqe* get_sqe(int op,int fd,uint64_t user_data)
+    {
+        while(local_tail-__atomic_load_n(sq_head,__ATOMIC_ACQUIRE)>=sq_entries)
+            submit(0);
+        struct io_uring_sqe* sqe=&sqes[local_tail&sq_mask];
+        local_tail++;
+        memset(sqe,0,sizeof(*sqe));
+        sqe->opcode=(uint8_t)op;
+        sqe->fd=fd;
+        sqe->user_data=user_data;
+        return sqe;
+    }
+
+    int ring_fd;
+    char* ring_ptr;                 // 提交队列和完成队列的映射
+    size_t ring_len;
+    struct io_uring_sqe* sqes;      // 提交队列项数组
+    size_t sqes_len;
+
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned sq_mask;
+    unsigned sq_entries;
+    unsigned local_tail;            // 已填写但尚未发布的队尾
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned cq_mask;
+    struct io_uring_cqe* cqes;
+
+    struct io_uring_buf_ring* buf_ring;     // 缓冲区环（与内核共享）
+    size_t buf_ring_len;
+    char* buf_mem;                  // 缓冲区内存
+    unsigned short buf_group;       // 缓冲区组编号
+    unsigned buf_count;
+    unsigned buf_size;
+    unsigned short buf_tail;        // 缓冲区环的队尾
+
+    io_ring(const io_ring&);
+    io_ring& operator=(const io_ring&);
+};
+
+#endif // URING_H